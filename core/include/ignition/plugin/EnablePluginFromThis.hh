@@ -21,6 +21,7 @@
 #include <memory>
 
 #include <ignition/plugin/PluginPtr.hh>
+#include <ignition/plugin/WeakPluginPtr.hh>
 
 namespace ignition
 {
@@ -75,10 +76,8 @@ namespace ignition
       /// containing this interface gets instantiated.
       private: void PrivateSetPluginFromThis(const PluginPtr &_ptr);
 
-      private: class Implementation;
-      IGN_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
-      private: std::unique_ptr<Implementation> pimpl;
-      IGN_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+      /// \brief Weak reference to the PluginPtr that manages this object
+      private: WeakPluginPtr weak;
     };
   }
 }
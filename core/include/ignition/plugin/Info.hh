@@ -19,6 +19,7 @@
 #ifndef IGNITION_PLUGIN_INFO_HH_
 #define IGNITION_PLUGIN_INFO_HH_
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <set>
@@ -37,7 +38,7 @@ namespace ignition
     /// version of the Info struct
     //
     /// This must be incremented when the Info struct changes
-    const int INFO_API_VERSION = 1;
+    const int INFO_API_VERSION = 2;
 
     // We use an inline namespace to assist in forward-compatibility. Eventually
     // we may want to support a version-2 of the Info API, in which case
@@ -92,6 +93,40 @@ namespace ignition
         IGN_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
         std::function<void(void*)> deleter;
         IGN_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+
+        /// \brief Bit flags that describe traits of a plugin class. These
+        /// are computed at compile time by the Registrar and stored in
+        /// `capabilities`, so that they can be checked without looking up any
+        /// interfaces.
+        enum Capability : std::uint32_t
+        {
+          /// \brief The plugin class inherits EnablePluginFromThis
+          ENABLE_PLUGIN_FROM_THIS = 1u << 0,
+
+          /// \brief The plugin provides at least one Factory interface. The
+          /// Loader does not instantiate plugins without this flag when it is
+          /// asked for a Factory.
+          FACTORY = 1u << 1,
+
+          /// \brief Some instances may hand out a proxy instead of an
+          /// interface of the instance itself, so the interfaces are not at
+          /// the same offsets in every instance. This is set by the Loader,
+          /// not by the Registrar.
+          INTERFACE_PROXIES = 1u << 2
+        };
+
+        /// \brief The Capability flags of the plugin class, combined with a
+        /// bitwise OR.
+        std::uint32_t capabilities = 0;
+
+        /// \brief Check whether this plugin has the given capability.
+        /// \param[in] _capability
+        ///   The capability flag to check for
+        /// \return True if the flag is set in `capabilities`
+        bool HasCapability(const Capability _capability) const
+        {
+          return (this->capabilities & _capability) != 0;
+        }
       };
     }
 
@@ -19,9 +19,11 @@
 #ifndef IGNITION_PLUGIN_PLUGIN_HH_
 #define IGNITION_PLUGIN_PLUGIN_HH_
 
+#include <cstddef>
 #include <memory>
 #include <map>
 #include <string>
+#include <tuple>
 
 #include <ignition/utilities/SuppressWarning.hh>
 
@@ -32,10 +34,34 @@ namespace ignition
 {
   namespace plugin
   {
+    namespace detail
+    {
+      /// \brief Describes the interfaces that a SpecializedPlugin type
+      /// anticipates. There is one instance of this per SpecializedPlugin
+      /// type, and it is created at the first construction of that type.
+      struct SpecializationTable
+      {
+        /// \brief Mangled names of the specialized interfaces, in the order
+        /// that they were given to SpecializedPlugin.
+        const char *const *names;
+
+        /// \brief Positions within `names`, sorted so that the names they
+        /// refer to are in ascending (strcmp) order.
+        const std::size_t *order;
+
+        /// \brief An array of nullptrs with one entry per specialized
+        /// interface, used while a SpecializedPlugin is empty.
+        void *const *empty;
+
+        /// \brief The number of specialized interfaces
+        std::size_t count;
+      };
+    }
+
     // Forward declaration
-    namespace detail { template <class, class> class ComposePlugin; }
     class EnablePluginFromThis;
     class WeakPluginPtr;
+    struct PluginWithDlHandle;
 
     class IGNITION_PLUGIN_VISIBLE Plugin
     {
@@ -137,12 +163,46 @@ namespace ignition
       public: bool HasInterface(const std::string &_interfaceName,
                                 const bool _demangled = true) const;
 
+      /// \brief Get several interfaces of this plugin at once. All of them are
+      /// found with a single call into this library and a single pass over the
+      /// interfaces of the plugin instance, which is much cheaper than calling
+      /// QueryInterface<Interface>() once for each of them when they are not
+      /// already in its inline cache. The result of that pass is remembered
+      /// by the plugin instance, so later queries for the same list of
+      /// interfaces do not need to repeat it.
+      ///
+      /// \code
+      ///     FooInterface *foo;
+      ///     BarInterface *bar;
+      ///     std::tie(foo, bar) =
+      ///         plugin->QueryInterfaces<FooInterface, BarInterface>();
+      /// \endcode
+      ///
+      /// The same ownership rules apply as for QueryInterface<Interface>().
+      ///
+      /// \return A std::tuple with a pointer to each of the requested
+      /// interfaces, in the order that they were requested. Any interface that
+      /// is not provided by this Plugin will be a nullptr.
+      public: template <class... Interfaces>
+              std::tuple<Interfaces*...> QueryInterfaces();
+
+      /// \brief const-qualified version of QueryInterfaces<Interfaces...>()
+      public: template <class... Interfaces>
+              std::tuple<const Interfaces*...> QueryInterfaces() const;
+
+      /// \brief Returns true if this Plugin has every one of the specified
+      /// types of interface. Like QueryInterfaces<Interfaces...>(), this only
+      /// needs a single pass over the interfaces of the plugin instance.
+      public: template <class... Interfaces>
+              bool HasInterfaces() const;
+
 
       // -------------------- Private API -----------------------
 
       template <class> friend class TemplatePluginPtr;
+      template <class> friend class TemplatePluginPin;
+      template <class> friend class TemplateShardedPluginPtr;
       template <class...> friend class SpecializedPlugin;
-      template <class, class> friend class detail::ComposePlugin;
       friend class EnablePluginFromThis;
       friend class WeakPluginPtr;
 
@@ -154,17 +214,42 @@ namespace ignition
       private: void *PrivateQueryInterface(
                   const std::string &_interfaceName) const;
 
+      /// \brief Header-only retriever for interfaces. Each Interface type
+      /// keeps an inline cache with a few entries, which is shared by every
+      /// thread and every call site in the process. Each entry is keyed on the
+      /// Info of a plugin type, and remembers where the interface is located
+      /// within instances of that type. When the cache hits, the interface is
+      /// found without calling into this library. When it misses, this falls
+      /// back to PrivateQueryInterface(~) and replaces one of the entries.
+      /// \param[out] _lookedUp
+      ///   If this is not a nullptr, it is set to true when the cache missed
+      /// \return The interface, or a nullptr if the plugin does not provide it
+      private: template <class Interface>
+               void *PrivateQueryInterfaceInline(
+                   bool *_lookedUp = nullptr) const;
+
+      /// \brief Type-agnostic retriever for several interfaces at once
+      /// \param[in] _table
+      ///   The interfaces to retrieve
+      /// \return An array with an entry for each interface of _table, which
+      /// is either a pointer to that interface or a nullptr. It remains valid
+      /// until this Plugin is changed to a different plugin instance.
+      private: void *const *PrivateQueryInterfaces(
+                  const detail::SpecializationTable *_table) const;
+
+      /// \brief Refresh instanceMirror and infoMirror after the instance held
+      /// by dataPtr has changed.
+      private: void PrivateUpdateMirrors() const;
+
       /// \brief Copy the plugin instance from another Plugin object
       private: void PrivateCopyPluginInstance(const Plugin &_other) const;
 
-      /// \brief Copy an existing plugin instance into this plugin
-      /// \param[in] _info
-      ///   Pointer to the Info for this plugin
-      /// \param[in] _instancePtr
-      ///   Pointer to an already-existing abstract plugin instance pointer
+      /// \brief Refer to an existing plugin instance through its record
+      /// \param[in] _record
+      ///   Reference-counting pointer to the record of an already-existing
+      ///   plugin instance, or a nullptr to clear this plugin
       private: void PrivateCopyPluginInstance(
-                  const ConstInfoPtr &_info,
-                  const std::shared_ptr<void> &_instancePtr) const;
+                  const std::shared_ptr<PluginWithDlHandle> &_record) const;
 
       /// \brief Create a new plugin instance based on the info provided
       /// \param[in] _info
@@ -182,17 +267,33 @@ namespace ignition
       /// \brief Get a reference to the Info being used by this wrapper
       private: const ConstInfoPtr &PrivateGetInfoPtr() const;
 
+      /// \brief Get a reference-counting pointer to the record of the plugin
+      /// instance being managed by this wrapper. It shares ownership with
+      /// PrivateGetInstancePtr().
+      private: std::shared_ptr<PluginWithDlHandle> PrivateGetRecordPtr() const;
+
       /// \brief The InterfaceMap type needs to get used in several places, like
-      /// Plugin::Implementation and SpecializedPlugin<T>. We make the typedef
-      /// public so that those other classes can use it without needing to be
-      /// friends of Plugin. End-users should not have any need for this
-      /// typedef.
+      /// Plugin::Implementation and the record of each plugin instance. We
+      /// make the typedef public so that those other classes can use it
+      /// without needing to be friends of Plugin. End-users should not have
+      /// any need for this typedef.
       public: using InterfaceMap = std::map<std::string, void*>;
 
-      /// \brief Get or create an iterator to the std::map that holds pointers
-      /// to the various interfaces provided by this plugin instance.
-      private: InterfaceMap::iterator PrivateGetOrCreateIterator(
-          const std::string &_interfaceName);
+      /// \brief Tell this Plugin which interfaces its SpecializedPlugin type
+      /// anticipates, and where to publish pointers to them. Every time the
+      /// plugin instance changes, _slots gets pointed at an array whose entry
+      /// i points at the interface named _table->names[i], or is a nullptr if
+      /// the instance does not provide it. That array is resolved the first
+      /// time that the instance is viewed through _table, and is shared by
+      /// every Plugin that views the same instance through the same _table.
+      /// \param[in] _table
+      ///   The interfaces that are anticipated. This must outlive the Plugin.
+      /// \param[in] _slots
+      ///   Where to publish the array of interfaces. This must outlive the
+      ///   Plugin.
+      private: void PrivateSetSpecializations(
+          const detail::SpecializationTable *_table,
+          void *const **_slots) const;
 
       class Implementation;
       IGN_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
@@ -200,6 +301,14 @@ namespace ignition
       private: const std::unique_ptr<Implementation> dataPtr;
       IGN_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
 
+      /// \brief Raw pointer to the plugin instance held by dataPtr. This is
+      /// mirrored here so that header-only code can reach it.
+      private: mutable void *instanceMirror;
+
+      /// \brief Raw pointer to the Info of the plugin instance held by
+      /// dataPtr. This is mirrored here so that header-only code can reach it.
+      private: mutable const Info *infoMirror;
+
       /// \brief Virtual destructor
       public: virtual ~Plugin();
     };
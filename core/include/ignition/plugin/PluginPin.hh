@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef IGNITION_PLUGIN_PLUGINPIN_HH_
+#define IGNITION_PLUGIN_PLUGINPIN_HH_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <ignition/plugin/PluginPtr.hh>
+
+namespace ignition
+{
+  namespace plugin
+  {
+    /// \brief A PluginPin is a borrowed, non-owning reference to the plugin
+    /// wrapper of a PluginPtr. Creating, copying, and destroying a PluginPin
+    /// never touches any reference count, so any number of threads can pin
+    /// the same PluginPtr at once without contending with each other.
+    ///
+    /// The PluginPtr that a PluginPin was created from MUST outlive the
+    /// PluginPin, and it MUST NOT be modified (cleared, assigned, or moved
+    /// from) while any PluginPin refers to it. The typical use case is a
+    /// PluginPtr that is owned by a scope which spawns and joins a set of
+    /// worker threads:
+    ///
+    /// \code
+    ///     PluginPtr plugin = loader.Instantiate("MyPlugin");
+    ///     for (std::thread &worker : workers)
+    ///     {
+    ///       worker = std::thread([pin = PluginPin(plugin)]()
+    ///       {
+    ///         pin->QueryInterface<MyInterface>()->DoWork();
+    ///       });
+    ///     }
+    ///     for (std::thread &worker : workers)
+    ///       worker.join();
+    /// \endcode
+    ///
+    /// If the workers need to keep the plugin instance alive on their own,
+    /// use a ShardedPluginPtr instead.
+    template <typename PluginType>
+    class TemplatePluginPin final
+    {
+      /// \brief Default constructor. Creates an empty pin.
+      public: TemplatePluginPin();
+
+      /// \brief Pin the plugin wrapper of _ptr.
+      /// \param[in] _ptr
+      ///   The PluginPtr to borrow from. It must outlive this pin.
+      // cppcheck-suppress noExplicitConstructor
+      public: TemplatePluginPin(const TemplatePluginPtr<PluginType> &_ptr);
+
+      /// \brief Access the pinned plugin wrapper and call one of its member
+      /// functions.
+      /// \return The ability to call a member function on the underlying
+      /// Plugin object.
+      public: PluginType *operator->() const;
+
+      /// \brief Get a reference to the pinned plugin wrapper.
+      /// \return A reference to the underlying Plugin object.
+      public: PluginType &operator*() const;
+
+      /// \brief Check whether this pin refers to a valid plugin instance.
+      /// \return True if this pin is empty or if the PluginPtr that it borrows
+      /// from is empty.
+      public: bool IsEmpty() const;
+
+      /// \brief Implicitly convert this pin to a boolean.
+      /// \return The opposite value of IsEmpty().
+      public: operator bool() const;
+
+      /// \brief The borrowed plugin wrapper.
+      private: PluginType *plugin;
+    };
+
+    /// \brief Typical usage for TemplatePluginPin is to pin a generic
+    /// PluginPtr.
+    using PluginPin = TemplatePluginPin<Plugin>;
+
+    /// \brief Pin a ConstPluginPtr.
+    using ConstPluginPin = TemplatePluginPin<const Plugin>;
+
+    /// \brief ShardedPluginPtr shares ownership of one plugin instance across
+    /// many threads without making them all contend on the same reference
+    /// count.
+    ///
+    /// Every copy of a PluginPtr atomically modifies the reference count of
+    /// the plugin instance. When many threads copy the same PluginPtr (or call
+    /// QueryInterfaceSharedPtr on it) at a high rate, that count lives on a
+    /// single cache line which bounces between every core.
+    /// ShardedPluginPtr splits ownership into a number of shards, each with
+    /// its own reference count that holds one reference to the original
+    /// plugin instance. Acquire() hands out PluginPtrs that only touch the
+    /// reference count of the shard that belongs to the calling thread.
+    ///
+    /// The PluginPtrs that are produced by Acquire() behave exactly like
+    /// regular PluginPtrs, except that a WeakPluginPtr which is created from
+    /// one of them will expire once the ShardedPluginPtr and every PluginPtr
+    /// acquired from the same shard have been destroyed, even if other owners
+    /// of the plugin instance still exist.
+    template <typename PluginType>
+    class TemplateShardedPluginPtr final
+    {
+      /// \brief Default constructor. Creates an empty ShardedPluginPtr.
+      public: TemplateShardedPluginPtr();
+
+      /// \brief Share ownership of the plugin instance held by _ptr.
+      /// \param[in] _ptr
+      ///   The PluginPtr whose instance should be shared.
+      /// \param[in] _numShards
+      ///   The number of reference count shards to create. A value of 0 will
+      ///   use the number of hardware threads that are available.
+      public: explicit TemplateShardedPluginPtr(
+          const TemplatePluginPtr<PluginType> &_ptr,
+          std::size_t _numShards = 0);
+
+      /// \brief Get a PluginPtr to the shared plugin instance whose reference
+      /// count belongs to the shard of the calling thread.
+      /// \return A PluginPtr to the shared instance, or an empty PluginPtr if
+      /// this ShardedPluginPtr is empty.
+      public: TemplatePluginPtr<PluginType> Acquire() const;
+
+      /// \brief Get the number of reference count shards.
+      /// \return The number of shards.
+      public: std::size_t ShardCount() const;
+
+      /// \brief Check whether this refers to a valid plugin instance.
+      /// \return True if there is no plugin instance.
+      public: bool IsEmpty() const;
+
+      /// \brief Implicitly convert this ShardedPluginPtr to a boolean.
+      /// \return The opposite value of IsEmpty().
+      public: operator bool() const;
+
+      /// \brief One reference count shard. It is aligned so that no two
+      /// shards share a cache line.
+      private: struct alignas(64) Shard
+      {
+        /// \brief Record of the plugin instance, owned by the control block of
+        /// this shard
+        public: std::shared_ptr<PluginWithDlHandle> record;
+      };
+
+      /// \brief The shards of the shared plugin instance
+      private: std::vector<Shard> shards;
+    };
+
+    /// \brief Typical usage for TemplateShardedPluginPtr is to share a generic
+    /// PluginPtr.
+    using ShardedPluginPtr = TemplateShardedPluginPtr<Plugin>;
+
+    /// \brief Share a ConstPluginPtr.
+    using ConstShardedPluginPtr = TemplateShardedPluginPtr<const Plugin>;
+  }
+}
+
+#include "ignition/plugin/detail/PluginPin.hh"
+
+#endif
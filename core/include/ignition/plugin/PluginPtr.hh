@@ -29,9 +29,6 @@ namespace ignition
 {
   namespace plugin
   {
-    // Forward declarations
-    namespace detail { template<class, class> class ComposePlugin; }
-
     /// \brief This class manages the lifecycle of a plugin instance. It can
     /// receive a plugin instance from the ignition::plugin::Loader class
     /// or by copy-construction or assignment from another PluginPtr instance.
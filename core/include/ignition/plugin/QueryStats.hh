@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef IGNITION_PLUGIN_QUERYSTATS_HH_
+#define IGNITION_PLUGIN_QUERYSTATS_HH_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <ignition/plugin/config.hh>
+#include <ignition/plugin/Export.hh>
+
+#ifndef IGNITION_PLUGIN_ENABLE_QUERY_STATS
+#define IGNITION_PLUGIN_ENABLE_QUERY_STATS 0
+#endif
+
+namespace ignition
+{
+  namespace plugin
+  {
+    /// \brief True if this build counts the calls to QueryInterface, so that
+    /// AdviseSpecializations() can tell which interfaces are worth
+    /// specializing. Counting is turned on with the
+    /// IGN_PLUGIN_ENABLE_QUERY_STATS CMake option. When it is off, nothing
+    /// is counted and QueryInterface costs exactly what it did before.
+    ///
+    /// The calls are counted by the templates in the headers, so the option
+    /// applies to the code that calls QueryInterface, which is usually the
+    /// application. Each count is a relaxed atomic addition.
+    constexpr bool QueryStatsEnabled =
+        (IGNITION_PLUGIN_ENABLE_QUERY_STATS != 0);
+
+    /// \brief The calls of QueryInterface<Interface>() for one interface
+    /// through one type of plugin pointer.
+    struct QueryStatistics
+    {
+      /// \brief The demangled names of the interfaces that the plugin pointer
+      /// type is specialized for. This is empty for PluginPtr.
+      public: std::vector<std::string> pointerInterfaces;
+
+      /// \brief The demangled name of the interface that was queried
+      public: std::string interface;
+
+      /// \brief True if the pointer type is specialized for the interface,
+      /// so the queries did not have to search for it
+      public: bool specialized = false;
+
+      /// \brief Number of queries which found the interface
+      public: std::uint64_t hits = 0;
+
+      /// \brief Number of queries for an interface that the plugin does not
+      /// provide
+      public: std::uint64_t misses = 0;
+
+      /// \brief Number of the queries which were not specialized and missed
+      /// the inline cache of QueryInterface, so they searched the map of
+      /// interfaces of the plugin
+      public: std::uint64_t lookups = 0;
+    };
+
+    /// \brief A suggestion to specialize one type of plugin pointer for the
+    /// interfaces which are queried through it most often.
+    struct SpecializationAdvice
+    {
+      /// \brief The pointer type that the queries went through, such as
+      /// "ignition::plugin::PluginPtr"
+      public: std::string pointerType;
+
+      /// \brief The pointer type to use instead
+      public: std::string suggestedType;
+
+      /// \brief The demangled names of the interfaces that the suggestion
+      /// adds, from the most queried to the least
+      public: std::vector<std::string> interfaces;
+
+      /// \brief Number of unspecialized queries of those interfaces through
+      /// the pointer type
+      public: std::uint64_t unspecializedQueries = 0;
+    };
+
+    /// \brief Get the counts of every interface that has been queried since
+    /// the process started, or since ResetQueryStats() was called. This is
+    /// empty unless QueryStatsEnabled is true.
+    /// \return The counts, sorted from the most unspecialized queries to the
+    /// fewest
+    std::vector<QueryStatistics> IGNITION_PLUGIN_VISIBLE QueryStats();
+
+    /// \brief Set every query count back to zero.
+    void IGNITION_PLUGIN_VISIBLE ResetQueryStats();
+
+    /// \brief Rank the plugin pointer types by how often they were used to
+    /// query interfaces that they are not specialized for, and suggest a
+    /// SpecializedPluginPtr for each of them.
+    /// \param[in] _maxInterfaces
+    ///   The most interfaces to add to each suggested type. Interfaces which
+    ///   were queried less often are left out.
+    /// \return One suggestion per pointer type which had unspecialized
+    /// queries, sorted from the most unspecialized queries to the fewest
+    std::vector<SpecializationAdvice> IGNITION_PLUGIN_VISIBLE
+    AdviseSpecializations(std::size_t _maxInterfaces = 4);
+
+    /// \brief Format the query counts and the suggestions as a report which
+    /// ranks the interfaces by how often they were queried without being
+    /// specialized.
+    /// \param[in] _maxInterfaces
+    ///   \sa AdviseSpecializations()
+    /// \return The report
+    std::string IGNITION_PLUGIN_VISIBLE SpecializationReport(
+        std::size_t _maxInterfaces = 4);
+  }
+}
+
+#include <ignition/plugin/detail/QueryStats.hh>
+
+#endif
@@ -20,18 +20,22 @@
 #define IGNITION_PLUGIN_SPECIALIZEDPLUGIN_HH_
 
 #include <memory>
+#include <tuple>
+#include <type_traits>
 #include "ignition/plugin/Plugin.hh"
 
 namespace ignition
 {
   namespace plugin
   {
-    // Forward declarations
-    namespace detail { template <class, class> class ComposePlugin; }
-
-    // Forward declaration of the variadic template SpecializedPlugin class.
-    template <class... OtherSpecInterfaces>
-    class SpecializedPlugin;
+    namespace detail
+    {
+      /// \brief Provides the position of Interface within the list of
+      /// SpecInterfaces as `value`. If Interface is not in the list, then
+      /// `value` will be equal to the length of the list.
+      template <class Interface, class... SpecInterfaces>
+      struct SpecializationIndex;
+    }
 
     /// \brief This class allows Plugin instances to have high-speed access to
     /// interfaces that can be anticipated at compile time. The plugin does
@@ -58,8 +62,15 @@ namespace ignition
     /// direct access to the the `FooInterface*` of `plugin`. If `plugin` does
     /// not actually offer `FooInterface`, then it will return a nullptr, still
     /// at extremely high speed.
-    template <class SpecInterface>
-    class SpecializedPlugin<SpecInterface> : public virtual Plugin
+    ///
+    /// The pointers to the specialized interfaces are kept in a flat array
+    /// whose entries are chosen at compile time. The array is resolved once
+    /// per plugin instance and SpecializedPlugin type, and is then shared by
+    /// reference, so converting a PluginPtr into a SpecializedPluginPtr (or
+    /// between SpecializedPluginPtr types) does not depend on the number of
+    /// interfaces involved.
+    template <class... SpecInterfaces>
+    class SpecializedPlugin : public Plugin
     {
       // -------------------- Public API ---------------------
 
@@ -88,67 +99,122 @@ namespace ignition
       public: template <class Interface>
               bool HasInterface() const;
 
+      // Documentation inherited
+      public: template <class... Interfaces>
+              std::tuple<Interfaces*...> QueryInterfaces();
+
+      // Documentation inherited
+      public: template <class... Interfaces>
+              std::tuple<const Interfaces*...> QueryInterfaces() const;
+
+      // Documentation inherited
+      public: template <class... Interfaces>
+              bool HasInterfaces() const;
+
+      /// \brief Virtual destructor
+      public: virtual ~SpecializedPlugin() = default;
+
 
       // -------------------- Private API ---------------------
 
       // Declare friendship
-      template <class...> friend class SpecializedPlugin;
-      template <class, class> friend class detail::ComposePlugin;
       template <class> friend class TemplatePluginPtr;
 
-      /// \brief type is an empty placeholder class which is used by the private
+      /// \brief The number of specialized interfaces
+      private: static constexpr std::size_t NumSpecializations =
+          sizeof...(SpecInterfaces);
+
+      /// \brief std::true_type if Interface is one of the specialized
+      /// interfaces, otherwise std::false_type. This is used by the private
       /// member functions to provide two overloads: a high-performance one for
-      /// the specialized interface, and a normal-performance one for all other
-      /// Interface types.
-      private: template <class T> struct type { };
+      /// the specialized interfaces, and a normal-performance one for all
+      /// other Interface types.
+      private: template <class Interface>
+      using IsSpecialized = std::integral_constant<bool,
+          (detail::SpecializationIndex<Interface, SpecInterfaces...>::value
+           < NumSpecializations)>;
+
+      /// \brief std::true_type if every one of Interfaces is specialized,
+      /// otherwise std::false_type.
+      private: template <class... Interfaces>
+      using AreSpecialized =
+          std::conjunction<IsSpecialized<Interfaces>...>;
 
       /// \brief Delegate the function to the standard Plugin method
-      /// \param[in] _type Empty object meant to guide the compiler to pick the
-      /// desired implementation.
-      /// \return Pointer to the intergace
+      /// \return Pointer to the interface
       private: template <class Interface>
-               Interface *PrivateQueryInterface(type<Interface>);
+               Interface *PrivateQueryInterface(std::false_type);
 
-      /// \brief Use a high-speed accessor to provide this specialized interface
-      /// \param[in] _type Empty object meant to guide the compiler to pick the
-      /// desired implementation.
-      /// \return Pointer to the specialized intergace
-      private: SpecInterface *PrivateQueryInterface(type<SpecInterface>);
+      /// \brief Use a high-speed accessor to provide a specialized interface
+      /// \return Pointer to the specialized interface
+      private: template <class Interface>
+               Interface *PrivateQueryInterface(std::true_type);
 
       /// \brief Delegate the function to the standard Plugin method
-      /// \param[in] _type Empty object meant to guide the compiler to pick the
-      /// desired implementation.
-      /// \return Pointer to the specialized intergace
+      /// \return Pointer to the interface
+      private: template <class Interface>
+               const Interface *PrivateQueryInterface(std::false_type) const;
+
+      /// \brief Use a high-speed accessor to provide a specialized interface
+      /// \return Pointer to the specialized interface
       private: template <class Interface>
-               const Interface *PrivateQueryInterface(type<Interface>) const;
-
-      /// \brief Use a high-speed accessor to provide this specialized interface
-      /// \param[in] _type Empty object meant to guide the compiler to pick the
-      /// desired implementation.
-      /// \return Pointer to the specialized intergace
-      private: const SpecInterface *PrivateQueryInterface(
-                   type<SpecInterface>) const;
-
-      /// \brief Delegate the function to the standard PluginPtr method
-      /// \param[in] _type Empty object meant to guide the compiler to pick the
-      /// desired implementation.
+               const Interface *PrivateQueryInterface(std::true_type) const;
+
+      /// \brief Delegate the function to the standard Plugin method
+      /// \return Pointers to the interfaces
+      private: template <class... Interfaces>
+               std::tuple<Interfaces*...> PrivateQueryInterfaceTuple(
+                   std::false_type);
+
+      /// \brief Every interface is specialized, so use the high-speed
+      /// accessor for each of them.
+      /// \return Pointers to the interfaces
+      private: template <class... Interfaces>
+               std::tuple<Interfaces*...> PrivateQueryInterfaceTuple(
+                   std::true_type);
+
+      /// \brief Delegate the function to the standard Plugin method
+      /// \return Pointers to the interfaces
+      private: template <class... Interfaces>
+               std::tuple<const Interfaces*...> PrivateQueryInterfaceTuple(
+                   std::false_type) const;
+
+      /// \brief Every interface is specialized, so use the high-speed
+      /// accessor for each of them.
+      /// \return Pointers to the interfaces
+      private: template <class... Interfaces>
+               std::tuple<const Interfaces*...> PrivateQueryInterfaceTuple(
+                   std::true_type) const;
+
+      /// \brief Delegate the function to the standard Plugin method
       /// \return True if the interface is present.
       private: template <class Interface>
-               bool PrivateHasInterface(type<Interface>) const;
+               bool PrivateHasInterface(std::false_type) const;
 
-      /// \brief Use a high-speed accessor to check this specialized interface
-      /// \param[in] _type Empty object meant to guide the compiler to pick the
-      /// desired implementation.
+      /// \brief Use a high-speed accessor to check a specialized interface
       /// \return True if the interface is present.
-      private: bool PrivateHasInterface(type<SpecInterface>) const;
-
-      // Dev note (MXG): The privateSpecializedInterfaceIterator object must be
-      // available to the user during their compile time, so it cannot be hidden
-      // using PIMPL. The iterator is const because it must always point to the
-      // same entry throughout its entire lifecycle.
-      /// \brief Iterator that points to the entry of the specialized interface
-      private:
-      const Plugin::InterfaceMap::iterator privateSpecializedInterfaceIterator;
+      private: template <class Interface>
+               bool PrivateHasInterface(std::true_type) const;
+
+      /// \brief Delegate the function to the standard Plugin method
+      /// \return True if every interface is present.
+      private: template <class... Interfaces>
+               bool PrivateHasInterfaces(std::false_type) const;
+
+      /// \brief Use the high-speed accessor to check each interface
+      /// \return True if every interface is present.
+      private: template <class... Interfaces>
+               bool PrivateHasInterfaces(std::true_type) const;
+
+      // Dev note: The array of specialized interfaces must be available to the
+      // user during their compile time, so it cannot be hidden using PIMPL.
+      // Plugin keeps it up to date whenever the plugin instance changes.
+      /// \brief Pointers to the specialized interfaces, in the same order as
+      /// SpecInterfaces. An entry is a nullptr if the plugin instance does not
+      /// provide that interface. The array belongs to the record of the plugin
+      /// instance (or is a static array of nullptrs while this is empty), so
+      /// it remains valid for as long as this refers to the instance.
+      private: void *const *privateSpecializedInterfaces;
 
       /// \brief Default constructor
       private: SpecializedPlugin();
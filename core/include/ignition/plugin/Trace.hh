@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef IGNITION_PLUGIN_TRACE_HH_
+#define IGNITION_PLUGIN_TRACE_HH_
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include <ignition/plugin/config.hh>
+#include <ignition/plugin/Export.hh>
+
+#ifndef IGNITION_PLUGIN_ENABLE_TRACING
+#define IGNITION_PLUGIN_ENABLE_TRACING 0
+#endif
+
+namespace ignition
+{
+  namespace plugin
+  {
+    /// \brief True if this build records lifecycle trace events. Tracing is
+    /// turned on with the IGN_PLUGIN_ENABLE_TRACING CMake option. When it is
+    /// off, the trace points compile to nothing.
+    ///
+    /// The trace points mark when each library is loaded and forgotten, when
+    /// each plugin is instantiated and destroyed, and when lost products are
+    /// cleaned up. Each thread records its events into its own fixed-size
+    /// ring buffer without taking any lock, so the oldest events of a thread
+    /// are overwritten once its buffer is full.
+    constexpr bool TracingEnabled = (IGNITION_PLUGIN_ENABLE_TRACING != 0);
+
+    /// \brief The number of events that each thread keeps
+    constexpr std::size_t TraceEventsPerThread = 4096;
+
+    /// \brief Write the trace events of every thread in the Chrome
+    /// trace_event JSON format, which can be opened with chrome://tracing or
+    /// https://ui.perfetto.dev. If tracing is disabled, the trace is empty.
+    ///
+    /// Threads may keep recording events while this runs. Events which are
+    /// overwritten while they are being written out are skipped.
+    /// \param[out] _out
+    ///   The stream to write the trace to
+    void IGNITION_PLUGIN_VISIBLE WriteChromeTrace(std::ostream &_out);
+
+    /// \brief Get the trace events of every thread in the Chrome
+    /// trace_event JSON format.
+    /// \sa WriteChromeTrace()
+    /// \return The JSON text
+    std::string IGNITION_PLUGIN_VISIBLE ChromeTrace();
+
+    /// \brief Discard the trace events that have been recorded so far.
+    void IGNITION_PLUGIN_VISIBLE ClearTrace();
+  }
+}
+
+#include <ignition/plugin/detail/Trace.hh>
+
+#endif
@@ -36,6 +36,11 @@ namespace ignition
     /// If the Plugin is deleted while this WeakPluginPtr is referring to it,
     /// then Lock() will return an empty PluginPtr, and IsExpired() will return
     /// true.
+    ///
+    /// A WeakPluginPtr is exactly as large as a std::weak_ptr, and creating,
+    /// copying, or moving it never allocates memory. Lock() does a single
+    /// atomic operation on the reference count of the plugin instance, and it
+    /// does not depend on the number of interfaces that the plugin provides.
     class IGNITION_PLUGIN_VISIBLE WeakPluginPtr
     {
       /// \brief Default constructor
@@ -90,10 +95,14 @@ namespace ignition
       /// \brief Destructor
       public: ~WeakPluginPtr();
 
-      private: class Implementation;
+      // Declare friendship so that EnablePluginFromThis can retrieve the
+      // instance without creating a PluginPtr.
+      friend class EnablePluginFromThis;
+
       IGN_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
-      /// \brief PIMPL pointer to the implementation of this class
-      private: std::unique_ptr<Implementation> pimpl;
+      /// \brief Weak reference to the record of the plugin instance. The
+      /// record holds the instance, its Info, and its interface table.
+      private: std::weak_ptr<PluginWithDlHandle> record;
       IGN_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
     };
   }
@@ -19,28 +19,243 @@
 #ifndef IGNITION_PLUGIN_DETAIL_PLUGIN_HH_
 #define IGNITION_PLUGIN_DETAIL_PLUGIN_HH_
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <tuple>
+#include <typeinfo>
+#include <utility>
 #include <ignition/plugin/Plugin.hh>
+#include <ignition/plugin/QueryStats.hh>
 
 namespace ignition
 {
   namespace plugin
   {
+    namespace detail
+    {
+      /// \brief The inline cache of Plugin::QueryInterface<Interface>() has a
+      /// few entries, so that code which queries the same interface from
+      /// several types of plugins does not keep evicting one type with
+      /// another. Each entry packs everything that it knows about one plugin
+      /// type into a single word, so that it can be checked with one atomic
+      /// load and no locking:
+      ///
+      ///   bits  0-47: address of the Info of the cached plugin type
+      ///   bits 48-62: offset of the interface within instances of that type
+      ///   bit     63: whether that plugin type provides the interface
+      ///
+      /// Plugin types whose Info address or interface offset do not fit into
+      /// these bits, or whose instances may hand out interface proxies, are
+      /// simply never cached.
+      struct QueryInterfaceCache
+      {
+        /// \brief Bits that hold the address of the Info
+        public: static constexpr std::uint64_t InfoMask =
+            (std::uint64_t(1) << 48) - 1;
+
+        /// \brief Position of the bits that hold the offset
+        public: static constexpr unsigned int OffsetShift = 48;
+
+        /// \brief Largest offset that can be cached
+        public: static constexpr std::uint64_t MaxOffset =
+            (std::uint64_t(1) << 15) - 1;
+
+        /// \brief Bit that tells whether the interface is available
+        public: static constexpr std::uint64_t AvailableBit =
+            std::uint64_t(1) << 63;
+
+        /// \brief Number of entries. A hit scans all of them, which costs one
+        /// relaxed load each.
+        public: static constexpr std::size_t Entries = 4;
+      };
+
+      /// \brief The data that is needed when the inline cache of
+      /// Plugin::QueryInterface<Interface>() gets refilled.
+      struct QueryInterfaceCacheRefill
+      {
+        /// \brief Serializes the threads that refill the cache
+        public: std::mutex mutex;
+
+        /// \brief Keeps the memory of the Info of each entry reserved. The
+        /// Loader allocates each Info together with its reference counter, so
+        /// no other Info can appear at the same address while this is held.
+        public: std::weak_ptr<const Info> keys[QueryInterfaceCache::Entries];
+
+        /// \brief The entry that the next refill replaces, unless the plugin
+        /// type already has an entry. Entries are replaced in turn.
+        public: std::size_t next = 0;
+      };
+
+      /////////////////////////////////////////////////
+      /// \brief Get the table of the interfaces in SpecInterfaces, which is
+      /// used by SpecializedPlugin<SpecInterfaces...> and by
+      /// Plugin::QueryInterfaces<SpecInterfaces...>(). The table is built the
+      /// first time that it is requested, and is shared from then on.
+      template <class... SpecInterfaces>
+      const SpecializationTable &SpecializationTableOf()
+      {
+        static constexpr std::size_t N = sizeof...(SpecInterfaces);
+
+        // The trailing nullptr keeps these arrays valid when N is zero.
+        static const char *const names[N+1] =
+            {typeid(SpecInterfaces).name()..., nullptr};
+
+        static const std::array<std::size_t, N+1> order = []()
+        {
+          std::array<std::size_t, N+1> sorted;
+          for (std::size_t i = 0; i < sorted.size(); ++i)
+            sorted[i] = i;
+
+          std::sort(sorted.begin(), sorted.begin() + N,
+                    [](const std::size_t _a, const std::size_t _b)
+          {
+            return std::strcmp(names[_a], names[_b]) < 0;
+          });
+
+          return sorted;
+        }();
+
+        static void *const empty[N+1] = {};
+
+        static const SpecializationTable table =
+            {names, order.data(), empty, N};
+        return table;
+      }
+
+      /////////////////////////////////////////////////
+      /// \brief Turn the array that was found for
+      /// SpecializationTableOf<Interfaces...>() into a tuple of interfaces.
+      template <class... Interfaces, std::size_t... Indices>
+      std::tuple<Interfaces*...> MakeInterfaceTuple(
+          void *const *_interfaces, std::index_sequence<Indices...>)
+      {
+        return std::tuple<Interfaces*...>(
+              static_cast<Interfaces*>(_interfaces[Indices])...);
+      }
+    }
+
     //////////////////////////////////////////////////
     template <class Interface>
     Interface *Plugin::QueryInterface()
     {
-      return static_cast<Interface*>(
-            this->PrivateQueryInterface(typeid(Interface).name()));
+      bool lookedUp = false;
+      Interface *const result = static_cast<Interface*>(
+            this->template PrivateQueryInterfaceInline<Interface>(
+              QueryStatsEnabled ? &lookedUp : nullptr));
+
+      detail::CountQuery<Interface, false>(nullptr != result, lookedUp);
+      return result;
     }
 
     //////////////////////////////////////////////////
     template <class Interface>
     const Interface *Plugin::QueryInterface() const
     {
-      return static_cast<const Interface*>(
-            this->PrivateQueryInterface(typeid(Interface).name()));
+      bool lookedUp = false;
+      const Interface *const result = static_cast<const Interface*>(
+            this->template PrivateQueryInterfaceInline<Interface>(
+              QueryStatsEnabled ? &lookedUp : nullptr));
+
+      detail::CountQuery<Interface, false>(nullptr != result, lookedUp);
+      return result;
+    }
+
+    //////////////////////////////////////////////////
+    template <class Interface>
+    void *Plugin::PrivateQueryInterfaceInline(bool *_lookedUp) const
+    {
+      using Cache = detail::QueryInterfaceCache;
+
+      if (!this->infoMirror)
+        return nullptr;
+
+      // Every instance of a plugin type has its interfaces at the same
+      // offsets, so each entry only needs to know which plugin type it was
+      // filled in for. The entries are shared by every call site of this
+      // Interface in the process. A cache per call site would need a unique
+      // type for each call site, which C++17 cannot create inside of a
+      // function template.
+      static std::atomic<std::uint64_t> cache[Cache::Entries] = {};
+
+      const std::uint64_t infoAddress =
+          reinterpret_cast<std::uintptr_t>(this->infoMirror);
+
+      for (const std::atomic<std::uint64_t> &entry : cache)
+      {
+        const std::uint64_t cached = entry.load(std::memory_order_relaxed);
+        if ((cached & Cache::InfoMask) != infoAddress)
+          continue;
+
+        // Dev note: The Info of this plugin is alive, and the Info that an
+        // entry was filled in for is kept alive until after the entry stops
+        // referring to it, so a matching address always means that it is the
+        // same Info.
+        if (!(cached & Cache::AvailableBit))
+          return nullptr;
+
+        return static_cast<char*>(this->instanceMirror)
+            + ((cached >> Cache::OffsetShift) & Cache::MaxOffset);
+      }
+
+      if (_lookedUp)
+        *_lookedUp = true;
+
+      void *const location =
+          this->PrivateQueryInterface(typeid(Interface).name());
+
+      const std::ptrdiff_t offset = location ?
+            static_cast<char*>(location)
+            - static_cast<char*>(this->instanceMirror) : 0;
+
+      if ((infoAddress & ~Cache::InfoMask) != 0 || offset < 0
+          || static_cast<std::uint64_t>(offset) > Cache::MaxOffset
+          || this->infoMirror->HasCapability(Info::INTERFACE_PROXIES))
+      {
+        // LCOV_EXCL_START
+        return location;
+        // LCOV_EXCL_STOP
+      }
+
+      static detail::QueryInterfaceCacheRefill refill;
+      std::weak_ptr<const Info> previousKey = this->PrivateGetInfoPtr();
+      {
+        std::lock_guard<std::mutex> lock(refill.mutex);
+
+        // Another thread may have filled in an entry for this plugin type in
+        // the meantime. Otherwise the entries are replaced in turn.
+        std::size_t e = 0;
+        while (e < Cache::Entries
+               && (cache[e].load(std::memory_order_relaxed) & Cache::InfoMask)
+                  != infoAddress)
+        {
+          ++e;
+        }
+
+        if (Cache::Entries == e)
+        {
+          e = refill.next;
+          refill.next = (refill.next + 1) % Cache::Entries;
+        }
+
+        // The new Info is pinned before the entry refers to it, and the
+        // previous Info is only released after the entry has stopped
+        // referring to it.
+        refill.keys[e].swap(previousKey);
+        cache[e].store(
+              infoAddress
+              | (static_cast<std::uint64_t>(offset) << Cache::OffsetShift)
+              | (location ? Cache::AvailableBit : 0),
+              std::memory_order_relaxed);
+      }
+
+      return location;
     }
 
     //////////////////////////////////////////////////
@@ -105,6 +320,41 @@ namespace ignition
     {
       return this->HasInterface(typeid(Interface).name(), false);
     }
+
+    //////////////////////////////////////////////////
+    template <class... Interfaces>
+    std::tuple<Interfaces*...> Plugin::QueryInterfaces()
+    {
+      return detail::MakeInterfaceTuple<Interfaces...>(
+            this->PrivateQueryInterfaces(
+              &detail::SpecializationTableOf<Interfaces...>()),
+            std::index_sequence_for<Interfaces...>());
+    }
+
+    //////////////////////////////////////////////////
+    template <class... Interfaces>
+    std::tuple<const Interfaces*...> Plugin::QueryInterfaces() const
+    {
+      return detail::MakeInterfaceTuple<const Interfaces...>(
+            this->PrivateQueryInterfaces(
+              &detail::SpecializationTableOf<Interfaces...>()),
+            std::index_sequence_for<Interfaces...>());
+    }
+
+    //////////////////////////////////////////////////
+    template <class... Interfaces>
+    bool Plugin::HasInterfaces() const
+    {
+      const detail::SpecializationTable &table =
+          detail::SpecializationTableOf<Interfaces...>();
+
+      void *const *interfaces = this->PrivateQueryInterfaces(&table);
+      return std::all_of(interfaces, interfaces + table.count,
+                         [](const void *_interface)
+      {
+        return nullptr != _interface;
+      });
+    }
   }
 }
 
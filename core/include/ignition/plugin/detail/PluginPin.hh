@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef IGNITION_PLUGIN_DETAIL_PLUGINPIN_HH_
+#define IGNITION_PLUGIN_DETAIL_PLUGINPIN_HH_
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include <ignition/plugin/PluginPin.hh>
+
+namespace ignition
+{
+  namespace plugin
+  {
+    namespace detail
+    {
+      //////////////////////////////////////////////////
+      /// \brief Get a small number which identifies the calling thread. Each
+      /// thread receives the next number the first time that it calls this
+      /// function, so consecutive threads land on different shards.
+      inline std::size_t ShardIndexOfThisThread()
+      {
+        static std::atomic<std::size_t> nextIndex(0);
+        static thread_local const std::size_t index = nextIndex++;
+        return index;
+      }
+    }
+
+    //////////////////////////////////////////////////
+    template <typename PluginType>
+    TemplatePluginPin<PluginType>::TemplatePluginPin()
+      : plugin(nullptr)
+    {
+      // Do nothing
+    }
+
+    //////////////////////////////////////////////////
+    template <typename PluginType>
+    TemplatePluginPin<PluginType>::TemplatePluginPin(
+        const TemplatePluginPtr<PluginType> &_ptr)
+      : plugin(_ptr.operator->())
+    {
+      // Do nothing
+    }
+
+    //////////////////////////////////////////////////
+    template <typename PluginType>
+    PluginType *TemplatePluginPin<PluginType>::operator->() const
+    {
+      return this->plugin;
+    }
+
+    //////////////////////////////////////////////////
+    template <typename PluginType>
+    PluginType &TemplatePluginPin<PluginType>::operator*() const
+    {
+      return *this->plugin;
+    }
+
+    //////////////////////////////////////////////////
+    template <typename PluginType>
+    bool TemplatePluginPin<PluginType>::IsEmpty() const
+    {
+      return (nullptr == this->plugin
+              || nullptr == this->plugin->PrivateGetInstancePtr());
+    }
+
+    //////////////////////////////////////////////////
+    template <typename PluginType>
+    TemplatePluginPin<PluginType>::operator bool() const
+    {
+      return !this->IsEmpty();
+    }
+
+    //////////////////////////////////////////////////
+    template <typename PluginType>
+    TemplateShardedPluginPtr<PluginType>::TemplateShardedPluginPtr()
+    {
+      // Do nothing
+    }
+
+    //////////////////////////////////////////////////
+    template <typename PluginType>
+    TemplateShardedPluginPtr<PluginType>::TemplateShardedPluginPtr(
+        const TemplatePluginPtr<PluginType> &_ptr,
+        std::size_t _numShards)
+    {
+      if (_ptr.IsEmpty())
+        return;
+
+      if (0 == _numShards)
+        _numShards = std::thread::hardware_concurrency();
+
+      if (0 == _numShards)
+        _numShards = 1;
+
+      PluginWithDlHandle *const record = _ptr->PrivateGetRecordPtr().get();
+
+      this->shards.resize(_numShards);
+      for (Shard &shard : this->shards)
+      {
+        // Each shard gets its own control block, which holds one reference to
+        // the original instance. The aliasing constructor lets the shard
+        // point at the record of the instance while using that control block,
+        // so copying it never touches the reference count of the original.
+        const auto holder =
+            std::make_shared<TemplatePluginPtr<PluginType>>(_ptr);
+
+        shard.record = std::shared_ptr<PluginWithDlHandle>(holder, record);
+      }
+    }
+
+    //////////////////////////////////////////////////
+    template <typename PluginType>
+    TemplatePluginPtr<PluginType>
+    TemplateShardedPluginPtr<PluginType>::Acquire() const
+    {
+      TemplatePluginPtr<PluginType> ptr;
+      if (this->shards.empty())
+        return ptr;
+
+      const Shard &shard = this->shards[
+          detail::ShardIndexOfThisThread() % this->shards.size()];
+
+      ptr->PrivateCopyPluginInstance(shard.record);
+      return ptr;
+    }
+
+    //////////////////////////////////////////////////
+    template <typename PluginType>
+    std::size_t TemplateShardedPluginPtr<PluginType>::ShardCount() const
+    {
+      return this->shards.size();
+    }
+
+    //////////////////////////////////////////////////
+    template <typename PluginType>
+    bool TemplateShardedPluginPtr<PluginType>::IsEmpty() const
+    {
+      return this->shards.empty();
+    }
+
+    //////////////////////////////////////////////////
+    template <typename PluginType>
+    TemplateShardedPluginPtr<PluginType>::operator bool() const
+    {
+      return !this->IsEmpty();
+    }
+  }
+}
+
+#endif
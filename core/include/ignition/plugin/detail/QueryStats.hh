@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef IGNITION_PLUGIN_DETAIL_QUERYSTATS_HH_
+#define IGNITION_PLUGIN_DETAIL_QUERYSTATS_HH_
+
+#include <atomic>
+#include <cstdint>
+#include <typeinfo>
+
+#include <ignition/plugin/QueryStats.hh>
+
+namespace ignition
+{
+  namespace plugin
+  {
+    namespace detail
+    {
+      /// \brief The counts of one interface queried through one type of
+      /// plugin pointer. Counters are never destroyed, so the call sites
+      /// which refer to them may belong to libraries that get unloaded.
+      struct alignas(64) QueryCounter
+      {
+        /// \sa QueryStatistics::hits
+        public: std::atomic<std::uint64_t> hits{0};
+
+        /// \sa QueryStatistics::misses
+        public: std::atomic<std::uint64_t> misses{0};
+
+        /// \sa QueryStatistics::lookups
+        public: std::atomic<std::uint64_t> lookups{0};
+      };
+
+      /// \brief Get the counter of an interface queried through a type of
+      /// plugin pointer, creating it the first time. Every call site that
+      /// passes the same names gets the same counter.
+      /// \param[in] _interface
+      ///   The mangled name of the interface
+      /// \param[in] _specialized
+      ///   Whether the pointer type is specialized for the interface
+      /// \param[in] _pointerInterfaces
+      ///   The mangled names of the interfaces that the pointer type is
+      ///   specialized for, ending with a nullptr
+      /// \return The counter
+      IGNITION_PLUGIN_VISIBLE QueryCounter *RegisterQueryCounter(
+          const char *_interface,
+          bool _specialized,
+          const char *const *_pointerInterfaces);
+
+      /////////////////////////////////////////////////
+      /// \brief Count one query of Interface through a plugin pointer which is
+      /// specialized for PointerInterfaces. This does nothing unless
+      /// QueryStatsEnabled is true.
+      /// \param[in] _found Whether the interface was found
+      /// \param[in] _lookedUp Whether the interface map was searched
+      template <typename Interface, bool Specialized,
+                typename... PointerInterfaces>
+      void CountQuery(const bool _found, const bool _lookedUp)
+      {
+        if constexpr (QueryStatsEnabled)
+        {
+          static const char *const pointerInterfaces[] =
+              {typeid(PointerInterfaces).name()..., nullptr};
+          static QueryCounter *const counter = RegisterQueryCounter(
+                typeid(Interface).name(), Specialized, pointerInterfaces);
+
+          (_found ? counter->hits : counter->misses).fetch_add(
+                1, std::memory_order_relaxed);
+          if (_lookedUp)
+            counter->lookups.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+          static_cast<void>(_found);
+          static_cast<void>(_lookedUp);
+        }
+      }
+    }
+  }
+}
+
+#endif
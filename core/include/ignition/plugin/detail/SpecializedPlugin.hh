@@ -19,7 +19,10 @@
 #ifndef IGNITION_PLUGIN_DETAIL_SPECIALIZEDPLUGIN_HH_
 #define IGNITION_PLUGIN_DETAIL_SPECIALIZEDPLUGIN_HH_
 
+#include <algorithm>
+#include <iterator>
 #include <memory>
+#include <tuple>
 #include "ignition/plugin/SpecializedPlugin.hh"
 
 // This preprocessor token should only be used by the unittest that is
@@ -34,29 +37,58 @@ namespace ignition
 {
   namespace plugin
   {
+    namespace detail
+    {
+      /// \brief Base case: Interface is not in the list, so its index is the
+      /// length of the (empty) list.
+      template <class Interface>
+      struct SpecializationIndex<Interface>
+      {
+        static constexpr std::size_t value = 0;
+      };
+
+      /// \brief Interface is at the front of the list.
+      template <class Interface, class... Others>
+      struct SpecializationIndex<Interface, Interface, Others...>
+      {
+        static constexpr std::size_t value = 0;
+      };
+
+      /// \brief Interface is not at the front of the list, so keep searching.
+      template <class Interface, class First, class... Others>
+      struct SpecializationIndex<Interface, First, Others...>
+      {
+        static constexpr std::size_t value =
+            1 + SpecializationIndex<Interface, Others...>::value;
+      };
+    }
+
     /////////////////////////////////////////////////
-    template <class SpecInterface>
+    template <class... SpecInterfaces>
     // the following is a false positive with cppcheck 1.82 fixed in 1.83
     // cppcheck-suppress syntaxError
     template <class Interface>
-    Interface *SpecializedPlugin<SpecInterface>::QueryInterface()
+    Interface *SpecializedPlugin<SpecInterfaces...>::QueryInterface()
     {
-      return this->PrivateQueryInterface(type<Interface>());
+      return this->template PrivateQueryInterface<Interface>(
+            IsSpecialized<Interface>());
     }
 
     /////////////////////////////////////////////////
-    template <class SpecInterface>
+    template <class... SpecInterfaces>
     template <class Interface>
-    const Interface *SpecializedPlugin<SpecInterface>::QueryInterface() const
+    const Interface *SpecializedPlugin<SpecInterfaces...>::QueryInterface()
+    const
     {
-      return this->PrivateQueryInterface(type<Interface>());
+      return this->template PrivateQueryInterface<Interface>(
+            IsSpecialized<Interface>());
     }
 
     /////////////////////////////////////////////////
-    template <class SpecInterface>
+    template <class... SpecInterfaces>
     template <class Interface>
     std::shared_ptr<Interface>
-    SpecializedPlugin<SpecInterface>::QueryInterfaceSharedPtr()
+    SpecializedPlugin<SpecInterfaces...>::QueryInterfaceSharedPtr()
     {
       Interface *ptr = this->QueryInterface<Interface>();
       if (ptr)
@@ -66,10 +98,10 @@ namespace ignition
     }
 
     /////////////////////////////////////////////////
-    template <class SpecInterface>
+    template <class... SpecInterfaces>
     template <class Interface>
     std::shared_ptr<const Interface>
-    SpecializedPlugin<SpecInterface>::QueryInterfaceSharedPtr() const
+    SpecializedPlugin<SpecInterfaces...>::QueryInterfaceSharedPtr() const
     {
       const Interface *ptr = this->QueryInterface<Interface>();
       if (ptr)
@@ -79,222 +111,208 @@ namespace ignition
     }
 
     /////////////////////////////////////////////////
-    template <class SpecInterface>
+    template <class... SpecInterfaces>
     template <class Interface>
-    bool SpecializedPlugin<SpecInterface>::HasInterface() const
+    bool SpecializedPlugin<SpecInterfaces...>::HasInterface() const
     {
-      return this->PrivateHasInterface(type<Interface>());
+      return this->template PrivateHasInterface<Interface>(
+            IsSpecialized<Interface>());
     }
 
     /////////////////////////////////////////////////
-    // This function is necessary for compilation, but COMPOSEPLUGIN_DISPATCH
-    // always seems to call the base Plugin class instead of this.
-    // So we will exclude it from code coverage.
-    // LCOV_EXCL_START
-    template <class SpecInterface>
+    template <class... SpecInterfaces>
+    template <class... Interfaces>
+    std::tuple<Interfaces*...>
+    SpecializedPlugin<SpecInterfaces...>::QueryInterfaces()
+    {
+      return this->template PrivateQueryInterfaceTuple<Interfaces...>(
+            AreSpecialized<Interfaces...>());
+    }
+
+    /////////////////////////////////////////////////
+    template <class... SpecInterfaces>
+    template <class... Interfaces>
+    std::tuple<const Interfaces*...>
+    SpecializedPlugin<SpecInterfaces...>::QueryInterfaces() const
+    {
+      return this->template PrivateQueryInterfaceTuple<Interfaces...>(
+            AreSpecialized<Interfaces...>());
+    }
+
+    /////////////////////////////////////////////////
+    template <class... SpecInterfaces>
+    template <class... Interfaces>
+    bool SpecializedPlugin<SpecInterfaces...>::HasInterfaces() const
+    {
+      return this->template PrivateHasInterfaces<Interfaces...>(
+            AreSpecialized<Interfaces...>());
+    }
+
+    /////////////////////////////////////////////////
+    template <class... SpecInterfaces>
     template <class Interface>
-    Interface *SpecializedPlugin<SpecInterface>::PrivateQueryInterface(
-        type<Interface>)
+    Interface *SpecializedPlugin<SpecInterfaces...>::PrivateQueryInterface(
+        std::false_type)
     {
-      return this->Plugin::QueryInterface<Interface>();
+      // This bypasses Plugin::QueryInterface so that the query is counted
+      // once, against the type of this pointer.
+      bool lookedUp = false;
+      Interface *const result = static_cast<Interface*>(
+            this->template PrivateQueryInterfaceInline<Interface>(
+              QueryStatsEnabled ? &lookedUp : nullptr));
+
+      detail::CountQuery<Interface, false, SpecInterfaces...>(
+            nullptr != result, lookedUp);
+      return result;
     }
-    // LCOV_EXCL_STOP
 
     /////////////////////////////////////////////////
-    template <class SpecInterface>
-    SpecInterface *SpecializedPlugin<SpecInterface>::PrivateQueryInterface(
-        type<SpecInterface>)
+    template <class... SpecInterfaces>
+    template <class Interface>
+    Interface *SpecializedPlugin<SpecInterfaces...>::PrivateQueryInterface(
+        std::true_type)
     {
       #ifdef IGNITION_UNITTEST_SPECIALIZED_PLUGIN_ACCESS
       usedSpecializedInterfaceAccess = true;
       #endif
-      return static_cast<SpecInterface*>(
-            this->privateSpecializedInterfaceIterator->second);
+      Interface *const result = static_cast<Interface*>(
+            this->privateSpecializedInterfaces[detail::SpecializationIndex<
+              Interface, SpecInterfaces...>::value]);
+
+      detail::CountQuery<Interface, true, SpecInterfaces...>(
+            nullptr != result, false);
+      return result;
     }
 
     /////////////////////////////////////////////////
-    template <class SpecInterface>
+    template <class... SpecInterfaces>
     template <class Interface>
-    const Interface *SpecializedPlugin<SpecInterface>::
-    PrivateQueryInterface(type<Interface>) const
+    const Interface *SpecializedPlugin<SpecInterfaces...>::
+    PrivateQueryInterface(std::false_type) const
     {
-      return this->Plugin::QueryInterface<Interface>();
+      bool lookedUp = false;
+      const Interface *const result = static_cast<const Interface*>(
+            this->template PrivateQueryInterfaceInline<Interface>(
+              QueryStatsEnabled ? &lookedUp : nullptr));
+
+      detail::CountQuery<Interface, false, SpecInterfaces...>(
+            nullptr != result, lookedUp);
+      return result;
     }
 
     /////////////////////////////////////////////////
-    template <class SpecInterface>
-    const SpecInterface *SpecializedPlugin<SpecInterface>::
-    PrivateQueryInterface(type<SpecInterface>) const
+    template <class... SpecInterfaces>
+    template <class Interface>
+    const Interface *SpecializedPlugin<SpecInterfaces...>::
+    PrivateQueryInterface(std::true_type) const
     {
       #ifdef IGNITION_UNITTEST_SPECIALIZED_PLUGIN_ACCESS
       usedSpecializedInterfaceAccess = true;
       #endif
-      return static_cast<SpecInterface*>(
-            this->privateSpecializedInterfaceIterator->second);
+      const Interface *const result = static_cast<const Interface*>(
+            this->privateSpecializedInterfaces[detail::SpecializationIndex<
+              Interface, SpecInterfaces...>::value]);
+
+      detail::CountQuery<Interface, true, SpecInterfaces...>(
+            nullptr != result, false);
+      return result;
     }
 
     /////////////////////////////////////////////////
-    template <class SpecInterface>
+    template <class... SpecInterfaces>
     template <class Interface>
-    bool SpecializedPlugin<SpecInterface>::PrivateHasInterface(
-        type<Interface>) const
+    bool SpecializedPlugin<SpecInterfaces...>::PrivateHasInterface(
+        std::false_type) const
     {
       return this->Plugin::HasInterface<Interface>();
     }
 
     /////////////////////////////////////////////////
-    template <class SpecInterface>
-    bool SpecializedPlugin<SpecInterface>::PrivateHasInterface(
-        type<SpecInterface>) const
+    template <class... SpecInterfaces>
+    template <class Interface>
+    bool SpecializedPlugin<SpecInterfaces...>::PrivateHasInterface(
+        std::true_type) const
     {
       #ifdef IGNITION_UNITTEST_SPECIALIZED_PLUGIN_ACCESS
       usedSpecializedInterfaceAccess = true;
       #endif
-      return (nullptr != this->privateSpecializedInterfaceIterator->second);
+      return (nullptr != this->privateSpecializedInterfaces[
+          detail::SpecializationIndex<Interface, SpecInterfaces...>::value]);
     }
 
     /////////////////////////////////////////////////
-    template <class SpecInterface>
-    SpecializedPlugin<SpecInterface>::SpecializedPlugin()
-      : privateSpecializedInterfaceIterator(
-          this->PrivateGetOrCreateIterator(
-            typeid(SpecInterface).name()))
+    template <class... SpecInterfaces>
+    template <class... Interfaces>
+    std::tuple<Interfaces*...> SpecializedPlugin<SpecInterfaces...>::
+    PrivateQueryInterfaceTuple(std::false_type)
     {
-      // Do nothing
+      return this->Plugin::QueryInterfaces<Interfaces...>();
     }
 
-    namespace detail
+    /////////////////////////////////////////////////
+    template <class... SpecInterfaces>
+    template <class... Interfaces>
+    std::tuple<Interfaces*...> SpecializedPlugin<SpecInterfaces...>::
+    PrivateQueryInterfaceTuple(std::true_type)
     {
-      /// \brief This template provides an implementation of
-      /// SelectSpecializerIfAvailable by having two template specializations
-      /// to choose between at compile time.
-      ///
-      /// If specialized is true, then this will provide the specializer for
-      /// Interface as `Specializer`.
-      template <typename Interface, bool specialized>
-      struct SelectSpecalizerIfAvailableImpl
-      {
-        using Specializer = SpecializedPlugin<Interface>;
-      };
-
-      /// \brief This template specialization will be invoked when
-      /// Specialization is not specialized for Interface, and therefore return
-      /// the generic Plugin type.
-      template <typename Interface>
-      struct SelectSpecalizerIfAvailableImpl<Interface, false>
-      {
-        using Specializer = Plugin;
-      };
+      return std::tuple<Interfaces*...>(
+            this->template PrivateQueryInterface<Interfaces>(
+              std::true_type())...);
+    }
 
-      /// \brief If Specialization contains a leaf specializer for Interface,
-      /// i.e. SpecializedPlugin<Interface>, then this will provide that type
-      /// under the name `Specializer`. Otherwise, this will simply provide the
-      /// generic Plugin type.
-      template <typename Interface, typename Specialization>
-      struct SelectSpecalizerIfAvailable
-      {
-        using Specializer = typename SelectSpecalizerIfAvailableImpl<Interface,
-            std::is_base_of<SpecializedPlugin<Interface>, Specialization>::value
-            >::Specializer;
-      };
+    /////////////////////////////////////////////////
+    template <class... SpecInterfaces>
+    template <class... Interfaces>
+    std::tuple<const Interfaces*...> SpecializedPlugin<SpecInterfaces...>::
+    PrivateQueryInterfaceTuple(std::false_type) const
+    {
+      return this->Plugin::QueryInterfaces<Interfaces...>();
+    }
 
-      /// \brief ComposePlugin provides a way for a multi-specialized Plugin
-      /// type to find its specializations within itself each time an
-      /// interface-querying function is called. The macro
-      /// DETAIL_IGN_PLUGIN_COMPOSEPLUGIN_DISPATCH accomplishes this for each
-      /// of the different functions by doing a compile-time check on whether
-      /// Base2 contains the specialization, and then picks Base1 if it does
-      /// not.
-      template <class Base1, class Base2>
-      class ComposePlugin : public virtual Base1, public virtual Base2
-      {
-        /// \brief Default destructor
-        public: virtual ~ComposePlugin() = default;
-
-        // Inherit function overloads
-        using Plugin::QueryInterface;
-        using Plugin::QueryInterfaceSharedPtr;
-        using Plugin::HasInterface;
-
-        // Used for template metaprogramming
-        using Specialization = ComposePlugin<Base1, Base2>;
-
-        /// \brief Implement functions whose only roles are to dispatch their
-        /// functionalities between two base classes, depending on which base is
-        /// specialized for the template type. This must only be called within
-        /// the ComposePlugin class.
-        ///
-        /// The dispatch is performed by casting this object to the type that
-        /// specializes for the requested Interface, if such a type is availabe
-        /// within its inheritance structure. Otherwise, we cast to the generic
-        /// Plugin type.
-#define DETAIL_IGN_PLUGIN_COMPOSEPLUGIN_DISPATCH( \
-                      ReturnType, Function, Suffix, CastTo, Args) \
-        public: \
-        template <class T> \
-        ReturnType Function Suffix \
-        { \
-          using Specializer = typename detail::SelectSpecalizerIfAvailable< \
-                  T, Specialization>::Specializer; \
-          return static_cast<CastTo*>(this)->template Function <T> Args; \
-        }
-
-
-        DETAIL_IGN_PLUGIN_COMPOSEPLUGIN_DISPATCH(
-            T*, QueryInterface, (), Specializer, ())
-
-        DETAIL_IGN_PLUGIN_COMPOSEPLUGIN_DISPATCH(
-            const T*, QueryInterface, () const, const Specializer, ())
-
-        DETAIL_IGN_PLUGIN_COMPOSEPLUGIN_DISPATCH(
-            std::shared_ptr<T>, QueryInterfaceSharedPtr, (), Specializer, ())
-
-        DETAIL_IGN_PLUGIN_COMPOSEPLUGIN_DISPATCH(
-            std::shared_ptr<const T>, QueryInterfaceSharedPtr,
-            () const, const Specializer, ())
-
-        DETAIL_IGN_PLUGIN_COMPOSEPLUGIN_DISPATCH(
-            bool, HasInterface, () const, const Specializer, ())
-
-
-        // Declare friendship
-        template <class...> friend class ignition::plugin::SpecializedPlugin;
-        template <class, class> friend class ComposePlugin;
-
-        private: ComposePlugin() = default;
-      };
+    /////////////////////////////////////////////////
+    template <class... SpecInterfaces>
+    template <class... Interfaces>
+    std::tuple<const Interfaces*...> SpecializedPlugin<SpecInterfaces...>::
+    PrivateQueryInterfaceTuple(std::true_type) const
+    {
+      return std::tuple<const Interfaces*...>(
+            this->template PrivateQueryInterface<Interfaces>(
+              std::true_type())...);
+    }
 
-      /// \brief This template specialization is used when Base1 and Base2 are
-      /// identical. It dodges a compilation error that occurs when a class
-      /// tries to double-inherit a direct base class.
-      template <class RepeatedBase>
-      class ComposePlugin<RepeatedBase, RepeatedBase>
-          : public virtual RepeatedBase { };  // NOLINT
+    /////////////////////////////////////////////////
+    template <class... SpecInterfaces>
+    template <class... Interfaces>
+    bool SpecializedPlugin<SpecInterfaces...>::PrivateHasInterfaces(
+        std::false_type) const
+    {
+      return this->Plugin::HasInterfaces<Interfaces...>();
     }
 
-    /// \brief Construct an unbalanced binary tree of specializations by
-    /// convoluting SpecializedPlugin types using ComposePlugin.
-    template <class SpecInterface1, class... OtherSpecInterfaces>
-    class SpecializedPlugin<SpecInterface1, OtherSpecInterfaces...> :
-        public virtual detail::ComposePlugin<
-          SpecializedPlugin<SpecInterface1>,
-          SpecializedPlugin<OtherSpecInterfaces...> >
+    /////////////////////////////////////////////////
+    template <class... SpecInterfaces>
+    template <class... Interfaces>
+    bool SpecializedPlugin<SpecInterfaces...>::PrivateHasInterfaces(
+        std::true_type) const
     {
-      // Declare friendship
-      template <class...> friend class SpecializedPlugin;
-      template <class, class> friend class detail::ComposePlugin;
-      template <class> friend class TemplatePluginPtr;
+      const bool present[] = {true,
+          this->template PrivateHasInterface<Interfaces>(std::true_type())...};
 
-      /// \brief Virtual destructor
-      public: virtual ~SpecializedPlugin() = default;
+      return std::all_of(std::begin(present), std::end(present),
+                         [](const bool _present) { return _present; });
+    }
 
-      /// \brief Default constructor
-      private: SpecializedPlugin() = default;
-    };
+    /////////////////////////////////////////////////
+    template <class... SpecInterfaces>
+    SpecializedPlugin<SpecInterfaces...>::SpecializedPlugin()
+    {
+      const detail::SpecializationTable &table =
+          detail::SpecializationTableOf<SpecInterfaces...>();
 
-    /// \brief Allow empty specializations of SpecializedPlugin
-    template <>
-    class SpecializedPlugin<> : public virtual Plugin { }; // NOLINT
+      this->privateSpecializedInterfaces = table.empty;
+      this->PrivateSetSpecializations(
+            &table, &this->privateSpecializedInterfaces);
+    }
   }
 }
 
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef IGNITION_PLUGIN_DETAIL_TRACE_HH_
+#define IGNITION_PLUGIN_DETAIL_TRACE_HH_
+
+#include <string_view>
+
+#include <ignition/plugin/Trace.hh>
+
+namespace ignition
+{
+  namespace plugin
+  {
+    namespace detail
+    {
+      /// \brief The kinds of trace events, using the phase letters of the
+      /// Chrome trace_event format
+      enum class TracePhase : char
+      {
+        BEGIN = 'B',
+        END = 'E'
+      };
+
+      /// \brief Record an event into the ring buffer of the calling thread.
+      /// \param[in] _phase
+      ///   Whether a span begins or ends
+      /// \param[in] _name
+      ///   The name of the span. This must be a string literal, because only
+      ///   the pointer is stored.
+      /// \param[in] _detail
+      ///   Extra information about the span, such as a library path or a
+      ///   plugin name. It is truncated to fit inside of the event.
+      void IGNITION_PLUGIN_VISIBLE RecordTraceEvent(
+          TracePhase _phase,
+          const char *_name,
+          std::string_view _detail);
+
+      /// \brief Records a BEGIN event when it is constructed and an END event
+      /// when it is destructed. Use IGN_PLUGIN_TRACE_SCOPE instead of using
+      /// this directly, so that it compiles away when tracing is disabled.
+      class TraceScope
+      {
+        /// \brief Constructor
+        /// \param[in] _name The name of the span, which must be a literal
+        /// \param[in] _detail Extra information about the span
+        public: TraceScope(const char *_name, std::string_view _detail)
+          : name(_name)
+        {
+          RecordTraceEvent(TracePhase::BEGIN, _name, _detail);
+        }
+
+        /// \brief Destructor
+        public: ~TraceScope()
+        {
+          RecordTraceEvent(TracePhase::END, this->name, {});
+        }
+
+        /// \brief The name of the span
+        private: const char *name;
+      };
+    }
+  }
+}
+
+#define IGN_PLUGIN_TRACE_CONCAT_IMPL(a, b) a ## b
+#define IGN_PLUGIN_TRACE_CONCAT(a, b) IGN_PLUGIN_TRACE_CONCAT_IMPL(a, b)
+
+#if IGNITION_PLUGIN_ENABLE_TRACING
+/// \brief Trace the rest of the enclosing scope as a span called _name, with
+/// _detail describing it. Neither argument is evaluated when tracing is
+/// disabled.
+#define IGN_PLUGIN_TRACE_SCOPE(_name, _detail) \
+  const ::ignition::plugin::detail::TraceScope \
+  IGN_PLUGIN_TRACE_CONCAT(ignPluginTraceScope, __LINE__)(_name, _detail)
+#else
+#define IGN_PLUGIN_TRACE_SCOPE(_name, _detail) static_cast<void>(0)
+#endif
+
+#endif
@@ -26,6 +26,9 @@ namespace ignition
 {
   namespace plugin
   {
+    // Forward declaration
+    template <typename, typename...> class Factory;
+
     namespace detail
     {
       //////////////////////////////////////////////////
@@ -40,6 +43,19 @@ namespace ignition
           : std::integral_constant<bool, std::is_const<To>::value>
       {
       };
+
+      //////////////////////////////////////////////////
+      /// \brief Detect whether Interface is a Factory<Product, Args...>
+      template <typename Interface>
+      struct IsFactory : std::false_type
+      {
+      };
+
+      //////////////////////////////////////////////////
+      template <typename Product, typename... Args>
+      struct IsFactory<Factory<Product, Args...>> : std::true_type
+      {
+      };
     }
   }
 }
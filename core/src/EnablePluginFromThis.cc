@@ -18,29 +18,25 @@
 #include <ignition/plugin/EnablePluginFromThis.hh>
 #include <ignition/plugin/WeakPluginPtr.hh>
 
+#include "PluginWithDlHandle.hh"
+
 namespace ignition
 {
   namespace plugin
   {
-    class EnablePluginFromThis::Implementation
-    {
-      public: WeakPluginPtr weak;
-    };
-
     EnablePluginFromThis::EnablePluginFromThis()
-      : pimpl(new Implementation())
     {
       // Do nothing
     }
 
     PluginPtr EnablePluginFromThis::PluginFromThis()
     {
-      return this->pimpl->weak.Lock();
+      return this->weak.Lock();
     }
 
     ConstPluginPtr EnablePluginFromThis::PluginFromThis() const
     {
-      return this->pimpl->weak.Lock();
+      return this->weak.Lock();
     }
 
     EnablePluginFromThis::~EnablePluginFromThis()
@@ -51,12 +47,17 @@ namespace ignition
     std::shared_ptr<void>
     EnablePluginFromThis::PluginInstancePtrFromThis() const
     {
-      return this->pimpl->weak.Lock()->PrivateGetInstancePtr();
+      const std::shared_ptr<PluginWithDlHandle> record =
+          this->weak.record.lock();
+      if (!record)
+        return nullptr;
+
+      return std::shared_ptr<void>(record, record->loadedInstance);
     }
 
     void EnablePluginFromThis::PrivateSetPluginFromThis(const PluginPtr &_ptr)
     {
-      this->pimpl->weak = _ptr;
+      this->weak = _ptr;
     }
   }
 }
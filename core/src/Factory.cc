@@ -17,10 +17,12 @@
 
 #include <memory>
 #include <mutex>
+#include <string>
 #include <thread>
 #include <vector>
 
 #include <ignition/plugin/Factory.hh>
+#include <ignition/plugin/Trace.hh>
 
 namespace
 {
@@ -85,6 +87,10 @@ namespace ignition
     {
       std::unique_lock<std::mutex> lock(lostProductManager.mutex);
 
+      IGN_PLUGIN_TRACE_SCOPE("CleanupLostProducts",
+          std::to_string(lostProductManager.lostProducts.size())
+          + " lost products");
+
       // In case any products are in-between handing off their factory reference
       // and exiting their destructor, wait for a short while so that the call
       // stack can fully exit the destructor before we unload its library.
@@ -29,6 +29,7 @@ namespace ignition
       demangledInterfaces.clear();
       factory = nullptr;
       deleter = nullptr;
+      capabilities = 0;
     }
   }
 }
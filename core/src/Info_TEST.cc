@@ -54,6 +54,10 @@ TEST(Info, Clear)
   info.aliases.insert("some alias");
   info.aliases.insert("another alias");
 
+  EXPECT_FALSE(info.HasCapability(
+                 ignition::plugin::Info::ENABLE_PLUGIN_FROM_THIS));
+  info.capabilities |= ignition::plugin::Info::ENABLE_PLUGIN_FROM_THIS;
+
   for (const auto &interfaceName : info.interfaces)
   {
     info.demangledInterfaces.insert(interfaceName.first);
@@ -65,6 +69,9 @@ TEST(Info, Clear)
   EXPECT_FALSE(info.demangledInterfaces.empty());
   EXPECT_TRUE(static_cast<bool>(info.factory));
   EXPECT_TRUE(static_cast<bool>(info.deleter));
+  EXPECT_TRUE(info.HasCapability(
+                ignition::plugin::Info::ENABLE_PLUGIN_FROM_THIS));
+  EXPECT_FALSE(info.HasCapability(ignition::plugin::Info::FACTORY));
 
   info.Clear();
 
@@ -74,6 +81,7 @@ TEST(Info, Clear)
   EXPECT_TRUE(info.demangledInterfaces.empty());
   EXPECT_FALSE(static_cast<bool>(info.factory));
   EXPECT_FALSE(static_cast<bool>(info.deleter));
+  EXPECT_EQ(0u, info.capabilities);
 }
 
 int main(int argc, char **argv)
@@ -22,105 +22,20 @@
 #include "ignition/plugin/Plugin.hh"
 #include "ignition/plugin/Info.hh"
 
+#include "PluginWithDlHandle.hh"
+
 namespace ignition
 {
   namespace plugin
   {
-    /// \brief Struct which wraps a plugin instance together with a
-    /// std::shared_ptr to its shared library handle. Instantiating plugin
-    /// instances into this struct ensures that the shared library will remain
-    /// loaded for as long as the plugin instance continues to exist.
-    struct PluginWithDlHandle
-    {
-      /// \brief Constructor
-      public: PluginWithDlHandle(
-        void *_loadedInstance,
-        const std::function<void(void*)> &_deleter,
-        const std::shared_ptr<void> &_dlHandlePtr)
-        : dlHandlePtr(_dlHandlePtr),
-          loadedInstance(_loadedInstance),
-          deleter(_deleter)
-      {
-        // Do nothing
-      }
-
-      /// \brief Destructor. We call the deleter on the loadedInstance while the
-      /// deleter and dlHandlePtr are still valid and available.
-      public: ~PluginWithDlHandle()
-      {
-        if (loadedInstance)
-        {
-          if (!deleter)
-          {
-            // LCOV_EXCL_START
-            std::cerr << "This plugin instance (" << loadedInstance
-                      << ") was not given a deleter. This should never happen! "
-                      << "Please report this bug!\n";
-            assert(false);
-            return;
-            // LCOV_EXCL_STOP
-          }
-
-          deleter(loadedInstance);
-        }
-        else
-        {
-          // LCOV_EXCL_START
-          std::cerr << "We have a nullptr plugin instance inside of a "
-                    << "PluginWithDlHandle. This should not be possible! "
-                    << "Please report this bug!\n";
-          assert(false);
-          return;
-          // LCOV_EXCL_STOP
-        }
-      }
-
-      /// \brief A reference counting handle for the shared library that this
-      /// plugin depends on.
-      ///
-      /// CRUCIAL DEV NOTE (MXG): `dlHandlePtr` MUST come BEFORE `deleter` in
-      /// this class definition to ensure that `deleter` gets deleted first
-      /// (member variables get destructed in the reverse order of their
-      /// appearance in the class definition). The destructor of `deleter`
-      /// depends on the shared library still being available, so this reference
-      /// counting handle must be destroyed after `deleter` to ensure that the
-      /// library is still loaded when `deleter` needs it.
-      ///
-      /// If you change this class definition for ANY reason, be sure to
-      /// maintain the ordering of these member variables.
-      public: std::shared_ptr<void> dlHandlePtr;
-
-      /// \brief Pointer to the plugin instance
-      public: void *loadedInstance;
-
-      /// \brief Deleter function for the plugin instance
-      ///
-      /// CRUCIAL DEV NOTE (MXG): `deleter` MUST come AFTER `dlHandlePtr` in
-      /// this class definition. See the comment on `dlHandlePtr` for an
-      /// explanation.
-      ///
-      /// If you change this class definition for ANY reason, be sure to
-      /// maintain the ordering of these member variables.
-      public: std::function<void(void*)> deleter;
-    };
-
     class Plugin::Implementation
     {
-      /// \brief Clear this object without invaliding any map entry
-      /// iterators.
+      /// \brief Clear this object, including the specialized interface slots.
       public: void Clear()
       {
         this->loadedInstancePtr.reset();
-        this->info.reset();
-
-        // Dev note (MXG): We must NOT call clear() on the InterfaceMap or
-        // remove ANY of the map entries, because that would potentially
-        // invalidate all of the iterators that are pointing to map entries.
-        // This would break any specialized plugins that provide instant access
-        // to specialized interfaces. Instead, we simply overwrite the map
-        // entries with a nullptr.
-        for (auto &entry : this->interfaces)
-          entry.second = nullptr;
+        this->record = nullptr;
+        this->RefreshInterfaces();
       }
 
       /// \brief Initialize this object by creating a new plugin instance from
@@ -137,8 +52,6 @@ namespace ignition
         if (!_info)
           return;
 
-        this->info = _info;
-
         if (!_dlHandlePtr)
         {
           // LCOV_EXCL_START
@@ -155,35 +68,28 @@ namespace ignition
         // exists.
         std::shared_ptr<PluginWithDlHandle> pluginWithDlHandle =
             std::make_shared<PluginWithDlHandle>(
-              _info->factory(), _info->deleter, _dlHandlePtr);
-
-        // Use the aliasing constructor of std::shared_ptr to disguise
-        // pluginWithDlHandle as just a simple std::shared_ptr<void> which
-        // points at the plugin instance, so we have the benefit of
-        // automatically managing the lifecycle of the dlHandlePtr without
-        // needing to actually keep track of it.
-        this->loadedInstancePtr =
-            std::shared_ptr<void>(
-              pluginWithDlHandle,
-              pluginWithDlHandle->loadedInstance);
+              _info->factory(), _info->deleter, _dlHandlePtr, _info);
 
+        // Fill in the interface table of the instance. This is the only time
+        // that the table gets written to, because nothing else can refer to
+        // the instance yet.
         for (const auto &entry : _info->interfaces)
         {
           // entry.first:  name of the interface
           // entry.second: function which casts the loadedInstance pointer to
           //               the correct location of the interface within the
           //               plugin
-          this->interfaces[entry.first] =
-              entry.second(this->loadedInstancePtr.get());
+          pluginWithDlHandle->interfaces[entry.first] =
+              entry.second(pluginWithDlHandle->loadedInstance);
         }
+
+        this->Share(pluginWithDlHandle);
       }
 
       /// \brief Initialize this object using another instance
       /// \param[in] _other Another instance of a Plugin::Implementation object
       public: void Copy(const Implementation *_other)
       {
-        this->Clear();
-
         if (!_other)
         {
           // LCOV_EXCL_START
@@ -197,100 +103,98 @@ namespace ignition
         }
 
         this->loadedInstancePtr = _other->loadedInstancePtr;
-        this->info = _other->info;
+        this->record = _other->record;
 
-        if (this->loadedInstancePtr)
+        // When both objects are the same kind of SpecializedPlugin, they can
+        // share the slots directly.
+        if (this->specializations
+            && this->specializations == _other->specializations)
         {
-          for (const auto &entry : _other->interfaces)
-          {
-            // entry.first:  name of the interface
-            // entry.second: pointer to the location of that interface within
-            //               the plugin instance
-            this->interfaces[entry.first] = entry.second;
-          }
+          *this->slots = *_other->slots;
+          return;
         }
+
+        this->RefreshInterfaces();
       }
 
-      /// \brief Initialize this object using another instance
-      /// \param[in] _info
-      ///   A reference to the plugin's Info
-      /// \param[in] _instance
-      ///   A reference to the plugin's abstact instance
-      public: void Copy(const ConstInfoPtr &_info,
-                        const std::shared_ptr<void> &_instance)
+      /// \brief Initialize this object using the record of an instance
+      /// \param[in] _record
+      ///   A reference to the record of the plugin instance. This may be a
+      ///   nullptr, in which case this object will be cleared.
+      public: void Share(const std::shared_ptr<PluginWithDlHandle> &_record)
       {
-        this->loadedInstancePtr = _instance;
-        this->info = _info;
-
-        if (this->loadedInstancePtr)
+        if (!_record)
         {
-          if (!this->info)
-          {
-            // LCOV_EXCL_START
-            std::cerr << "[Plugin::Implementation::Copy(_info, _instance)] A "
-                      << "Plugin has been copied from its info and instance, "
-                      << "but the info was null even though the instance was "
-                      << "valid. This should never happen! Please report this "
-                      << "bug!" << std::endl;
-            assert(false);
-            return;
-            // LCOV_EXCL_STOP
-          }
-
-          // We need to construct the interface map for this Plugin
-          for (const auto &entry : this->info->interfaces)
-          {
-            // entry.first:  name of the interface
-            // entry.second: function which casts the loadedInstance pointer to
-            //               the correct location of the interface within the
-            //               plugin
-            this->interfaces[entry.first] =
-                entry.second(this->loadedInstancePtr.get());
-          }
+          this->Clear();
+          return;
         }
+
+        // Use the aliasing constructor of std::shared_ptr to disguise the
+        // record as just a simple std::shared_ptr<void> which points at the
+        // plugin instance, so we have the benefit of automatically managing
+        // the lifecycle of the record without needing to actually keep track
+        // of it.
+        this->loadedInstancePtr =
+            std::shared_ptr<void>(_record, _record->loadedInstance);
+        this->record = _record.get();
+        this->RefreshInterfaces();
       }
 
-      /// \brief Map from interface names to their locations within the plugin
-      /// instance
-      //
-      // Dev Note (MXG): We use std::map here instead of std::unordered_map
-      // because iterators to a std::map are not invalidated by the insertion
-      // operation (whereas all iterators to a std::unordered_map are
-      // potentially invalidated each time an insertion is performed on the
-      // std::unordered_map). Holding onto valid iterators allows us to do
-      // optimizations with template magic to provide direct access to
-      // interfaces whose availability we can anticipate at run time.
-      //
-      // It is also worth noting that ordered vs unordered lookup time is very
-      // similar on sets where the strings have relatively small lengths (5-20
-      // characters) and a relatively small number of entries in the set (5-20
-      // entries). Those conditions match our expected use case here. In fact,
-      // ordered lookup can sometimes outperform unordered in these conditions.
-      public: Plugin::InterfaceMap interfaces;
-
-      /// \brief shared_ptr which manages the lifecycle of the plugin instance.
-      ///
-      /// CRUCIAL DEV NOTE (MXG): `loadedInstancePtr` must come BEFORE `info` in
-      /// this class definition to ensure that `info` gets deleted first (member
-      /// variables get destructed in the reverse order of their appearance in
-      /// the class definition). The destructor of `info` depends on the shared
-      /// library still being available, so this reference counting handle must
-      /// be destroyed after `info` to ensure that the library is still loaded
-      /// when `info` needs it.
-      ///
-      /// If you change this class definition for ANY reason, be sure to
-      /// maintain the ordering of these member variables.
+      /// \brief Point the specialized interface slots, if there are any, at
+      /// the interfaces of the current record. The record resolves them once
+      /// per SpecializedPlugin type and shares them from then on.
+      public: void RefreshInterfaces()
+      {
+        if (!this->specializations)
+          return;
+
+        *this->slots = this->Specialize(this->specializations);
+      }
+
+      /// \brief Find the interfaces of _table in the current record
+      /// \param[in] _table The interfaces to find
+      /// \return An array with one entry per interface of _table
+      public: void *const *Specialize(
+          const detail::SpecializationTable *_table) const
+      {
+        if (!this->record || 0 == _table->count)
+          return _table->empty;
+
+        return this->record->Specialize(_table);
+      }
+
+      /// \brief Find an interface in the table of the current record
+      /// \param[in] _interfaceName The mangled name of the interface
+      /// \return A pointer to the interface, or a nullptr if the interface is
+      /// not available.
+      public: void *Find(const std::string &_interfaceName) const
+      {
+        if (!this->record)
+          return nullptr;
+
+        const auto it = this->record->interfaces.find(_interfaceName);
+        if (this->record->interfaces.end() == it)
+          return nullptr;
+
+        return it->second;
+      }
+
+      /// \brief The interfaces that are anticipated by the SpecializedPlugin
+      /// which owns this object, or a nullptr if it is not specialized.
+      public: const detail::SpecializationTable *specializations = nullptr;
+
+      /// \brief Where the SpecializedPlugin which owns this object looks for
+      /// its array of anticipated interfaces.
+      public: void *const **slots = nullptr;
+
+      /// \brief shared_ptr which manages the lifecycle of the plugin instance
+      /// and of its record.
       public: std::shared_ptr<void> loadedInstancePtr;
 
-      /// \brief A copy of the Info that was used to create the Plugin
-      ///
-      /// CRUCIAL DEV NOTE (MXG): `info` must come AFTER `loadedInstancePtr` in
-      /// this class definition. See the comment on `loadedInstancePtr` for an
-      /// explanation.
-      ///
-      /// If you change this class definition for ANY reason, be sure to
-      /// maintain the ordering of these member variables.
-      public: ConstInfoPtr info;
+      /// \brief The record of the plugin instance. This is kept alive by
+      /// loadedInstancePtr, either directly or through a holder which shares
+      /// ownership of the record.
+      public: PluginWithDlHandle *record = nullptr;
     };
 
     //////////////////////////////////////////////////
@@ -298,21 +202,23 @@ namespace ignition
         const std::string &_interfaceName,
         const bool _demangled) const
     {
-      const ConstInfoPtr &info = this->dataPtr->info;
-      if (!info)
+      const PluginWithDlHandle *record = this->dataPtr->record;
+      if (!record)
         return false;
 
       if (_demangled)
       {
-        return (info->demangledInterfaces.count(_interfaceName) != 0);
+        return (record->info->demangledInterfaces.count(_interfaceName) != 0);
       }
 
-      return (this->dataPtr->interfaces.count(_interfaceName) != 0);
+      return (record->interfaces.count(_interfaceName) != 0);
     }
 
     //////////////////////////////////////////////////
     Plugin::Plugin()
-      : dataPtr(new Implementation)
+      : dataPtr(new Implementation),
+        instanceMirror(nullptr),
+        infoMirror(nullptr)
     {
       // Do nothing
     }
@@ -321,25 +227,29 @@ namespace ignition
     void *Plugin::PrivateQueryInterface(
         const std::string &_interfaceName) const
     {
-      const auto &it = this->dataPtr->interfaces.find(_interfaceName);
-      if (this->dataPtr->interfaces.end() == it)
-        return nullptr;
+      return this->dataPtr->Find(_interfaceName);
+    }
 
-      return it->second;
+    //////////////////////////////////////////////////
+    void *const *Plugin::PrivateQueryInterfaces(
+        const detail::SpecializationTable *_table) const
+    {
+      return this->dataPtr->Specialize(_table);
     }
 
     //////////////////////////////////////////////////
     void Plugin::PrivateCopyPluginInstance(const Plugin &_other) const
     {
       this->dataPtr->Copy(_other.dataPtr.get());
+      this->PrivateUpdateMirrors();
     }
 
     //////////////////////////////////////////////////
     void Plugin::PrivateCopyPluginInstance(
-        const ConstInfoPtr &_info,
-        const std::shared_ptr<void> &_instancePtr) const
+        const std::shared_ptr<PluginWithDlHandle> &_record) const
     {
-      this->dataPtr->Copy(_info, _instancePtr);
+      this->dataPtr->Share(_record);
+      this->PrivateUpdateMirrors();
     }
 
     //////////////////////////////////////////////////
@@ -348,6 +258,15 @@ namespace ignition
         const std::shared_ptr<void> &_dlHandlePtr) const
     {
       this->dataPtr->Create(_info, _dlHandlePtr);
+      this->PrivateUpdateMirrors();
+    }
+
+    //////////////////////////////////////////////////
+    void Plugin::PrivateUpdateMirrors() const
+    {
+      const PluginWithDlHandle *record = this->dataPtr->record;
+      this->instanceMirror = record ? record->loadedInstance : nullptr;
+      this->infoMirror = record ? record->info.get() : nullptr;
     }
 
     //////////////////////////////////////////////////
@@ -359,17 +278,31 @@ namespace ignition
     //////////////////////////////////////////////////
     const ConstInfoPtr &Plugin::PrivateGetInfoPtr() const
     {
-      return this->dataPtr->info;
+      static const ConstInfoPtr noInfo;
+      if (!this->dataPtr->record)
+        return noInfo;
+
+      return this->dataPtr->record->info;
+    }
+
+    //////////////////////////////////////////////////
+    std::shared_ptr<PluginWithDlHandle> Plugin::PrivateGetRecordPtr() const
+    {
+      if (!this->dataPtr->record)
+        return nullptr;
+
+      return std::shared_ptr<PluginWithDlHandle>(
+            this->dataPtr->loadedInstancePtr, this->dataPtr->record);
     }
 
     //////////////////////////////////////////////////
-    Plugin::InterfaceMap::iterator Plugin::PrivateGetOrCreateIterator(
-        const std::string &_interfaceName)
+    void Plugin::PrivateSetSpecializations(
+        const detail::SpecializationTable *_table,
+        void *const **_slots) const
     {
-      // We want to use the insert function here to avoid accidentally
-      // overwriting a value which might exist at the desired map key.
-      return this->dataPtr->interfaces.insert(
-            std::make_pair(_interfaceName, nullptr)).first;
+      this->dataPtr->specializations = _table;
+      this->dataPtr->slots = _slots;
+      this->dataPtr->RefreshInterfaces();
     }
 
     //////////////////////////////////////////////////
@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2017 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+#ifndef IGNITION_PLUGIN_SRC_PLUGINWITHDLHANDLE_HH_
+#define IGNITION_PLUGIN_SRC_PLUGINWITHDLHANDLE_HH_
+
+#include <atomic>
+#include <cassert>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string_view>
+
+#include "ignition/plugin/Info.hh"
+#include "ignition/plugin/Plugin.hh"
+#include "ignition/plugin/Trace.hh"
+
+namespace ignition
+{
+  namespace plugin
+  {
+    /// \brief Struct which wraps a plugin instance together with a
+    /// std::shared_ptr to its shared library handle. Instantiating plugin
+    /// instances into this struct ensures that the shared library will remain
+    /// loaded for as long as the plugin instance continues to exist.
+    ///
+    /// Each plugin instance has exactly one of these records. It also holds
+    /// the Info of the plugin and the table of interface locations within the
+    /// instance, which are both filled in once when the instance is created
+    /// and never modified afterwards. Every PluginPtr and WeakPluginPtr which
+    /// refers to the instance shares this record, so copying or locking them
+    /// does not need to do any per-interface work.
+    struct PluginWithDlHandle
+    {
+      /// \brief The interfaces of this instance which are anticipated by one
+      /// SpecializedPlugin type, in the order that the type expects them.
+      public: struct Specialization
+      {
+        /// \brief The SpecializedPlugin type that this was resolved for
+        public: const detail::SpecializationTable *table;
+
+        /// \brief Pointers to the interfaces, or nullptrs for interfaces that
+        /// the instance does not provide
+        public: std::unique_ptr<void*[]> slots;
+
+        /// \brief The next Specialization of this instance
+        public: Specialization *next;
+      };
+
+      /// \brief Constructor
+      public: PluginWithDlHandle(
+        void *_loadedInstance,
+        const std::function<void(void*)> &_deleter,
+        const std::shared_ptr<void> &_dlHandlePtr,
+        const ConstInfoPtr &_info)
+        : dlHandlePtr(_dlHandlePtr),
+          info(_info),
+          loadedInstance(_loadedInstance),
+          deleter(_deleter)
+      {
+        // Do nothing
+      }
+
+      /// \brief Destructor. We call the deleter on the loadedInstance while the
+      /// deleter and dlHandlePtr are still valid and available.
+      public: ~PluginWithDlHandle()
+      {
+        IGN_PLUGIN_TRACE_SCOPE("DestroyPlugin", this->info ?
+              std::string_view(this->info->name) : std::string_view());
+
+        Specialization *spec = this->specializations.load();
+        while (spec)
+        {
+          Specialization *const next = spec->next;
+          delete spec;
+          spec = next;
+        }
+
+        if (loadedInstance)
+        {
+          if (!deleter)
+          {
+            // LCOV_EXCL_START
+            std::cerr << "This plugin instance (" << loadedInstance
+                      << ") was not given a deleter. This should never happen! "
+                      << "Please report this bug!\n";
+            assert(false);
+            return;
+            // LCOV_EXCL_STOP
+          }
+
+          deleter(loadedInstance);
+        }
+        else
+        {
+          // LCOV_EXCL_START
+          std::cerr << "We have a nullptr plugin instance inside of a "
+                    << "PluginWithDlHandle. This should not be possible! "
+                    << "Please report this bug!\n";
+          assert(false);
+          return;
+          // LCOV_EXCL_STOP
+        }
+      }
+
+      /// \brief Get the interfaces of this instance which are anticipated by
+      /// _table. They are resolved with a single pass over `interfaces` the
+      /// first time that _table is used with this instance, and are shared
+      /// from then on.
+      /// \param[in] _table
+      ///   The interfaces anticipated by a SpecializedPlugin type
+      /// \return An array with one entry per interface of _table, which
+      /// remains valid for as long as this record exists.
+      public: void *const *Specialize(const detail::SpecializationTable *_table)
+      {
+        Specialization *head = this->specializations.load();
+        for (Specialization *spec = head; spec; spec = spec->next)
+        {
+          if (spec->table == _table)
+            return spec->slots.get();
+        }
+
+        // Walk the sorted names of the specialization alongside the sorted
+        // interface table of this instance.
+        std::unique_ptr<Specialization> created(new Specialization);
+        created->table = _table;
+        created->slots.reset(new void*[_table->count]);
+
+        auto it = this->interfaces.begin();
+        for (std::size_t i = 0; i < _table->count; ++i)
+        {
+          const std::size_t slot = _table->order[i];
+          const char *name = _table->names[slot];
+
+          int cmp = 1;
+          while (this->interfaces.end() != it
+                 && (cmp = it->first.compare(name)) < 0)
+            ++it;
+
+          created->slots[slot] =
+              (this->interfaces.end() != it && 0 == cmp) ? it->second : nullptr;
+        }
+
+        // Publish the new Specialization. If other threads published some in
+        // the meantime, check whether any of them was for the same table.
+        Specialization *seen = head;
+        created->next = head;
+        while (!this->specializations.compare_exchange_weak(
+                 created->next, created.get()))
+        {
+          for (Specialization *spec = created->next; spec != seen;
+               spec = spec->next)
+          {
+            if (spec->table == _table)
+              return spec->slots.get();
+          }
+
+          seen = created->next;
+        }
+
+        return created.release()->slots.get();
+      }
+
+      /// \brief A reference counting handle for the shared library that this
+      /// plugin depends on.
+      ///
+      /// CRUCIAL DEV NOTE (MXG): `dlHandlePtr` MUST come BEFORE `deleter` in
+      /// this class definition to ensure that `deleter` gets deleted first
+      /// (member variables get destructed in the reverse order of their
+      /// appearance in the class definition). The destructor of `deleter`
+      /// depends on the shared library still being available, so this reference
+      /// counting handle must be destroyed after `deleter` to ensure that the
+      /// library is still loaded when `deleter` needs it.
+      ///
+      /// If you change this class definition for ANY reason, be sure to
+      /// maintain the ordering of these member variables.
+      public: std::shared_ptr<void> dlHandlePtr;
+
+      /// \brief The Info that was used to create the plugin instance.
+      ///
+      /// CRUCIAL DEV NOTE: `info` must come AFTER `dlHandlePtr` in this
+      /// class definition. The destructor of `info` depends on the shared
+      /// library still being available. See the comment on `dlHandlePtr`.
+      public: ConstInfoPtr info;
+
+      /// \brief Map from interface names to their locations within the plugin
+      /// instance. This gets filled in right after the instance is created.
+      public: Plugin::InterfaceMap interfaces;
+
+      /// \brief The interfaces of this instance which have been resolved for
+      /// each SpecializedPlugin type that has viewed it
+      public: std::atomic<Specialization*> specializations{nullptr};
+
+      /// \brief Pointer to the plugin instance
+      public: void *loadedInstance;
+
+      /// \brief Deleter function for the plugin instance
+      ///
+      /// CRUCIAL DEV NOTE (MXG): `deleter` MUST come AFTER `dlHandlePtr` in
+      /// this class definition. See the comment on `dlHandlePtr` for an
+      /// explanation.
+      ///
+      /// If you change this class definition for ANY reason, be sure to
+      /// maintain the ordering of these member variables.
+      public: std::function<void(void*)> deleter;
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,291 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <ignition/plugin/QueryStats.hh>
+#include <ignition/plugin/utility.hh>
+
+namespace
+{
+  /// \brief A counter together with the names that it was registered with
+  struct QueryEntry
+  {
+    /// \brief The mangled name of the interface
+    public: std::string interface;
+
+    /// \brief The mangled names of the interfaces of the pointer type
+    public: std::vector<std::string> pointerInterfaces;
+
+    /// \brief Whether the pointer type is specialized for the interface
+    public: bool specialized;
+
+    /// \brief The counter that the call sites update
+    public: std::unique_ptr<ignition::plugin::detail::QueryCounter> counter;
+  };
+
+  /// \brief Every counter which has been registered
+  struct QueryRegistry
+  {
+    /// \brief Get the registry of this process. It is never destroyed,
+    /// because the call sites keep pointers to its counters.
+    /// \return The registry
+    public: static QueryRegistry &Instance()
+    {
+      static QueryRegistry *registry = new QueryRegistry;
+      return *registry;
+    }
+
+    /// \brief Protects the entries
+    public: std::mutex mutex;
+
+    /// \brief The entries, keyed by the name of the interface followed by
+    /// the names of the interfaces of the pointer type
+    public: std::map<std::vector<std::string>, QueryEntry> entries;
+  };
+
+  /////////////////////////////////////////////////
+  /// \brief Get the number of queries which were not specialized.
+  std::uint64_t Unspecialized(
+      const ignition::plugin::QueryStatistics &_stats)
+  {
+    return _stats.specialized ? 0 : _stats.hits + _stats.misses;
+  }
+
+  /////////////////////////////////////////////////
+  /// \brief Get the name of the plugin pointer type which is specialized for
+  /// some interfaces.
+  std::string PointerType(const std::vector<std::string> &_interfaces)
+  {
+    if (_interfaces.empty())
+      return "ignition::plugin::PluginPtr";
+
+    std::string name = "ignition::plugin::SpecializedPluginPtr<";
+    for (std::size_t i = 0; i < _interfaces.size(); ++i)
+    {
+      if (i > 0)
+        name += ", ";
+      name += _interfaces[i];
+    }
+    // Keep the closing brackets of nested templates apart
+    if ('>' == name.back())
+      name += ' ';
+    return name + '>';
+  }
+}
+
+namespace ignition
+{
+  namespace plugin
+  {
+    namespace detail
+    {
+      /////////////////////////////////////////////////
+      QueryCounter *RegisterQueryCounter(
+          const char *_interface,
+          const bool _specialized,
+          const char *const *_pointerInterfaces)
+      {
+        std::vector<std::string> key = {_interface};
+        for (; *_pointerInterfaces; ++_pointerInterfaces)
+          key.push_back(*_pointerInterfaces);
+
+        QueryRegistry &registry = QueryRegistry::Instance();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        QueryEntry &entry = registry.entries[key];
+        if (!entry.counter)
+        {
+          entry.interface = key.front();
+          entry.pointerInterfaces.assign(key.begin() + 1, key.end());
+          entry.specialized = _specialized;
+          entry.counter = std::make_unique<QueryCounter>();
+        }
+
+        return entry.counter.get();
+      }
+    }
+
+    /////////////////////////////////////////////////
+    std::vector<QueryStatistics> QueryStats()
+    {
+      std::vector<QueryStatistics> stats;
+      {
+        QueryRegistry &registry = QueryRegistry::Instance();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (const auto &item : registry.entries)
+        {
+          const QueryEntry &entry = item.second;
+
+          QueryStatistics query;
+          query.interface = entry.interface;
+          query.pointerInterfaces = entry.pointerInterfaces;
+          query.specialized = entry.specialized;
+          query.hits = entry.counter->hits.load(std::memory_order_relaxed);
+          query.misses =
+              entry.counter->misses.load(std::memory_order_relaxed);
+          query.lookups =
+              entry.counter->lookups.load(std::memory_order_relaxed);
+
+          if (query.hits + query.misses > 0)
+            stats.push_back(std::move(query));
+        }
+      }
+
+      // Demangle outside of the lock
+      for (QueryStatistics &query : stats)
+      {
+        query.interface = DemangleSymbol(query.interface);
+        for (std::string &name : query.pointerInterfaces)
+          name = DemangleSymbol(name);
+      }
+
+      std::sort(stats.begin(), stats.end(),
+                [](const QueryStatistics &_a, const QueryStatistics &_b)
+      {
+        return std::make_tuple(Unspecialized(_b), _b.hits + _b.misses,
+                               std::cref(_a.interface),
+                               std::cref(_a.pointerInterfaces))
+            < std::make_tuple(Unspecialized(_a), _a.hits + _a.misses,
+                              std::cref(_b.interface),
+                              std::cref(_b.pointerInterfaces));
+      });
+
+      return stats;
+    }
+
+    /////////////////////////////////////////////////
+    void ResetQueryStats()
+    {
+      QueryRegistry &registry = QueryRegistry::Instance();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      for (auto &item : registry.entries)
+      {
+        detail::QueryCounter &counter = *item.second.counter;
+        counter.hits.store(0, std::memory_order_relaxed);
+        counter.misses.store(0, std::memory_order_relaxed);
+        counter.lookups.store(0, std::memory_order_relaxed);
+      }
+    }
+
+    /////////////////////////////////////////////////
+    std::vector<SpecializationAdvice> AdviseSpecializations(
+        const std::size_t _maxInterfaces)
+    {
+      std::vector<SpecializationAdvice> advice;
+      if (0 == _maxInterfaces)
+        return advice;
+
+      // QueryStats() is already ranked, so the interfaces of each pointer
+      // type are visited from the most queried to the least.
+      std::map<std::vector<std::string>, std::size_t> adviceOfPointer;
+      for (const QueryStatistics &query : QueryStats())
+      {
+        const std::uint64_t count = Unspecialized(query);
+        if (0 == count)
+          continue;
+
+        const auto inserted = adviceOfPointer.insert(
+              std::make_pair(query.pointerInterfaces, advice.size()));
+        if (inserted.second)
+        {
+          advice.emplace_back();
+          advice.back().pointerType = PointerType(query.pointerInterfaces);
+        }
+
+        SpecializationAdvice &pointer = advice[inserted.first->second];
+        if (pointer.interfaces.size() >= _maxInterfaces)
+          continue;
+
+        pointer.interfaces.push_back(query.interface);
+        pointer.unspecializedQueries += count;
+      }
+
+      for (auto &item : adviceOfPointer)
+      {
+        SpecializationAdvice &pointer = advice[item.second];
+        std::vector<std::string> interfaces = item.first;
+        interfaces.insert(interfaces.end(),
+                          pointer.interfaces.begin(),
+                          pointer.interfaces.end());
+        pointer.suggestedType = PointerType(interfaces);
+      }
+
+      std::stable_sort(advice.begin(), advice.end(),
+                       [](const SpecializationAdvice &_a,
+                          const SpecializationAdvice &_b)
+      {
+        return _a.unspecializedQueries > _b.unspecializedQueries;
+      });
+
+      return advice;
+    }
+
+    /////////////////////////////////////////////////
+    std::string SpecializationReport(const std::size_t _maxInterfaces)
+    {
+      const std::vector<QueryStatistics> stats = QueryStats();
+
+      std::stringstream ss;
+      if (stats.empty())
+      {
+        ss << "No interface queries have been counted.";
+        if (!QueryStatsEnabled)
+        {
+          ss << " Build with the IGN_PLUGIN_ENABLE_QUERY_STATS option to "
+             << "count them.";
+        }
+        ss << "\n";
+        return ss.str();
+      }
+
+      ss << "Interface queries, by unspecialized queries:\n";
+      for (const QueryStatistics &query : stats)
+      {
+        ss << "  " << query.interface << "\n"
+           << "    through " << PointerType(query.pointerInterfaces)
+           << (query.specialized ? " (specialized)" : "") << "\n"
+           << "    hits: " << query.hits
+           << ", misses: " << query.misses
+           << ", lookups: " << query.lookups << "\n";
+      }
+
+      const std::vector<SpecializationAdvice> advice =
+          AdviseSpecializations(_maxInterfaces);
+      if (advice.empty())
+        return ss.str();
+
+      ss << "Suggested plugin pointer types:\n";
+      for (const SpecializationAdvice &pointer : advice)
+      {
+        ss << "  " << pointer.pointerType << "\n"
+           << "    -> " << pointer.suggestedType << "\n"
+           << "    would specialize " << pointer.unspecializedQueries
+           << " queries\n";
+      }
+
+      return ss.str();
+    }
+  }
+}
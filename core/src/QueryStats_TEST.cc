@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include <ignition/plugin/QueryStats.hh>
+
+namespace test
+{
+  struct Hot { };
+  struct Warm { };
+  struct Cold { };
+  struct Specialized { };
+}
+
+using ignition::plugin::detail::QueryCounter;
+using ignition::plugin::detail::RegisterQueryCounter;
+
+/////////////////////////////////////////////////
+QueryCounter *Counter(
+    const std::type_info &_interface,
+    const bool _specialized,
+    const std::vector<const char*> &_pointerInterfaces)
+{
+  std::vector<const char*> names = _pointerInterfaces;
+  names.push_back(nullptr);
+  return RegisterQueryCounter(_interface.name(), _specialized, names.data());
+}
+
+/////////////////////////////////////////////////
+TEST(QueryStats, CountersAreShared)
+{
+  const char *specialized = typeid(test::Specialized).name();
+
+  QueryCounter *counter = Counter(typeid(test::Hot), false, {});
+  EXPECT_EQ(counter, Counter(typeid(test::Hot), false, {}));
+  EXPECT_NE(counter, Counter(typeid(test::Hot), false, {specialized}));
+  EXPECT_NE(counter, Counter(typeid(test::Warm), false, {}));
+}
+
+/////////////////////////////////////////////////
+TEST(QueryStats, RanksUnspecializedQueries)
+{
+  ignition::plugin::ResetQueryStats();
+  EXPECT_TRUE(ignition::plugin::QueryStats().empty());
+  EXPECT_TRUE(ignition::plugin::AdviseSpecializations().empty());
+  EXPECT_EQ(0u, ignition::plugin::SpecializationReport().find("No "));
+
+  const char *specialized = typeid(test::Specialized).name();
+
+  Counter(typeid(test::Hot), false, {})->hits += 100;
+  Counter(typeid(test::Hot), false, {})->lookups += 2;
+  Counter(typeid(test::Warm), false, {})->misses += 50;
+  Counter(typeid(test::Cold), false, {})->hits += 1;
+  Counter(typeid(test::Warm), false, {specialized})->hits += 20;
+  Counter(typeid(test::Specialized), true, {specialized})->hits += 1000;
+
+  const std::vector<ignition::plugin::QueryStatistics> stats =
+      ignition::plugin::QueryStats();
+  ASSERT_EQ(5u, stats.size());
+
+  EXPECT_EQ("test::Hot", stats[0].interface);
+  EXPECT_TRUE(stats[0].pointerInterfaces.empty());
+  EXPECT_FALSE(stats[0].specialized);
+  EXPECT_EQ(100u, stats[0].hits);
+  EXPECT_EQ(0u, stats[0].misses);
+  EXPECT_EQ(2u, stats[0].lookups);
+
+  EXPECT_EQ("test::Warm", stats[1].interface);
+  EXPECT_EQ(50u, stats[1].misses);
+
+  EXPECT_EQ("test::Warm", stats[2].interface);
+  EXPECT_EQ(std::vector<std::string>{"test::Specialized"},
+            stats[2].pointerInterfaces);
+
+  EXPECT_EQ("test::Cold", stats[3].interface);
+
+  // Specialized queries are ranked last, however many there are
+  EXPECT_EQ("test::Specialized", stats[4].interface);
+  EXPECT_TRUE(stats[4].specialized);
+  EXPECT_EQ(1000u, stats[4].hits);
+
+  const std::vector<ignition::plugin::SpecializationAdvice> advice =
+      ignition::plugin::AdviseSpecializations(2);
+  ASSERT_EQ(2u, advice.size());
+
+  EXPECT_EQ("ignition::plugin::PluginPtr", advice[0].pointerType);
+  EXPECT_EQ("ignition::plugin::SpecializedPluginPtr<test::Hot, test::Warm>",
+            advice[0].suggestedType);
+  EXPECT_EQ((std::vector<std::string>{"test::Hot", "test::Warm"}),
+            advice[0].interfaces);
+  EXPECT_EQ(150u, advice[0].unspecializedQueries);
+
+  EXPECT_EQ("ignition::plugin::SpecializedPluginPtr<test::Specialized>",
+            advice[1].pointerType);
+  EXPECT_EQ("ignition::plugin::SpecializedPluginPtr<"
+            "test::Specialized, test::Warm>",
+            advice[1].suggestedType);
+  EXPECT_EQ(20u, advice[1].unspecializedQueries);
+
+  const std::string report = ignition::plugin::SpecializationReport(2);
+  EXPECT_LT(report.find("test::Hot"), report.find("test::Cold"));
+  EXPECT_NE(std::string::npos, report.find(
+      "-> ignition::plugin::SpecializedPluginPtr<test::Hot, test::Warm>"));
+
+  ignition::plugin::ResetQueryStats();
+  EXPECT_TRUE(ignition::plugin::QueryStats().empty());
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
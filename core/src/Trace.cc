@@ -0,0 +1,350 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <locale>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include <ignition/plugin/Trace.hh>
+
+namespace
+{
+  /// \brief The number of words which hold the detail of an event
+  constexpr std::size_t DetailWords = 4;
+
+  /// \brief One trace event, as it is written out
+  struct TraceEvent
+  {
+    /// \brief Nanoseconds since the epoch of std::chrono::steady_clock
+    public: std::int64_t timestamp;
+
+    /// \brief The name of the span, which is a string literal
+    public: const char *name;
+
+    /// \brief The number of the thread which recorded the event
+    public: std::uint32_t thread;
+
+    /// \brief The TracePhase of the event
+    public: char phase;
+
+    /// \brief Null-terminated detail of the event
+    public: char detail[DetailWords * sizeof(std::uint64_t)];
+  };
+
+  /// \brief The slot of one event in a ring. It fills exactly one cache
+  /// line. The owner of the ring writes it as a sequence lock, and every
+  /// field is an atomic word, so a thread which copies the slot while it is
+  /// being overwritten reads a torn event instead of racing with the owner,
+  /// and the sequence number tells it to throw that event away.
+  struct alignas(64) TraceSlot
+  {
+    /// \brief One more than the index of the event in the slot, or 0 while
+    /// the slot is empty or being written
+    public: std::atomic<std::uint64_t> sequence{0};
+
+    /// \brief The timestamp of the event
+    public: std::atomic<std::int64_t> timestamp{0};
+
+    /// \brief The address of the name of the event
+    public: std::atomic<std::uintptr_t> name{0};
+
+    /// \brief The thread of the event, shifted left by 8 bits, combined
+    /// with its phase
+    public: std::atomic<std::uint64_t> threadAndPhase{0};
+
+    /// \brief The bytes of the null-terminated detail of the event
+    public: std::array<std::atomic<std::uint64_t>, DetailWords> detail{};
+  };
+
+  static_assert(sizeof(TraceSlot) == 64,
+                "A TraceSlot should fill exactly one cache line");
+
+  /// \brief The ring buffer of one thread. Only the owning thread writes to
+  /// it, so recording an event needs no lock and no read-modify-write.
+  struct TraceRing
+  {
+    /// \brief The events. Event i is stored in slot i % size.
+    public: std::array<TraceSlot, ignition::plugin::TraceEventsPerThread>
+        events;
+
+    /// \brief The index of the next event to record
+    public: std::atomic<std::uint64_t> head{0};
+
+    /// \brief The index of the first event that has not been cleared
+    public: std::atomic<std::uint64_t> tail{0};
+  };
+
+  /// \brief Every ring which has been created. Rings are never destroyed,
+  /// so that the events of threads which have exited can still be written
+  /// out. Instead, the ring of an exited thread is given to the next thread
+  /// which needs one.
+  struct TraceRegistry
+  {
+    /// \brief Get the registry of this process. It is never destroyed,
+    /// because threads may record events while the process exits.
+    /// \return The registry
+    public: static TraceRegistry &Instance()
+    {
+      static TraceRegistry *registry = new TraceRegistry;
+      return *registry;
+    }
+
+    /// \brief Protects the fields below
+    public: std::mutex mutex;
+
+    /// \brief Every ring
+    public: std::vector<std::unique_ptr<TraceRing>> rings;
+
+    /// \brief Rings whose threads have exited
+    public: std::vector<TraceRing*> unused;
+
+    /// \brief The number of the next thread which records an event
+    public: std::uint32_t nextThread = 1;
+  };
+
+  /// \brief The ring of the calling thread, which is returned to the
+  /// registry when the thread exits
+  struct ThreadTrace
+  {
+    /// \brief Constructor. Takes a ring from the registry.
+    public: ThreadTrace()
+    {
+      TraceRegistry &registry = TraceRegistry::Instance();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      this->thread = registry.nextThread++;
+      if (!registry.unused.empty())
+      {
+        this->ring = registry.unused.back();
+        registry.unused.pop_back();
+        return;
+      }
+
+      registry.rings.push_back(std::make_unique<TraceRing>());
+      this->ring = registry.rings.back().get();
+    }
+
+    /// \brief Destructor. Gives the ring back to the registry.
+    public: ~ThreadTrace()
+    {
+      TraceRegistry &registry = TraceRegistry::Instance();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      registry.unused.push_back(this->ring);
+    }
+
+    /// \brief The ring of this thread
+    public: TraceRing *ring;
+
+    /// \brief The number of this thread
+    public: std::uint32_t thread;
+  };
+
+  /////////////////////////////////////////////////
+  /// \brief Copy event _index out of its slot, unless the owner of the ring
+  /// has overwritten the slot or is in the middle of doing so.
+  /// \param[in] _slot The slot of the event
+  /// \param[in] _index The index of the event
+  /// \param[out] _event The event
+  /// \return True if _event holds a consistent copy of the event
+  bool ReadTraceEvent(
+      const TraceSlot &_slot,
+      const std::uint64_t _index,
+      TraceEvent &_event)
+  {
+    const std::uint64_t sequence =
+        _slot.sequence.load(std::memory_order_acquire);
+    if (sequence != _index + 1)
+      return false;
+
+    _event.timestamp = _slot.timestamp.load(std::memory_order_relaxed);
+    _event.name = reinterpret_cast<const char*>(
+          _slot.name.load(std::memory_order_relaxed));
+    const std::uint64_t threadAndPhase =
+        _slot.threadAndPhase.load(std::memory_order_relaxed);
+    _event.thread = static_cast<std::uint32_t>(threadAndPhase >> 8);
+    _event.phase = static_cast<char>(threadAndPhase & 0xFF);
+
+    std::uint64_t detail[DetailWords];
+    for (std::size_t i = 0; i < DetailWords; ++i)
+      detail[i] = _slot.detail[i].load(std::memory_order_relaxed);
+    std::memcpy(_event.detail, detail, sizeof(detail));
+
+    // The fields above may have been loaded from a newer event. If so, the
+    // owner started writing it before they were loaded, which means that the
+    // sequence number has changed by now.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return _slot.sequence.load(std::memory_order_relaxed) == sequence;
+  }
+
+  /////////////////////////////////////////////////
+  /// \brief Write _text as a quoted JSON string.
+  void WriteJsonString(std::ostream &_out, const char *_text)
+  {
+    _out << '"';
+    for (; *_text; ++_text)
+    {
+      const char c = *_text;
+      if ('"' == c || '\\' == c)
+        _out << '\\' << c;
+      else if (static_cast<unsigned char>(c) < 0x20)
+        _out << ' ';
+      else
+        _out << c;
+    }
+    _out << '"';
+  }
+}
+
+namespace ignition
+{
+  namespace plugin
+  {
+    namespace detail
+    {
+      /////////////////////////////////////////////////
+      void RecordTraceEvent(
+          const TracePhase _phase,
+          const char *_name,
+          const std::string_view _detail)
+      {
+        static thread_local ThreadTrace local;
+        TraceRing &ring = *local.ring;
+
+        const std::uint64_t index =
+            ring.head.load(std::memory_order_relaxed);
+        TraceSlot &slot = ring.events[index % TraceEventsPerThread];
+
+        // Mark the slot as being written before any field changes, so that
+        // readers which see a new field also see the slot change.
+        slot.sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        slot.timestamp.store(
+              std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count(),
+              std::memory_order_relaxed);
+        slot.name.store(reinterpret_cast<std::uintptr_t>(_name),
+                        std::memory_order_relaxed);
+        slot.threadAndPhase.store(
+              (static_cast<std::uint64_t>(local.thread) << 8) |
+              static_cast<unsigned char>(_phase),
+              std::memory_order_relaxed);
+
+        std::uint64_t detail[DetailWords] = {};
+        std::memcpy(detail, _detail.data(),
+                    std::min(_detail.size(), sizeof(detail) - 1));
+        for (std::size_t i = 0; i < DetailWords; ++i)
+          slot.detail[i].store(detail[i], std::memory_order_relaxed);
+
+        // Publish the event to the threads which write out the trace
+        slot.sequence.store(index + 1, std::memory_order_release);
+        ring.head.store(index + 1, std::memory_order_release);
+      }
+    }
+
+    /////////////////////////////////////////////////
+    void WriteChromeTrace(std::ostream &_out)
+    {
+      std::vector<TraceRing*> rings;
+      {
+        TraceRegistry &registry = TraceRegistry::Instance();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (const auto &ring : registry.rings)
+          rings.push_back(ring.get());
+      }
+
+#ifdef _WIN32
+      const int pid = _getpid();
+#else
+      const int pid = getpid();
+#endif
+
+      std::stringstream json;
+      json.imbue(std::locale::classic());
+      json << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+      const std::uint64_t size = TraceEventsPerThread;
+      bool first = true;
+      for (const TraceRing *ring : rings)
+      {
+        const std::uint64_t end = ring->head.load(std::memory_order_acquire);
+        const std::uint64_t begin = std::max(
+              ring->tail.load(std::memory_order_acquire),
+              end > size ? end - size : 0);
+
+        // The owner of the ring might overwrite the oldest events while
+        // they are being copied, in which case they are skipped.
+        TraceEvent event;
+        for (std::uint64_t i = begin; i < end; ++i)
+        {
+          if (!ReadTraceEvent(ring->events[i % size], i, event))
+            continue;
+
+          json << (first ? "" : ",") << "{\"name\":";
+          WriteJsonString(json, event.name);
+          json << ",\"cat\":\"ignition-plugin\",\"ph\":\"" << event.phase
+               << "\",\"pid\":" << pid << ",\"tid\":" << event.thread
+               << ",\"ts\":" << event.timestamp / 1000 << "."
+               << std::to_string(1000 + event.timestamp % 1000).substr(1);
+
+          if (event.detail[0] != '\0')
+          {
+            json << ",\"args\":{\"detail\":";
+            WriteJsonString(json, event.detail);
+            json << "}";
+          }
+
+          json << "}";
+          first = false;
+        }
+      }
+
+      json << "]}";
+      _out << json.str();
+    }
+
+    /////////////////////////////////////////////////
+    std::string ChromeTrace()
+    {
+      std::stringstream trace;
+      WriteChromeTrace(trace);
+      return trace.str();
+    }
+
+    /////////////////////////////////////////////////
+    void ClearTrace()
+    {
+      TraceRegistry &registry = TraceRegistry::Instance();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      for (const auto &ring : registry.rings)
+        ring->tail.store(ring->head.load(std::memory_order_acquire));
+    }
+  }
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include <ignition/plugin/Trace.hh>
+
+/////////////////////////////////////////////////
+std::size_t Count(const std::string &_text, const std::string &_pattern)
+{
+  std::size_t count = 0;
+  for (std::size_t pos = _text.find(_pattern); pos != std::string::npos;
+       pos = _text.find(_pattern, pos + 1))
+  {
+    ++count;
+  }
+  return count;
+}
+
+/////////////////////////////////////////////////
+TEST(Trace, ScopeRecordsBeginAndEnd)
+{
+  ignition::plugin::ClearTrace();
+  EXPECT_EQ("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[]}",
+            ignition::plugin::ChromeTrace());
+
+  {
+    ignition::plugin::detail::TraceScope outer("Outer", "some \"detail\"");
+    ignition::plugin::detail::TraceScope inner("Inner", "");
+  }
+
+  const std::string trace = ignition::plugin::ChromeTrace();
+  EXPECT_EQ(1u, Count(trace, "{\"name\":\"Outer\",\"cat\":\"ignition-plugin\","
+                             "\"ph\":\"B\""));
+  EXPECT_EQ(1u, Count(trace, "{\"name\":\"Outer\",\"cat\":\"ignition-plugin\","
+                             "\"ph\":\"E\""));
+  EXPECT_EQ(2u, Count(trace, "{\"name\":\"Inner\""));
+  EXPECT_EQ(1u, Count(trace, "\"args\":{\"detail\":\"some \\\"detail\\\"\"}"));
+
+  // The inner span closes before the outer one
+  EXPECT_LT(trace.find("\"name\":\"Inner\",\"cat\":\"ignition-plugin\","
+                       "\"ph\":\"E\""),
+            trace.rfind("\"name\":\"Outer\""));
+
+  ignition::plugin::ClearTrace();
+  EXPECT_EQ(0u, Count(ignition::plugin::ChromeTrace(), "\"name\""));
+}
+
+/////////////////////////////////////////////////
+TEST(Trace, RingKeepsNewestEvents)
+{
+  ignition::plugin::ClearTrace();
+
+  // Record from a new thread, so that its ring starts out empty
+  std::thread([]()
+  {
+    for (std::size_t i = 0; i < ignition::plugin::TraceEventsPerThread; ++i)
+      ignition::plugin::detail::TraceScope scope("Old", "");
+
+    ignition::plugin::detail::TraceScope scope("New", "");
+  }).join();
+
+  const std::string trace = ignition::plugin::ChromeTrace();
+  EXPECT_EQ(2u, Count(trace, "{\"name\":\"New\""));
+  EXPECT_EQ(ignition::plugin::TraceEventsPerThread - 2,
+            Count(trace, "{\"name\":\"Old\""));
+}
+
+/////////////////////////////////////////////////
+TEST(Trace, WriteWhileRecording)
+{
+  ignition::plugin::ClearTrace();
+
+  // Each event has a detail made of a single repeated letter, so a torn copy
+  // of an event would show up as a detail with two different letters.
+  const std::string a(31, 'a');
+  const std::string b(31, 'b');
+
+  std::atomic<bool> done{false};
+  std::thread recorder([&]()
+  {
+    for (std::size_t i = 0; !done; ++i)
+    {
+      ignition::plugin::detail::TraceScope scope(
+            "Busy", (i % 2) ? a : b);
+    }
+  });
+
+  for (std::size_t i = 0; i < 100; ++i)
+  {
+    const std::string trace = ignition::plugin::ChromeTrace();
+    EXPECT_EQ(Count(trace, "{\"name\":\"Busy\""),
+              Count(trace, "\"detail\":\"" + a + "\"") +
+              Count(trace, "\"detail\":\"" + b + "\"") +
+              Count(trace, "{\"name\":\"Busy\",\"cat\":\"ignition-plugin\","
+                           "\"ph\":\"E\""));
+  }
+
+  done = true;
+  recorder.join();
+}
+
+/////////////////////////////////////////////////
+TEST(Trace, MacroCompilesAway)
+{
+  ignition::plugin::ClearTrace();
+
+  bool evaluated = false;
+  {
+    IGN_PLUGIN_TRACE_SCOPE("Macro", (evaluated = true, "detail"));
+  }
+
+  EXPECT_EQ(ignition::plugin::TracingEnabled, evaluated);
+  EXPECT_EQ(ignition::plugin::TracingEnabled ? 2u : 0u,
+            Count(ignition::plugin::ChromeTrace(), "{\"name\":\"Macro\""));
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
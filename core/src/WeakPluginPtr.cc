@@ -17,84 +17,54 @@
 
 #include <ignition/plugin/WeakPluginPtr.hh>
 
+#include "PluginWithDlHandle.hh"
+
 namespace ignition
 {
   namespace plugin
   {
     /////////////////////////////////////////////////
-    class WeakPluginPtr::Implementation
-    {
-      public: std::weak_ptr<void> instance;
-      public: std::weak_ptr<const Info> info;
-    };
-
-    /////////////////////////////////////////////////
-    WeakPluginPtr::WeakPluginPtr()
-      : pimpl(new Implementation())
-    {
-      // Do nothing
-    }
+    WeakPluginPtr::WeakPluginPtr() = default;
 
     /////////////////////////////////////////////////
-    WeakPluginPtr::WeakPluginPtr(const WeakPluginPtr &_other)
-      : pimpl(new Implementation())
-    {
-      *this->pimpl = *_other.pimpl;
-    }
+    WeakPluginPtr::WeakPluginPtr(const WeakPluginPtr &_other) = default;
 
     /////////////////////////////////////////////////
-    WeakPluginPtr::WeakPluginPtr(WeakPluginPtr &&_other)
-      : pimpl(new Implementation())
-    {
-      this->pimpl = std::move(_other.pimpl);
-    }
+    WeakPluginPtr::WeakPluginPtr(WeakPluginPtr &&_other) = default;
 
     /////////////////////////////////////////////////
     WeakPluginPtr::WeakPluginPtr(const PluginPtr &_ptr)
-      : pimpl(new Implementation())
+      : record(_ptr->PrivateGetRecordPtr())
     {
-      *this = _ptr;
+      // Do nothing
     }
 
     /////////////////////////////////////////////////
-    WeakPluginPtr &WeakPluginPtr::operator=(const WeakPluginPtr &_other)
-    {
-      *this->pimpl = *_other.pimpl;
-      return *this;
-    }
+    WeakPluginPtr &WeakPluginPtr::operator=(
+        const WeakPluginPtr &_other) = default;
 
     /////////////////////////////////////////////////
-    WeakPluginPtr &WeakPluginPtr::operator=(WeakPluginPtr &&_other)
-    {
-      this->pimpl = std::move(_other.pimpl);
-      return *this;
-    }
+    WeakPluginPtr &WeakPluginPtr::operator=(WeakPluginPtr &&_other) = default;
 
     /////////////////////////////////////////////////
     WeakPluginPtr &WeakPluginPtr::operator=(const PluginPtr &_ptr)
     {
-      this->pimpl->instance = _ptr->PrivateGetInstancePtr();
-      this->pimpl->info = _ptr->PrivateGetInfoPtr();
+      this->record = _ptr->PrivateGetRecordPtr();
       return *this;
     }
 
     /////////////////////////////////////////////////
     PluginPtr WeakPluginPtr::Lock() const
     {
-      // CRUCIAL DEV NOTE (MXG): We must lock the instance before the info.
-      // We must never allow info to get deleted before the plugin instance,
-      // because otherwise the library might get unloaded before the info is
-      // destructed, but the Info's destructor depends on the library.
-      // TODO(MXG): Consider ways to make this less fragile.
-      std::shared_ptr<void> instance = this->pimpl->instance.lock();
-      ConstInfoPtr info = this->pimpl->info.lock();
-
+      // The record holds the Info of the plugin, so locking it also keeps the
+      // Info alive, and the record itself makes sure that the Info gets
+      // destructed before the library is unloaded.
       PluginPtr ptr;
       // NOTE(MXG): We do not want to make a PluginPtr constructor overload for
       // this, because its signature would be too easily confused with the
       // constructor that takes a ConstInfoPtr and a std::shared_ptr<void> to a
       // dl handle. Using an explicitly named function avoids any ambiguity.
-      ptr->PrivateCopyPluginInstance(info, instance);
+      ptr->PrivateCopyPluginInstance(this->record.lock());
 
       return ptr;
     }
@@ -102,21 +72,10 @@ namespace ignition
     /////////////////////////////////////////////////
     bool WeakPluginPtr::IsExpired() const
     {
-      // CRUCIAL DEV NOTE (MXG): We must lock the instance before the info.
-      // We must never allow info to get deleted before the plugin instance,
-      // because otherwise the library might get unloaded before the info is
-      // destructed, but the Info's destructor depends on the library.
-      // TODO(MXG): Consider ways to make this less fragile.
-      std::shared_ptr<void> instance = this->pimpl->instance.lock();
-      ConstInfoPtr info = this->pimpl->info.lock();
-
-      return !(instance && info);
+      return this->record.expired();
     }
 
     /////////////////////////////////////////////////
-    WeakPluginPtr::~WeakPluginPtr()
-    {
-      // Do nothing
-    }
+    WeakPluginPtr::~WeakPluginPtr() = default;
   }
 }
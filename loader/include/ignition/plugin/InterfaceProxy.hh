@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef IGNITION_PLUGIN_INTERFACEPROXY_HH_
+#define IGNITION_PLUGIN_INTERFACEPROXY_HH_
+
+#include <cstddef>
+
+namespace ignition
+{
+  namespace plugin
+  {
+    namespace detail
+    {
+      struct MethodCounters;
+    }
+
+    /// \brief Base class of a proxy which times every call to the methods of
+    /// an interface. A proxy derives from the interface, and each of its
+    /// methods forwards the call to the real instance with Forward(~), which
+    /// counts the call and records how long it took.
+    ///
+    /// Proxies live in the application, not in the plugin libraries, so
+    /// plugins do not need to be rebuilt to be timed. A proxy is written
+    /// once per interface and registered with IGNITION_ADD_INTERFACE_PROXY,
+    /// which names its methods in the order of the indices that are passed
+    /// to Forward(~):
+    ///
+    /// \code
+    /// class TimedSetter
+    ///   : public ignition::plugin::InterfaceProxy<MySetterInterface>
+    /// {
+    ///   public: using InterfaceProxy::InterfaceProxy;
+    ///
+    ///   public: void SetValue(const int _value) override
+    ///   {
+    ///     this->Forward(0, &MySetterInterface::SetValue, _value);
+    ///   }
+    ///
+    ///   public: int Value() const override
+    ///   {
+    ///     return this->Forward(1, &MySetterInterface::Value);
+    ///   }
+    /// };
+    ///
+    /// IGNITION_ADD_INTERFACE_PROXY(TimedSetter, "SetValue", "Value")
+    /// \endcode
+    ///
+    /// Once Loader::SetInterfaceProxies(true) has been called, every
+    /// instance that the Loader creates hands out a proxy, instead of the
+    /// plugin itself, for each interface which has a registered proxy. The
+    /// proxy is destroyed together with the instance. Use
+    /// Loader::MethodStats() to get the timings.
+    ///
+    /// Timing a call costs two reads of std::chrono::steady_clock and three
+    /// relaxed atomic additions, so the overhead is dominated by the cost of
+    /// reading the clock on the system. The interface_proxy performance test
+    /// measures both. Creating an instance while proxies are enabled also
+    /// creates its proxies, but nothing changes for instances which are
+    /// created while proxies are disabled.
+    ///
+    /// \tparam Interface The interface. It must be default-constructible.
+    template <typename Interface>
+    class InterfaceProxy : public Interface
+    {
+      /// \brief The interface that this proxy implements
+      public: using InterfaceType = Interface;
+
+      /// \brief Constructor. This is called by the Loader.
+      /// \param[in] _target
+      ///   The interface of the plugin instance that calls are forwarded to
+      /// \param[in] _counters
+      ///   The counters of the methods, one per method name that was given
+      ///   to IGNITION_ADD_INTERFACE_PROXY
+      /// \param[in] _methodCount
+      ///   The number of method names that were given to
+      ///   IGNITION_ADD_INTERFACE_PROXY
+      public: InterfaceProxy(
+          Interface *_target,
+          detail::MethodCounters *_counters,
+          std::size_t _methodCount);
+
+      /// \brief Get the interface of the plugin instance.
+      /// \return The interface that calls are forwarded to
+      protected: Interface *Target() const;
+
+      /// \brief Call a method of the plugin instance, and record how long the
+      /// call took.
+      /// \param[in] _method
+      ///   The index of the method in the list of names that was given to
+      ///   IGNITION_ADD_INTERFACE_PROXY. An index beyond the end of that list
+      ///   is a bug in the proxy; the call is still forwarded, but it is not
+      ///   timed.
+      /// \param[in] _function
+      ///   A pointer to the member function of the interface
+      /// \param[in] _args
+      ///   The arguments of the call
+      /// \return Whatever the method returns
+      protected: template <typename Function, typename... Args>
+      decltype(auto) Forward(
+          std::size_t _method,
+          Function _function,
+          Args&&... _args) const;
+
+      /// \brief The interface of the plugin instance
+      private: Interface *target;
+
+      /// \brief The counters of the methods
+      private: detail::MethodCounters *counters;
+
+      /// \brief The number of elements in counters
+      private: std::size_t methodCount;
+    };
+  }
+}
+
+/// \brief Register a proxy class which times the calls to the methods of
+/// an interface. Use this in a source file of the application, outside of
+/// any namespace, and give the fully qualified name of the proxy class. The
+/// remaining arguments are the names of the methods, in the order of the
+/// indices that the proxy passes to InterfaceProxy::Forward(~).
+///
+/// \sa InterfaceProxy
+#define IGNITION_ADD_INTERFACE_PROXY(ProxyClass, ...) \
+  DETAIL_IGNITION_ADD_INTERFACE_PROXY(ProxyClass, __VA_ARGS__)
+
+#include <ignition/plugin/detail/InterfaceProxy.hh>
+
+#endif
@@ -19,31 +19,279 @@
 #ifndef IGNITION_PLUGIN_LOADER_HH_
 #define IGNITION_PLUGIN_LOADER_HH_
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <set>
 #include <string>
+#include <string_view>
 #include <typeinfo>
 #include <unordered_set>
+#include <vector>
 
 #include <ignition/utilities/SuppressWarning.hh>
 
+#include <ignition/plugin/config.hh>
 #include <ignition/plugin/loader/Export.hh>
 #include <ignition/plugin/PluginPtr.hh>
 
+#ifndef IGNITION_PLUGIN_ENABLE_CONSTRUCTION_TIMING
+#define IGNITION_PLUGIN_ENABLE_CONSTRUCTION_TIMING 0
+#endif
+
 namespace ignition
 {
   namespace plugin
   {
+    /// \brief True if this build times the constructors of plugins. Timing
+    /// is turned on with the IGN_PLUGIN_ENABLE_CONSTRUCTION_TIMING CMake
+    /// option. When it is off, instances are still counted, but the clock is
+    /// never read and Loader::PluginStatistics::constructionTime stays zero.
+    constexpr bool ConstructionTimingEnabled =
+        (IGNITION_PLUGIN_ENABLE_CONSTRUCTION_TIMING != 0);
+
     /// \brief Class for loading plugins
     class IGNITION_PLUGIN_LOADER_VISIBLE Loader
     {
+      /// \brief The reasons that a plugin name or alias can fail to resolve
+      public: enum class LookupError
+      {
+        /// \brief The name or alias resolved to exactly one plugin
+        NONE = 0,
+
+        /// \brief No known plugin has that name or alias
+        NOT_FOUND,
+
+        /// \brief The alias refers to more than one plugin
+        AMBIGUOUS_ALIAS
+      };
+
+      /// \brief A function that receives the diagnostic messages of a Loader.
+      /// Each message is complete, and it ends with a newline.
+      public: using DiagnosticSink =
+          std::function<void(const std::string &_message)>;
+
+      /// \brief Describes one change to the set of plugins that a Loader
+      /// knows about.
+      public: struct Change
+      {
+        /// \brief The generation of the Loader after this change
+        public: std::uint64_t generation;
+
+        /// \brief Names of the plugins that were added
+        public: std::unordered_set<std::string> added;
+
+        /// \brief Names of the plugins that were removed
+        public: std::unordered_set<std::string> removed;
+      };
+
+      /// \brief A function that is told about each Change of a Loader
+      public: using ChangeCallback = std::function<void(const Change &_change)>;
+
+      /// \brief Statistics about the libraries that a Loader has unloaded
+      public: struct UnloadStatistics
+      {
+        /// \brief Number of libraries that have been closed
+        public: std::size_t unloaded = 0;
+
+        /// \brief Number of deferred unloads that were cancelled because the
+        /// library was loaded again during its grace period
+        public: std::size_t cancelled = 0;
+
+        /// \brief Number of libraries that are waiting for their grace
+        /// period to pass
+        public: std::size_t pending = 0;
+
+        /// \brief Total time that was spent closing libraries
+        public: std::chrono::nanoseconds totalUnloadTime{0};
+
+        /// \brief The longest time that was spent closing one library
+        public: std::chrono::nanoseconds maxUnloadTime{0};
+      };
+
+      /// \brief Time that a Loader spent loading one library, summed over
+      /// every time that the library was loaded
+      public: struct LibraryStatistics
+      {
+        /// \brief The path that the library was loaded from
+        public: std::string path;
+
+        /// \brief Number of times that the library was loaded or reloaded
+        public: std::size_t loads = 0;
+
+        /// \brief Time spent in dlopen
+        public: std::chrono::nanoseconds dlopenTime{0};
+
+        /// \brief Time spent calling the hook which provides the Info of
+        /// the plugins
+        public: std::chrono::nanoseconds hookTime{0};
+
+        /// \brief Time spent copying the Info out of the library and adding
+        /// it to the Loader, excluding demangleTime
+        public: std::chrono::nanoseconds importTime{0};
+
+        /// \brief Time spent demangling the names of plugins and interfaces
+        public: std::chrono::nanoseconds demangleTime{0};
+      };
+
+      /// \brief Counts of the instances of one plugin which were created by
+      /// a Loader. Instances stay counted after the plugin is forgotten.
+      public: struct PluginStatistics
+      {
+        /// \brief The name of the plugin
+        public: std::string name;
+
+        /// \brief The path of the library which most recently provided the
+        /// plugin
+        public: std::string library;
+
+        /// \brief Number of instances that have been created
+        public: std::uint64_t instantiated = 0;
+
+        /// \brief Number of instances that currently exist
+        public: std::uint64_t live = 0;
+
+        /// \brief Number of instances that have been destroyed
+        public: std::uint64_t destroyed = 0;
+
+        /// \brief Total time spent in the constructor of the plugin. This is
+        /// only measured if ConstructionTimingEnabled is true.
+        public: std::chrono::nanoseconds constructionTime{0};
+      };
+
+      /// \brief A range of memory which holds the code of a plugin library
+      public: struct AddressRange
+      {
+        /// \brief The address of the first byte of the range
+        public: std::uintptr_t begin = 0;
+
+        /// \brief The address one past the last byte of the range
+        public: std::uintptr_t end = 0;
+
+        /// \brief The path that the library was loaded from
+        public: std::string library;
+
+        /// \brief The sorted names of the plugins which the library provides
+        public: std::vector<std::string> plugins;
+
+        /// \brief The sorted, demangled names of the interfaces which those
+        /// plugins implement
+        public: std::vector<std::string> interfaces;
+      };
+
+      /// \brief Heap memory that was allocated by the code of one plugin,
+      /// as counted by the allocation tracker. \sa AllocationStats()
+      public: struct AllocationStatistics
+      {
+        /// \brief The path of the plugin library
+        public: std::string library;
+
+        /// \brief The name of the plugin, or empty for code of the library
+        /// that could not be attributed to one of its plugins
+        public: std::string plugin;
+
+        /// \brief Number of bytes that are currently allocated
+        public: std::uint64_t liveBytes = 0;
+
+        /// \brief Number of allocations that have not been freed yet
+        public: std::uint64_t liveAllocations = 0;
+
+        /// \brief Number of allocations that have been made
+        public: std::uint64_t allocations = 0;
+
+        /// \brief Number of bytes that have been allocated
+        public: std::uint64_t allocatedBytes = 0;
+
+        /// \brief Average number of bytes allocated per second since
+        /// allocation tracking started
+        public: double bytesPerSecond = 0.0;
+      };
+
+      /// \brief Timings of one method of an interface proxy.
+      /// \sa SetInterfaceProxies()
+      public: struct MethodStatistics
+      {
+        /// \brief The name of the plugin
+        public: std::string plugin;
+
+        /// \brief The demangled name of the interface
+        public: std::string interface;
+
+        /// \brief The name of the method
+        public: std::string method;
+
+        /// \brief Number of calls through the proxies of the plugin
+        public: std::uint64_t calls = 0;
+
+        /// \brief Total time spent in the calls
+        public: std::chrono::nanoseconds totalTime{0};
+
+        /// \brief Number of calls by latency. Entry 0 counts calls that took
+        /// no measurable time, entry i counts calls that took at least
+        /// 2^(i-1) and less than 2^i nanoseconds, and the last entry also
+        /// counts every call that took longer.
+        public: std::vector<std::uint64_t> latencyHistogram;
+      };
+
+      /// \brief Statistics about the libraries and plugins of a Loader
+      public: struct Statistics
+      {
+        /// \brief One entry per library, sorted by path
+        public: std::vector<LibraryStatistics> libraries;
+
+        /// \brief One entry per plugin, sorted by name
+        public: std::vector<PluginStatistics> plugins;
+      };
+
+      /// \brief Options which control how the dynamic linker loads a library
+      public: struct LoadOptions
+      {
+        /// \brief Resolve every symbol of the library while it is being
+        /// loaded (RTLD_NOW), instead of the first time that each function
+        /// is called (RTLD_LAZY). This moves the cost of symbol binding out
+        /// of the first call of each plugin method.
+        public: bool bindNow = false;
+
+        /// \brief Make the symbols of the library available for resolving
+        /// the symbols of libraries that are loaded later (RTLD_GLOBAL).
+        public: bool global = false;
+
+        /// \brief Prefer the symbols of the library (and its dependencies)
+        /// over global symbols with the same names (RTLD_DEEPBIND). This is
+        /// only available with glibc, and it is ignored elsewhere. It cannot
+        /// be used while heap allocations are tracked (see
+        /// TrackAllocations.hh), since the library would not use the
+        /// tracking operator new and operator delete, so LoadLib(~) refuses
+        /// to load the library instead.
+        public: bool deepBind = false;
+
+        /// \brief Never unload the library, even after it has been released
+        /// (RTLD_NODELETE).
+        public: bool noDelete = false;
+
+        /// \brief Ask the kernel to read the pages of the library ahead
+        /// (MADV_WILLNEED) and touch each of them once it has been loaded,
+        /// so that the first call of each plugin method does not page fault.
+        /// This is only available on Linux, and it is ignored elsewhere.
+        public: bool prefault = false;
+      };
+
+      /// \brief A function that is told when an old version of a reloaded
+      /// library has been unloaded
+      public: using DrainCallback =
+          std::function<void(const std::string &_pathToLibrary)>;
+
       /// \brief Constructor
       public: Loader();
 
       /// \brief Destructor
       public: ~Loader();
 
-      /// \brief Makes a printable string with info about plugins
+      /// \brief Makes a printable string with info about plugins. If heap
+      /// allocations are being tracked, it also lists the memory held by
+      /// each plugin. \sa AllocationStats()
       ///
       /// \returns A pretty string
       public: std::string PrettyStr() const;
@@ -83,6 +331,66 @@ namespace ignition
           const std::string &_interface,
           const bool demangled = true) const;
 
+      /// \brief Get the names of the plugins that implement every one of the
+      /// specified interfaces.
+      ///
+      /// The Loader keeps a packed bit matrix of which interfaces each of its
+      /// plugins implements, so this is evaluated as a word-wise AND over one
+      /// bitset per interface instead of intersecting the results of
+      /// PluginsImplementing(~) for each interface.
+      ///
+      /// \tparam Interfaces
+      ///   The interfaces that the plugins must implement. If this is empty,
+      ///   every plugin will be returned.
+      ///
+      /// \return Names of the plugins that implement all of the interfaces
+      public: template <typename... Interfaces>
+      std::unordered_set<std::string> PluginsImplementingAll() const;
+
+      /// \brief Get the names of the plugins that implement at least one of the
+      /// specified interfaces. This is evaluated as a word-wise OR over one
+      /// bitset per interface.
+      ///
+      /// \tparam Interfaces
+      ///   The interfaces that the plugins may implement
+      ///
+      /// \return Names of the plugins that implement any of the interfaces
+      public: template <typename... Interfaces>
+      std::unordered_set<std::string> PluginsImplementingAny() const;
+
+      /// \brief Get the names of the plugins that implement every one of the
+      /// specified interface strings. See PluginsImplementing(~) for the
+      /// meaning of _demangled.
+      ///
+      /// \param[in] _interfaces
+      ///   Names of the interfaces. If this is empty, every plugin will be
+      ///   returned.
+      ///
+      /// \param[in] _demangled
+      ///   Specify whether the _interfaces strings are demangled (default,
+      ///   true) or mangled (false).
+      ///
+      /// \return Names of the plugins that implement all of the interfaces
+      public: std::unordered_set<std::string> PluginsImplementingAll(
+          const std::vector<std::string> &_interfaces,
+          const bool _demangled = true) const;
+
+      /// \brief Get the names of the plugins that implement at least one of the
+      /// specified interface strings. See PluginsImplementing(~) for the
+      /// meaning of _demangled.
+      ///
+      /// \param[in] _interfaces
+      ///   Names of the interfaces
+      ///
+      /// \param[in] _demangled
+      ///   Specify whether the _interfaces strings are demangled (default,
+      ///   true) or mangled (false).
+      ///
+      /// \return Names of the plugins that implement any of the interfaces
+      public: std::unordered_set<std::string> PluginsImplementingAny(
+          const std::vector<std::string> &_interfaces,
+          const bool _demangled = true) const;
+
       /// \brief Get a set of the names of all plugins that are currently known
       /// to this Loader.
       /// \return A set of all plugin names known to this Loader.
@@ -102,7 +410,7 @@ namespace ignition
       ///
       /// \return A set of plugins that correspond to the desired alias
       public: std::set<std::string> PluginsWithAlias(
-          const std::string &_alias) const;
+          std::string_view _alias) const;
 
       /// \brief Get the aliases of the plugin with the given name
       ///
@@ -113,6 +421,72 @@ namespace ignition
       public: std::set<std::string> AliasesOfPlugin(
           const std::string &_pluginName) const;
 
+      /// \brief Visit the name of every plugin that is known to this Loader,
+      /// in the same order as AllPlugins(). Unlike AllPlugins(), this does not
+      /// copy any of the names, so it never allocates memory.
+      ///
+      /// The visitor receives a std::string_view that refers to storage which
+      /// is owned by this Loader. The view remains valid until the plugin is
+      /// forgotten.
+      ///
+      /// \param[in] _visitor
+      ///   A callable that accepts a std::string_view
+      public: template <typename Visitor>
+      void ForEachPlugin(Visitor &&_visitor) const;
+
+      /// \brief Visit the name of every plugin that implements Interface. See
+      /// ForEachPlugin(~) for the lifetime of the names.
+      ///
+      /// \param[in] _visitor
+      ///   A callable that accepts a std::string_view
+      public: template <typename Interface, typename Visitor>
+      void ForEachPluginImplementing(Visitor &&_visitor) const;
+
+      /// \brief Visit the name of every plugin that implements the specified
+      /// interface string. See PluginsImplementing(~) for the meaning of
+      /// _demangled, and ForEachPlugin(~) for the lifetime of the names.
+      ///
+      /// \param[in] _interface
+      ///   Name of an interface
+      ///
+      /// \param[in] _visitor
+      ///   A callable that accepts a std::string_view
+      ///
+      /// \param[in] _demangled
+      ///   Specify whether the _interface string is demangled (default, true)
+      ///   or mangled (false).
+      public: template <typename Visitor>
+      void ForEachPluginImplementing(
+          std::string_view _interface,
+          Visitor &&_visitor,
+          const bool _demangled = true) const;
+
+      /// \brief Visit the name of every plugin that corresponds to the
+      /// specified alias string, like PluginsWithAlias(~) does. See
+      /// ForEachPlugin(~) for the lifetime of the names.
+      ///
+      /// \param[in] _alias
+      ///   The alias
+      ///
+      /// \param[in] _visitor
+      ///   A callable that accepts a std::string_view
+      public: template <typename Visitor>
+      void ForEachPluginWithAlias(
+          std::string_view _alias, Visitor &&_visitor) const;
+
+      /// \brief Visit every alias of the plugin with the given name, like
+      /// AliasesOfPlugin(~) does. See ForEachPlugin(~) for the lifetime of the
+      /// aliases.
+      ///
+      /// \param[in] _pluginName
+      ///   The name of the desired plugin
+      ///
+      /// \param[in] _visitor
+      ///   A callable that accepts a std::string_view
+      public: template <typename Visitor>
+      void ForEachAliasOfPlugin(
+          std::string_view _pluginName, Visitor &&_visitor) const;
+
       /// \brief Resolve the plugin name or alias into the name of the plugin
       /// that it maps to. If this is a name or alias that does not uniquely map
       /// to a known plugin, then the return value will be an empty string.
@@ -122,7 +496,37 @@ namespace ignition
       ///
       /// \return The name of the plugin being referred to, or an empty string
       /// if no such plugin is known.
-      public: std::string LookupPlugin(const std::string &_nameOrAlias) const;
+      public: std::string LookupPlugin(std::string_view _nameOrAlias) const;
+
+      /// \brief Same as LookupPlugin(~), except that the name is not copied.
+      ///
+      /// \param[in] _nameOrAlias
+      ///   The name or alias of the plugin of interest.
+      ///
+      /// \return A view of the name of the plugin being referred to, or an
+      /// empty view if no such plugin is known. The view refers to storage
+      /// that is owned by this Loader, and it remains valid until the plugin
+      /// is forgotten.
+      public: std::string_view LookupPluginView(
+          std::string_view _nameOrAlias) const;
+
+      /// \brief Same as LookupPluginView(~), except that a failure is reported
+      /// through the return value instead of printing a diagnostic. This
+      /// performs no I/O and does not allocate memory, so it is suitable for
+      /// probing optional plugin names in a loop.
+      ///
+      /// \param[in] _nameOrAlias
+      ///   The name or alias of the plugin of interest.
+      ///
+      /// \param[out] _resolvedName
+      ///   The name of the plugin being referred to, or an empty view if the
+      ///   lookup failed. See LookupPluginView(~) for its lifetime.
+      ///
+      /// \return LookupError::NONE if the lookup succeeded, otherwise the
+      /// reason that it failed.
+      public: LookupError TryLookupPlugin(
+          std::string_view _nameOrAlias,
+          std::string_view &_resolvedName) const;
 
       /// \brief Load a library at the given path
       ///
@@ -133,6 +537,34 @@ namespace ignition
       public: std::unordered_set<std::string> LoadLib(
                   const std::string &_pathToLibrary);
 
+      /// \brief Load a library at the given path with specific options,
+      /// instead of the options of SetDefaultLoadOptions(~). If the library
+      /// has already been loaded, the dynamic linker may still upgrade it,
+      /// e.g. from lazy to immediate binding or from local to global.
+      ///
+      /// \param[in] _pathToLibrary
+      ///   The path to a library
+      ///
+      /// \param[in] _options
+      ///   How the library should be loaded
+      ///
+      /// \returns The set of plugins that have been loaded from the library
+      public: std::unordered_set<std::string> LoadLib(
+                  const std::string &_pathToLibrary,
+                  const LoadOptions &_options);
+
+      /// \brief Choose the options that are used by LoadLib(~) when none are
+      /// given, and by ReloadLib(~). By default, libraries are loaded with
+      /// lazy binding and local symbols, and they are not prefaulted.
+      ///
+      /// \param[in] _options
+      ///   The default options
+      public: void SetDefaultLoadOptions(const LoadOptions &_options);
+
+      /// \brief Get the options that were set by SetDefaultLoadOptions(~).
+      /// \return The default options
+      public: LoadOptions DefaultLoadOptions() const;
+
       /// \brief Instantiates a plugin for the given plugin name
       ///
       /// \param[in] _pluginNameOrAlias
@@ -140,7 +572,7 @@ namespace ignition
       ///
       /// \returns Pointer to instantiated plugin
       public: PluginPtr Instantiate(
-          const std::string &_pluginNameOrAlias) const;
+          std::string_view _pluginNameOrAlias) const;
 
       /// \brief Instantiates a plugin of PluginType for the given plugin name.
       /// This can be used to create a specialized PluginPtr.
@@ -154,7 +586,28 @@ namespace ignition
       ///
       /// \returns pointer for the instantiated PluginPtr
       public: template <typename PluginPtrType>
-      PluginPtrType Instantiate(const std::string &_pluginNameOrAlias) const;
+      PluginPtrType Instantiate(std::string_view _pluginNameOrAlias) const;
+
+      /// \brief Same as Instantiate(~), except that a failure to resolve the
+      /// name is reported through the return value instead of printing a
+      /// diagnostic.
+      ///
+      /// \tparam PluginPtrType
+      ///   The type of PluginPtr that you want to construct. This is deduced
+      ///   from _plugin.
+      ///
+      /// \param[in] _pluginNameOrAlias
+      ///   Name or alias of the plugin that you want to instantiate.
+      ///
+      /// \param[out] _plugin
+      ///   The new plugin instance, or an empty PluginPtr if the lookup failed.
+      ///
+      /// \return LookupError::NONE if the plugin was instantiated, otherwise
+      /// the reason that its name could not be resolved.
+      public: template <typename PluginPtrType>
+      LookupError TryInstantiate(
+          std::string_view _pluginNameOrAlias,
+          PluginPtrType &_plugin) const;
 
       /// \brief Instantiates a plugin for the given plugin name, and then
       /// returns a reference-counting interface corresponding to InterfaceType.
@@ -163,13 +616,16 @@ namespace ignition
       /// Construct(...) on the returned interface, as long as the returned
       /// interface is not a nullptr.
       ///
-      /// \remark This function is identical to:
+      /// \remark This function gives the same result as:
       ///
       /// \code
       /// loader->Instantiate(_pluginNameOrAlias)
       ///   ->QueryInterfaceSharedPtr<InterfaceType>();
       /// \endcode
       ///
+      /// except that when InterfaceType is a Factory, a plugin which was not
+      /// registered with any Factory is not instantiated at all.
+      ///
       /// \tparam InterfaceType
       ///   The type of interface to look for. This function is meant for
       ///   producing Factories, but any type of Interface can be requested.
@@ -181,7 +637,7 @@ namespace ignition
       /// requested plugin.
       public: template <typename InterfaceType>
       std::shared_ptr<InterfaceType> Factory(
-          const std::string &_pluginNameOrAlias) const;
+          std::string_view _pluginNameOrAlias) const;
 
       /// \brief This loader will forget about the library at the given path
       /// location. If you want to instantiate a plugin from this library using
@@ -219,28 +675,372 @@ namespace ignition
       /// \sa bool ForgetLibrary(const std::string &_pathToLibrary)
       public: bool ForgetLibraryOfPlugin(const std::string &_pluginNameOrAlias);
 
-      /// \brief Get a pointer to the Info corresponding to _pluginName.
+      /// \brief Load the current contents of a library file, and replace the
+      /// version of the library that this Loader has loaded from that path.
+      ///
+      /// The file is copied to a unique temporary path before it is loaded,
+      /// so that the dynamic linker does not hand back the version which is
+      /// already loaded. The plugins of the new version take over the names
+      /// and aliases of the old version, so Instantiate(~) produces instances
+      /// of the new version from then on. PluginPtrs which were created from
+      /// the old version keep it loaded until they are all gone, at which
+      /// point the callback of SetDrainCallback(~) is told about it.
+      ///
+      /// Subscribers receive a single Change for the whole swap, in which the
+      /// plugins of the old version are removed and the plugins of the new
+      /// version are added, so a plugin that is provided by both versions
+      /// appears in both sets.
       ///
-      /// \param[in] _resolvedName
-      ///   The resolved name, i.e. the demangled class symbol name as returned
-      ///   by LookupPlugin(~), of the plugin that you want to instantiate.
+      /// If the new version cannot be loaded or does not provide any plugins,
+      /// the old version stays in place. If the library was not loaded yet,
+      /// it is simply loaded.
       ///
-      /// \return Pointer to the corresponding Info, or nullptr if there
-      /// is no info for the requested _pluginName.
-      private: ConstInfoPtr PrivateGetInfo(
-          const std::string &_resolvedName) const;
+      /// \param[in] _pathToLibrary
+      ///   The path that the library was loaded from
+      ///
+      /// \return The set of plugins that the new version provides, or an empty
+      /// set if it could not be loaded.
+      public: std::unordered_set<std::string> ReloadLib(
+          const std::string &_pathToLibrary);
 
-      /// \brief Get a std::shared_ptr that manages the lifecycle of the shared
-      /// library handle which provides the specified plugin.
+      /// \brief Reload a library with ReloadLib(~) whenever its file is
+      /// rewritten or replaced. Changes are picked up by
+      /// ProcessLibraryChanges(~), which the owner of this Loader must call,
+      /// for example whenever LibraryWatchDescriptor() becomes readable.
+      /// This is only supported on Linux, where it uses inotify.
+      ///
+      /// \param[in] _pathToLibrary
+      ///   The path of the library to watch
+      ///
+      /// \return True if the library is being watched
+      public: bool WatchLib(const std::string &_pathToLibrary);
+
+      /// \brief Stop watching a library that was passed to WatchLib(~).
+      ///
+      /// \param[in] _pathToLibrary
+      ///   The path that was passed to WatchLib(~)
+      ///
+      /// \return True if the library was being watched
+      public: bool UnwatchLib(const std::string &_pathToLibrary);
+
+      /// \brief Get a file descriptor which becomes readable when a watched
+      /// library has changed. It can be added to an event loop that uses
+      /// poll, select, or epoll. Do not read from it.
+      ///
+      /// \return The file descriptor, or -1 if no library has been watched.
+      public: int LibraryWatchDescriptor() const;
+
+      /// \brief Reload every watched library whose file has changed since the
+      /// last call, and report the old versions which have been unloaded
+      /// since the last call. This never blocks.
+      ///
+      /// \return The number of libraries that were reloaded
+      public: std::size_t ProcessLibraryChanges();
+
+      /// \brief Choose the function which is told when an old version of a
+      /// reloaded library has been unloaded. Old versions are checked by
+      /// ProcessLibraryChanges(~).
+      ///
+      /// \param[in] _callback
+      ///   The function to call
+      public: void SetDrainCallback(DrainCallback _callback);
+
+      /// \brief Get the number of old versions of reloaded libraries which
+      /// are still kept loaded by plugin instances.
+      ///
+      /// \return The number of old versions which have not been unloaded
+      public: std::size_t DrainingLibraryCount() const;
+
+      /// \brief Freeze the set of plugins that are known to this Loader.
+      ///
+      /// This builds an immutable lookup index that uses a minimal perfect hash
+      /// over every plugin name and alias. After the Loader is frozen, each
+      /// call to LookupPlugin(~), Instantiate(~), or Factory(~) resolves its
+      /// argument with a single hash and a single string comparison, and the
+      /// Loader is never modified by those calls, so it can be read from many
+      /// threads at once without locking.
+      ///
+      /// The frozen index is compacted into one contiguous memory region which
+      /// is made read-only and is never written to again. This makes frozen
+      /// Loaders suitable for pre-fork worker models: load every library,
+      /// Freeze(), instantiate the plugins that the workers will share, and
+      /// then fork. The workers can look up plugins without unsharing any of
+      /// the pages of the index. The first time that a worker instantiates a
+      /// plugin, it makes its own copies of the plugin Info objects, and from
+      /// then on instantiating only writes to memory that belongs to the
+      /// worker. Copying a PluginPtr that was created before the fork still
+      /// writes to the reference count of that instance, which unshares the
+      /// page that holds it.
+      ///
+      /// Once a Loader is frozen, the set of plugins that it knows about can no
+      /// longer change. LoadLib(~), ForgetLibrary(~), and
+      /// ForgetLibraryOfPlugin(~) will be rejected. If you need a different
+      /// set of plugins, create a new Loader and freeze it after loading the
+      /// libraries that it needs.
+      ///
+      /// Calling this function on a Loader that is already frozen has no
+      /// effect.
+      public: void Freeze();
+
+      /// \brief Check whether Freeze() has been called on this Loader.
+      /// \return True if this Loader is frozen, otherwise false.
+      public: bool IsFrozen() const;
+
+      /// \brief Get the generation of the set of plugins that this Loader
+      /// knows about. It starts at 0 and increases by one every time that
+      /// LoadLib(~), ForgetLibrary(~), or ForgetLibraryOfPlugin(~) adds or
+      /// removes plugins. Calls which do not change the set of plugins, such
+      /// as loading a library a second time, leave it unchanged.
+      ///
+      /// Anything that is derived from the set of plugins can remember the
+      /// generation that it was computed at, and it is stale if this returns
+      /// a different value.
+      ///
+      /// \return The current generation
+      public: std::uint64_t Generation() const;
+
+      /// \brief Be told about every future change to the set of plugins that
+      /// this Loader knows about. The callback is called after the change has
+      /// been made, by the thread that made it, with the exact names that
+      /// were added or removed.
+      ///
+      /// \param[in] _callback
+      ///   The function to call for each change
+      ///
+      /// \return An ID which can be passed to Unsubscribe(~)
+      public: std::size_t Subscribe(ChangeCallback _callback);
+
+      /// \brief Stop calling a callback that was passed to Subscribe(~). It is
+      /// safe to call this from inside of the callback.
+      ///
+      /// \param[in] _subscription
+      ///   The ID that was returned by Subscribe(~)
+      ///
+      /// \return True if the subscription existed and has been removed
+      public: bool Unsubscribe(std::size_t _subscription);
+
+      /// \brief Choose how long a library stays loaded after the last
+      /// reference to it is released.
+      ///
+      /// With the default grace period of zero, the library is closed right
+      /// away by whichever thread releases the last PluginPtr or Info which
+      /// uses it. With a positive grace period, the library is handed to a
+      /// background thread, which closes it (along with any other libraries
+      /// that are due) once the grace period has passed. If the library is
+      /// loaded again before then, by any Loader, the pending close is
+      /// cancelled and the library is reused without being reinitialized.
+      ///
+      /// The grace period applies to every library of this Loader that is
+      /// released after this call, including libraries that were loaded
+      /// before it.
+      ///
+      /// \param[in] _gracePeriod
+      ///   How long to wait before closing a library
+      public: void SetUnloadGracePeriod(std::chrono::milliseconds _gracePeriod);
+
+      /// \brief Get the grace period that was set by SetUnloadGracePeriod(~).
+      /// \return How long libraries stay loaded after they are released
+      public: std::chrono::milliseconds UnloadGracePeriod() const;
+
+      /// \brief Get statistics about the libraries of this Loader that have
+      /// been unloaded, including libraries that were released after the
+      /// plugins of this Loader were forgotten.
+      /// \return The statistics
+      public: UnloadStatistics UnloadStats() const;
+
+      /// \brief Get the time that was spent loading each library, and the
+      /// number of instances that were created of each plugin.
+      ///
+      /// The instance counters are updated with relaxed atomic operations
+      /// whenever a plugin is instantiated or destroyed, so they are cheap to
+      /// keep, and this may be called from any thread while instances are
+      /// being created. The counts of one plugin are not guaranteed to be a
+      /// consistent snapshot while that happens.
+      ///
+      /// \return The statistics
+      public: Statistics Stats() const;
+
+      /// \brief Format statistics as a JSON object, with every time given in
+      /// nanoseconds.
+      /// \param[in] _stats
+      ///   The statistics to format, as returned by Stats()
+      /// \return The JSON text
+      public: static std::string StatsToJson(const Statistics &_stats);
+
+      /// \brief Format statistics in the Prometheus text exposition format,
+      /// with every time given in seconds. The metrics are prefixed with
+      /// "ignition_plugin_" and labeled by library path and plugin name.
+      /// \param[in] _stats
+      ///   The statistics to format, as returned by Stats()
+      /// \return The metrics text
+      public: static std::string StatsToPrometheus(const Statistics &_stats);
+
+      /// \brief Get the ranges of memory which hold the executable code of
+      /// the libraries that this Loader has loaded plugins from. They are
+      /// found with dl_iterate_phdr, so this is only available on Linux.
+      ///
+      /// Use this to find out which library, and which plugins, an address
+      /// such as a frame of a stack trace belongs to. The ranges stay valid
+      /// for as long as their libraries stay loaded.
+      ///
+      /// \return The ranges, sorted by address. They do not overlap.
+      public: std::vector<AddressRange> AddressRanges() const;
+
+      /// \brief Choose whether the plugin instances that this Loader
+      /// creates hand out timing proxies from QueryInterface, for the
+      /// interfaces which have a proxy registered with
+      /// IGNITION_ADD_INTERFACE_PROXY. This only affects instances that are
+      /// created afterwards. The proxies are off by default.
+      /// \sa InterfaceProxy
+      /// \param[in] _enabled
+      ///   True to hand out proxies, false to hand out the plugin itself
+      public: void SetInterfaceProxies(bool _enabled);
+
+      /// \brief Check whether new plugin instances hand out timing proxies.
+      /// \return True if they do
+      public: bool InterfaceProxiesEnabled() const;
+
+      /// \brief Get the call counts and latencies of the methods of every
+      /// interface proxy that the plugins of this Loader can hand out. The
+      /// counters are updated with relaxed atomic operations, so this may be
+      /// called while the methods are being called.
+      /// \return One entry per plugin, interface, and method, sorted by
+      /// plugin and interface, and then in the order that the methods were
+      /// registered
+      public: std::vector<MethodStatistics> MethodStats() const;
+
+      /// \brief Check whether heap allocations are being tracked. They are
+      /// tracked if the executable includes
+      /// <ignition/plugin/TrackAllocations.hh>.
+      /// \return True if AllocationStats() can report anything
+      public: static bool AllocationTrackingEnabled();
+
+      /// \brief Get the heap memory that was allocated by the code of each
+      /// plugin library that this Loader has loaded, and by each plugin of
+      /// those libraries. This requires allocation tracking, see
+      /// AllocationTrackingEnabled(), and it uses AddressRanges(), so it is
+      /// only available on Linux.
+      ///
+      /// Each allocation is counted against the function which called
+      /// operator new. It is attributed to a plugin if the function is a
+      /// member of the plugin class, or if its name mentions the plugin
+      /// class (such as the factory which creates its instances), or if the
+      /// library only provides one plugin. Memory that a library allocated
+      /// before it was unloaded is no longer reported.
+      ///
+      /// \return One entry per library and plugin, sorted by library and
+      /// then by plugin. The entry of a library with an empty plugin name
+      /// counts the allocations which could not be attributed to a plugin.
+      public: std::vector<AllocationStatistics> AllocationStats() const;
+
+      /// \brief Choose where the diagnostic messages of this Loader go. By
+      /// default they are written to std::cerr, and none of them are
+      /// dropped.
+      ///
+      /// Messages which go to the chosen sink are rate-limited: at most
+      /// _burst messages are delivered in each _period, and the rest are
+      /// dropped without being formatted. The number of dropped messages is
+      /// reported before the next message that gets delivered.
+      ///
+      /// \param[in] _sink
+      ///   The function which receives the messages. Pass in a nullptr to
+      ///   discard all of them.
+      ///
+      /// \param[in] _burst
+      ///   The most messages that can be delivered in one period. A value of 0
+      ///   means that there is no limit.
+      ///
+      /// \param[in] _period
+      ///   The length of each period.
+      public: void SetDiagnosticSink(
+          DiagnosticSink _sink,
+          std::size_t _burst = 20,
+          std::chrono::milliseconds _period = std::chrono::seconds(1));
+
+      /// \brief Type-erased visitor which is used by the ForEach functions
+      /// to reach into this library without allocating memory.
+      private: struct Visit
+      {
+        /// \brief The visitor that was passed to the ForEach function
+        public: void *visitor;
+
+        /// \brief Calls the visitor with a name
+        public: void (*function)(void *, std::string_view);
+
+        /// \brief Call the visitor
+        /// \param[in] _name The name to visit
+        public: void operator()(std::string_view _name) const
+        {
+          this->function(this->visitor, _name);
+        }
+      };
+
+      /// \brief Create a Visit for _visitor
+      /// \param[in] _visitor The visitor that should be called
+      /// \return A Visit which calls _visitor
+      private: template <typename Visitor>
+      static Visit PrivateMakeVisit(Visitor &_visitor);
+
+      /// \sa ForEachPlugin(~)
+      private: void PrivateForEachPlugin(const Visit &_visit) const;
+
+      /// \sa ForEachPluginImplementing(~)
+      private: void PrivateForEachPluginImplementing(
+          std::string_view _interface,
+          const bool _demangled,
+          const Visit &_visit) const;
+
+      /// \sa ForEachPluginWithAlias(~)
+      private: void PrivateForEachPluginWithAlias(
+          std::string_view _alias,
+          const Visit &_visit) const;
+
+      /// \sa ForEachAliasOfPlugin(~)
+      private: void PrivateForEachAliasOfPlugin(
+          std::string_view _pluginName,
+          const Visit &_visit) const;
+
+      /// \brief Create an instance of a plugin which has already been found
+      /// by PrivateFindPlugin(~).
+      ///
+      /// \param[in] _info
+      ///   The Info of the plugin that you want to instantiate.
+      ///
+      /// \param[in] _dlHandle
+      ///   Reference-counting pointer to the handle of the library which
+      ///   provides the plugin.
+      ///
+      /// \return The new plugin instance
+      private: template <typename PluginPtrType>
+      PluginPtrType PrivateInstantiate(
+          const ConstInfoPtr &_info,
+          const std::shared_ptr<void> &_dlHandle) const;
+
+      /// \brief Find the Info of a plugin and the handle of the library
+      /// which provides it. A frozen Loader does this with a single lookup in
+      /// its index.
+      ///
+      /// \param[in] _nameOrAlias
+      ///   The name or alias of the plugin.
+      ///
+      /// \param[in] _quiet
+      ///   True if a failed lookup should not be reported to the diagnostic
+      ///   sink.
+      ///
+      /// \param[out] _info
+      ///   The Info of the plugin, or nullptr if it was not found.
       ///
-      /// \param[in] _resolvedName
-      ///   The resolved name, i.e. the demangled class symbol name as returned
-      ///   by LookupPlugin(~), of the plugin that you want to instantiate.
+      /// \param[out] _dlHandle
+      ///   Reference-counting pointer to the library handle, or nullptr if
+      ///   the plugin was not found.
       ///
-      /// \return Reference-counting pointer to a library handle, or else a
-      /// nullptr if the plugin is not available.
-      private: std::shared_ptr<void> PrivateGetPluginDlHandlePtr(
-          const std::string &_resolvedName) const;
+      /// \return LookupError::NONE if the plugin was found, otherwise the
+      /// reason why it was not.
+      private: LookupError PrivateFindPlugin(
+          std::string_view _nameOrAlias,
+          bool _quiet,
+          ConstInfoPtr &_info,
+          std::shared_ptr<void> &_dlHandle) const;
 
       class Implementation;
       IGN_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
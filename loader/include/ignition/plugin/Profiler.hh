@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef IGNITION_PLUGIN_PROFILER_HH_
+#define IGNITION_PLUGIN_PROFILER_HH_
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <ignition/utilities/SuppressWarning.hh>
+
+#include <ignition/plugin/loader/Export.hh>
+#include <ignition/plugin/Loader.hh>
+
+namespace ignition
+{
+  namespace plugin
+  {
+    /// \brief Sampling profiler which tells how much of the CPU time of the
+    /// process is spent inside of each plugin.
+    ///
+    /// While it is running, the kernel sends SIGPROF to the process at a
+    /// fixed interval of CPU time, and the signal handler records the program
+    /// counter of the thread that was interrupted. Nothing else is done inside
+    /// of the signal handler. Each sample is attributed afterwards, using the
+    /// Loader::AddressRanges() of the libraries and the nearest symbol that
+    /// dladdr can find:
+    ///
+    /// - Samples inside a member function of a plugin class are attributed
+    ///   to that plugin.
+    /// - Samples inside a function whose name mentions exactly one plugin of
+    ///   the library, such as a template instantiated for the plugin class,
+    ///   are attributed to that plugin.
+    /// - Samples inside a member function of an interface class are
+    ///   attributed to that interface, and also to the plugin if only one
+    ///   plugin of the library implements the interface.
+    /// - Other samples inside a plugin library are attributed to the library,
+    ///   and also to the plugin if the library only provides one.
+    /// - Samples anywhere else are attributed to none of them.
+    ///
+    /// Only the innermost frame of each sample is used, so time spent in
+    /// other libraries on behalf of a plugin (for example in malloc) is not
+    /// attributed to the plugin. Symbols that are hidden from the dynamic
+    /// symbol table cannot be told apart from the exported symbol before
+    /// them.
+    ///
+    /// Only one Profiler can run at a time in a process, and it replaces any
+    /// other SIGPROF handler while it runs. This is only available on Linux.
+    class IGNITION_PLUGIN_LOADER_VISIBLE Profiler
+    {
+      /// \brief Where an address belongs
+      public: struct Attribution
+      {
+        /// \brief The path of the plugin library, or empty if the address is
+        /// outside of every plugin library
+        public: std::string library;
+
+        /// \brief The name of the plugin, or empty if it is not known
+        public: std::string plugin;
+
+        /// \brief The name of the interface, or empty if the address is not
+        /// inside a member function of an interface
+        public: std::string interface;
+
+        /// \brief The demangled name of the nearest symbol, or empty if
+        /// there is none
+        public: std::string symbol;
+      };
+
+      /// \brief The share of the samples that were attributed to the same
+      /// library, plugin, and interface
+      public: struct Share
+      {
+        /// \sa Attribution::library
+        public: std::string library;
+
+        /// \sa Attribution::plugin
+        public: std::string plugin;
+
+        /// \sa Attribution::interface
+        public: std::string interface;
+
+        /// \brief The number of samples
+        public: std::size_t samples = 0;
+
+        /// \brief The fraction of all samples, from 0 to 1
+        public: double fraction = 0.0;
+      };
+
+      /// \brief Constructor
+      /// \param[in] _loader
+      ///   The Loader whose plugins should be profiled. It must outlive this
+      ///   Profiler.
+      /// \param[in] _capacity
+      ///   The most samples to keep. Samples beyond this are counted as
+      ///   dropped.
+      public: explicit Profiler(
+          const Loader &_loader,
+          std::size_t _capacity = 1u << 16);
+
+      /// \brief Destructor. Stops the profiler if it is running.
+      public: ~Profiler();
+
+      /// \brief Start sampling. The address ranges of the libraries of the
+      /// Loader are taken at this point, so start the profiler after the
+      /// libraries of interest have been loaded.
+      /// \param[in] _interval
+      ///   The CPU time between two samples
+      /// \return True if the profiler was started. False if this or another
+      /// Profiler is already running, or if profiling is not available.
+      public: bool Start(
+          std::chrono::microseconds _interval = std::chrono::milliseconds(1));
+
+      /// \brief Stop sampling. The samples are kept until Reset() is called.
+      public: void Stop();
+
+      /// \brief Check whether this profiler is running.
+      /// \return True if it is running
+      public: bool IsRunning() const;
+
+      /// \brief Discard every sample.
+      public: void Reset();
+
+      /// \brief Get the number of samples that have been kept.
+      /// \return The number of samples
+      public: std::size_t SampleCount() const;
+
+      /// \brief Get the number of samples that were dropped because the
+      /// profiler was full.
+      /// \return The number of dropped samples
+      public: std::size_t DroppedSampleCount() const;
+
+      /// \brief Find out where an address belongs. This uses the address
+      /// ranges that were taken by the last call to Start(), or by the
+      /// constructor if the profiler has not been started.
+      /// \param[in] _address
+      ///   The address, such as a return address or a function pointer
+      /// \return Where the address belongs
+      public: Attribution Attribute(const void *_address) const;
+
+      /// \brief Attribute every sample that has been kept.
+      /// \return One share per combination of library, plugin, and
+      /// interface, sorted from the most samples to the fewest.
+      public: std::vector<Share> Shares() const;
+
+      /// \brief Format shares as a table with one row per share.
+      /// \param[in] _shares
+      ///   The shares, as returned by Shares()
+      /// \return The table
+      public: static std::string FormatShares(
+          const std::vector<Share> &_shares);
+
+      class Implementation;
+      IGN_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+      /// \brief PIMPL pointer to class implementation
+      private: std::unique_ptr<Implementation> dataPtr;
+      IGN_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef IGNITION_PLUGIN_TRACKALLOCATIONS_HH_
+#define IGNITION_PLUGIN_TRACKALLOCATIONS_HH_
+
+// Including this header turns on heap allocation tracking for the whole
+// process. It replaces the global operator new and operator delete with
+// versions that count every allocation against the code which called
+// operator new, so that Loader::AllocationStats() and Loader::PrettyStr()
+// can tell how much heap memory each plugin holds and how fast it allocates.
+//
+// Include it in exactly one source file of the executable, such as the one
+// which defines main(). Plugin libraries do not need to be rebuilt: the
+// replacement operators of the executable are used by every library of the
+// process.
+//
+// Each allocation costs a hash table lookup on the address of its caller and
+// two relaxed atomic additions, plus 16 bytes of bookkeeping in front of the
+// memory. Only the innermost caller is known, so memory which a plugin
+// allocates through a function of another library (for example the out of
+// line parts of std::string) is not counted against the plugin. Memory that
+// is allocated with malloc is not tracked.
+//
+// Libraries which are loaded with RTLD_DEEPBIND would bind operator new and
+// operator delete to their own dependencies instead, and could free tracked
+// memory with the untracked operator, so Loader::LoadLib(~) refuses to load
+// them with LoadOptions::deepBind while allocations are tracked.
+
+#include <cstddef>
+#include <new>
+
+#include <ignition/plugin/detail/AllocationTracker.hh>
+
+// The operators must not be inlined into their callers in this file, or
+// they would see the return address of the caller instead.
+#if defined(__GNUC__) || defined(__clang__)
+#define IGN_PLUGIN_ALLOCATION_CALLER __builtin_return_address(0)
+#define IGN_PLUGIN_ALLOCATION_NOINLINE __attribute__((noinline))
+#else
+#define IGN_PLUGIN_ALLOCATION_CALLER nullptr
+#define IGN_PLUGIN_ALLOCATION_NOINLINE
+#endif
+
+namespace ignition
+{
+  namespace plugin
+  {
+    namespace detail
+    {
+      /// \brief Allocate tracked memory the way that a throwing operator new
+      /// must: call the new_handler until the allocation succeeds, and throw
+      /// std::bad_alloc if there is no new_handler.
+      /// \param[in] _size The number of bytes to allocate
+      /// \param[in] _alignment The alignment, or 0 for the default
+      /// \param[in] _caller The return address of operator new
+      /// \return The memory
+      inline void *TrackedNew(
+          const std::size_t _size,
+          const std::size_t _alignment,
+          const void *_caller)
+      {
+        for (;;)
+        {
+          if (void *ptr = TrackedAllocate(_size, _alignment, _caller))
+            return ptr;
+
+          const std::new_handler handler = std::get_new_handler();
+          if (!handler)
+            throw std::bad_alloc();
+
+          handler();
+        }
+      }
+
+      /// \brief Allocate tracked memory the way that a non-throwing operator
+      /// new must.
+      /// \param[in] _size The number of bytes to allocate
+      /// \param[in] _alignment The alignment, or 0 for the default
+      /// \param[in] _caller The return address of operator new
+      /// \return The memory, or nullptr if it could not be allocated
+      inline void *TrackedNewNoThrow(
+          const std::size_t _size,
+          const std::size_t _alignment,
+          const void *_caller) noexcept
+      {
+        try
+        {
+          return TrackedNew(_size, _alignment, _caller);
+        }
+        catch (...)
+        {
+          return nullptr;
+        }
+      }
+    }
+  }
+}
+
+/////////////////////////////////////////////////
+IGN_PLUGIN_ALLOCATION_NOINLINE
+void *operator new(std::size_t _size)
+{
+  return ignition::plugin::detail::TrackedNew(
+        _size, 0, IGN_PLUGIN_ALLOCATION_CALLER);
+}
+
+/////////////////////////////////////////////////
+IGN_PLUGIN_ALLOCATION_NOINLINE
+void *operator new[](std::size_t _size)
+{
+  return ignition::plugin::detail::TrackedNew(
+        _size, 0, IGN_PLUGIN_ALLOCATION_CALLER);
+}
+
+/////////////////////////////////////////////////
+IGN_PLUGIN_ALLOCATION_NOINLINE
+void *operator new(std::size_t _size, const std::nothrow_t &) noexcept
+{
+  return ignition::plugin::detail::TrackedNewNoThrow(
+        _size, 0, IGN_PLUGIN_ALLOCATION_CALLER);
+}
+
+/////////////////////////////////////////////////
+IGN_PLUGIN_ALLOCATION_NOINLINE
+void *operator new[](std::size_t _size, const std::nothrow_t &) noexcept
+{
+  return ignition::plugin::detail::TrackedNewNoThrow(
+        _size, 0, IGN_PLUGIN_ALLOCATION_CALLER);
+}
+
+/////////////////////////////////////////////////
+IGN_PLUGIN_ALLOCATION_NOINLINE
+void *operator new(std::size_t _size, std::align_val_t _alignment)
+{
+  return ignition::plugin::detail::TrackedNew(
+        _size, static_cast<std::size_t>(_alignment),
+        IGN_PLUGIN_ALLOCATION_CALLER);
+}
+
+/////////////////////////////////////////////////
+IGN_PLUGIN_ALLOCATION_NOINLINE
+void *operator new[](std::size_t _size, std::align_val_t _alignment)
+{
+  return ignition::plugin::detail::TrackedNew(
+        _size, static_cast<std::size_t>(_alignment),
+        IGN_PLUGIN_ALLOCATION_CALLER);
+}
+
+/////////////////////////////////////////////////
+IGN_PLUGIN_ALLOCATION_NOINLINE
+void *operator new(std::size_t _size, std::align_val_t _alignment,
+                   const std::nothrow_t &) noexcept
+{
+  return ignition::plugin::detail::TrackedNewNoThrow(
+        _size, static_cast<std::size_t>(_alignment),
+        IGN_PLUGIN_ALLOCATION_CALLER);
+}
+
+/////////////////////////////////////////////////
+IGN_PLUGIN_ALLOCATION_NOINLINE
+void *operator new[](std::size_t _size, std::align_val_t _alignment,
+                     const std::nothrow_t &) noexcept
+{
+  return ignition::plugin::detail::TrackedNewNoThrow(
+        _size, static_cast<std::size_t>(_alignment),
+        IGN_PLUGIN_ALLOCATION_CALLER);
+}
+
+/////////////////////////////////////////////////
+void operator delete(void *_ptr) noexcept
+{
+  ignition::plugin::detail::TrackedDeallocate(_ptr);
+}
+
+/////////////////////////////////////////////////
+void operator delete[](void *_ptr) noexcept
+{
+  ignition::plugin::detail::TrackedDeallocate(_ptr);
+}
+
+/////////////////////////////////////////////////
+void operator delete(void *_ptr, const std::nothrow_t &) noexcept
+{
+  ignition::plugin::detail::TrackedDeallocate(_ptr);
+}
+
+/////////////////////////////////////////////////
+void operator delete[](void *_ptr, const std::nothrow_t &) noexcept
+{
+  ignition::plugin::detail::TrackedDeallocate(_ptr);
+}
+
+/////////////////////////////////////////////////
+void operator delete(void *_ptr, std::size_t) noexcept
+{
+  ignition::plugin::detail::TrackedDeallocate(_ptr);
+}
+
+/////////////////////////////////////////////////
+void operator delete[](void *_ptr, std::size_t) noexcept
+{
+  ignition::plugin::detail::TrackedDeallocate(_ptr);
+}
+
+/////////////////////////////////////////////////
+void operator delete(void *_ptr, std::align_val_t) noexcept
+{
+  ignition::plugin::detail::TrackedDeallocate(_ptr);
+}
+
+/////////////////////////////////////////////////
+void operator delete[](void *_ptr, std::align_val_t) noexcept
+{
+  ignition::plugin::detail::TrackedDeallocate(_ptr);
+}
+
+/////////////////////////////////////////////////
+void operator delete(void *_ptr, std::align_val_t,
+                     const std::nothrow_t &) noexcept
+{
+  ignition::plugin::detail::TrackedDeallocate(_ptr);
+}
+
+/////////////////////////////////////////////////
+void operator delete[](void *_ptr, std::align_val_t,
+                       const std::nothrow_t &) noexcept
+{
+  ignition::plugin::detail::TrackedDeallocate(_ptr);
+}
+
+/////////////////////////////////////////////////
+void operator delete(void *_ptr, std::size_t, std::align_val_t) noexcept
+{
+  ignition::plugin::detail::TrackedDeallocate(_ptr);
+}
+
+/////////////////////////////////////////////////
+void operator delete[](void *_ptr, std::size_t, std::align_val_t) noexcept
+{
+  ignition::plugin::detail::TrackedDeallocate(_ptr);
+}
+
+#undef IGN_PLUGIN_ALLOCATION_CALLER
+#undef IGN_PLUGIN_ALLOCATION_NOINLINE
+
+#endif
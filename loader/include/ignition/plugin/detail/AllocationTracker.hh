@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef IGNITION_PLUGIN_DETAIL_ALLOCATIONTRACKER_HH_
+#define IGNITION_PLUGIN_DETAIL_ALLOCATIONTRACKER_HH_
+
+#include <cstddef>
+
+#include <ignition/plugin/loader/Export.hh>
+
+namespace ignition
+{
+  namespace plugin
+  {
+    namespace detail
+    {
+      /// \brief Allocate memory and count it against the code at _caller.
+      /// This never throws, and it never calls operator new.
+      /// \param[in] _size
+      ///   The number of bytes to allocate
+      /// \param[in] _alignment
+      ///   The alignment of the memory, or 0 for the default alignment of
+      ///   operator new
+      /// \param[in] _caller
+      ///   The return address of the call to operator new, or nullptr if it
+      ///   is not known
+      /// \return The memory, or nullptr if it could not be allocated
+      IGNITION_PLUGIN_LOADER_VISIBLE void *TrackedAllocate(
+          std::size_t _size,
+          std::size_t _alignment,
+          const void *_caller) noexcept;
+
+      /// \brief Free memory that was allocated by TrackedAllocate(~).
+      /// \param[in] _ptr
+      ///   The memory, or nullptr to do nothing
+      IGNITION_PLUGIN_LOADER_VISIBLE void TrackedDeallocate(
+          void *_ptr) noexcept;
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,232 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef IGNITION_PLUGIN_DETAIL_INTERFACEPROXY_HH_
+#define IGNITION_PLUGIN_DETAIL_INTERFACEPROXY_HH_
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include <ignition/plugin/InterfaceProxy.hh>
+#include <ignition/plugin/loader/Export.hh>
+
+namespace ignition
+{
+  namespace plugin
+  {
+    namespace detail
+    {
+      /// \brief The number of buckets in the latency histogram of a method.
+      /// Bucket 0 counts calls that took no time, bucket i counts calls that
+      /// took at least 2^(i-1) and less than 2^i nanoseconds, and the last
+      /// bucket also counts every call that took longer.
+      constexpr std::size_t LatencyBuckets = 32;
+
+      /// \brief The counters of one method of the proxies of one plugin.
+      /// Each method gets its own cache lines, so that threads which call
+      /// different methods do not slow each other down.
+      struct alignas(64) MethodCounters
+      {
+        /// \brief Number of calls
+        public: std::atomic<std::uint64_t> calls{0};
+
+        /// \brief Total time spent in the calls, in nanoseconds
+        public: std::atomic<std::uint64_t> totalTime{0};
+
+        /// \brief Number of calls in each latency bucket
+        public: std::atomic<std::uint64_t> histogram[LatencyBuckets] = {};
+      };
+
+      /////////////////////////////////////////////////
+      /// \brief Find the latency bucket of a duration.
+      /// \param[in] _nanoseconds The duration
+      /// \return The index of the bucket
+      inline std::size_t LatencyBucket(std::uint64_t _nanoseconds)
+      {
+#if defined(__GNUC__) || defined(__clang__)
+        const std::size_t width = 0 == _nanoseconds ? 0 :
+            64 - static_cast<std::size_t>(__builtin_clzll(_nanoseconds));
+#else
+        std::size_t width = 0;
+        for (; _nanoseconds > 0; _nanoseconds >>= 1)
+          ++width;
+#endif
+        return width < LatencyBuckets ? width : LatencyBuckets - 1;
+      }
+
+      /// \brief Records one call of a method when it goes out of scope, so
+      /// that calls which throw are counted too.
+      class TimedCall
+      {
+        /// \brief Constructor. Starts the clock.
+        /// \param[in] _counters The counters of the method
+        public: explicit TimedCall(MethodCounters &_counters)
+          : counters(_counters),
+            start(std::chrono::steady_clock::now())
+        {
+          // Do nothing
+        }
+
+        /// \brief Destructor. Stops the clock and records the call.
+        public: ~TimedCall()
+        {
+          const std::uint64_t nanoseconds = static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::steady_clock::now() - this->start).count());
+
+          this->counters.calls.fetch_add(1, std::memory_order_relaxed);
+          this->counters.totalTime.fetch_add(
+                nanoseconds, std::memory_order_relaxed);
+          this->counters.histogram[LatencyBucket(nanoseconds)].fetch_add(
+                1, std::memory_order_relaxed);
+        }
+
+        /// \brief The counters of the method
+        private: MethodCounters &counters;
+
+        /// \brief When the call started
+        private: const std::chrono::steady_clock::time_point start;
+      };
+
+      /// \brief A function which creates a proxy around the interface of a
+      /// plugin instance. It returns the interface of the proxy, which also
+      /// owns the proxy.
+      using ProxyFactory = std::function<std::shared_ptr<void>(
+          void *_interface, MethodCounters *_counters,
+          std::size_t _methodCount)>;
+
+      /// \brief Register the proxy of an interface. A proxy which is
+      /// registered later for the same interface replaces this one.
+      /// \param[in] _interfaceName
+      ///   The mangled name of the interface
+      /// \param[in] _methods
+      ///   The names of the methods of the interface that the proxy times
+      /// \param[in] _factory
+      ///   Creates the proxy around an interface
+      IGNITION_PLUGIN_LOADER_VISIBLE void RegisterInterfaceProxy(
+          const std::string &_interfaceName,
+          std::vector<std::string> _methods,
+          ProxyFactory _factory);
+
+      /////////////////////////////////////////////////
+      /// \brief Register ProxyClass as the proxy of its interface.
+      /// \param[in] _methods The names of the methods that it times
+      template <typename ProxyClass>
+      void AddInterfaceProxy(std::vector<std::string> _methods)
+      {
+        using Interface = typename ProxyClass::InterfaceType;
+
+        RegisterInterfaceProxy(typeid(Interface).name(), std::move(_methods),
+          [](void *_interface, MethodCounters *_counters,
+             const std::size_t _methodCount)
+          {
+            const std::shared_ptr<ProxyClass> proxy =
+                std::make_shared<ProxyClass>(
+                  static_cast<Interface*>(_interface), _counters,
+                  _methodCount);
+            return std::shared_ptr<void>(
+                  proxy, static_cast<Interface*>(proxy.get()));
+          });
+      }
+    }
+
+    /////////////////////////////////////////////////
+    template <typename Interface>
+    InterfaceProxy<Interface>::InterfaceProxy(
+        Interface *_target,
+        detail::MethodCounters *_counters,
+        const std::size_t _methodCount)
+      : target(_target),
+        counters(_counters),
+        methodCount(_methodCount)
+    {
+      // Do nothing
+    }
+
+    /////////////////////////////////////////////////
+    template <typename Interface>
+    Interface *InterfaceProxy<Interface>::Target() const
+    {
+      return this->target;
+    }
+
+    /////////////////////////////////////////////////
+    template <typename Interface>
+    template <typename Function, typename... Args>
+    decltype(auto) InterfaceProxy<Interface>::Forward(
+        const std::size_t _method,
+        Function _function,
+        Args&&... _args) const
+    {
+      assert(_method < this->methodCount);
+      if (_method >= this->methodCount)
+        return (this->target->*_function)(std::forward<Args>(_args)...);
+
+      const detail::TimedCall call(this->counters[_method]);
+      return (this->target->*_function)(std::forward<Args>(_args)...);
+    }
+  }
+}
+
+/// This is a helper for DETAIL_IGNITION_ADD_INTERFACE_PROXY, in the same way
+/// as DETAIL_IGNITION_ADD_PLUGIN_HELPER.
+#define DETAIL_IGNITION_ADD_INTERFACE_PROXY_HELPER( \
+  UniqueID, ProxyClass, ...) \
+  namespace ignition \
+  { \
+    namespace plugin \
+    { \
+      namespace \
+      { \
+        struct ExecuteWhenStarting##UniqueID \
+        { \
+          ExecuteWhenStarting##UniqueID() \
+          { \
+            ::ignition::plugin::detail::AddInterfaceProxy<ProxyClass>( \
+                {__VA_ARGS__}); \
+          } \
+        }; \
+  \
+        static ExecuteWhenStarting##UniqueID execute##UniqueID; \
+      } /* namespace */ \
+    } \
+  }
+
+/// This macro is needed to force the __COUNTER__ macro to expand to a value
+/// before being passed to the *_HELPER macro.
+#define DETAIL_IGNITION_ADD_INTERFACE_PROXY_WITH_COUNTER( \
+  UniqueID, ProxyClass, ...) \
+  DETAIL_IGNITION_ADD_INTERFACE_PROXY_HELPER( \
+    UniqueID, ProxyClass, __VA_ARGS__)
+
+/// We use the __COUNTER__ here to give each proxy registration its own unique
+/// name, which is required in order to statically initialize it.
+#define DETAIL_IGNITION_ADD_INTERFACE_PROXY(ProxyClass, ...) \
+  DETAIL_IGNITION_ADD_INTERFACE_PROXY_WITH_COUNTER( \
+    __COUNTER__, ProxyClass, __VA_ARGS__)
+
+#endif
@@ -21,9 +21,14 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <unordered_set>
+#include <vector>
 #include <ignition/plugin/EnablePluginFromThis.hh>
 #include <ignition/plugin/Loader.hh>
+#include <ignition/plugin/Trace.hh>
+#include <ignition/plugin/utility.hh>
 
 namespace ignition
 {
@@ -35,29 +40,138 @@ namespace ignition
       return this->PluginsImplementing(typeid(Interface).name(), false);
     }
 
+    template <typename... Interfaces>
+    std::unordered_set<std::string> Loader::PluginsImplementingAll() const
+    {
+      return this->PluginsImplementingAll(
+            {typeid(Interfaces).name()...}, false);
+    }
+
+    template <typename... Interfaces>
+    std::unordered_set<std::string> Loader::PluginsImplementingAny() const
+    {
+      return this->PluginsImplementingAny(
+            {typeid(Interfaces).name()...}, false);
+    }
+
+    template <typename Visitor>
+    void Loader::ForEachPlugin(Visitor &&_visitor) const
+    {
+      this->PrivateForEachPlugin(PrivateMakeVisit(_visitor));
+    }
+
+    template <typename Interface, typename Visitor>
+    void Loader::ForEachPluginImplementing(Visitor &&_visitor) const
+    {
+      this->PrivateForEachPluginImplementing(
+            typeid(Interface).name(), false, PrivateMakeVisit(_visitor));
+    }
+
+    template <typename Visitor>
+    void Loader::ForEachPluginImplementing(
+        std::string_view _interface,
+        Visitor &&_visitor,
+        const bool _demangled) const
+    {
+      this->PrivateForEachPluginImplementing(
+            _interface, _demangled, PrivateMakeVisit(_visitor));
+    }
+
+    template <typename Visitor>
+    void Loader::ForEachPluginWithAlias(
+        std::string_view _alias, Visitor &&_visitor) const
+    {
+      this->PrivateForEachPluginWithAlias(_alias, PrivateMakeVisit(_visitor));
+    }
+
+    template <typename Visitor>
+    void Loader::ForEachAliasOfPlugin(
+        std::string_view _pluginName, Visitor &&_visitor) const
+    {
+      this->PrivateForEachAliasOfPlugin(
+            _pluginName, PrivateMakeVisit(_visitor));
+    }
+
+    template <typename Visitor>
+    auto Loader::PrivateMakeVisit(Visitor &_visitor) -> Visit
+    {
+      return Visit{
+        const_cast<void*>(static_cast<const void*>(&_visitor)),
+        [](void *_v, std::string_view _name)
+        {
+          (*static_cast<Visitor*>(_v))(_name);
+        }};
+    }
+
     template <typename PluginPtrType>
     PluginPtrType Loader::Instantiate(
-        const std::string &_pluginNameOrAlias) const
+        std::string_view _pluginNameOrAlias) const
+    {
+      ConstInfoPtr info;
+      std::shared_ptr<void> dlHandle;
+      if (LookupError::NONE != this->PrivateFindPlugin(
+            _pluginNameOrAlias, false, info, dlHandle))
+        return PluginPtrType();
+
+      return this->PrivateInstantiate<PluginPtrType>(info, dlHandle);
+    }
+
+    template <typename PluginPtrType>
+    auto Loader::TryInstantiate(
+        std::string_view _pluginNameOrAlias,
+        PluginPtrType &_plugin) const -> LookupError
     {
-      const std::string &resolvedName = this->LookupPlugin(_pluginNameOrAlias);
-      if (resolvedName.empty())
-        return PluginPtr();
+      ConstInfoPtr info;
+      std::shared_ptr<void> dlHandle;
+      const LookupError error = this->PrivateFindPlugin(
+            _pluginNameOrAlias, true, info, dlHandle);
+
+      if (LookupError::NONE == error)
+        _plugin = this->PrivateInstantiate<PluginPtrType>(info, dlHandle);
+      else
+        _plugin = PluginPtrType();
 
-       PluginPtrType ptr(this->PrivateGetInfo(resolvedName),
-                         this->PrivateGetPluginDlHandlePtr(resolvedName));
+      return error;
+    }
 
-       if (auto *enableFromThis =
-              ptr->template QueryInterface<EnablePluginFromThis>())
-         enableFromThis->PrivateSetPluginFromThis(ptr);
+    template <typename PluginPtrType>
+    PluginPtrType Loader::PrivateInstantiate(
+        const ConstInfoPtr &_info,
+        const std::shared_ptr<void> &_dlHandle) const
+    {
+      IGN_PLUGIN_TRACE_SCOPE("Instantiate", _info->name);
 
-       return ptr;
+      PluginPtrType ptr(_info, _dlHandle);
+
+      // Only plugins which inherit EnablePluginFromThis need to be told about
+      // their PluginPtr, and the Registrar has already told us which ones do.
+      if (_info->HasCapability(Info::ENABLE_PLUGIN_FROM_THIS))
+      {
+        if (auto *enableFromThis =
+                ptr->template QueryInterface<EnablePluginFromThis>())
+          enableFromThis->PrivateSetPluginFromThis(ptr);
+      }
+
+      return ptr;
     }
 
     template <typename InterfaceType>
     std::shared_ptr<InterfaceType> Loader::Factory(
-        const std::string &_pluginNameOrAlias) const
+        std::string_view _pluginNameOrAlias) const
     {
-      return this->Instantiate(_pluginNameOrAlias)
+      ConstInfoPtr info;
+      std::shared_ptr<void> dlHandle;
+      if (LookupError::NONE != this->PrivateFindPlugin(
+            _pluginNameOrAlias, false, info, dlHandle))
+        return nullptr;
+
+      // A plugin can only provide a Factory if it was registered with one, so
+      // the other plugins do not need to be instantiated to find that out.
+      if (detail::IsFactory<std::remove_cv_t<InterfaceType>>::value
+          && !info->HasCapability(Info::FACTORY))
+        return nullptr;
+
+      return this->PrivateInstantiate<PluginPtr>(info, dlHandle)
           ->template QueryInterfaceSharedPtr<InterfaceType>();
     }
   }
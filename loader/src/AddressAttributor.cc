@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <dlfcn.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#include <cxxabi.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <string_view>
+#include <unordered_set>
+
+#include "AddressAttributor.hh"
+
+namespace
+{
+  /////////////////////////////////////////////////
+  /// \brief Demangle the name of a function symbol. Unlike DemangleSymbol,
+  /// this quietly keeps names which are not mangled, such as C functions.
+  /// \param[in] _symbol The symbol name
+  /// \return The demangled name
+  std::string DemangleFunction(const char *_symbol)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    int status = 0;
+    char *demangled = abi::__cxa_demangle(_symbol, nullptr, nullptr, &status);
+    if (0 == status && demangled)
+    {
+      const std::string name(demangled);
+      std::free(demangled);
+      return name;
+    }
+#endif
+    return _symbol;
+  }
+
+  /////////////////////////////////////////////////
+  /// \brief Remove the thunk prefix from a demangled function name. Calls
+  /// through a base class go through a thunk, which is named after the
+  /// function that it adjusts the pointer for.
+  /// \param[in] _symbol A demangled function name
+  /// \return The name of the function that the thunk calls
+  std::string_view WithoutThunk(std::string_view _symbol)
+  {
+    for (const std::string_view thunk :
+         {"non-virtual thunk to ", "virtual thunk to "})
+    {
+      if (_symbol.substr(0, thunk.size()) == thunk)
+        _symbol.remove_prefix(thunk.size());
+    }
+    return _symbol;
+  }
+
+  /////////////////////////////////////////////////
+  /// \brief Find the longest class name that _symbol is a member of.
+  /// \param[in] _symbol A demangled function name
+  /// \param[in] _classes The class names to choose from
+  /// \return The class name, or an empty string if none matches
+  std::string OwnerOf(
+      std::string_view _symbol,
+      const std::vector<std::string> &_classes)
+  {
+    _symbol = WithoutThunk(_symbol);
+
+    std::string owner;
+    for (const std::string &name : _classes)
+    {
+      if (name.size() > owner.size() &&
+          _symbol.size() > name.size() + 2 &&
+          _symbol.substr(0, name.size()) == name &&
+          _symbol.substr(name.size(), 2) == "::")
+      {
+        owner = name;
+      }
+    }
+    return owner;
+  }
+
+  /////////////////////////////////////////////////
+  /// \brief Check whether a character can be part of a qualified name
+  /// \param[in] _c The character
+  /// \return True if _c is a letter, a digit, an underscore, or a colon
+  bool IsNameCharacter(const char _c)
+  {
+    return (_c >= 'a' && _c <= 'z') || (_c >= 'A' && _c <= 'Z') ||
+        (_c >= '0' && _c <= '9') || '_' == _c || ':' == _c;
+  }
+
+  /////////////////////////////////////////////////
+  /// \brief Find the one class name which _symbol mentions as a whole
+  /// qualified name, such as a template argument.
+  /// \param[in] _symbol A demangled function name
+  /// \param[in] _classes The class names to choose from
+  /// \return The class name, or an empty string if none or several match
+  std::string MentionedIn(
+      std::string_view _symbol,
+      const std::vector<std::string> &_classes)
+  {
+    std::string mentioned;
+    for (const std::string &name : _classes)
+    {
+      for (std::size_t pos = _symbol.find(name);
+           std::string_view::npos != pos;
+           pos = _symbol.find(name, pos + 1))
+      {
+        const std::size_t end = pos + name.size();
+        if ((0 == pos || !IsNameCharacter(_symbol[pos - 1])) &&
+            (end == _symbol.size() || !IsNameCharacter(_symbol[end])))
+        {
+          if (!mentioned.empty())
+            return std::string();
+
+          mentioned = name;
+          break;
+        }
+      }
+    }
+    return mentioned;
+  }
+}
+
+namespace ignition
+{
+  namespace plugin
+  {
+    /////////////////////////////////////////////////
+    AddressAttributor::AddressAttributor(const Loader &_loader)
+      : loader(_loader),
+        ranges(_loader.AddressRanges())
+    {
+      // Do nothing
+    }
+
+    /////////////////////////////////////////////////
+    void AddressAttributor::Refresh()
+    {
+      this->ranges = this->loader.AddressRanges();
+    }
+
+    /////////////////////////////////////////////////
+    auto AddressAttributor::Attribute(
+        const std::uintptr_t _address) const -> Attribution
+    {
+      Attribution attribution;
+
+      auto range = std::upper_bound(this->ranges.begin(), this->ranges.end(),
+          _address, [](const std::uintptr_t _a, const Loader::AddressRange &_r)
+          {
+            return _a < _r.begin;
+          });
+
+      if (this->ranges.begin() == range || _address >= (--range)->end)
+        return attribution;
+
+      attribution.library = range->library;
+
+      Dl_info info;
+      if (0 != dladdr(reinterpret_cast<void*>(_address), &info) &&
+          info.dli_sname)
+      {
+        attribution.symbol = DemangleFunction(info.dli_sname);
+      }
+
+      attribution.plugin = OwnerOf(attribution.symbol, range->plugins);
+      if (!attribution.plugin.empty())
+        return attribution;
+
+      attribution.interface = OwnerOf(attribution.symbol, range->interfaces);
+
+      // Templates which are instantiated for one plugin, such as the factory
+      // that creates its instances, name the plugin in their arguments.
+      attribution.plugin = MentionedIn(
+            WithoutThunk(attribution.symbol), range->plugins);
+      if (!attribution.plugin.empty())
+        return attribution;
+
+      std::vector<std::string> candidates;
+      if (attribution.interface.empty())
+      {
+        candidates = range->plugins;
+      }
+      else
+      {
+        const std::unordered_set<std::string> implementers =
+            this->loader.PluginsImplementing(attribution.interface, true);
+        for (const std::string &plugin : range->plugins)
+        {
+          if (implementers.count(plugin) > 0)
+            candidates.push_back(plugin);
+        }
+      }
+
+      if (candidates.size() == 1)
+        attribution.plugin = candidates.front();
+
+      return attribution;
+    }
+  }
+}
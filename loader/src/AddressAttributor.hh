@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef IGNITION_PLUGIN_SRC_ADDRESSATTRIBUTOR_HH_
+#define IGNITION_PLUGIN_SRC_ADDRESSATTRIBUTOR_HH_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <ignition/plugin/Loader.hh>
+
+namespace ignition
+{
+  namespace plugin
+  {
+    /// \brief Finds out which plugin library, plugin, and interface the code
+    /// at an address belongs to. This is shared by the Profiler and the
+    /// allocation tracker.
+    class AddressAttributor
+    {
+      /// \brief Where an address belongs
+      public: struct Attribution
+      {
+        /// \brief The path of the plugin library, or empty if the address is
+        /// outside of every plugin library
+        public: std::string library;
+
+        /// \brief The name of the plugin, or empty if it is not known
+        public: std::string plugin;
+
+        /// \brief The name of the interface, or empty if the address is not
+        /// inside a member function of an interface
+        public: std::string interface;
+
+        /// \brief The demangled name of the nearest symbol, or empty if
+        /// there is none
+        public: std::string symbol;
+      };
+
+      /// \brief Constructor. Takes the address ranges of the libraries of
+      /// _loader.
+      /// \param[in] _loader
+      ///   The Loader whose plugins the addresses are attributed to. It must
+      ///   outlive this AddressAttributor.
+      public: explicit AddressAttributor(const Loader &_loader);
+
+      /// \brief Take the address ranges of the libraries again, for example
+      /// after more libraries have been loaded.
+      public: void Refresh();
+
+      /// \brief Find out where the code at an address belongs.
+      ///
+      /// - Addresses inside a member function of a plugin class are
+      ///   attributed to that plugin.
+      /// - Addresses inside a function whose name mentions exactly one plugin
+      ///   of the library, such as a template instantiated for the plugin
+      ///   class, are attributed to that plugin.
+      /// - Addresses inside a member function of an interface class are
+      ///   attributed to that interface, and also to the plugin if only one
+      ///   plugin of the library implements the interface.
+      /// - Other addresses inside a plugin library are attributed to the
+      ///   library, and also to the plugin if the library only provides one.
+      ///
+      /// \param[in] _address
+      ///   The address
+      /// \return Where the address belongs
+      public: Attribution Attribute(std::uintptr_t _address) const;
+
+      /// \brief The Loader whose plugins the addresses are attributed to
+      private: const Loader &loader;
+
+      /// \brief The address ranges of the plugin libraries
+      private: std::vector<Loader::AddressRange> ranges;
+    };
+  }
+}
+
+#endif
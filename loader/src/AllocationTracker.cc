@@ -0,0 +1,341 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <new>
+
+#include "AllocationTracker.hh"
+
+namespace
+{
+  /// \brief The counters of one call site. Each site has a cache line of its
+  /// own, so that threads which allocate from different sites do not slow
+  /// each other down.
+  ///
+  /// Every member has a constant initializer, so the overflow site is ready
+  /// before any constructor runs, and operator new can be called during the
+  /// static initialization of any library.
+  struct alignas(64) Site
+  {
+    /// \brief The return address of the calls to operator new, or 0 if this
+    /// slot has not been claimed
+    public: std::atomic<std::uintptr_t> caller{0};
+
+    /// \sa AllocationSiteCounts::allocations
+    public: std::atomic<std::uint64_t> allocations{0};
+
+    /// \sa AllocationSiteCounts::deallocations
+    public: std::atomic<std::uint64_t> deallocations{0};
+
+    /// \sa AllocationSiteCounts::allocatedBytes
+    public: std::atomic<std::uint64_t> allocatedBytes{0};
+
+    /// \sa AllocationSiteCounts::freedBytes
+    public: std::atomic<std::uint64_t> freedBytes{0};
+  };
+
+  /// \brief The bookkeeping which is kept in front of each allocation
+  struct Header
+  {
+    /// \brief The number of bytes that were asked for
+    public: std::uint64_t size;
+
+    /// \brief The index of the call site in the table of sites
+    public: std::uint32_t site;
+
+    /// \brief The distance from the start of the block that was allocated
+    /// to the memory that was handed out
+    public: std::uint32_t offset;
+  };
+
+  static_assert(sizeof(Header) == 16, "The header must stay small");
+
+  /// \brief log2 of the number of call sites that can be told apart
+  constexpr unsigned int SiteBits = 14;
+
+  /// \brief The number of call sites that can be told apart
+  constexpr std::size_t SiteCapacity = std::size_t(1) << SiteBits;
+
+  /// \brief The index of the site which counts allocations whose call site
+  /// is not known or did not fit into the table
+  constexpr std::uint32_t OverflowSite = SiteCapacity;
+
+  /// \brief The most slots that are tried when looking up a call site
+  constexpr std::size_t MaxProbes = 16;
+
+  /// \brief The offset of memory which does not need more than the alignment
+  /// of malloc
+  constexpr std::size_t DefaultOffset =
+      std::max(sizeof(Header), alignof(std::max_align_t));
+
+  /// \brief The table of call sites. It takes about a megabyte, so it is
+  /// only allocated once the first allocation is tracked, instead of being
+  /// reserved by every process which links against the loader. It is never
+  /// freed, because memory may still be deallocated while the process exits.
+  std::atomic<Site*> sites{nullptr};
+
+  /// \brief The site which counts allocations whose call site is not known
+  /// or did not fit into the table
+  Site overflow;
+
+  /////////////////////////////////////////////////
+  /// \brief Allocate a block of memory without calling operator new.
+  /// \param[in] _size The number of bytes to allocate
+  /// \param[in] _alignment The alignment of the block, or 0 for the
+  /// alignment of malloc
+  /// \return The block, or nullptr if it could not be allocated. It must be
+  /// freed with FreeBlock(~).
+  void *AllocateBlock(const std::size_t _size, const std::size_t _alignment)
+  {
+#ifdef _WIN32
+    // Memory from _aligned_malloc can only be freed by _aligned_free, so
+    // every block comes from _aligned_malloc.
+    return _aligned_malloc(
+          _size, std::max(_alignment, alignof(std::max_align_t)));
+#else
+    if (_alignment <= alignof(std::max_align_t))
+      return std::malloc(_size);
+
+    void *block = nullptr;
+    if (0 != posix_memalign(&block, _alignment, _size))
+      return nullptr;
+    return block;
+#endif
+  }
+
+  /////////////////////////////////////////////////
+  /// \brief Free a block that was allocated by AllocateBlock(~).
+  /// \param[in] _block The block
+  void FreeBlock(void *_block)
+  {
+#ifdef _WIN32
+    _aligned_free(_block);
+#else
+    std::free(_block);
+#endif
+  }
+
+  /////////////////////////////////////////////////
+  /// \brief Get the table of call sites, allocating it if this is the first
+  /// time that it is needed. This does not use operator new, since it is
+  /// called from within operator new.
+  /// \return The table, or nullptr if it could not be allocated
+  Site *SiteTable()
+  {
+    Site *table = sites.load(std::memory_order_acquire);
+    if (table)
+      return table;
+
+    void *const memory =
+        AllocateBlock(SiteCapacity * sizeof(Site), alignof(Site));
+    if (!memory)
+      return nullptr;
+
+    Site *const created = static_cast<Site*>(memory);
+    for (std::size_t i = 0; i < SiteCapacity; ++i)
+      new (created + i) Site;
+
+    // Another thread may have allocated the table at the same time, in which
+    // case its table is used and this one is thrown away.
+    if (!sites.compare_exchange_strong(table, created,
+          std::memory_order_acq_rel, std::memory_order_acquire))
+    {
+      FreeBlock(memory);
+      return table;
+    }
+
+    return created;
+  }
+
+  /////////////////////////////////////////////////
+  /// \brief Get a site by its index.
+  /// \param[in] _index The index of the site, which must have been returned
+  /// by SiteOf(~)
+  /// \return The site
+  Site &SiteAt(const std::uint32_t _index)
+  {
+    if (OverflowSite == _index)
+      return overflow;
+
+    return sites.load(std::memory_order_acquire)[_index];
+  }
+
+  /// \brief The steady_clock time of the first tracked allocation, or 0 if
+  /// there has not been one
+  std::atomic<std::chrono::steady_clock::rep> startTime{0};
+
+  /////////////////////////////////////////////////
+  /// \brief Find the slot of a call site, claiming a free slot for it if it
+  /// has not been seen before.
+  /// \param[in] _caller The return address of the call to operator new
+  /// \return The index of the site
+  std::uint32_t SiteOf(const std::uintptr_t _caller)
+  {
+    if (0 == _caller)
+      return OverflowSite;
+
+    Site *const table = SiteTable();
+    if (!table)
+      return OverflowSite;
+
+    // Fibonacci hashing spreads the nearby addresses of a library evenly
+    // over the table.
+    std::size_t index = static_cast<std::size_t>(
+        (static_cast<std::uint64_t>(_caller) * 0x9E3779B97F4A7C15ull)
+        >> (64 - SiteBits));
+
+    for (std::size_t probe = 0; probe < MaxProbes; ++probe)
+    {
+      Site &site = table[index];
+      std::uintptr_t current = site.caller.load(std::memory_order_relaxed);
+      if (current == _caller)
+        return static_cast<std::uint32_t>(index);
+
+      if (0 == current &&
+          (site.caller.compare_exchange_strong(
+             current, _caller, std::memory_order_relaxed) ||
+           current == _caller))
+      {
+        return static_cast<std::uint32_t>(index);
+      }
+
+      index = (index + 1) & (SiteCapacity - 1);
+    }
+
+    return OverflowSite;
+  }
+}
+
+namespace ignition
+{
+  namespace plugin
+  {
+    namespace detail
+    {
+      /////////////////////////////////////////////////
+      void *TrackedAllocate(
+          const std::size_t _size,
+          const std::size_t _alignment,
+          const void *_caller) noexcept
+      {
+        const bool overaligned = _alignment > alignof(std::max_align_t);
+        const std::size_t offset =
+            overaligned ? std::max(_alignment, sizeof(Header)) : DefaultOffset;
+
+        if (_size > std::numeric_limits<std::size_t>::max() - offset ||
+            offset > std::numeric_limits<std::uint32_t>::max())
+        {
+          return nullptr;
+        }
+
+        void *const block =
+            AllocateBlock(offset + _size, overaligned ? _alignment : 0);
+        if (!block)
+          return nullptr;
+
+        if (0 == startTime.load(std::memory_order_relaxed))
+        {
+          std::chrono::steady_clock::rep expected = 0;
+          startTime.compare_exchange_strong(expected,
+                std::chrono::steady_clock::now().time_since_epoch().count());
+        }
+
+        const std::uint32_t index =
+            SiteOf(reinterpret_cast<std::uintptr_t>(_caller));
+        Site &site = SiteAt(index);
+        site.allocations.fetch_add(1, std::memory_order_relaxed);
+        site.allocatedBytes.fetch_add(_size, std::memory_order_relaxed);
+
+        char *const ptr = static_cast<char*>(block) + offset;
+        Header *const header = reinterpret_cast<Header*>(ptr) - 1;
+        header->size = _size;
+        header->site = index;
+        header->offset = static_cast<std::uint32_t>(offset);
+        return ptr;
+      }
+
+      /////////////////////////////////////////////////
+      void TrackedDeallocate(void *_ptr) noexcept
+      {
+        if (!_ptr)
+          return;
+
+        const Header *const header = static_cast<const Header*>(_ptr) - 1;
+        Site &site = SiteAt(header->site);
+        site.deallocations.fetch_add(1, std::memory_order_relaxed);
+        site.freedBytes.fetch_add(header->size, std::memory_order_relaxed);
+
+        FreeBlock(static_cast<char*>(_ptr) - header->offset);
+      }
+    }
+
+    /////////////////////////////////////////////////
+    bool AllocationsTracked()
+    {
+      return 0 != startTime.load(std::memory_order_relaxed);
+    }
+
+    /////////////////////////////////////////////////
+    std::chrono::steady_clock::duration AllocationTrackingTime()
+    {
+      const std::chrono::steady_clock::rep start =
+          startTime.load(std::memory_order_relaxed);
+      if (0 == start)
+        return std::chrono::steady_clock::duration::zero();
+
+      return std::chrono::steady_clock::now().time_since_epoch() -
+          std::chrono::steady_clock::duration(start);
+    }
+
+    /////////////////////////////////////////////////
+    std::vector<AllocationSiteCounts> AllocationSites()
+    {
+      std::vector<AllocationSiteCounts> counts;
+      const Site *const table = sites.load(std::memory_order_acquire);
+      const std::size_t tableSize = table ? SiteCapacity : 0;
+      for (std::size_t i = 0; i <= tableSize; ++i)
+      {
+        const Site &site = i < tableSize ? table[i] : overflow;
+        AllocationSiteCounts count;
+
+        // Frees are read first, so that they are not ahead of the
+        // allocations that they belong to.
+        count.deallocations =
+            site.deallocations.load(std::memory_order_relaxed);
+        count.freedBytes = site.freedBytes.load(std::memory_order_relaxed);
+        count.allocations = site.allocations.load(std::memory_order_relaxed);
+        count.allocatedBytes =
+            site.allocatedBytes.load(std::memory_order_relaxed);
+
+        if (0 == count.allocations)
+          continue;
+
+        count.caller = site.caller.load(std::memory_order_relaxed);
+        counts.push_back(count);
+      }
+      return counts;
+    }
+  }
+}
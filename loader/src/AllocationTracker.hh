@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef IGNITION_PLUGIN_SRC_ALLOCATIONTRACKER_HH_
+#define IGNITION_PLUGIN_SRC_ALLOCATIONTRACKER_HH_
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include <ignition/plugin/detail/AllocationTracker.hh>
+
+namespace ignition
+{
+  namespace plugin
+  {
+    /// \brief The allocations that were made from one call site
+    struct AllocationSiteCounts
+    {
+      /// \brief The return address of the calls to operator new
+      public: std::uintptr_t caller = 0;
+
+      /// \brief Number of allocations
+      public: std::uint64_t allocations = 0;
+
+      /// \brief Number of those allocations that have been freed
+      public: std::uint64_t deallocations = 0;
+
+      /// \brief Number of bytes that were allocated
+      public: std::uint64_t allocatedBytes = 0;
+
+      /// \brief Number of those bytes that have been freed
+      public: std::uint64_t freedBytes = 0;
+    };
+
+    /// \brief Check whether any allocation has been tracked, which means
+    /// that the executable includes TrackAllocations.hh.
+    /// \return True if allocations are being tracked
+    bool AllocationsTracked();
+
+    /// \brief Get how long allocations have been tracked for.
+    /// \return The time since the first tracked allocation
+    std::chrono::steady_clock::duration AllocationTrackingTime();
+
+    /// \brief Get the counts of every call site that has allocated memory.
+    /// Allocations whose call site did not fit into the table of call sites
+    /// are counted under a caller of 0.
+    /// \return The counts
+    std::vector<AllocationSiteCounts> AllocationSites();
+  }
+}
+
+#endif
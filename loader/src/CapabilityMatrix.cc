@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <utility>
+
+#include <ignition/plugin/utility.hh>
+
+#include "CapabilityMatrix.hh"
+
+namespace ignition
+{
+  namespace plugin
+  {
+    /////////////////////////////////////////////////
+    void CapabilityMatrix::Add(const std::string &_name, const Info &_info)
+    {
+      std::size_t row;
+      if (this->freeRows.empty())
+      {
+        row = this->rowNames.size();
+        if (row == 64*this->stride)
+          this->Grow();
+        this->rowNames.push_back(nullptr);
+      }
+      else
+      {
+        row = this->freeRows.back();
+        this->freeRows.pop_back();
+      }
+
+      this->rowNames[row] = &_name;
+      this->rows[_name] = row;
+
+      const std::uint64_t bit = std::uint64_t(1) << (row % 64);
+      const std::size_t word = row / 64;
+      this->occupied[word] |= bit;
+
+      for (const auto &interface : _info.interfaces)
+        this->bits[this->Intern(interface.first)*this->stride + word] |= bit;
+    }
+
+    /////////////////////////////////////////////////
+    void CapabilityMatrix::Remove(const std::string &_pluginName)
+    {
+      const auto it = this->rows.find(_pluginName);
+      if (this->rows.end() == it)
+        return;
+
+      const std::size_t row = it->second;
+      const std::uint64_t mask = ~(std::uint64_t(1) << (row % 64));
+      const std::size_t word = row / 64;
+
+      this->occupied[word] &= mask;
+      for (std::size_t c = 0; c < this->columnUsers.size(); ++c)
+      {
+        std::uint64_t &column = this->bits[c*this->stride + word];
+        if (column & ~mask)
+        {
+          column &= mask;
+          this->Release(c);
+        }
+      }
+
+      this->rowNames[row] = nullptr;
+      this->freeRows.push_back(row);
+      this->rows.erase(it);
+    }
+
+    /////////////////////////////////////////////////
+    std::unordered_set<std::string> CapabilityMatrix::Query(
+        const std::vector<std::string> &_interfaces,
+        const bool _demangled,
+        const bool _all) const
+    {
+      std::vector<std::uint64_t> result;
+      if (_all)
+        result = this->occupied;
+      else
+        result.assign(this->stride, 0);
+
+      // Scratch space for the union of the columns of a demangled name which
+      // more than one mangled name demangles to
+      std::vector<std::uint64_t> merged;
+
+      std::uint64_t *const out = result.data();
+      for (const std::string &interface : _interfaces)
+      {
+        const std::uint64_t *column = nullptr;
+        if (_demangled)
+        {
+          const auto ids = this->demangledIds.find(interface);
+          if (this->demangledIds.end() != ids)
+          {
+            if (ids->second.size() == 1)
+            {
+              column = this->bits.data() + ids->second[0]*this->stride;
+            }
+            else
+            {
+              merged.assign(this->stride, 0);
+              for (const std::size_t c : ids->second)
+              {
+                for (std::size_t w = 0; w < this->stride; ++w)
+                  merged[w] |= this->bits[c*this->stride + w];
+              }
+              column = merged.data();
+            }
+          }
+        }
+        else
+        {
+          const auto id = this->mangledIds.find(interface);
+          if (this->mangledIds.end() != id)
+            column = this->bits.data() + id->second*this->stride;
+        }
+
+        if (!column)
+        {
+          // No plugin implements this interface
+          if (_all)
+            return {};
+
+          continue;
+        }
+
+        if (_all)
+        {
+          for (std::size_t w = 0; w < this->stride; ++w)
+            out[w] &= column[w];
+        }
+        else
+        {
+          for (std::size_t w = 0; w < this->stride; ++w)
+            out[w] |= column[w];
+        }
+      }
+
+      std::unordered_set<std::string> plugins;
+      this->VisitRows(out, [&](std::string_view _name)
+      {
+        plugins.emplace(_name);
+      });
+
+      return plugins;
+    }
+
+    /////////////////////////////////////////////////
+    std::size_t CapabilityMatrix::Intern(const std::string &_mangled)
+    {
+      const auto it = this->mangledIds.find(_mangled);
+      if (this->mangledIds.end() != it)
+      {
+        ++this->columnUsers[it->second];
+        return it->second;
+      }
+
+      // A released column has no bits set, so it can be handed out as it is
+      std::size_t id;
+      if (this->freeColumns.empty())
+      {
+        id = this->columnUsers.size();
+        this->columnUsers.push_back(0);
+        this->interfaceNames.emplace_back();
+        this->interfaceNames.emplace_back();
+        this->bits.resize(this->bits.size() + this->stride, 0);
+      }
+      else
+      {
+        id = this->freeColumns.back();
+        this->freeColumns.pop_back();
+      }
+
+      this->interfaceNames[2*id] = _mangled;
+      this->mangledIds[this->interfaceNames[2*id]] = id;
+      // If another mangled name already demangles to the same name, the key
+      // keeps referring to the name of that column.
+      this->interfaceNames[2*id + 1] = DemangleSymbol(_mangled);
+      this->demangledIds[this->interfaceNames[2*id + 1]].push_back(id);
+      this->columnUsers[id] = 1;
+
+      return id;
+    }
+
+    /////////////////////////////////////////////////
+    void CapabilityMatrix::Release(const std::size_t _column)
+    {
+      if (--this->columnUsers[_column] > 0)
+        return;
+
+      const std::string &name = this->interfaceNames[2*_column + 1];
+      const auto demangled = this->demangledIds.find(name);
+      std::vector<std::size_t> &columns = demangled->second;
+      columns.erase(std::find(columns.begin(), columns.end(), _column));
+      if (columns.empty())
+      {
+        this->demangledIds.erase(demangled);
+      }
+      else if (demangled->first.data() == name.data())
+      {
+        // The name of this column will be overwritten when the column gets
+        // reused, so the key has to refer to the name of another column.
+        auto node = this->demangledIds.extract(demangled);
+        node.key() = this->interfaceNames[2*node.mapped().front() + 1];
+        this->demangledIds.insert(std::move(node));
+      }
+
+      this->mangledIds.erase(this->interfaceNames[2*_column]);
+      this->freeColumns.push_back(_column);
+    }
+
+    /////////////////////////////////////////////////
+    void CapabilityMatrix::Grow()
+    {
+      const std::size_t newStride = this->stride ? 2*this->stride : 1;
+      const std::size_t columns = this->columnUsers.size();
+      std::vector<std::uint64_t> newBits(columns*newStride, 0);
+      for (std::size_t c = 0; c < columns; ++c)
+      {
+        std::copy(this->bits.begin() + c*this->stride,
+                  this->bits.begin() + (c+1)*this->stride,
+                  newBits.begin() + c*newStride);
+      }
+
+      this->bits.swap(newBits);
+      this->occupied.resize(newStride, 0);
+      this->stride = newStride;
+    }
+  }
+}
@@ -0,0 +1,232 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef IGNITION_PLUGIN_SRC_CAPABILITYMATRIX_HH_
+#define IGNITION_PLUGIN_SRC_CAPABILITYMATRIX_HH_
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <ignition/plugin/Info.hh>
+
+namespace ignition
+{
+  namespace plugin
+  {
+    /// \brief Packed bit matrix which records the interfaces that each known
+    /// plugin implements. Every interface name is interned into a dense
+    /// column ID, and every plugin is given a row. The bits are stored column
+    /// by column in one contiguous array, so the set of plugins implementing
+    /// one interface is a contiguous run of words, and a query over several
+    /// interfaces is a word-wise AND (or OR) of those runs which the compiler
+    /// can vectorize. Each column counts the plugins which use it, and it is
+    /// reused for another interface once all of them have been removed, so
+    /// loading and forgetting libraries does not grow the matrix.
+    class CapabilityMatrix
+    {
+      /// \brief Give a row to a plugin and set the bits of its interfaces.
+      /// \param[in] _name The name of the plugin. This must not already have
+      /// a row, and it must remain valid until the plugin is removed.
+      /// \param[in] _info The Info of the plugin
+      public: void Add(const std::string &_name, const Info &_info);
+
+      /// \brief Release the row of a plugin, along with the columns of the
+      /// interfaces that no other plugin implements. They will be reused by
+      /// the next plugins and interfaces that get added.
+      /// \param[in] _pluginName The name of the plugin
+      public: void Remove(const std::string &_pluginName);
+
+      /// \brief Find the plugins that implement the given interfaces.
+      /// \param[in] _interfaces Names of the interfaces
+      /// \param[in] _demangled True if the names are demangled
+      /// \param[in] _all True to require every interface, false to require
+      /// at least one of them
+      /// \return The names of the plugins that match
+      public: std::unordered_set<std::string> Query(
+          const std::vector<std::string> &_interfaces,
+          bool _demangled,
+          bool _all) const;
+
+      /// \brief Visit the plugins that implement one interface, without
+      /// allocating any memory.
+      /// \param[in] _interface Name of the interface
+      /// \param[in] _demangled True if the name is demangled
+      /// \param[in] _visitor Called with the name of each plugin
+      public: template <typename Visitor>
+      void ForEach(
+          std::string_view _interface,
+          bool _demangled,
+          const Visitor &_visitor) const;
+
+      /// \brief Visit the rows whose bits are set in a column
+      /// \param[in] _words The column
+      /// \param[in] _visitor Called with the name of each plugin
+      private: template <typename Visitor>
+      void VisitRows(
+          const std::uint64_t *_words,
+          const Visitor &_visitor) const;
+
+      /// \brief Visit the rows whose bits are set in any of several columns
+      /// \param[in] _columns The column IDs
+      /// \param[in] _visitor Called with the name of each plugin
+      private: template <typename Visitor>
+      void VisitRows(
+          const std::vector<std::size_t> &_columns,
+          const Visitor &_visitor) const;
+
+      /// \brief Visit the rows whose bits are set in a word of a column
+      /// \param[in] _word The word
+      /// \param[in] _row The row of the first bit of the word
+      /// \param[in] _visitor Called with the name of each plugin
+      private: template <typename Visitor>
+      void VisitRows(
+          std::uint64_t _word,
+          std::size_t _row,
+          const Visitor &_visitor) const;
+
+      /// \brief Get the column of an interface, creating it if necessary,
+      /// and count one more plugin as using it.
+      /// \param[in] _mangled The mangled name of the interface
+      /// \return The column ID of the interface
+      private: std::size_t Intern(const std::string &_mangled);
+
+      /// \brief Count one less plugin as using a column, and release the
+      /// column if no plugin uses it anymore.
+      /// \param[in] _column The column ID
+      private: void Release(std::size_t _column);
+
+      /// \brief Double the number of words in each column, so that more rows
+      /// fit.
+      private: void Grow();
+
+      /// \brief Storage for the interface names that are referred to by
+      /// mangledIds and demangledIds. Column c stores its mangled name at
+      /// 2*c and its demangled name at 2*c+1. A std::deque never moves its
+      /// elements when it grows.
+      private: std::deque<std::string> interfaceNames;
+
+      /// \brief Number of plugins which use each column. Columns that are not
+      /// in use have a count of 0.
+      private: std::vector<std::size_t> columnUsers;
+
+      /// \brief Columns which were released and can be reused
+      private: std::vector<std::size_t> freeColumns;
+
+      /// \brief Column IDs of the mangled interface names
+      private: std::unordered_map<std::string_view, std::size_t> mangledIds;
+
+      /// \brief Column IDs of the demangled interface names. Several mangled
+      /// names can demangle to the same name, so each demangled name has the
+      /// list of all of their columns, and its key refers to the demangled
+      /// name of one of those columns.
+      private: std::unordered_map<std::string_view, std::vector<std::size_t>>
+          demangledIds;
+
+      /// \brief Row of each plugin
+      private: std::unordered_map<std::string_view, std::size_t> rows;
+
+      /// \brief Plugin name of each row. Rows that are not in use are
+      /// nullptr.
+      private: std::vector<const std::string*> rowNames;
+
+      /// \brief Rows which were released and can be reused
+      private: std::vector<std::size_t> freeRows;
+
+      /// \brief Bits of the rows that are in use
+      private: std::vector<std::uint64_t> occupied;
+
+      /// \brief The matrix. Column c occupies the words
+      /// [c*stride, (c+1)*stride), and row r is bit r%64 of word r/64 within a
+      /// column.
+      private: std::vector<std::uint64_t> bits;
+
+      /// \brief Number of words in each column
+      private: std::size_t stride = 0;
+    };
+
+    /////////////////////////////////////////////////
+    template <typename Visitor>
+    void CapabilityMatrix::ForEach(
+        const std::string_view _interface,
+        const bool _demangled,
+        const Visitor &_visitor) const
+    {
+      if (_demangled)
+      {
+        const auto ids = this->demangledIds.find(_interface);
+        if (this->demangledIds.end() != ids)
+          this->VisitRows(ids->second, _visitor);
+
+        return;
+      }
+
+      const auto id = this->mangledIds.find(_interface);
+      if (this->mangledIds.end() == id)
+        return;
+
+      this->VisitRows(this->bits.data() + id->second*this->stride, _visitor);
+    }
+
+    /////////////////////////////////////////////////
+    template <typename Visitor>
+    void CapabilityMatrix::VisitRows(
+        const std::uint64_t *_words,
+        const Visitor &_visitor) const
+    {
+      for (std::size_t w = 0; w < this->stride; ++w)
+        this->VisitRows(_words[w], 64*w, _visitor);
+    }
+
+    /////////////////////////////////////////////////
+    template <typename Visitor>
+    void CapabilityMatrix::VisitRows(
+        const std::vector<std::size_t> &_columns,
+        const Visitor &_visitor) const
+    {
+      for (std::size_t w = 0; w < this->stride; ++w)
+      {
+        std::uint64_t word = 0;
+        for (const std::size_t column : _columns)
+          word |= this->bits[column*this->stride + w];
+
+        this->VisitRows(word, 64*w, _visitor);
+      }
+    }
+
+    /////////////////////////////////////////////////
+    template <typename Visitor>
+    void CapabilityMatrix::VisitRows(
+        std::uint64_t _word,
+        std::size_t _row,
+        const Visitor &_visitor) const
+    {
+      for (; _word; _word >>= 1, ++_row)
+      {
+        if (_word & 1)
+          _visitor(std::string_view(*this->rowNames[_row]));
+      }
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <utility>
+
+#include <ignition/plugin/Loader.hh>
+
+#include "CountingFactory.hh"
+
+namespace ignition
+{
+  namespace plugin
+  {
+    /////////////////////////////////////////////////
+    void CountingFactory::Instrument(
+        Info &_info,
+        std::shared_ptr<PluginCounters> _counters)
+    {
+      auto original = std::make_shared<CountingFactory>();
+      original->factory = std::move(_info.factory);
+      original->deleter = std::move(_info.deleter);
+      original->counters = std::move(_counters);
+
+      // A copy of the deleter is stored with every plugin instance, so it
+      // only captures a raw pointer, which std::function can hold without
+      // allocating. The factory keeps the original alive, and every instance
+      // holds on to the Info which owns the factory until after the deleter
+      // has been called.
+      CountingFactory *const raw = original.get();
+      _info.deleter = [raw](void *_instance)
+      {
+        raw->deleter(_instance);
+        raw->counters->destroyed.fetch_add(1, std::memory_order_relaxed);
+      };
+
+      if constexpr (!ConstructionTimingEnabled)
+      {
+        _info.factory = [original = std::move(original)]() -> void*
+        {
+          void *const instance = original->factory();
+          original->counters->instantiated.fetch_add(
+                1, std::memory_order_relaxed);
+          return instance;
+        };
+        return;
+      }
+
+      // Reading the clock costs more than the rest of the bookkeeping, so it
+      // is only done in builds which asked for it.
+      _info.factory = [original = std::move(original)]() -> void*
+      {
+        const auto start = std::chrono::steady_clock::now();
+        void *const instance = original->factory();
+        PluginCounters &counters = *original->counters;
+        counters.constructionTime.fetch_add(
+              std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count(),
+              std::memory_order_relaxed);
+        counters.instantiated.fetch_add(1, std::memory_order_relaxed);
+        return instance;
+      };
+    }
+  }
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef IGNITION_PLUGIN_SRC_COUNTINGFACTORY_HH_
+#define IGNITION_PLUGIN_SRC_COUNTINGFACTORY_HH_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <ignition/plugin/Info.hh>
+
+namespace ignition
+{
+  namespace plugin
+  {
+    /// \brief The instance counters of one plugin. Every version of the
+    /// plugin shares the same counters, and the factories which update them
+    /// keep them alive, so instances stay counted after the Loader is gone.
+    /// Each set of counters gets its own cache line, so that busy plugins do
+    /// not slow each other down.
+    struct alignas(64) PluginCounters
+    {
+      /// \brief Number of instances that have been created
+      public: std::atomic<std::uint64_t> instantiated{0};
+
+      /// \brief Number of instances that have been destroyed
+      public: std::atomic<std::uint64_t> destroyed{0};
+
+      /// \brief Total time spent in the factory, in nanoseconds. This is
+      /// only updated if ConstructionTimingEnabled is true.
+      public: std::atomic<std::chrono::nanoseconds::rep> constructionTime{0};
+
+      /// \brief The path of the library which most recently provided the
+      /// plugin. This is only touched while the Loader is being modified.
+      public: std::string library;
+    };
+
+    /////////////////////////////////////////////////
+    /// \brief The original factory and deleter of a plugin, which are called
+    /// by the counting versions that replace them in its Info.
+    struct CountingFactory
+    {
+      /// \brief Replace the factory and deleter of _info with versions that
+      /// update _counters.
+      /// \param[in, out] _info The Info to instrument
+      /// \param[in] _counters The counters of the plugin
+      public: static void Instrument(
+          Info &_info,
+          std::shared_ptr<PluginCounters> _counters);
+
+      /// \brief The factory which was provided by the plugin library
+      public: std::function<void*()> factory;
+
+      /// \brief The deleter which was provided by the plugin library
+      public: std::function<void(void*)> deleter;
+
+      /// \brief The counters to update
+      public: std::shared_ptr<PluginCounters> counters;
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <iostream>
+
+#include "Diagnostics.hh"
+
+namespace ignition
+{
+  namespace plugin
+  {
+    /////////////////////////////////////////////////
+    Diagnostics::Diagnostics()
+      : sink([](const std::string &_message) { std::cerr << _message; }),
+        burst(0),
+        period(std::chrono::seconds(1)),
+        periodStart(std::chrono::steady_clock::now())
+    {
+      // Do nothing
+    }
+
+    /////////////////////////////////////////////////
+    void Diagnostics::SetSink(
+        Loader::DiagnosticSink _sink,
+        const std::size_t _burst,
+        const std::chrono::milliseconds _period)
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->sink = std::move(_sink);
+      this->burst = _burst;
+      this->period = _period;
+      this->periodStart = std::chrono::steady_clock::now();
+      this->delivered = 0;
+      this->dropped = 0;
+    }
+
+    /////////////////////////////////////////////////
+    bool Diagnostics::Admit(std::size_t &_dropped) const
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      if (0 == this->burst)
+        return true;
+
+      const auto now = std::chrono::steady_clock::now();
+      if (now - this->periodStart >= this->period)
+      {
+        this->periodStart = now;
+        this->delivered = 0;
+      }
+
+      if (this->delivered >= this->burst)
+      {
+        ++this->dropped;
+        return false;
+      }
+
+      ++this->delivered;
+      _dropped = this->dropped;
+      this->dropped = 0;
+      return true;
+    }
+  }
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef IGNITION_PLUGIN_SRC_DIAGNOSTICS_HH_
+#define IGNITION_PLUGIN_SRC_DIAGNOSTICS_HH_
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <sstream>
+
+#include <ignition/plugin/Loader.hh>
+
+namespace ignition
+{
+  namespace plugin
+  {
+    /// \brief Delivers the diagnostic messages of a Loader to its sink, and
+    /// drops the messages that exceed its rate limit before they get
+    /// formatted.
+    class Diagnostics
+    {
+      /// \brief Constructor. Messages go to std::cerr without a rate limit
+      /// until SetSink is called.
+      public: Diagnostics();
+
+      /// \sa Loader::SetDiagnosticSink()
+      public: void SetSink(
+          Loader::DiagnosticSink _sink,
+          std::size_t _burst,
+          std::chrono::milliseconds _period);
+
+      /// \brief Deliver a message, unless the rate limit has been reached.
+      /// \param[in] _write Called with a std::ostream to format the message
+      /// into. It is only called if the message will be delivered.
+      public: template <typename Writer>
+      void Report(const Writer &_write) const;
+
+      /// \brief Check whether a message may be delivered now.
+      /// \param[out] _dropped The number of messages that were dropped since
+      /// the last one that was delivered
+      /// \return True if the message may be delivered
+      private: bool Admit(std::size_t &_dropped) const;
+
+      /// \brief The function which receives the messages
+      private: Loader::DiagnosticSink sink;
+
+      /// \brief The most messages that can be delivered in one period, or 0
+      /// if there is no limit
+      private: std::size_t burst;
+
+      /// \brief The length of each period
+      private: std::chrono::steady_clock::duration period;
+
+      /// \brief Protects the fields below, since messages can be reported
+      /// by the const member functions of the Loader.
+      private: mutable std::mutex mutex;
+
+      /// \brief When the current period began
+      private: mutable std::chrono::steady_clock::time_point periodStart;
+
+      /// \brief Number of messages delivered in the current period
+      private: mutable std::size_t delivered = 0;
+
+      /// \brief Number of messages dropped since the last delivery
+      private: mutable std::size_t dropped = 0;
+    };
+
+    /////////////////////////////////////////////////
+    template <typename Writer>
+    void Diagnostics::Report(const Writer &_write) const
+    {
+      if (!this->sink)
+        return;
+
+      std::size_t droppedBefore = 0;
+      if (!this->Admit(droppedBefore))
+        return;
+
+      // The sink is called without holding the lock, so that it is free to
+      // use the Loader that reported the message.
+      if (droppedBefore > 0)
+      {
+        std::stringstream notice;
+        notice << "[ignition::plugin::Loader] Dropped " << droppedBefore
+               << " diagnostic message" << (droppedBefore == 1 ? "" : "s")
+               << " because of the rate limit.\n";
+        this->sink(notice.str());
+      }
+
+      std::stringstream ss;
+      _write(ss);
+      this->sink(ss.str());
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,331 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sys/mman.h>
+#endif
+
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+
+#include "FrozenIndex.hh"
+
+namespace ignition
+{
+  namespace plugin
+  {
+    /// \brief Incremented in every child process that gets forked, so that a
+    /// FrozenIndex can tell when its Local belongs to another process.
+    static std::atomic<std::uint64_t> forkGeneration(0);
+
+    /////////////////////////////////////////////////
+    /// \brief Get the fork generation of the calling process
+    /// \return The number of forks between the first FrozenIndex and the
+    /// calling process
+    static std::uint64_t ForkGeneration()
+    {
+#ifdef _WIN32
+      // There is no fork() on Windows, so every index stays in the process
+      // that built it.
+      return forkGeneration.load(std::memory_order_acquire);
+#else
+      static std::once_flag registered;
+      std::call_once(registered, []()
+      {
+        pthread_atfork(nullptr, nullptr, []()
+        {
+          forkGeneration.fetch_add(1, std::memory_order_relaxed);
+        });
+      });
+
+      return forkGeneration.load(std::memory_order_acquire);
+#endif
+    }
+
+    /////////////////////////////////////////////////
+    FrozenIndex::FrozenIndex(const std::vector<Entry> &_entries)
+      : localFork(ForkGeneration() - 1)
+    {
+      const std::size_t size = _entries.size();
+      if (0 == size)
+        return;
+
+      // Pin every plugin once, no matter how many keys resolve to it.
+      std::unordered_map<const Info*, std::size_t> plugins;
+      std::vector<std::size_t> entryPlugins(size, NoPlugin);
+      for (std::size_t i = 0; i < size; ++i)
+      {
+        const Entry &entry = _entries[i];
+        if (!entry.info)
+          continue;
+
+        const auto inserted =
+            plugins.insert({entry.info.get(), this->infos.size()});
+        if (inserted.second)
+        {
+          this->dlHandles.push_back(entry.dlHandle);
+          this->infos.push_back(entry.info);
+        }
+        entryPlugins[i] = inserted.first->second;
+      }
+
+      // Sort the keys into buckets that hold two keys on average. Every bucket
+      // will get its own displacement seed which sends each of its keys into a
+      // distinct slot that no other bucket has claimed.
+      std::vector<std::uint64_t> bucketSeeds(size/2 + 1, 0);
+      std::vector<std::uint64_t> hashes(size);
+      std::vector<std::vector<std::size_t>> buckets(bucketSeeds.size());
+      for (std::size_t i = 0; i < size; ++i)
+      {
+        hashes[i] = Hash(_entries[i].key);
+        buckets[hashes[i] % bucketSeeds.size()].push_back(i);
+      }
+
+      // Place the largest buckets first, while there are still plenty of free
+      // slots to choose from.
+      std::vector<std::size_t> order(buckets.size());
+      for (std::size_t b = 0; b < order.size(); ++b)
+        order[b] = b;
+
+      std::stable_sort(order.begin(), order.end(),
+          [&](const std::size_t _a, const std::size_t _b)
+          {
+            return buckets[_a].size() > buckets[_b].size();
+          });
+
+      const std::size_t unclaimed = size;
+      std::vector<std::size_t> slotOwner(size, unclaimed);
+      std::vector<std::size_t> candidates;
+      for (const std::size_t b : order)
+      {
+        const std::vector<std::size_t> &bucket = buckets[b];
+        if (bucket.empty())
+          break;
+
+        // There is always at least one free slot for each key that still needs
+        // to be placed, so this search will terminate.
+        for (std::uint64_t seed = 1; ; ++seed)
+        {
+          candidates.clear();
+          bool collision = false;
+          for (const std::size_t key : bucket)
+          {
+            const std::size_t slot = Slot(hashes[key], seed, size);
+            if (slotOwner[slot] != unclaimed ||
+                std::find(candidates.begin(), candidates.end(), slot)
+                  != candidates.end())
+            {
+              collision = true;
+              break;
+            }
+            candidates.push_back(slot);
+          }
+
+          if (collision)
+            continue;
+
+          for (std::size_t k = 0; k < bucket.size(); ++k)
+            slotOwner[candidates[k]] = bucket[k];
+
+          bucketSeeds[b] = seed;
+          break;
+        }
+      }
+
+      // Lay out the region as [seeds][records][characters]. The seeds come
+      // first because they have the strictest alignment.
+      static_assert(alignof(Record) <= alignof(std::uint64_t),
+                    "The region layout assumes that the seeds have the "
+                    "strictest alignment");
+      const std::size_t seedBytes = bucketSeeds.size()*sizeof(std::uint64_t);
+      const std::size_t recordBytes = size*sizeof(Record);
+      std::size_t charBytes = 0;
+      for (const Entry &entry : _entries)
+        charBytes += entry.key.size() + entry.resolved.size();
+
+      this->regionSize = seedBytes + recordBytes + charBytes;
+#ifdef _WIN32
+      this->region = VirtualAlloc(nullptr, this->regionSize,
+                                  MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+      if (!this->region)
+#else
+      this->region = mmap(nullptr, this->regionSize, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (MAP_FAILED == this->region)
+#endif
+      {
+        // LCOV_EXCL_START
+        std::cerr << "[ignition::plugin::Loader::Freeze] Failed to map "
+                  << this->regionSize << " bytes for the frozen index. "
+                  << "Lookups will not find any plugins.\n";
+        this->region = nullptr;
+        this->regionSize = 0;
+        return;
+        // LCOV_EXCL_STOP
+      }
+
+      char *const begin = static_cast<char*>(this->region);
+      std::uint64_t *const seedsOut = reinterpret_cast<std::uint64_t*>(begin);
+      Record *const recordsOut =
+          reinterpret_cast<Record*>(begin + seedBytes);
+      char *chars = begin + seedBytes + recordBytes;
+
+      std::copy(bucketSeeds.begin(), bucketSeeds.end(), seedsOut);
+
+      for (std::size_t slot = 0; slot < size; ++slot)
+      {
+        const Entry &entry = _entries[slotOwner[slot]];
+        Record &record = recordsOut[slot];
+
+        record.key = chars;
+        record.keyLength = entry.key.size();
+        chars = std::copy(entry.key.begin(), entry.key.end(), chars);
+
+        record.resolved = nullptr;
+        record.resolvedLength = entry.resolved.size();
+        if (!entry.resolved.empty())
+        {
+          record.resolved = chars;
+          chars = std::copy(entry.resolved.begin(), entry.resolved.end(),
+                            chars);
+        }
+
+        record.plugin = entryPlugins[slotOwner[slot]];
+      }
+
+      // Nothing may write to the index from now on. If anything tries to, it
+      // will crash immediately instead of silently unsharing the pages of
+      // forked processes.
+#ifdef _WIN32
+      DWORD oldProtection;
+      VirtualProtect(this->region, this->regionSize, PAGE_READONLY,
+                     &oldProtection);
+#else
+      mprotect(this->region, this->regionSize, PROT_READ);
+#endif
+
+      this->seeds = seedsOut;
+      this->bucketCount = bucketSeeds.size();
+      this->records = recordsOut;
+      this->recordCount = size;
+    }
+
+    /////////////////////////////////////////////////
+    FrozenIndex::~FrozenIndex()
+    {
+      if (!this->region)
+        return;
+
+#ifdef _WIN32
+      VirtualFree(this->region, 0, MEM_RELEASE);
+#else
+      munmap(this->region, this->regionSize);
+#endif
+    }
+
+    /////////////////////////////////////////////////
+    auto FrozenIndex::Find(std::string_view _key) const -> const Record*
+    {
+      if (0 == this->recordCount)
+        return nullptr;
+
+      const std::uint64_t hash = Hash(_key);
+      const Record &record = this->records[
+          Slot(hash, this->seeds[hash % this->bucketCount],
+               this->recordCount)];
+
+      if (record.keyLength != _key.size() ||
+          !std::equal(_key.begin(), _key.end(), record.key))
+        return nullptr;
+
+      return &record;
+    }
+
+    /////////////////////////////////////////////////
+    void FrozenIndex::Resolve(
+        const Record &_record,
+        ConstInfoPtr &_info,
+        std::shared_ptr<void> &_dlHandle) const
+    {
+      const std::shared_ptr<const Local> &process = this->LocalOfProcess();
+      _info = process->infos[_record.plugin];
+      _dlHandle = std::shared_ptr<void>(
+            process, process->dlHandles[_record.plugin].get());
+    }
+
+    /////////////////////////////////////////////////
+    auto FrozenIndex::LocalOfProcess() const
+        -> const std::shared_ptr<const Local>&
+    {
+      const std::uint64_t fork = ForkGeneration();
+      if (this->localFork.load(std::memory_order_acquire) == fork)
+        return this->local;
+
+      std::lock_guard<std::mutex> lock(this->localMutex);
+      if (this->localFork.load(std::memory_order_relaxed) == fork)
+        return this->local;
+
+      // Copying the pinned pointers writes to their reference counters once,
+      // and every pointer that gets handed out afterwards only writes to the
+      // reference counters of the copies, which live in memory that belongs to
+      // this process.
+      auto process = std::make_shared<Local>();
+      process->dlHandles = this->dlHandles;
+      process->infos.reserve(this->infos.size());
+      for (const ConstInfoPtr &info : this->infos)
+        process->infos.push_back(std::make_shared<const Info>(*info));
+
+      this->local = std::move(process);
+      this->localFork.store(fork, std::memory_order_release);
+      return this->local;
+    }
+
+    /////////////////////////////////////////////////
+    std::uint64_t FrozenIndex::Hash(std::string_view _key)
+    {
+      std::uint64_t hash = 14695981039346656037ull;
+      for (const char c : _key)
+      {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+      }
+      return hash;
+    }
+
+    /////////////////////////////////////////////////
+    std::size_t FrozenIndex::Slot(
+        const std::uint64_t _hash,
+        const std::uint64_t _seed,
+        const std::size_t _size)
+    {
+      // The splitmix64 finalizer scrambles the key hash with the seed, so each
+      // seed gives an independent placement of the keys in a bucket.
+      std::uint64_t x = _hash ^ (_seed * 0x9e3779b97f4a7c15ull);
+      x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+      x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+      x = x ^ (x >> 31);
+      return static_cast<std::size_t>(x % _size);
+    }
+  }
+}
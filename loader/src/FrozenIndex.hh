@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef IGNITION_PLUGIN_SRC_FROZENINDEX_HH_
+#define IGNITION_PLUGIN_SRC_FROZENINDEX_HH_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <ignition/plugin/Info.hh>
+
+namespace ignition
+{
+  namespace plugin
+  {
+    /// \brief Immutable index over the plugin names and aliases of a frozen
+    /// Loader. The keys are placed with a minimal perfect hash (hash and
+    /// displace), so every key occupies exactly one slot of the record table
+    /// and a lookup costs one hash of the key string plus one comparison.
+    ///
+    /// The seeds, the records, and the characters of every key are compacted
+    /// into one contiguous memory mapping which is made read-only as soon as
+    /// it has been filled in. Lookups never write to it, so processes that are
+    /// forked after Loader::Freeze() keep sharing its pages.
+    ///
+    /// The index also pins the Info and the library handle of every plugin
+    /// for as long as it exists. The pointers that it hands out do not share
+    /// the reference counters of the pinned objects, because incrementing
+    /// those would unshare a page of the parent process each time a worker
+    /// instantiates a plugin. Instead, each process gets its own copy of every
+    /// Info and its own owner of the library handles the first time that it
+    /// asks for them.
+    class FrozenIndex
+    {
+      /// \brief Description of one key, used to construct the index
+      public: struct Entry
+      {
+        /// \brief The plugin name or alias that this entry is keyed on
+        std::string key;
+
+        /// \brief Name of the plugin that the key resolves to. This is empty
+        /// if the key is an alias which refers to more than one plugin.
+        std::string resolved;
+
+        /// \brief Info of the resolved plugin, or nullptr if the key is
+        /// ambiguous
+        ConstInfoPtr info;
+
+        /// \brief Handle of the library that provides the resolved plugin, or
+        /// nullptr if the key is ambiguous
+        std::shared_ptr<void> dlHandle;
+      };
+
+      /// \brief The compacted form of an Entry that lives inside the read-only
+      /// region. Its character pointers also point inside the region.
+      public: struct Record
+      {
+        /// \brief Characters of the key (not null-terminated)
+        const char *key;
+
+        /// \brief Characters of the resolved plugin name (not
+        /// null-terminated), or nullptr if the key is ambiguous
+        const char *resolved;
+
+        /// \brief Number of characters in key
+        std::size_t keyLength;
+
+        /// \brief Number of characters in resolved
+        std::size_t resolvedLength;
+
+        /// \brief Position of the resolved plugin in the pinned tables, or
+        /// NoPlugin if the key is ambiguous
+        std::size_t plugin;
+      };
+
+      /// \brief Value of Record::plugin for an ambiguous key
+      public: static constexpr std::size_t NoPlugin =
+          static_cast<std::size_t>(-1);
+
+      /// \brief Constructor. Builds the perfect hash over _entries and
+      /// compacts it into the read-only region.
+      /// \param[in] _entries Every key that this index should contain. Each
+      /// key must be unique.
+      public: explicit FrozenIndex(const std::vector<Entry> &_entries);
+
+      /// \brief Destructor. Unmaps the read-only region.
+      public: ~FrozenIndex();
+
+      /// \brief Find the record of a plugin name or alias
+      /// \param[in] _key The plugin name or alias to look for
+      /// \return The record for _key, or nullptr if _key is not in this index.
+      public: const Record *Find(std::string_view _key) const;
+
+      /// \brief Get the Info and the library handle of the plugin that a
+      /// record resolves to. The reference counters of the returned pointers
+      /// belong to the calling process.
+      /// \param[in] _record A record which was returned by Find(~) and which
+      /// is not ambiguous
+      /// \param[out] _info The Info of the plugin
+      /// \param[out] _dlHandle The handle of the library of the plugin
+      public: void Resolve(
+          const Record &_record,
+          ConstInfoPtr &_info,
+          std::shared_ptr<void> &_dlHandle) const;
+
+      /// \brief Hash a key. This is the only pass that a lookup makes over the
+      /// characters of its key before the final comparison.
+      /// \param[in] _key The key to hash
+      /// \return 64-bit FNV-1a hash of _key
+      private: static std::uint64_t Hash(std::string_view _key);
+
+      /// \brief Pick the slot of a key from its hash and the displacement seed
+      /// of its bucket.
+      /// \param[in] _hash Result of Hash(~) for the key
+      /// \param[in] _seed Displacement seed of the bucket of the key
+      /// \param[in] _size Number of slots
+      /// \return The slot index for the key
+      private: static std::size_t Slot(
+          std::uint64_t _hash, std::uint64_t _seed, std::size_t _size);
+
+      /// \brief Pointers whose reference counters belong to one process
+      private: struct Local
+      {
+        /// \brief Copies of the pinned library handles. Handles that are
+        /// handed out share the reference counter of this Local.
+        std::vector<std::shared_ptr<void>> dlHandles;
+
+        /// \brief Copies of the pinned Info objects. These are declared after
+        /// the library handles so that they are destroyed first.
+        std::vector<ConstInfoPtr> infos;
+      };
+
+      /// \brief Get the Local of the calling process, creating it if the
+      /// process has been forked since the last one was created.
+      /// \return The Local of the calling process
+      private: const std::shared_ptr<const Local> &LocalOfProcess() const;
+
+      /// \brief The library handle of each plugin, in the order of
+      /// Record::plugin
+      private: std::vector<std::shared_ptr<void>> dlHandles;
+
+      /// \brief The Info of each plugin, in the order of Record::plugin
+      private: std::vector<ConstInfoPtr> infos;
+
+      /// \brief Serializes the creation of local
+      private: mutable std::mutex localMutex;
+
+      /// \brief The Local of the process that last created it
+      private: mutable std::shared_ptr<const Local> local;
+
+      /// \brief The fork generation in which local was created
+      private: mutable std::atomic<std::uint64_t> localFork;
+
+      /// \brief Start of the read-only region, or nullptr for an empty index
+      private: void *region = nullptr;
+
+      /// \brief Size of the read-only region in bytes
+      private: std::size_t regionSize = 0;
+
+      /// \brief Displacement seed for each bucket (inside the region)
+      private: const std::uint64_t *seeds = nullptr;
+
+      /// \brief Number of buckets
+      private: std::size_t bucketCount = 0;
+
+      /// \brief The records, stored at the slot that the hash assigns them
+      /// (inside the region)
+      private: const Record *records = nullptr;
+
+      /// \brief Number of records
+      private: std::size_t recordCount = 0;
+    };
+  }
+}
+
+#endif
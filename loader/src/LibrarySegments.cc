@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <dlfcn.h>
+
+#ifdef __linux__
+#include <link.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+
+#include "LibrarySegments.hh"
+
+namespace ignition
+{
+  namespace plugin
+  {
+    /////////////////////////////////////////////////
+    std::vector<Segment> LoadedSegments(void *_dlHandle)
+    {
+      std::vector<Segment> segments;
+#ifdef __linux__
+      struct link_map *linkMap = nullptr;
+      if (0 != dlinfo(_dlHandle, RTLD_DI_LINKMAP, &linkMap) || !linkMap)
+        return segments;
+
+      struct Search
+      {
+        const struct link_map *linkMap;
+        std::vector<Segment> &segments;
+      } search{linkMap, segments};
+
+      dl_iterate_phdr([](struct dl_phdr_info *_info, size_t, void *_data)
+      {
+        Search &s = *static_cast<Search*>(_data);
+        if (_info->dlpi_addr != s.linkMap->l_addr ||
+            std::strcmp(_info->dlpi_name, s.linkMap->l_name) != 0)
+        {
+          return 0;
+        }
+
+        for (ElfW(Half) i = 0; i < _info->dlpi_phnum; ++i)
+        {
+          const ElfW(Phdr) &phdr = _info->dlpi_phdr[i];
+          if (PT_LOAD != phdr.p_type)
+            continue;
+
+          const std::uintptr_t begin = _info->dlpi_addr + phdr.p_vaddr;
+          s.segments.push_back({begin, begin + phdr.p_memsz, phdr.p_flags});
+        }
+
+        return 1;
+      }, &search);
+#else
+      (void)_dlHandle;
+#endif
+      return segments;
+    }
+
+    /////////////////////////////////////////////////
+    std::size_t PrefaultLibrary(void *_dlHandle)
+    {
+      std::size_t pages = 0;
+#ifdef __linux__
+      const std::uintptr_t pageSize =
+          static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+
+      for (const Segment &segment : LoadedSegments(_dlHandle))
+      {
+        if (!(segment.flags & PF_R))
+          continue;
+
+        const std::uintptr_t begin = segment.begin & ~(pageSize - 1);
+        madvise(reinterpret_cast<void*>(begin), segment.end - begin,
+                MADV_WILLNEED);
+
+        // Reading one byte of each page is enough to map it in. Nothing is
+        // written, so the pages stay shared with other processes.
+        for (std::uintptr_t page = begin; page < segment.end; page += pageSize)
+        {
+          static_cast<void>(*reinterpret_cast<const volatile char*>(page));
+          ++pages;
+        }
+      }
+#else
+      (void)_dlHandle;
+#endif
+      return pages;
+    }
+  }
+}
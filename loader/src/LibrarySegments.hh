@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef IGNITION_PLUGIN_SRC_LIBRARYSEGMENTS_HH_
+#define IGNITION_PLUGIN_SRC_LIBRARYSEGMENTS_HH_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ignition
+{
+  namespace plugin
+  {
+    /// \brief A loadable segment of a library, as it is mapped in memory
+    struct Segment
+    {
+      /// \brief The address of the first byte of the segment
+      public: std::uintptr_t begin;
+
+      /// \brief The address one past the last byte of the segment
+      public: std::uintptr_t end;
+
+      /// \brief The PF_R, PF_W, and PF_X flags of the segment
+      public: std::uint32_t flags;
+    };
+
+    /// \brief Find the loadable segments of a library.
+    /// \param[in] _dlHandle The handle of the library
+    /// \return The segments, or nothing if they could not be found. This is
+    /// only available on Linux.
+    std::vector<Segment> LoadedSegments(void *_dlHandle);
+
+    /// \brief Fault in every page of the loadable segments of a library, so
+    /// that the first call into it does not have to wait for disk reads or
+    /// page faults.
+    /// \param[in] _dlHandle The handle of the library
+    /// \return The number of pages that were touched
+    std::size_t PrefaultLibrary(void *_dlHandle);
+  }
+}
+
+#endif
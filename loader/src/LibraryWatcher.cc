@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "LibraryWatcher.hh"
+
+namespace ignition
+{
+  namespace plugin
+  {
+    /////////////////////////////////////////////////
+    LibraryWatcher::~LibraryWatcher()
+    {
+#ifdef __linux__
+      if (this->fd >= 0)
+        close(this->fd);
+#endif
+    }
+
+    /////////////////////////////////////////////////
+    bool LibraryWatcher::Watch(const std::string &_pathToLibrary)
+    {
+#ifdef __linux__
+      if (this->fd < 0)
+      {
+        this->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (this->fd < 0)
+          return false;
+      }
+
+      const std::size_t slash = _pathToLibrary.rfind('/');
+      std::string directory = ".";
+      if (0 == slash)
+        directory = "/";
+      else if (std::string::npos != slash)
+        directory = _pathToLibrary.substr(0, slash);
+
+      const std::string file = _pathToLibrary.substr(
+            std::string::npos == slash ? 0 : slash + 1);
+
+      // A library is rewritten in place when its file is closed after being
+      // written, and it is replaced when a new file is renamed over it.
+      const int wd = inotify_add_watch(
+            this->fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+      if (wd < 0)
+        return false;
+
+      this->directories[directory] = wd;
+      this->files[std::make_pair(wd, file)] = _pathToLibrary;
+      return true;
+#else
+      (void)_pathToLibrary;
+      return false;
+#endif
+    }
+
+    /////////////////////////////////////////////////
+    bool LibraryWatcher::Unwatch(const std::string &_pathToLibrary)
+    {
+      auto it = this->files.begin();
+      while (this->files.end() != it && it->second != _pathToLibrary)
+        ++it;
+
+      if (this->files.end() == it)
+        return false;
+
+      const int wd = it->first.first;
+      this->files.erase(it);
+
+      for (const auto &file : this->files)
+      {
+        if (file.first.first == wd)
+          return true;
+      }
+
+      // No other library in this directory is being watched
+      for (auto dir = this->directories.begin();
+           dir != this->directories.end(); ++dir)
+      {
+        if (dir->second == wd)
+        {
+          this->directories.erase(dir);
+          break;
+        }
+      }
+
+#ifdef __linux__
+      inotify_rm_watch(this->fd, wd);
+#endif
+      return true;
+    }
+
+    /////////////////////////////////////////////////
+    int LibraryWatcher::Descriptor() const
+    {
+      return this->fd;
+    }
+
+    /////////////////////////////////////////////////
+    std::set<std::string> LibraryWatcher::TakeChanges()
+    {
+      std::set<std::string> changed;
+
+#ifdef __linux__
+      if (this->fd < 0)
+        return changed;
+
+      alignas(struct inotify_event) char buffer[4096];
+      while (true)
+      {
+        const ssize_t length = read(this->fd, buffer, sizeof(buffer));
+        if (length <= 0)
+          break;
+
+        for (const char *ptr = buffer; ptr < buffer + length;)
+        {
+          const auto *event = reinterpret_cast<const inotify_event*>(ptr);
+          ptr += sizeof(inotify_event) + event->len;
+
+          if (event->mask & IN_Q_OVERFLOW)
+          {
+            // Some events were lost, so any library might have changed
+            for (const auto &file : this->files)
+              changed.insert(file.second);
+            continue;
+          }
+
+          if (0 == event->len)
+            continue;
+
+          const auto file = this->files.find(
+                std::make_pair(event->wd, std::string(event->name)));
+          if (this->files.end() != file)
+            changed.insert(file->second);
+        }
+      }
+#endif
+
+      return changed;
+    }
+  }
+}
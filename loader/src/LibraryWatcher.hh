@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef IGNITION_PLUGIN_SRC_LIBRARYWATCHER_HH_
+#define IGNITION_PLUGIN_SRC_LIBRARYWATCHER_HH_
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+
+namespace ignition
+{
+  namespace plugin
+  {
+    /// \brief Watches the files of libraries with inotify. Each directory
+    /// which contains a watched library gets one watch, because tools often
+    /// replace a library by renaming a new file over it, which a watch on the
+    /// file itself would not notice.
+    class LibraryWatcher
+    {
+      /// \brief Destructor. Closes the inotify descriptor.
+      public: ~LibraryWatcher();
+
+      /// \sa Loader::WatchLib()
+      public: bool Watch(const std::string &_pathToLibrary);
+
+      /// \sa Loader::UnwatchLib()
+      public: bool Unwatch(const std::string &_pathToLibrary);
+
+      /// \sa Loader::LibraryWatchDescriptor()
+      public: int Descriptor() const;
+
+      /// \brief Read the pending events without blocking.
+      /// \return The paths of the watched libraries whose files have changed
+      public: std::set<std::string> TakeChanges();
+
+      /// \brief The inotify descriptor, or -1 if it has not been created
+      private: int fd = -1;
+
+      /// \brief The path of each watched library, keyed by the watch of its
+      /// directory and its file name
+      private: std::map<std::pair<int, std::string>, std::string> files;
+
+      /// \brief The watch of each directory
+      private: std::map<std::string, int> directories;
+    };
+  }
+}
+
+#endif
@@ -17,64 +17,216 @@
 
 #include <dlfcn.h>
 
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <link.h>
+#endif
+
 #include <algorithm>
+#include <atomic>
 #include <cassert>
-#include <functional>
-#include <iostream>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <locale>
+#include <map>
+#include <set>
 #include <sstream>
+#include <string_view>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <ignition/plugin/Info.hh>
+#include <ignition/plugin/InterfaceProxy.hh>
 #include <ignition/plugin/Loader.hh>
 #include <ignition/plugin/Plugin.hh>
+#include <ignition/plugin/Trace.hh>
 
 #include <ignition/plugin/utility.hh>
 
+#include "AddressAttributor.hh"
+#include "AllocationTracker.hh"
+#include "CapabilityMatrix.hh"
+#include "CountingFactory.hh"
+#include "Diagnostics.hh"
+#include "FrozenIndex.hh"
+#include "LibraryWatcher.hh"
+#include "LibrarySegments.hh"
+#include "NameMap.hh"
+#include "ProxyInstances.hh"
+#include "UnloadReaper.hh"
+
 namespace ignition
 {
   namespace plugin
   {
+    /////////////////////////////////////////////////
+    /// \brief Get the flags for dlopen that correspond to a set of options.
+    /// \param[in] _options The options
+    /// \return The flags
+    static int DlopenFlags(const Loader::LoadOptions &_options)
+    {
+      int flags = _options.bindNow ? RTLD_NOW : RTLD_LAZY;
+      flags |= _options.global ? RTLD_GLOBAL : RTLD_LOCAL;
+
+#ifdef RTLD_DEEPBIND
+      if (_options.deepBind)
+        flags |= RTLD_DEEPBIND;
+#endif
+
+#ifdef RTLD_NODELETE
+      if (_options.noDelete)
+        flags |= RTLD_NODELETE;
+#endif
+
+      return flags;
+    }
+
+    /////////////////////////////////////////////////
+    /// \brief Get the time that has passed since _start.
+    /// \param[in] _start When the measurement started
+    /// \return The elapsed time
+    static std::chrono::nanoseconds Since(
+        const std::chrono::steady_clock::time_point _start)
+    {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - _start);
+    }
+
     /////////////////////////////////////////////////
     /// \brief PIMPL Implementation of the Loader class
     class Loader::Implementation
     {
       /// \brief Attempt to load a library at the given path.
       /// \param[in] _pathToLibrary The full path to the desired library
+      /// \param[in] _options How to load the library
+      /// \param[in, out] _stats The statistics of the library
       /// \return If a library exists at the given path, get a point to its dl
       /// handle. If the library does not exist, get a nullptr.
       public: std::shared_ptr<void> LoadLib(
-        const std::string &_pathToLibrary);
+        const std::string &_pathToLibrary,
+        const LoadOptions &_options,
+        LibraryStatistics &_stats);
 
       /// \brief Using a dl handle produced by LoadLib, extract the
       /// Info from the loaded library.
       /// \param[in] _dlHandle A handle produced by LoadLib
       /// \param[in] _pathToLibrary The path that the library was loaded from
       /// (used for debug purposes)
+      /// \param[in, out] _stats The statistics of the library
       /// \return All the Info provided by the loaded library.
       public: std::vector<Info> LoadPlugins(
         const std::shared_ptr<void> &_dlHandle,
-        const std::string &_pathToLibrary) const;
+        const std::string &_pathToLibrary,
+        LibraryStatistics &_stats) const;
 
       /// \sa Loader::ForgetLibrary()
       public: bool ForgetLibrary(void *_dlHandle);
 
+      /// \brief Erase the plugins of a library from every map, without
+      /// telling the subscribers.
+      /// \param[in] _dlHandle The handle of the library
+      /// \param[out] _removed The names of the plugins that were erased
+      /// \return True if this Loader had loaded the library
+      public: bool EraseLibrary(
+          void *_dlHandle,
+          std::unordered_set<std::string> &_removed);
+
+      /// \brief Add the plugins of a library to every map, without telling
+      /// the subscribers.
+      /// \param[in] _dlHandle The handle of the library
+      /// \param[in] _infos The Info provided by the library
+      /// \param[out] _added The names of the plugins that were not known
+      /// before
+      /// \param[in, out] _stats The statistics of the library
+      /// \return The names of every plugin that the library provides
+      public: std::unordered_set<std::string> RegisterPlugins(
+          const std::shared_ptr<void> &_dlHandle,
+          std::vector<Info> &_infos,
+          std::unordered_set<std::string> &_added,
+          LibraryStatistics &_stats);
+
+      /// \brief Get the statistics of a library, creating them if needed.
+      /// \param[in] _pathToLibrary The path of the library
+      /// \return The statistics
+      public: LibraryStatistics &StatsOf(const std::string &_pathToLibrary);
+
+      /// \brief Find the handle of the version of a library that this Loader
+      /// currently uses for a path.
+      /// \param[in] _pathToLibrary The path of the library
+      /// \return The handle, or nullptr if the library is not loaded
+      public: void *CurrentHandleOf(const std::string &_pathToLibrary) const;
+
+      /// \sa Loader::ReloadLib()
+      public: std::unordered_set<std::string> ReloadLib(
+          const std::string &_pathToLibrary);
+
+      /// \brief Tell the drain callback about the old versions of reloaded
+      /// libraries which have been unloaded, and stop tracking them.
+      public: void CollectDrained();
+
       /// \brief Pass in a plugin name or alias, and this will give back the
       /// plugin name that corresponds to it. If the name or alias could not be
       /// found, this returns an empty string.
       /// \return The demangled symbol name of the desired plugin, or an empty
       /// string if no matching plugin could be found.
-      public: std::string LookupPlugin(const std::string &_nameOrAlias) const;
-
-      public: using AliasMap = std::map<std::string, std::set<std::string>>;
+      public: std::string_view LookupPlugin(
+          std::string_view _nameOrAlias) const;
+
+      /// \brief Advance the generation and tell the subscribers about a
+      /// change. Nothing happens if the change is empty.
+      /// \param[in] _added Names of the plugins that were added
+      /// \param[in] _removed Names of the plugins that were removed
+      public: void Notify(
+          std::unordered_set<std::string> _added,
+          std::unordered_set<std::string> _removed);
+
+      /// \brief Same as LookupPlugin(~), except that failures are returned
+      /// instead of being reported.
+      /// \sa Loader::TryLookupPlugin()
+      public: LookupError TryLookupPlugin(
+          std::string_view _nameOrAlias,
+          std::string_view &_resolvedName) const;
+
+      /// \brief Report a failed lookup to the diagnostic sink.
+      /// \param[in] _nameOrAlias The name or alias which was looked up
+      /// \param[in] _error The reason why the lookup failed
+      public: void ReportLookupError(
+          std::string_view _nameOrAlias,
+          LookupError _error) const;
+
+      /// \brief Find the Info and the library handle of a plugin.
+      /// \sa Loader::PrivateFindPlugin()
+      public: LookupError FindPlugin(
+          std::string_view _nameOrAlias,
+          ConstInfoPtr &_info,
+          std::shared_ptr<void> &_dlHandle) const;
+
+      /// \brief Swap the Info of a plugin for the copy in proxiedPlugins, if
+      /// proxies are enabled and the plugin has one.
+      /// \param[in, out] _info The Info of the plugin to instantiate
+      public: void ApplyProxies(ConstInfoPtr &_info) const;
+
+      // Dev note: The maps which are keyed on names are NameMaps so that
+      // they can be searched with a std::string_view without allocating a
+      // std::string.
+      public: using AliasMap = NameMap<std::set<std::string>>;
       /// \brief A map from known alias names to the plugin names that they
       /// correspond to. Since an alias might refer to more than one plugin, the
       /// key of this map is a set.
       public: AliasMap aliases;
 
-      public: using PluginToDlHandleMap =
-          std::unordered_map< std::string, std::shared_ptr<void> >;
+      public: using PluginToDlHandleMap = NameMap<std::shared_ptr<void>>;
       /// \brief A map from known plugin names to the handle of the library that
       /// provides it.
       ///
@@ -90,7 +242,7 @@ namespace ignition
       /// maintain the ordering of these member variables.
       public: PluginToDlHandleMap pluginToDlHandlePtrs;
 
-      public: using PluginMap = std::unordered_map<std::string, ConstInfoPtr>;
+      public: using PluginMap = NameMap<ConstInfoPtr>;
       /// \brief A map from known plugin names to their Info
       ///
       /// CRUCIAL DEV NOTE (MXG): `plugins` MUST come AFTER
@@ -101,6 +253,12 @@ namespace ignition
       /// maintain the ordering of these member variables.
       public: PluginMap plugins;
 
+      /// \brief Copies of the Info of the plugins which have an interface
+      /// proxy, whose casts hand out the proxies. These are instantiated
+      /// instead of the Info in `plugins` while proxies are enabled. Like
+      /// `plugins`, this MUST come AFTER `pluginToDlHandlePtrs`.
+      public: PluginMap proxiedPlugins;
+
       using DlHandleMap = std::unordered_map< void*, std::weak_ptr<void> >;
       /// \brief A map which keeps track of which shared libraries have been
       /// loaded by this Loader.
@@ -122,6 +280,81 @@ namespace ignition
       /// \brief A map from the shared library handle to the names of the
       /// plugins that it provides.
       public: DlHandleToPluginMap dlHandleToPluginMap;
+
+      /// \brief Records which interfaces are implemented by each plugin in
+      /// `plugins`.
+      public: CapabilityMatrix capabilities;
+
+      /// \brief The index that is used for lookups once Freeze() has been
+      /// called. This is a nullptr while the Loader is not frozen.
+      public: std::unique_ptr<const FrozenIndex> frozen;
+
+      /// \brief Where the diagnostic messages of this Loader go
+      public: Diagnostics diagnostics;
+
+      /// \brief The number of changes that have been made to `plugins`.
+      /// This is atomic so that other threads can poll it.
+      public: std::atomic<std::uint64_t> generation{0};
+
+      /// \brief Callbacks which are told about each change, keyed by the ID
+      /// of their subscription
+      public: std::map<std::size_t, ChangeCallback> subscribers;
+
+      /// \brief The ID of the next subscription
+      public: std::size_t nextSubscription = 0;
+
+      /// \brief The handle of the current version of each library that has
+      /// been reloaded, keyed by the path that it was reloaded from. The
+      /// current version was loaded from a temporary copy, so it cannot be
+      /// found by passing the path to dlopen.
+      public: std::unordered_map<std::string, void*> reloadedHandles;
+
+      /// \brief A token for each library handle of this Loader, which expires
+      /// once dlclose has returned for the handle. That can be later than
+      /// the expiry of the handle itself when the close is deferred.
+      public: std::unordered_map<void*, std::weak_ptr<const void>>
+          closedTokens;
+
+      /// \brief An old version of a reloaded library
+      public: struct Retired
+      {
+        /// \brief The path that the library was reloaded from
+        public: std::string pathToLibrary;
+
+        /// \brief Expires once dlclose has returned for the old version
+        public: std::weak_ptr<const void> closed;
+      };
+
+      /// \brief The old versions of reloaded libraries which might still be
+      /// kept loaded by plugin instances
+      public: std::vector<Retired> retired;
+
+      /// \brief Told about each old version once it has been unloaded
+      public: DrainCallback drainCallback;
+
+      /// \brief Watches the libraries that are passed to WatchLib()
+      public: LibraryWatcher watcher;
+
+      /// \brief How the libraries of this Loader are unloaded
+      public: const std::shared_ptr<UnloadPolicy> unloadPolicy =
+          std::make_shared<UnloadPolicy>();
+
+      /// \brief The options that are used when LoadLib() is not given any
+      public: LoadOptions loadOptions;
+
+      /// \brief The statistics of each library, keyed by the path that it
+      /// was loaded from
+      public: std::map<std::string, LibraryStatistics> libraryStats;
+
+      /// \brief The instance counters of each plugin, keyed by its name
+      public: std::map<std::string, std::shared_ptr<PluginCounters>>
+          pluginCounters;
+
+      /// \brief Whether new instances hand out interface proxies
+      public: std::atomic<bool> proxiesEnabled{false};
+
+      /// \brief The counters of the interface proxies
+      public: ProxyCountersMap proxyCounters;
     };
 
     /////////////////////////////////////////////////
@@ -160,7 +393,7 @@ namespace ignition
           pretty << "\t\t\t\t" << interface << "\n";
       }
 
-      Implementation::AliasMap badAliases;
+      std::map<std::string, std::set<std::string>> badAliases;
       for (const auto &entry : this->dataPtr->aliases)
       {
         if (entry.second.size() > 1)
@@ -183,6 +416,24 @@ namespace ignition
         }
       }
 
+      if (AllocationTrackingEnabled())
+      {
+        const std::vector<AllocationStatistics> allocations =
+            this->AllocationStats();
+        pretty << "\tHeap Allocations: " << allocations.size() << "\n";
+        for (const AllocationStatistics &entry : allocations)
+        {
+          pretty << "\t\t["
+                 << (entry.plugin.empty() ? "(unknown plugin)" : entry.plugin)
+                 << "] in " << entry.library << "\n"
+                 << "\t\t\tlive: " << entry.liveBytes << " bytes in "
+                 << entry.liveAllocations << " allocations\n"
+                 << "\t\t\ttotal: " << entry.allocatedBytes << " bytes in "
+                 << entry.allocations << " allocations ("
+                 << entry.bytesPerSecond << " bytes/s)\n";
+        }
+      }
+
       pretty << std::endl;
 
       return pretty.str();
@@ -205,11 +456,35 @@ namespace ignition
     std::unordered_set<std::string> Loader::LoadLib(
         const std::string &_pathToLibrary)
     {
+      return this->LoadLib(_pathToLibrary, this->dataPtr->loadOptions);
+    }
+
+    /////////////////////////////////////////////////
+    std::unordered_set<std::string> Loader::LoadLib(
+        const std::string &_pathToLibrary,
+        const LoadOptions &_options)
+    {
+      IGN_PLUGIN_TRACE_SCOPE("LoadLib", _pathToLibrary);
+
       std::unordered_set<std::string> newPlugins;
+      std::unordered_set<std::string> added;
+
+      if (this->dataPtr->frozen)
+      {
+        this->dataPtr->diagnostics.Report([&](std::ostream &_out)
+        {
+          _out << "[ignition::plugin::Loader::LoadLib] This Loader is "
+               << "frozen, so the library [" << _pathToLibrary << "] will "
+               << "not be loaded. Use a new Loader to load more plugins.\n";
+        });
+        return newPlugins;
+      }
+
+      LibraryStatistics &stats = this->dataPtr->StatsOf(_pathToLibrary);
 
       // Attempt to load the library at this path
       const std::shared_ptr<void> &dlHandle =
-          this->dataPtr->LoadLib(_pathToLibrary);
+          this->dataPtr->LoadLib(_pathToLibrary, _options, stats);
 
       // Quit early and return an empty set of plugin names if we did not
       // actually get a valid dlHandle.
@@ -218,33 +493,12 @@ namespace ignition
 
       // Found a shared library, does it have the symbols we're looking for?
       std::vector<Info> loadedPlugins = this->dataPtr->LoadPlugins(
-            dlHandle, _pathToLibrary);
-
-      for (Info &plugin : loadedPlugins)
-      {
-        // Demangle the plugin name before creating an entry for it.
-        plugin.name = DemangleSymbol(plugin.name);
-
-        // Add the plugin's aliases to the alias map
-        for (const std::string &alias : plugin.aliases)
-          this->dataPtr->aliases[alias].insert(plugin.name);
-
-        // Make a list of the demangled interface names for later convenience.
-        for (auto const &interface : plugin.interfaces)
-          plugin.demangledInterfaces.insert(DemangleSymbol(interface.first));
-
-        // Add the plugin to the map
-        this->dataPtr->plugins.insert(
-              std::make_pair(plugin.name, std::make_shared<Info>(plugin)));
-
-        // Add the plugin's name to the set of newPlugins
-        newPlugins.insert(plugin.name);
+            dlHandle, _pathToLibrary, stats);
 
-        // Save the dl handle for this plugin
-        this->dataPtr->pluginToDlHandlePtrs[plugin.name] = dlHandle;
-      }
+      newPlugins = this->dataPtr->RegisterPlugins(
+            dlHandle, loadedPlugins, added, stats);
 
-      dataPtr->dlHandleToPluginMap[dlHandle.get()] = newPlugins;
+      this->dataPtr->Notify(std::move(added), {});
 
       return newPlugins;
     }
@@ -266,28 +520,23 @@ namespace ignition
         const std::string &_interface,
         const bool demangled) const
     {
-      std::unordered_set<std::string> plugins;
+      return this->dataPtr->capabilities.Query({_interface}, demangled, true);
+    }
 
-      if (demangled)
-      {
-        for (auto const &plugin : this->dataPtr->plugins)
-        {
-          if (plugin.second->demangledInterfaces.find(_interface) !=
-              plugin.second->demangledInterfaces.end())
-            plugins.insert(plugin.second->name);
-        }
-      }
-      else
-      {
-        for (auto const &plugin : this->dataPtr->plugins)
-        {
-          if (plugin.second->interfaces.find(_interface) !=
-              plugin.second->interfaces.end())
-            plugins.insert(plugin.second->name);
-        }
-      }
+    /////////////////////////////////////////////////
+    std::unordered_set<std::string> Loader::PluginsImplementingAll(
+        const std::vector<std::string> &_interfaces,
+        const bool _demangled) const
+    {
+      return this->dataPtr->capabilities.Query(_interfaces, _demangled, true);
+    }
 
-      return plugins;
+    /////////////////////////////////////////////////
+    std::unordered_set<std::string> Loader::PluginsImplementingAny(
+        const std::vector<std::string> &_interfaces,
+        const bool _demangled) const
+    {
+      return this->dataPtr->capabilities.Query(_interfaces, _demangled, false);
     }
 
     /////////////////////////////////////////////////
@@ -301,23 +550,82 @@ namespace ignition
       return result;
     }
 
+    /////////////////////////////////////////////////
+    void Loader::PrivateForEachPlugin(const Visit &_visit) const
+    {
+      for (const auto &entry : this->dataPtr->plugins)
+        _visit(entry.first);
+    }
+
+    /////////////////////////////////////////////////
+    void Loader::PrivateForEachPluginImplementing(
+        const std::string_view _interface,
+        const bool _demangled,
+        const Visit &_visit) const
+    {
+      this->dataPtr->capabilities.ForEach(_interface, _demangled, _visit);
+    }
+
+    /////////////////////////////////////////////////
+    void Loader::PrivateForEachPluginWithAlias(
+        const std::string_view _alias,
+        const Visit &_visit) const
+    {
+      const Implementation::AliasMap::value_type *names =
+          this->dataPtr->aliases.Find(_alias);
+
+      const Implementation::PluginMap::value_type *plugin =
+          this->dataPtr->plugins.Find(_alias);
+
+      const bool isPlugin = (nullptr != plugin);
+
+      if (names)
+      {
+        for (const std::string &name : names->second)
+        {
+          // Do not visit the same name twice if a plugin is also an alias of
+          // itself.
+          if (!isPlugin || name != plugin->first)
+            _visit(name);
+        }
+      }
+
+      if (isPlugin)
+        _visit(plugin->first);
+    }
+
+    /////////////////////////////////////////////////
+    void Loader::PrivateForEachAliasOfPlugin(
+        const std::string_view _pluginName,
+        const Visit &_visit) const
+    {
+      const Implementation::PluginMap::value_type *plugin =
+          this->dataPtr->plugins.Find(_pluginName);
+
+      if (!plugin)
+        return;
+
+      for (const std::string &alias : plugin->second->aliases)
+        _visit(alias);
+    }
+
     /////////////////////////////////////////////////
     std::set<std::string> Loader::PluginsWithAlias(
-        const std::string &_alias) const
+        const std::string_view _alias) const
     {
       std::set<std::string> result;
 
-      const Implementation::AliasMap::const_iterator names =
-          this->dataPtr->aliases.find(_alias);
+      const Implementation::AliasMap::value_type *names =
+          this->dataPtr->aliases.Find(_alias);
 
-      if (names != this->dataPtr->aliases.end())
+      if (names)
         result = names->second;
 
-      const Implementation::PluginMap::const_iterator plugin =
-          this->dataPtr->plugins.find(_alias);
+      const Implementation::PluginMap::value_type *plugin =
+          this->dataPtr->plugins.Find(_alias);
 
-      if (plugin != this->dataPtr->plugins.end())
-        result.insert(_alias);
+      if (plugin)
+        result.insert(plugin->first);
 
       return result;
     }
@@ -326,182 +634,795 @@ namespace ignition
     std::set<std::string> Loader::AliasesOfPlugin(
         const std::string &_pluginName) const
     {
-      const Implementation::PluginMap::const_iterator plugin =
-          this->dataPtr->plugins.find(_pluginName);
+      const Implementation::PluginMap::value_type *plugin =
+          this->dataPtr->plugins.Find(_pluginName);
 
-      if (plugin != this->dataPtr->plugins.end())
+      if (plugin)
         return plugin->second->aliases;
 
       return {};
     }
 
     /////////////////////////////////////////////////
-    std::string Loader::LookupPlugin(const std::string &_nameOrAlias) const
+    std::string Loader::LookupPlugin(const std::string_view _nameOrAlias) const
     {
-      return this->dataPtr->LookupPlugin(_nameOrAlias);
+      return std::string(this->dataPtr->LookupPlugin(_nameOrAlias));
     }
 
     /////////////////////////////////////////////////
-    PluginPtr Loader::Instantiate(const std::string &_pluginNameOrAlias) const
+    std::string_view Loader::LookupPluginView(
+        const std::string_view _nameOrAlias) const
     {
-      const std::string &resolvedName = this->LookupPlugin(_pluginNameOrAlias);
-      if (resolvedName.empty())
-        return PluginPtr();
+      return this->dataPtr->LookupPlugin(_nameOrAlias);
+    }
 
-      PluginPtr ptr(this->PrivateGetInfo(resolvedName),
-                    this->PrivateGetPluginDlHandlePtr(resolvedName));
+    /////////////////////////////////////////////////
+    auto Loader::TryLookupPlugin(
+        const std::string_view _nameOrAlias,
+        std::string_view &_resolvedName) const -> LookupError
+    {
+      return this->dataPtr->TryLookupPlugin(_nameOrAlias, _resolvedName);
+    }
 
-      if (auto *enableFromThis = ptr->QueryInterface<EnablePluginFromThis>())
-        enableFromThis->PrivateSetPluginFromThis(ptr);
+    /////////////////////////////////////////////////
+    PluginPtr Loader::Instantiate(
+        const std::string_view _pluginNameOrAlias) const
+    {
+      ConstInfoPtr info;
+      std::shared_ptr<void> dlHandle;
+      if (LookupError::NONE != this->PrivateFindPlugin(
+            _pluginNameOrAlias, false, info, dlHandle))
+        return PluginPtr();
 
-      return ptr;
+      return this->PrivateInstantiate<PluginPtr>(info, dlHandle);
     }
 
     /////////////////////////////////////////////////
     bool Loader::ForgetLibrary(const std::string &_pathToLibrary)
     {
-#ifndef RTLD_NOLOAD
-// This macro is not part of the POSIX standard, and is a custom addition to
-// glibc-2.2, so we need create a no-op stand-in flag for it if we are not
-// using glibc-2.2.
-#define RTLD_NOLOAD 0
-#endif
+      IGN_PLUGIN_TRACE_SCOPE("ForgetLibrary", _pathToLibrary);
 
-      void *dlHandle = dlopen(_pathToLibrary.c_str(),
-                              RTLD_NOLOAD | RTLD_LAZY | RTLD_LOCAL);
+      if (this->dataPtr->frozen)
+      {
+        this->dataPtr->diagnostics.Report([&](std::ostream &_out)
+        {
+          _out << "[ignition::plugin::Loader::ForgetLibrary] This Loader is "
+               << "frozen, so the library [" << _pathToLibrary << "] will "
+               << "not be forgotten.\n";
+        });
+        return false;
+      }
+
+      void *dlHandle = this->dataPtr->CurrentHandleOf(_pathToLibrary);
 
       if (!dlHandle)
         return false;
 
-      // We should decrement the reference count because we called dlopen. Even
-      // with the RTLD_NOLOAD flag, the call to dlopen will still (allegedly)
-      // increment the reference count when it returns a valid handle. Note that
-      // this knowledge is according to online discussions and is not explicitly
-      // stated in the manual pages of dlopen (but it is consistent with the
-      // overall behavior of dlopen).
-      dlclose(dlHandle);
-
       return this->dataPtr->ForgetLibrary(dlHandle);
     }
 
     /////////////////////////////////////////////////
     bool Loader::ForgetLibraryOfPlugin(const std::string &_pluginNameOrAlias)
     {
-      const std::string &resolvedName = this->LookupPlugin(_pluginNameOrAlias);
+      IGN_PLUGIN_TRACE_SCOPE("ForgetLibrary", _pluginNameOrAlias);
+
+      if (this->dataPtr->frozen)
+      {
+        this->dataPtr->diagnostics.Report([&](std::ostream &_out)
+        {
+          _out << "[ignition::plugin::Loader::ForgetLibraryOfPlugin] This "
+               << "Loader is frozen, so the library of ["
+               << _pluginNameOrAlias << "] will not be forgotten.\n";
+        });
+        return false;
+      }
 
-      Implementation::PluginToDlHandleMap::iterator it =
-          dataPtr->pluginToDlHandlePtrs.find(resolvedName);
+      const std::string_view resolvedName =
+          this->dataPtr->LookupPlugin(_pluginNameOrAlias);
 
-      if (dataPtr->pluginToDlHandlePtrs.end() == it)
+      const Implementation::PluginToDlHandleMap::value_type *dlHandle =
+          dataPtr->pluginToDlHandlePtrs.Find(resolvedName);
+
+      if (!dlHandle)
         return false;
 
-      return dataPtr->ForgetLibrary(it->second.get());
+      return dataPtr->ForgetLibrary(dlHandle->second.get());
     }
 
     /////////////////////////////////////////////////
-    ConstInfoPtr Loader::PrivateGetInfo(
-        const std::string &_resolvedName) const
+    void Loader::Freeze()
     {
-      const Implementation::PluginMap::const_iterator it =
-          this->dataPtr->plugins.find(_resolvedName);
+      if (this->dataPtr->frozen)
+        return;
 
-      if (this->dataPtr->plugins.end() == it)
+      std::vector<FrozenIndex::Entry> entries;
+      entries.reserve(
+            this->dataPtr->plugins.size() + this->dataPtr->aliases.size());
+
+      for (const auto &plugin : this->dataPtr->plugins)
       {
-        // LCOV_EXCL_START
-        std::cerr << "[ignition::Loader::PrivateGetInfo] A resolved name ["
-                  << _resolvedName << "] could not be found in the PluginMap. "
-                  << "This should not be possible! Please report this bug!\n";
-        assert(false);
-        return nullptr;
-        // LCOV_EXCL_STOP
+        entries.push_back({plugin.first, plugin.first, plugin.second,
+                           this->dataPtr->pluginToDlHandlePtrs.At(
+                             plugin.first)});
+      }
+
+      for (const auto &alias : this->dataPtr->aliases)
+      {
+        // A plugin whose name matches the alias always takes precedence, and
+        // an alias that no longer refers to any plugin is not a valid key.
+        if (alias.second.empty() ||
+            this->dataPtr->plugins.Find(alias.first))
+          continue;
+
+        if (alias.second.size() == 1)
+        {
+          const std::string &name = *alias.second.begin();
+          entries.push_back({alias.first, name,
+                             this->dataPtr->plugins.At(name),
+                             this->dataPtr->pluginToDlHandlePtrs.At(name)});
+        }
+        else
+        {
+          // Ambiguous aliases are kept in the index so that they are still
+          // found quickly, but they do not resolve to anything.
+          entries.push_back({alias.first, "", nullptr, nullptr});
+        }
       }
 
-      return it->second;
+      this->dataPtr->frozen.reset(new FrozenIndex(entries));
+    }
+
+    /////////////////////////////////////////////////
+    bool Loader::IsFrozen() const
+    {
+      return static_cast<bool>(this->dataPtr->frozen);
+    }
+
+    /////////////////////////////////////////////////
+    std::uint64_t Loader::Generation() const
+    {
+      return this->dataPtr->generation.load(std::memory_order_acquire);
+    }
+
+    /////////////////////////////////////////////////
+    std::size_t Loader::Subscribe(ChangeCallback _callback)
+    {
+      const std::size_t id = this->dataPtr->nextSubscription++;
+      this->dataPtr->subscribers[id] = std::move(_callback);
+      return id;
     }
 
     /////////////////////////////////////////////////
-    std::shared_ptr<void> Loader::PrivateGetPluginDlHandlePtr(
-        const std::string &_resolvedName) const
+    bool Loader::Unsubscribe(const std::size_t _subscription)
     {
-      Implementation::PluginToDlHandleMap::iterator it =
-          dataPtr->pluginToDlHandlePtrs.find(_resolvedName);
+      return this->dataPtr->subscribers.erase(_subscription) > 0;
+    }
 
-      if (this->dataPtr->pluginToDlHandlePtrs.end() == it)
+    /////////////////////////////////////////////////
+    std::unordered_set<std::string> Loader::ReloadLib(
+        const std::string &_pathToLibrary)
+    {
+      if (this->dataPtr->frozen)
       {
-        // LCOV_EXCL_START
-        std::cerr << "[ignition::Loader::PrivateGetInfo] A resolved name ["
-                  << _resolvedName << "] could not be found in the "
-                  << "PluginToDlHandleMap. This should not be possible! Please "
-                  << "report this bug!\n";
-        assert(false);
-        return nullptr;
-        // LCOV_EXCL_STOP
+        this->dataPtr->diagnostics.Report([&](std::ostream &_out)
+        {
+          _out << "[ignition::plugin::Loader::ReloadLib] This Loader is "
+               << "frozen, so the library [" << _pathToLibrary << "] will "
+               << "not be reloaded.\n";
+        });
+        return {};
       }
 
-      return it->second;
+      std::unordered_set<std::string> plugins =
+          this->dataPtr->ReloadLib(_pathToLibrary);
+      this->dataPtr->CollectDrained();
+      return plugins;
     }
 
     /////////////////////////////////////////////////
-    std::shared_ptr<void> Loader::Implementation::LoadLib(
-        const std::string &_full_path)
+    bool Loader::WatchLib(const std::string &_pathToLibrary)
     {
-      std::shared_ptr<void> dlHandlePtr;
+      if (this->dataPtr->watcher.Watch(_pathToLibrary))
+        return true;
 
-      // Call dlerror() before dlopen(~) to ensure that we get accurate error
-      // reporting afterwards. The function dlerror() is stateful, and that
-      // state gets cleared each time it is called.
-      dlerror();
+#ifdef __linux__
+      const int error = errno;
+#endif
+      this->dataPtr->diagnostics.Report([&](std::ostream &_out)
+      {
+        _out << "[ignition::plugin::Loader::WatchLib] Unable to watch the "
+             << "library [" << _pathToLibrary << "]";
+#ifdef __linux__
+        _out << ": " << std::strerror(error) << "\n";
+#else
+        _out << ", because hot reloading is only supported on Linux.\n";
+#endif
+      });
 
-      // NOTE: We open using RTLD_LOCAL instead of RTLD_GLOBAL to prevent the
-      // symbols of different libraries from writing over each other.
-      void *dlHandle = dlopen(_full_path.c_str(), RTLD_LAZY | RTLD_LOCAL);
+      return false;
+    }
 
-      const char *loadError = dlerror();
-      if (nullptr == dlHandle || nullptr != loadError)
-      {
-        std::cerr << "Error while loading the library [" << _full_path << "]: "
-                  << loadError << std::endl;
+    /////////////////////////////////////////////////
+    bool Loader::UnwatchLib(const std::string &_pathToLibrary)
+    {
+      return this->dataPtr->watcher.Unwatch(_pathToLibrary);
+    }
 
-        // Just return a nullptr if the library could not be loaded. The
-        // Loader::LoadLib(~) function will handle this gracefully.
-        return nullptr;
-      }
+    /////////////////////////////////////////////////
+    int Loader::LibraryWatchDescriptor() const
+    {
+      return this->dataPtr->watcher.Descriptor();
+    }
 
-      // The dl library maintains a reference count of how many times dlopen(~)
-      // or dlclose(~) has been called on each loaded library. dlopen(~)
-      // increments the reference count while dlclose(~) decrements the count.
-      // When the count reaches zero, the operating system is free to unload
-      // the library (which it might or might not choose to do; we do not seem
-      // to have control over that, probably for the best).
+    /////////////////////////////////////////////////
+    std::size_t Loader::ProcessLibraryChanges()
+    {
+      std::size_t reloaded = 0;
+      for (const std::string &path : this->dataPtr->watcher.TakeChanges())
+      {
+        if (!this->ReloadLib(path).empty())
+          ++reloaded;
+      }
 
-      // The idea in our implementation here is to first check if the library
-      // has already been loaded by this Loader. If it has been, then we
-      // will see it in the dlHandlePtrMap, and we'll be able to get a shared
-      // reference to its handle. The advantage of this is it allows us to keep
-      // track of how many places the shared library is being used by plugins
-      // that were generated from this Loader. When all of the instances
-      // spawned by this Loader are gone, the destructor of the
-      // std::shared_ptr will call dlclose on the library handle, bringing down
-      // its dl library reference count.
+      this->dataPtr->CollectDrained();
+      return reloaded;
+    }
 
-      bool inserted;
-      DlHandleMap::iterator it;
-      std::tie(it, inserted) = this->dlHandlePtrMap.insert(
-            std::make_pair(dlHandle, std::weak_ptr<void>()));
+    /////////////////////////////////////////////////
+    void Loader::SetDrainCallback(DrainCallback _callback)
+    {
+      this->dataPtr->drainCallback = std::move(_callback);
+    }
 
-      if (!inserted)
+    /////////////////////////////////////////////////
+    std::size_t Loader::DrainingLibraryCount() const
+    {
+      std::size_t count = 0;
+      for (const Implementation::Retired &retired : this->dataPtr->retired)
       {
-        // This shared library has already been loaded by this Loader in
-        // the past, so we should use the reference counter that already
-        // exists for it.
-        dlHandlePtr = it->second.lock();
+        if (!retired.closed.expired())
+          ++count;
+      }
 
-        if (dlHandlePtr)
-        {
-          // The reference counter of this library is still active.
+      return count;
+    }
 
-          // The functions dlopen and dlclose keep their own independent
-          // counters for how many times each of them has been called. The
+    /////////////////////////////////////////////////
+    void Loader::SetDefaultLoadOptions(const LoadOptions &_options)
+    {
+      this->dataPtr->loadOptions = _options;
+    }
+
+    /////////////////////////////////////////////////
+    auto Loader::DefaultLoadOptions() const -> LoadOptions
+    {
+      return this->dataPtr->loadOptions;
+    }
+
+    /////////////////////////////////////////////////
+    void Loader::SetUnloadGracePeriod(
+        const std::chrono::milliseconds _gracePeriod)
+    {
+      this->dataPtr->unloadPolicy->gracePeriod =
+          std::max<std::chrono::milliseconds::rep>(0, _gracePeriod.count());
+    }
+
+    /////////////////////////////////////////////////
+    std::chrono::milliseconds Loader::UnloadGracePeriod() const
+    {
+      return std::chrono::milliseconds(
+            this->dataPtr->unloadPolicy->gracePeriod.load());
+    }
+
+    /////////////////////////////////////////////////
+    auto Loader::UnloadStats() const -> UnloadStatistics
+    {
+      const UnloadPolicy &policy = *this->dataPtr->unloadPolicy;
+
+      UnloadStatistics stats;
+      stats.unloaded = policy.unloaded.load();
+      stats.cancelled = policy.cancelled.load();
+      stats.pending = policy.pending.load();
+      stats.totalUnloadTime =
+          std::chrono::nanoseconds(policy.totalUnloadTime.load());
+      stats.maxUnloadTime =
+          std::chrono::nanoseconds(policy.maxUnloadTime.load());
+      return stats;
+    }
+
+    /////////////////////////////////////////////////
+    auto Loader::Stats() const -> Statistics
+    {
+      Statistics stats;
+
+      stats.libraries.reserve(this->dataPtr->libraryStats.size());
+      for (const auto &entry : this->dataPtr->libraryStats)
+        stats.libraries.push_back(entry.second);
+
+      stats.plugins.reserve(this->dataPtr->pluginCounters.size());
+      for (const auto &entry : this->dataPtr->pluginCounters)
+      {
+        const PluginCounters &counters = *entry.second;
+
+        PluginStatistics plugin;
+        plugin.name = entry.first;
+        plugin.library = counters.library;
+
+        // Read the destroyed count first, so that an instance which is
+        // created and destroyed in between cannot make the live count wrap.
+        plugin.destroyed =
+            counters.destroyed.load(std::memory_order_relaxed);
+        plugin.instantiated =
+            counters.instantiated.load(std::memory_order_relaxed);
+        plugin.live = plugin.instantiated > plugin.destroyed ?
+              plugin.instantiated - plugin.destroyed : 0;
+        plugin.constructionTime = std::chrono::nanoseconds(
+              counters.constructionTime.load(std::memory_order_relaxed));
+
+        stats.plugins.push_back(std::move(plugin));
+      }
+
+      return stats;
+    }
+
+    /////////////////////////////////////////////////
+    auto Loader::AddressRanges() const -> std::vector<AddressRange>
+    {
+      std::vector<AddressRange> ranges;
+
+      for (const auto &library : this->dataPtr->dlHandleToPluginMap)
+      {
+        AddressRange range;
+        range.plugins.assign(library.second.begin(), library.second.end());
+        std::sort(range.plugins.begin(), range.plugins.end());
+
+        std::set<std::string> interfaces;
+        for (const std::string &name : range.plugins)
+        {
+          const Implementation::PluginMap::value_type *plugin =
+              this->dataPtr->plugins.Find(name);
+          if (plugin)
+          {
+            interfaces.insert(plugin->second->demangledInterfaces.begin(),
+                              plugin->second->demangledInterfaces.end());
+          }
+        }
+        range.interfaces.assign(interfaces.begin(), interfaces.end());
+
+        // Reloaded libraries were loaded from a temporary copy, so they are
+        // named after the path that they were reloaded from instead.
+        for (const auto &reloaded : this->dataPtr->reloadedHandles)
+        {
+          if (reloaded.second == library.first)
+            range.library = reloaded.first;
+        }
+
+#ifdef __linux__
+        struct link_map *linkMap = nullptr;
+        if (range.library.empty() &&
+            0 == dlinfo(library.first, RTLD_DI_LINKMAP, &linkMap) && linkMap)
+        {
+          range.library = linkMap->l_name;
+        }
+
+        for (const Segment &segment : LoadedSegments(library.first))
+        {
+          if (!(segment.flags & PF_X))
+            continue;
+
+          range.begin = segment.begin;
+          range.end = segment.end;
+          ranges.push_back(range);
+        }
+#endif
+      }
+
+      std::sort(ranges.begin(), ranges.end(),
+          [](const AddressRange &_a, const AddressRange &_b)
+          {
+            return _a.begin < _b.begin;
+          });
+
+      return ranges;
+    }
+
+    /////////////////////////////////////////////////
+    void Loader::SetInterfaceProxies(const bool _enabled)
+    {
+      this->dataPtr->proxiesEnabled.store(_enabled);
+    }
+
+    /////////////////////////////////////////////////
+    bool Loader::InterfaceProxiesEnabled() const
+    {
+      return this->dataPtr->proxiesEnabled.load();
+    }
+
+    /////////////////////////////////////////////////
+    auto Loader::MethodStats() const -> std::vector<MethodStatistics>
+    {
+      std::vector<MethodStatistics> stats;
+      for (const auto &entry : this->dataPtr->proxyCounters)
+      {
+        const ProxyCounters &proxy = *entry.second;
+        for (std::size_t i = 0; i < proxy.methods.size(); ++i)
+        {
+          const detail::MethodCounters &counters = proxy.counters[i];
+
+          MethodStatistics method;
+          method.plugin = entry.first.first;
+          method.interface = entry.first.second;
+          method.method = proxy.methods[i];
+          method.calls = counters.calls.load(std::memory_order_relaxed);
+          method.totalTime = std::chrono::nanoseconds(
+                counters.totalTime.load(std::memory_order_relaxed));
+          method.latencyHistogram.reserve(detail::LatencyBuckets);
+          for (const auto &bucket : counters.histogram)
+          {
+            method.latencyHistogram.push_back(
+                  bucket.load(std::memory_order_relaxed));
+          }
+
+          stats.push_back(std::move(method));
+        }
+      }
+
+      return stats;
+    }
+
+    /////////////////////////////////////////////////
+    bool Loader::AllocationTrackingEnabled()
+    {
+      return AllocationsTracked();
+    }
+
+    /////////////////////////////////////////////////
+    auto Loader::AllocationStats() const
+        -> std::vector<AllocationStatistics>
+    {
+      const std::vector<AllocationSiteCounts> sites = AllocationSites();
+      const double seconds = std::chrono::duration<double>(
+            AllocationTrackingTime()).count();
+
+      const AddressAttributor attributor(*this);
+      std::map<std::pair<std::string, std::string>, AllocationStatistics>
+          totals;
+      for (const AllocationSiteCounts &site : sites)
+      {
+        if (0 == site.caller)
+          continue;
+
+        // The caller is a return address, which may already be past the end
+        // of the function that made the call.
+        AddressAttributor::Attribution attribution =
+            attributor.Attribute(site.caller - 1);
+        if (attribution.library.empty())
+          continue;
+
+        AllocationStatistics &entry = totals[std::make_pair(
+              attribution.library, attribution.plugin)];
+        entry.library = std::move(attribution.library);
+        entry.plugin = std::move(attribution.plugin);
+        entry.allocations += site.allocations;
+        entry.allocatedBytes += site.allocatedBytes;
+        // The counters are read one at a time while other threads may be
+        // allocating, so the frees could be ahead of the allocations.
+        entry.liveAllocations += site.allocations -
+            std::min(site.allocations, site.deallocations);
+        entry.liveBytes += site.allocatedBytes -
+            std::min(site.allocatedBytes, site.freedBytes);
+      }
+
+      std::vector<AllocationStatistics> stats;
+      stats.reserve(totals.size());
+      for (auto &total : totals)
+      {
+        if (seconds > 0.0)
+        {
+          total.second.bytesPerSecond =
+              static_cast<double>(total.second.allocatedBytes) / seconds;
+        }
+        stats.push_back(std::move(total.second));
+      }
+
+      return stats;
+    }
+
+    /////////////////////////////////////////////////
+    /// \brief Write _text as a quoted JSON string.
+    /// \param[out] _out The stream to write to
+    /// \param[in] _text The text to quote
+    static void WriteJsonString(std::ostream &_out, const std::string &_text)
+    {
+      _out << '"';
+      for (const char c : _text)
+      {
+        switch (c)
+        {
+          case '"': _out << "\\\""; break;
+          case '\\': _out << "\\\\"; break;
+          case '\n': _out << "\\n"; break;
+          case '\t': _out << "\\t"; break;
+          default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+              const char *const hex = "0123456789abcdef";
+              _out << "\\u00" << hex[(c >> 4) & 0xf] << hex[c & 0xf];
+            }
+            else
+            {
+              _out << c;
+            }
+        }
+      }
+      _out << '"';
+    }
+
+    /////////////////////////////////////////////////
+    std::string Loader::StatsToJson(const Statistics &_stats)
+    {
+      std::stringstream json;
+      json.imbue(std::locale::classic());
+      json << "{\"libraries\":[";
+      for (std::size_t i = 0; i < _stats.libraries.size(); ++i)
+      {
+        const LibraryStatistics &library = _stats.libraries[i];
+        json << (i > 0 ? "," : "") << "{\"path\":";
+        WriteJsonString(json, library.path);
+        json << ",\"loads\":" << library.loads
+             << ",\"dlopen_ns\":" << library.dlopenTime.count()
+             << ",\"hook_ns\":" << library.hookTime.count()
+             << ",\"import_ns\":" << library.importTime.count()
+             << ",\"demangle_ns\":" << library.demangleTime.count() << "}";
+      }
+
+      json << "],\"plugins\":[";
+      for (std::size_t i = 0; i < _stats.plugins.size(); ++i)
+      {
+        const PluginStatistics &plugin = _stats.plugins[i];
+        json << (i > 0 ? "," : "") << "{\"name\":";
+        WriteJsonString(json, plugin.name);
+        json << ",\"library\":";
+        WriteJsonString(json, plugin.library);
+        json << ",\"instantiated\":" << plugin.instantiated
+             << ",\"live\":" << plugin.live
+             << ",\"destroyed\":" << plugin.destroyed
+             << ",\"construction_ns\":" << plugin.constructionTime.count()
+             << "}";
+      }
+      json << "]}";
+
+      return json.str();
+    }
+
+    /////////////////////////////////////////////////
+    /// \brief Write _text as a quoted Prometheus label value.
+    /// \param[out] _out The stream to write to
+    /// \param[in] _text The text to quote
+    static void WriteLabelValue(std::ostream &_out, const std::string &_text)
+    {
+      _out << '"';
+      for (const char c : _text)
+      {
+        if ('"' == c || '\\' == c)
+          _out << '\\' << c;
+        else if ('\n' == c)
+          _out << "\\n";
+        else
+          _out << c;
+      }
+      _out << '"';
+    }
+
+    /////////////////////////////////////////////////
+    std::string Loader::StatsToPrometheus(const Statistics &_stats)
+    {
+      std::stringstream text;
+      text.imbue(std::locale::classic());
+      text.precision(9);
+
+      const auto seconds = [](const std::chrono::nanoseconds _time)
+      {
+        return std::chrono::duration<double>(_time).count();
+      };
+
+      // Each metric is written with all of its samples, one per library or
+      // plugin, under a single HELP and TYPE header.
+      const auto metric = [&](
+          const char *_name, const char *_type, const char *_help,
+          const auto &_entries, const auto &_sample)
+      {
+        text << "# HELP ignition_plugin_" << _name << " " << _help << "\n"
+             << "# TYPE ignition_plugin_" << _name << " " << _type << "\n";
+        for (const auto &entry : _entries)
+        {
+          text << "ignition_plugin_" << _name << "{";
+          _sample(entry);
+          text << "\n";
+        }
+      };
+
+      const auto library = [&](const auto &_value)
+      {
+        return [&text, _value](const LibraryStatistics &_library)
+        {
+          text << "library=";
+          WriteLabelValue(text, _library.path);
+          text << "} " << _value(_library);
+        };
+      };
+
+      const auto plugin = [&](const auto &_value)
+      {
+        return [&text, _value](const PluginStatistics &_plugin)
+        {
+          text << "plugin=";
+          WriteLabelValue(text, _plugin.name);
+          text << ",library=";
+          WriteLabelValue(text, _plugin.library);
+          text << "} " << _value(_plugin);
+        };
+      };
+
+      metric("library_loads_total", "counter",
+             "Number of times that the library was loaded.",
+             _stats.libraries, library([](const LibraryStatistics &_l)
+             { return _l.loads; }));
+
+      metric("library_dlopen_seconds_total", "counter",
+             "Time spent in dlopen.",
+             _stats.libraries, library([&](const LibraryStatistics &_l)
+             { return seconds(_l.dlopenTime); }));
+
+      metric("library_hook_seconds_total", "counter",
+             "Time spent calling the plugin hook of the library.",
+             _stats.libraries, library([&](const LibraryStatistics &_l)
+             { return seconds(_l.hookTime); }));
+
+      metric("library_import_seconds_total", "counter",
+             "Time spent importing the plugin Info of the library.",
+             _stats.libraries, library([&](const LibraryStatistics &_l)
+             { return seconds(_l.importTime); }));
+
+      metric("library_demangle_seconds_total", "counter",
+             "Time spent demangling the symbols of the library.",
+             _stats.libraries, library([&](const LibraryStatistics &_l)
+             { return seconds(_l.demangleTime); }));
+
+      metric("instances_created_total", "counter",
+             "Number of plugin instances that have been created.",
+             _stats.plugins, plugin([](const PluginStatistics &_p)
+             { return _p.instantiated; }));
+
+      metric("instances_live", "gauge",
+             "Number of plugin instances that currently exist.",
+             _stats.plugins, plugin([](const PluginStatistics &_p)
+             { return _p.live; }));
+
+      metric("instances_destroyed_total", "counter",
+             "Number of plugin instances that have been destroyed.",
+             _stats.plugins, plugin([](const PluginStatistics &_p)
+             { return _p.destroyed; }));
+
+      metric("construction_seconds_total", "counter",
+             "Time spent constructing plugin instances.",
+             _stats.plugins, plugin([&](const PluginStatistics &_p)
+             { return seconds(_p.constructionTime); }));
+
+      return text.str();
+    }
+
+    /////////////////////////////////////////////////
+    void Loader::SetDiagnosticSink(
+        DiagnosticSink _sink,
+        const std::size_t _burst,
+        const std::chrono::milliseconds _period)
+    {
+      this->dataPtr->diagnostics.SetSink(std::move(_sink), _burst, _period);
+    }
+
+    /////////////////////////////////////////////////
+    auto Loader::PrivateFindPlugin(
+        const std::string_view _nameOrAlias,
+        const bool _quiet,
+        ConstInfoPtr &_info,
+        std::shared_ptr<void> &_dlHandle) const -> LookupError
+    {
+      const LookupError error =
+          this->dataPtr->FindPlugin(_nameOrAlias, _info, _dlHandle);
+
+      if (!_quiet)
+        this->dataPtr->ReportLookupError(_nameOrAlias, error);
+
+      return error;
+    }
+
+    /////////////////////////////////////////////////
+    std::shared_ptr<void> Loader::Implementation::LoadLib(
+        const std::string &_full_path,
+        const LoadOptions &_options,
+        LibraryStatistics &_stats)
+    {
+      std::shared_ptr<void> dlHandlePtr;
+
+#ifdef RTLD_DEEPBIND
+      // A library which is loaded with RTLD_DEEPBIND binds operator new and
+      // operator delete to its own dependencies instead of the replacements
+      // in the executable, so it would free tracked memory with the wrong
+      // operator and corrupt the heap.
+      if (_options.deepBind && AllocationsTracked())
+      {
+        this->diagnostics.Report([&](std::ostream &_out)
+        {
+          _out << "Refusing to load the library [" << _full_path << "] with "
+               << "RTLD_DEEPBIND, because heap allocations are being tracked "
+               << "by the operator new of the executable.\n";
+        });
+        return nullptr;
+      }
+#endif
+
+      // Call dlerror() before dlopen(~) to ensure that we get accurate error
+      // reporting afterwards. The function dlerror() is stateful, and that
+      // state gets cleared each time it is called.
+      dlerror();
+
+      // NOTE: By default we open using RTLD_LOCAL instead of RTLD_GLOBAL to
+      // prevent the symbols of different libraries from writing over each
+      // other.
+      const auto start = std::chrono::steady_clock::now();
+      void *dlHandle = dlopen(_full_path.c_str(), DlopenFlags(_options));
+      _stats.dlopenTime += Since(start);
+
+      const char *loadError = dlerror();
+      if (nullptr == dlHandle || nullptr != loadError)
+      {
+        this->diagnostics.Report([&](std::ostream &_out)
+        {
+          _out << "Error while loading the library [" << _full_path << "]: "
+               << loadError << "\n";
+        });
+
+        // Just return a nullptr if the library could not be loaded. The
+        // Loader::LoadLib(~) function will handle this gracefully.
+        return nullptr;
+      }
+
+      // The dl library maintains a reference count of how many times dlopen(~)
+      // or dlclose(~) has been called on each loaded library. dlopen(~)
+      // increments the reference count while dlclose(~) decrements the count.
+      // When the count reaches zero, the operating system is free to unload
+      // the library (which it might or might not choose to do; we do not seem
+      // to have control over that, probably for the best).
+
+      // The idea in our implementation here is to first check if the library
+      // has already been loaded by this Loader. If it has been, then we
+      // will see it in the dlHandlePtrMap, and we'll be able to get a shared
+      // reference to its handle. The advantage of this is it allows us to keep
+      // track of how many places the shared library is being used by plugins
+      // that were generated from this Loader. When all of the instances
+      // spawned by this Loader are gone, the destructor of the
+      // std::shared_ptr will call dlclose on the library handle, bringing down
+      // its dl library reference count.
+
+      bool inserted;
+      DlHandleMap::iterator it;
+      std::tie(it, inserted) = this->dlHandlePtrMap.insert(
+            std::make_pair(dlHandle, std::weak_ptr<void>()));
+
+      if (!inserted)
+      {
+        // This shared library has already been loaded by this Loader in
+        // the past, so we should use the reference counter that already
+        // exists for it.
+        dlHandlePtr = it->second.lock();
+
+        if (dlHandlePtr)
+        {
+          // The reference counter of this library is still active.
+
+          // The functions dlopen and dlclose keep their own independent
+          // counters for how many times each of them has been called. The
           // library is unloaded once dlclose has been called as many times as
           // dlopen.
           //
@@ -518,22 +1439,62 @@ namespace ignition
 
       if (!dlHandlePtr)
       {
+        // If the library was released recently and is waiting to be closed,
+        // then we take over the reference which the reaper would have closed,
+        // and undo the dlopen that we just did.
+        std::shared_ptr<const void> closed;
+        if (UnloadReaper::Instance().Cancel(dlHandle, closed))
+          dlclose(dlHandle);
+        else
+          closed = std::make_shared<bool>(true);
+
         // The library was not already loaded (or if it was loaded in the past,
         // it is no longer active), so we should create a reference counting
-        // handle for it.
+        // handle for it. The deleter holds on to the closed token until the
+        // handle has really been closed.
+        //
+        // Every reload opens a new copy of its library, so the tokens of
+        // handles which have been closed are dropped here. Those handles can
+        // only come back through this branch, which creates a new token.
+        for (auto token = this->closedTokens.begin();
+             token != this->closedTokens.end();)
+        {
+          if (token->second.expired())
+            token = this->closedTokens.erase(token);
+          else
+            ++token;
+        }
+        this->closedTokens[dlHandle] = closed;
         dlHandlePtr = std::shared_ptr<void>(
-              dlHandle, [](void *ptr) { dlclose(ptr); }); // NOLINT
+              dlHandle,
+              [policy = this->unloadPolicy, closed](void *ptr) mutable
+        {
+          if (policy->gracePeriod.load() > 0)
+          {
+            UnloadReaper::Instance().Defer(ptr, policy, std::move(closed));
+          }
+          else
+          {
+            CloseLibrary(ptr, *policy);
+            closed.reset();
+          }
+        });
 
         it->second = dlHandlePtr;
       }
 
+      if (_options.prefault)
+        PrefaultLibrary(dlHandle);
+
+      ++_stats.loads;
       return dlHandlePtr;
     }
 
     /////////////////////////////////////////////////
     std::vector<Info> Loader::Implementation::LoadPlugins(
         const std::shared_ptr<void> &_dlHandle,
-        const std::string& _pathToLibrary) const
+        const std::string& _pathToLibrary,
+        LibraryStatistics &_stats) const
     {
       std::vector<Info> loadedPlugins;
 
@@ -548,9 +1509,12 @@ namespace ignition
       // Does the library have the right symbol?
       if (nullptr == infoFuncPtr)
       {
-        std::cerr << "Library [" << _pathToLibrary << "] does not export any "
-                  << "plugins. The symbol [" << infoSymbol << "] is missing, "
-                  << "or it is not externally visible.\n";
+        this->diagnostics.Report([&](std::ostream &_out)
+        {
+          _out << "Library [" << _pathToLibrary << "] does not export any "
+               << "plugins. The symbol [" << infoSymbol << "] is missing, "
+               << "or it is not externally visible.\n";
+        });
 
         return loadedPlugins;
       }
@@ -592,8 +1556,10 @@ namespace ignition
       // against the static runtime. Using this pointer-to-a-pointer approach is
       // the cleanest way to ensure that all dynamically allocated objects are
       // deleted in the same heap that they were allocated from.
+      const auto hookStart = std::chrono::steady_clock::now();
       InfoHook(nullptr, reinterpret_cast<const void**>(&allInfo),
            &version, &size, &alignment);
+      _stats.hookTime += Since(hookStart);
 
       if (ignition::plugin::INFO_API_VERSION != version)
       {
@@ -602,83 +1568,252 @@ namespace ignition
         // We can call IgnitionPluginHook(~) again with the
         // API version that it expects.
 
-        std::cerr << "The library [" << _pathToLibrary << "] is using an "
-                  << "incompatible version [" << version << "] of the "
-                  << "ignition::plugin Info API. The version in this library "
-                  << "is [" << INFO_API_VERSION << "].\n";
+        this->diagnostics.Report([&](std::ostream &_out)
+        {
+          _out << "The library [" << _pathToLibrary << "] is using an "
+               << "incompatible version [" << version << "] of the "
+               << "ignition::plugin Info API. The version in this library "
+               << "is [" << INFO_API_VERSION << "].\n";
+        });
         return loadedPlugins;
       }
 
       if (sizeof(Info) != size || alignof(Info) != alignment)
       {
-        std::cerr << "The plugin::Info size or alignment are not consistent "
-               << "with the expected values for the library [" << _pathToLibrary
-               << "]:\n -- size: expected " << sizeof(Info)
+        this->diagnostics.Report([&](std::ostream &_out)
+        {
+          _out << "The plugin::Info size or alignment are not consistent "
+               << "with the expected values for the library ["
+               << _pathToLibrary << "]:\n -- size: expected " << sizeof(Info)
                << " | received " << size << "\n -- alignment: expected "
                << alignof(Info) << " | received " << alignment << "\n"
                << " -- We will not be able to safely load plugins from that "
                << "library.\n";
+        });
 
         return loadedPlugins;
       }
 
       if (!allInfo)
       {
-        std::cerr << "The library [" << _pathToLibrary << "] failed to provide "
-                  << "ignition::plugin Info for unknown reasons. Please report "
-                  << "this error as a bug!\n";
+        this->diagnostics.Report([&](std::ostream &_out)
+        {
+          _out << "The library [" << _pathToLibrary << "] failed to provide "
+               << "ignition::plugin Info for unknown reasons. Please report "
+               << "this error as a bug!\n";
+        });
 
         return loadedPlugins;
       }
 
+      const auto importStart = std::chrono::steady_clock::now();
+      loadedPlugins.reserve(allInfo->size());
       for (const InfoMap::value_type &info : *allInfo)
       {
         loadedPlugins.push_back(info.second);
       }
+      _stats.importTime += Since(importStart);
 
       return loadedPlugins;
     }
 
     /////////////////////////////////////////////////
-    std::string Loader::Implementation::LookupPlugin(
-        const std::string &_nameOrAlias) const
+    std::string_view Loader::Implementation::LookupPlugin(
+        const std::string_view _nameOrAlias) const
     {
-      const PluginMap::const_iterator name = this->plugins.find(_nameOrAlias);
+      std::string_view resolvedName;
+      const LookupError error = this->TryLookupPlugin(
+            _nameOrAlias, resolvedName);
+
+      this->ReportLookupError(_nameOrAlias, error);
 
-      if (this->plugins.end() != name)
-        return _nameOrAlias;
+      return resolvedName;
+    }
 
-      const AliasMap::const_iterator alias = this->aliases.find(_nameOrAlias);
-      if (this->aliases.end() != alias && !alias->second.empty())
+    /////////////////////////////////////////////////
+    void Loader::Implementation::ReportLookupError(
+        const std::string_view _nameOrAlias,
+        const LookupError _error) const
+    {
+      if (LookupError::AMBIGUOUS_ALIAS == _error)
+      {
+        this->diagnostics.Report([&](std::ostream &_out)
+        {
+          _out << "[ignition::plugin::Loader::LookupPlugin] Failed to resolve "
+               << "the alias [" << _nameOrAlias << "] because it refers to "
+               << "multiple plugins:\n";
+          const std::set<std::string> &plugins =
+              this->aliases.At(_nameOrAlias);
+          for (const std::string &plugin : plugins)
+            _out << " -- [" << plugin << "]\n";
+        });
+      }
+      else if (LookupError::NOT_FOUND == _error)
       {
-        if (alias->second.size() == 1)
-          return *alias->second.begin();
+        this->diagnostics.Report([&](std::ostream &_out)
+        {
+          _out << "[ignition::plugin::Loader::LookupPlugin] Failed to get "
+               << "info for [" << _nameOrAlias << "]. Could not find a plugin "
+               << "with that name or alias.\n";
+        });
+      }
+    }
+
+    /////////////////////////////////////////////////
+    auto Loader::Implementation::FindPlugin(
+        const std::string_view _nameOrAlias,
+        ConstInfoPtr &_info,
+        std::shared_ptr<void> &_dlHandle) const -> LookupError
+    {
+      _info.reset();
+      _dlHandle.reset();
 
-        // We use a stringstream because we're going to output to std::cerr, and
-        // we want it all to print at once, but std::cerr does not support
-        // buffering.
-        std::stringstream ss;
+      if (this->frozen)
+      {
+        // The frozen index resolves the name and finds the plugin with a
+        // single lookup.
+        const FrozenIndex::Record *record = this->frozen->Find(_nameOrAlias);
+        if (!record)
+          return LookupError::NOT_FOUND;
+
+        if (!record->resolved)
+          return LookupError::AMBIGUOUS_ALIAS;
+
+        this->frozen->Resolve(*record, _info, _dlHandle);
+        this->ApplyProxies(_info);
+        return LookupError::NONE;
+      }
 
-        ss << "[ignition::plugin::Loader::LookupPlugin] Failed to resolve the "
-           << "alias [" << _nameOrAlias << "] because it refers to multiple "
-           << "plugins:\n";
-        for (const std::string &plugin : alias->second)
-          ss << " -- [" << plugin << "]\n";
+      std::string_view resolvedName;
+      const LookupError error = this->TryLookupPlugin(
+            _nameOrAlias, resolvedName);
+      if (LookupError::NONE != error)
+        return error;
 
-        std::cerr << ss.str();
+      const PluginMap::value_type *info = this->plugins.Find(resolvedName);
+      const PluginToDlHandleMap::value_type *dlHandle =
+          this->pluginToDlHandlePtrs.Find(resolvedName);
 
-        return "";
+      if (!info || !dlHandle)
+      {
+        // LCOV_EXCL_START
+        this->diagnostics.Report([&](std::ostream &_out)
+        {
+          _out << "[ignition::Loader::FindPlugin] A resolved name ["
+               << resolvedName << "] could not be found in the PluginMap or "
+               << "the PluginToDlHandleMap. This should not be possible! "
+               << "Please report this bug!\n";
+        });
+        assert(false);
+        return LookupError::NOT_FOUND;
+        // LCOV_EXCL_STOP
       }
 
-      std::cerr << "[ignition::plugin::Loader::LookupPlugin] Failed to get "
-                << "info for [" << _nameOrAlias << "]. Could not find a plugin "
-                << "with that name or alias.\n";
+      _info = info->second;
+      _dlHandle = dlHandle->second;
+      this->ApplyProxies(_info);
+      return LookupError::NONE;
+    }
 
-      return "";
+    /////////////////////////////////////////////////
+    void Loader::Implementation::ApplyProxies(ConstInfoPtr &_info) const
+    {
+      if (this->proxiedPlugins.empty()
+          || !this->proxiesEnabled.load(std::memory_order_relaxed))
+        return;
+
+      const PluginMap::value_type *proxied =
+          this->proxiedPlugins.Find(_info->name);
+      if (proxied)
+        _info = proxied->second;
+    }
+
+    /////////////////////////////////////////////////
+    void Loader::Implementation::Notify(
+        std::unordered_set<std::string> _added,
+        std::unordered_set<std::string> _removed)
+    {
+      if (_added.empty() && _removed.empty())
+        return;
+
+      Change change;
+      change.generation =
+          this->generation.fetch_add(1, std::memory_order_acq_rel) + 1;
+      change.added = std::move(_added);
+      change.removed = std::move(_removed);
+
+      // Iterate over a copy so that the callbacks are free to subscribe or
+      // unsubscribe.
+      const std::map<std::size_t, ChangeCallback> callbacks = this->subscribers;
+      for (const auto &subscriber : callbacks)
+      {
+        if (this->subscribers.count(subscriber.first) && subscriber.second)
+          subscriber.second(change);
+      }
+    }
+
+    /////////////////////////////////////////////////
+    auto Loader::Implementation::TryLookupPlugin(
+        const std::string_view _nameOrAlias,
+        std::string_view &_resolvedName) const -> LookupError
+    {
+      _resolvedName = std::string_view();
+
+      if (this->frozen)
+      {
+        // Every name and alias is a key of the frozen index, and ambiguous
+        // aliases are kept in it without a resolved name.
+        const FrozenIndex::Record *record = this->frozen->Find(_nameOrAlias);
+        if (!record)
+          return LookupError::NOT_FOUND;
+
+        if (!record->resolved)
+          return LookupError::AMBIGUOUS_ALIAS;
+
+        _resolvedName =
+            std::string_view(record->resolved, record->resolvedLength);
+        return LookupError::NONE;
+      }
+
+      const PluginMap::value_type *name = this->plugins.Find(_nameOrAlias);
+
+      if (name)
+      {
+        _resolvedName = name->first;
+        return LookupError::NONE;
+      }
+
+      const AliasMap::value_type *alias = this->aliases.Find(_nameOrAlias);
+      if (!alias || alias->second.empty())
+        return LookupError::NOT_FOUND;
+
+      if (alias->second.size() > 1)
+        return LookupError::AMBIGUOUS_ALIAS;
+
+      _resolvedName = *alias->second.begin();
+      return LookupError::NONE;
     }
 
     /////////////////////////////////////////////////
     bool Loader::Implementation::ForgetLibrary(void *_dlHandle)
+    {
+      std::unordered_set<std::string> removed;
+      if (!this->EraseLibrary(_dlHandle, removed))
+        return false;
+
+      this->Notify({}, std::move(removed));
+
+      // Dev note (MXG): We do not need to call dlclose because that will be
+      // taken care of automatically by the std::shared_ptr that manages the
+      // shared library handle.
+
+      return true;
+    }
+
+    /////////////////////////////////////////////////
+    bool Loader::Implementation::EraseLibrary(
+        void *_dlHandle,
+        std::unordered_set<std::string> &_removed)
     {
       DlHandleToPluginMap::iterator it = dlHandleToPluginMap.find(_dlHandle);
       if (dlHandleToPluginMap.end() == it)
@@ -689,9 +1824,9 @@ namespace ignition
       for (const std::string &forget : forgottenPlugins)
       {
         // Erase each alias entry corresponding to this plugin
-        const ConstInfoPtr &info = plugins.at(forget);
+        const ConstInfoPtr &info = plugins.At(forget);
         for (const std::string &alias : info->aliases)
-          this->aliases.at(alias).erase(info->name);
+          this->aliases.At(alias).erase(info->name);
       }
 
       for (const std::string &forget : forgottenPlugins)
@@ -701,26 +1836,297 @@ namespace ignition
         // because the Info structs require the library to remain loaded
         // for the destructors of their `deleter` member variables.
 
+        this->capabilities.Remove(forget);
+
         // This erase should come FIRST.
-        plugins.erase(forget);
+        plugins.Erase(forget);
+        proxiedPlugins.Erase(forget);
 
         // This erase should come LAST.
-        pluginToDlHandlePtrs.erase(forget);
+        pluginToDlHandlePtrs.Erase(forget);
       }
 
       // Dev note (MXG): We do not need to delete anything from `dlHandlePtrMap`
       // because it uses std::weak_ptrs. It will clear itself automatically.
 
+      for (auto reloaded = this->reloadedHandles.begin();
+           reloaded != this->reloadedHandles.end();)
+      {
+        if (reloaded->second == _dlHandle)
+          reloaded = this->reloadedHandles.erase(reloaded);
+        else
+          ++reloaded;
+      }
+
+      _removed = std::move(it->second);
+
       // Dev note (MXG): This erase call should come at the very end of this
       // function to ensure that the `forgottenPlugins` reference remains valid
       // while it is being used.
       dlHandleToPluginMap.erase(it);
 
-      // Dev note (MXG): We do not need to call dlclose because that will be
-      // taken care of automatically by the std::shared_ptr that manages the
-      // shared library handle.
-
       return true;
     }
+
+    /////////////////////////////////////////////////
+    std::unordered_set<std::string> Loader::Implementation::RegisterPlugins(
+        const std::shared_ptr<void> &_dlHandle,
+        std::vector<Info> &_infos,
+        std::unordered_set<std::string> &_added,
+        LibraryStatistics &_stats)
+    {
+      const auto start = std::chrono::steady_clock::now();
+      std::chrono::nanoseconds demangleTime{0};
+
+      std::unordered_set<std::string> newPlugins;
+
+      for (Info &plugin : _infos)
+      {
+        const auto demangleStart = std::chrono::steady_clock::now();
+
+        // Demangle the plugin name before creating an entry for it.
+        plugin.name = DemangleSymbol(plugin.name);
+
+        // Make a list of the demangled interface names for later convenience.
+        for (auto const &interface : plugin.interfaces)
+          plugin.demangledInterfaces.insert(DemangleSymbol(interface.first));
+
+        demangleTime += Since(demangleStart);
+
+        // Add the plugin's aliases to the alias map
+        for (const std::string &alias : plugin.aliases)
+          this->aliases[alias].insert(plugin.name);
+
+        std::shared_ptr<PluginCounters> &counters =
+            this->pluginCounters[plugin.name];
+        if (!counters)
+          counters = std::make_shared<PluginCounters>();
+        counters->library = _stats.path;
+        CountingFactory::Instrument(plugin, counters);
+
+        // Add the plugin to the map
+        const auto inserted = this->plugins.Insert(
+              plugin.name, std::make_shared<Info>(plugin));
+
+        if (inserted.second)
+        {
+          if (ConstInfoPtr proxied =
+                  ProxyInstances::Instrument(plugin, this->proxyCounters))
+          {
+            this->proxiedPlugins[plugin.name] = std::move(proxied);
+          }
+
+          this->capabilities.Add(
+                inserted.first->first, *inserted.first->second);
+          _added.insert(plugin.name);
+        }
+
+        // Add the plugin's name to the set of newPlugins
+        newPlugins.insert(plugin.name);
+
+        // Save the dl handle for this plugin
+        this->pluginToDlHandlePtrs[plugin.name] = _dlHandle;
+      }
+
+      this->dlHandleToPluginMap[_dlHandle.get()] = newPlugins;
+
+      _stats.demangleTime += demangleTime;
+      _stats.importTime += Since(start) - demangleTime;
+
+      return newPlugins;
+    }
+
+    /////////////////////////////////////////////////
+    auto Loader::Implementation::StatsOf(const std::string &_pathToLibrary)
+        -> LibraryStatistics &
+    {
+      LibraryStatistics &stats = this->libraryStats[_pathToLibrary];
+      stats.path = _pathToLibrary;
+      return stats;
+    }
+
+    /////////////////////////////////////////////////
+    void *Loader::Implementation::CurrentHandleOf(
+        const std::string &_pathToLibrary) const
+    {
+      const auto reloaded = this->reloadedHandles.find(_pathToLibrary);
+      if (this->reloadedHandles.end() != reloaded)
+        return reloaded->second;
+
+#ifndef RTLD_NOLOAD
+// This macro is not part of the POSIX standard, and is a custom addition to
+// glibc-2.2, so we need create a no-op stand-in flag for it if we are not
+// using glibc-2.2.
+#define RTLD_NOLOAD 0
+#endif
+
+      void *dlHandle = dlopen(_pathToLibrary.c_str(),
+                              RTLD_NOLOAD | RTLD_LAZY | RTLD_LOCAL);
+
+      if (!dlHandle)
+        return nullptr;
+
+      // We should decrement the reference count because we called dlopen. Even
+      // with the RTLD_NOLOAD flag, the call to dlopen will still (allegedly)
+      // increment the reference count when it returns a valid handle. Note that
+      // this knowledge is according to online discussions and is not explicitly
+      // stated in the manual pages of dlopen (but it is consistent with the
+      // overall behavior of dlopen).
+      dlclose(dlHandle);
+
+      return dlHandle;
+    }
+
+    /////////////////////////////////////////////////
+    /// \brief Copy a library to a new file in the temporary directory, so that
+    /// the dynamic linker treats it as a different library than the one which
+    /// was loaded from the original path.
+    /// \param[in] _pathToLibrary The library to copy
+    /// \return The path of the copy, or an empty string if it failed
+    static std::string CopyToUniquePath(const std::string &_pathToLibrary)
+    {
+#ifdef _WIN32
+      // A library cannot be removed while it is loaded on Windows, so the
+      // copies of a process pile up in the temporary directory. Each one is
+      // named after the process, the number of the copy, and the time, and
+      // it keeps the extension of the library.
+      static std::atomic<std::uint64_t> copies{0};
+      std::string copy = ".";
+      char *tmpdir = nullptr;
+      std::size_t tmpdirLength = 0;
+      if (0 == _dupenv_s(&tmpdir, &tmpdirLength, "TEMP") && tmpdir)
+      {
+        if (*tmpdir)
+          copy = tmpdir;
+        std::free(tmpdir);
+      }
+
+      const std::size_t slash = _pathToLibrary.find_last_of("/\\");
+      copy += "\\ign_" + std::to_string(_getpid()) + "_"
+          + std::to_string(copies++) + "_"
+          + std::to_string(std::chrono::steady_clock::now()
+                           .time_since_epoch().count()) + "_"
+          + _pathToLibrary.substr(std::string::npos == slash ? 0 : slash + 1);
+#else
+      const char *tmpdir = std::getenv("TMPDIR");
+      std::string copy = (tmpdir && *tmpdir) ? tmpdir : "/tmp";
+
+      const std::size_t slash = _pathToLibrary.rfind('/');
+      copy += "/" + _pathToLibrary.substr(
+            std::string::npos == slash ? 0 : slash + 1) + ".XXXXXX";
+
+      const int fd = mkstemp(&copy[0]);
+      if (fd < 0)
+        return "";
+      close(fd);
+#endif
+
+      std::ifstream in(_pathToLibrary, std::ios::binary);
+      std::ofstream out(copy, std::ios::binary | std::ios::trunc);
+      out << in.rdbuf();
+      out.close();
+
+      if (!in || !out)
+      {
+        std::remove(copy.c_str());
+        return "";
+      }
+
+      return copy;
+    }
+
+    /////////////////////////////////////////////////
+    std::unordered_set<std::string> Loader::Implementation::ReloadLib(
+        const std::string &_pathToLibrary)
+    {
+      IGN_PLUGIN_TRACE_SCOPE("ReloadLib", _pathToLibrary);
+
+      const std::string copy = CopyToUniquePath(_pathToLibrary);
+      if (copy.empty())
+      {
+        this->diagnostics.Report([&](std::ostream &_out)
+        {
+          _out << "[ignition::plugin::Loader::ReloadLib] Unable to make a "
+               << "copy of the library [" << _pathToLibrary << "]. The "
+               << "current version will be kept.\n";
+        });
+        return {};
+      }
+
+      LibraryStatistics &stats = this->StatsOf(_pathToLibrary);
+      const std::shared_ptr<void> dlHandle =
+          this->LoadLib(copy, this->loadOptions, stats);
+
+      // The mapping of the library keeps the copy alive, so its name can be
+      // released right away. Windows does not allow a loaded library to be
+      // removed, so the copy stays in the temporary directory there.
+      std::remove(copy.c_str());
+
+      if (!dlHandle)
+        return {};
+
+      std::vector<Info> loadedPlugins =
+          this->LoadPlugins(dlHandle, _pathToLibrary, stats);
+
+      if (loadedPlugins.empty())
+      {
+        this->diagnostics.Report([&](std::ostream &_out)
+        {
+          _out << "[ignition::plugin::Loader::ReloadLib] The new version of "
+               << "the library [" << _pathToLibrary << "] does not provide "
+               << "any plugins. The current version will be kept.\n";
+        });
+        return {};
+      }
+
+      // Retire the version which is currently in use. Plugin instances that
+      // were created from it hold their own references to its handle, so it
+      // stays loaded until they are gone.
+      std::unordered_set<std::string> removed;
+      void *const oldHandle = this->CurrentHandleOf(_pathToLibrary);
+      const DlHandleMap::const_iterator old =
+          this->dlHandlePtrMap.find(oldHandle);
+
+      if (oldHandle && this->dlHandlePtrMap.end() != old)
+      {
+        const std::weak_ptr<const void> retiring =
+            this->closedTokens.at(oldHandle);
+        if (this->EraseLibrary(oldHandle, removed))
+          this->retired.push_back({_pathToLibrary, retiring});
+      }
+
+      std::unordered_set<std::string> added;
+      std::unordered_set<std::string> newPlugins =
+          this->RegisterPlugins(dlHandle, loadedPlugins, added, stats);
+      this->reloadedHandles[_pathToLibrary] = dlHandle.get();
+
+      this->Notify(std::move(added), std::move(removed));
+
+      return newPlugins;
+    }
+
+    /////////////////////////////////////////////////
+    void Loader::Implementation::CollectDrained()
+    {
+      std::vector<std::string> drained;
+      for (auto it = this->retired.begin(); it != this->retired.end();)
+      {
+        if (it->closed.expired())
+        {
+          drained.push_back(std::move(it->pathToLibrary));
+          it = this->retired.erase(it);
+        }
+        else
+        {
+          ++it;
+        }
+      }
+
+      if (!this->drainCallback)
+        return;
+
+      for (const std::string &path : drained)
+        this->drainCallback(path);
+    }
   }
 }
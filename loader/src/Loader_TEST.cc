@@ -18,6 +18,12 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <vector>
 
 #include <ignition/plugin/Loader.hh>
 #include <ignition/plugin/config.hh>
@@ -112,6 +118,251 @@ TEST(Loader, ForgetUnloadedLibrary)
   EXPECT_FALSE(loader.ForgetLibrary(IGNDummyPlugins_LIB));
 }
 
+/////////////////////////////////////////////////
+TEST(Loader, Freeze)
+{
+  ignition::plugin::Loader loader;
+  EXPECT_FALSE(loader.IsFrozen());
+
+  const std::size_t pluginCount = loader.LoadLib(IGNDummyPlugins_LIB).size();
+  EXPECT_LT(0u, pluginCount);
+
+  loader.Freeze();
+  EXPECT_TRUE(loader.IsFrozen());
+
+  // Freezing twice should be harmless
+  loader.Freeze();
+  EXPECT_TRUE(loader.IsFrozen());
+
+  // Names and unique aliases resolve through the frozen index
+  EXPECT_EQ("test::util::DummySinglePlugin",
+            loader.LookupPlugin("test::util::DummySinglePlugin"));
+  EXPECT_EQ("test::util::DummySinglePlugin",
+            loader.LookupPlugin("Alternative name"));
+  EXPECT_EQ("test::util::DummyMultiPlugin", loader.LookupPlugin("Foo"));
+
+  // Ambiguous aliases and unknown names still fail to resolve
+  EXPECT_TRUE(loader.LookupPlugin("Bar").empty());
+  EXPECT_TRUE(loader.LookupPlugin("not::a::plugin").empty());
+  EXPECT_TRUE(loader.LookupPlugin("").empty());
+
+  EXPECT_TRUE(loader.Instantiate("Foo"));
+  EXPECT_TRUE(loader.Instantiate("test::util::DummyNoAliasPlugin"));
+  EXPECT_FALSE(loader.Instantiate("Baz"));
+  EXPECT_TRUE(loader.Instantiate<
+      ignition::plugin::SpecializedPluginPtr<SomeInterface>>(
+        "Alternative name"));
+
+  // The set of plugins can no longer change
+  EXPECT_TRUE(loader.LoadLib(IGNDummyPlugins_LIB).empty());
+  EXPECT_FALSE(loader.ForgetLibrary(IGNDummyPlugins_LIB));
+  EXPECT_FALSE(loader.ForgetLibraryOfPlugin("Foo"));
+  EXPECT_EQ(pluginCount, loader.AllPlugins().size());
+  EXPECT_TRUE(loader.Instantiate("Foo"));
+}
+
+/////////////////////////////////////////////////
+TEST(Loader, FreezeEmpty)
+{
+  ignition::plugin::Loader loader;
+  loader.Freeze();
+  EXPECT_TRUE(loader.IsFrozen());
+  EXPECT_TRUE(loader.LookupPlugin("anything").empty());
+  EXPECT_FALSE(loader.Instantiate("anything"));
+}
+
+/////////////////////////////////////////////////
+TEST(Loader, TryLookupPlugin)
+{
+  using LookupError = ignition::plugin::Loader::LookupError;
+
+  ignition::plugin::Loader loader;
+  loader.LoadLib(IGNDummyPlugins_LIB);
+
+  std::vector<std::string> messages;
+  loader.SetDiagnosticSink([&](const std::string &_message)
+  {
+    messages.push_back(_message);
+  });
+
+  for (const bool frozen : {false, true})
+  {
+    if (frozen)
+      loader.Freeze();
+
+    std::string_view name = "unchanged";
+    EXPECT_EQ(LookupError::NONE, loader.TryLookupPlugin("Foo", name));
+    EXPECT_EQ("test::util::DummyMultiPlugin", name);
+
+    EXPECT_EQ(LookupError::NONE, loader.TryLookupPlugin(
+                "test::util::DummySinglePlugin", name));
+    EXPECT_EQ("test::util::DummySinglePlugin", name);
+
+    EXPECT_EQ(LookupError::AMBIGUOUS_ALIAS,
+              loader.TryLookupPlugin("Bar", name));
+    EXPECT_TRUE(name.empty());
+
+    EXPECT_EQ(LookupError::NOT_FOUND,
+              loader.TryLookupPlugin("not::a::plugin", name));
+    EXPECT_TRUE(name.empty());
+
+    ignition::plugin::PluginPtr plugin;
+    EXPECT_EQ(LookupError::NONE, loader.TryInstantiate("Foo", plugin));
+    EXPECT_TRUE(plugin);
+
+    EXPECT_EQ(LookupError::NOT_FOUND,
+              loader.TryInstantiate("not::a::plugin", plugin));
+    EXPECT_FALSE(plugin);
+
+    ignition::plugin::SpecializedPluginPtr<SomeInterface> specialized;
+    EXPECT_EQ(LookupError::AMBIGUOUS_ALIAS,
+              loader.TryInstantiate("Bar", specialized));
+    EXPECT_FALSE(specialized);
+
+    EXPECT_EQ(LookupError::NONE,
+              loader.TryInstantiate("Alternative name", specialized));
+    EXPECT_TRUE(specialized);
+
+    // None of the Try functions report anything
+    EXPECT_TRUE(messages.empty());
+  }
+
+  // The regular lookups still report their failures
+  EXPECT_TRUE(loader.LookupPlugin("Bar").empty());
+  ASSERT_EQ(1u, messages.size());
+  EXPECT_NE(std::string::npos,
+            messages[0].find("test::util::DummyMultiPlugin"));
+
+  EXPECT_FALSE(loader.Instantiate("not::a::plugin"));
+  ASSERT_EQ(2u, messages.size());
+  EXPECT_NE(std::string::npos, messages[1].find("not::a::plugin"));
+
+  // A nullptr sink discards everything
+  loader.SetDiagnosticSink(nullptr);
+  EXPECT_TRUE(loader.LookupPlugin("not::a::plugin").empty());
+  EXPECT_EQ(2u, messages.size());
+}
+
+/////////////////////////////////////////////////
+TEST(Loader, DiagnosticRateLimit)
+{
+  ignition::plugin::Loader loader;
+
+  std::vector<std::string> messages;
+  const auto sink = [&](const std::string &_message)
+  {
+    messages.push_back(_message);
+  };
+
+  loader.SetDiagnosticSink(sink, 2, std::chrono::hours(1));
+  for (std::size_t i = 0; i < 10; ++i)
+    EXPECT_TRUE(loader.LookupPlugin("not::a::plugin").empty());
+  EXPECT_EQ(2u, messages.size());
+
+  // Once the period has passed, the number of dropped messages is reported
+  // ahead of the next message.
+  messages.clear();
+  loader.SetDiagnosticSink(sink, 1, std::chrono::milliseconds(50));
+  for (std::size_t i = 0; i < 3; ++i)
+    EXPECT_TRUE(loader.LookupPlugin("not::a::plugin").empty());
+  EXPECT_EQ(1u, messages.size());
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(60));
+  EXPECT_TRUE(loader.LookupPlugin("not::a::plugin").empty());
+  ASSERT_EQ(3u, messages.size());
+  EXPECT_NE(std::string::npos, messages[1].find("Dropped 2"));
+
+  // A burst of 0 means that there is no limit
+  messages.clear();
+  loader.SetDiagnosticSink(sink, 0);
+  for (std::size_t i = 0; i < 100; ++i)
+    EXPECT_TRUE(loader.LookupPlugin("not::a::plugin").empty());
+  EXPECT_EQ(100u, messages.size());
+}
+
+/////////////////////////////////////////////////
+TEST(Loader, DefaultDiagnosticsAreNotLimited)
+{
+  ignition::plugin::Loader loader;
+
+  testing::internal::CaptureStderr();
+  for (std::size_t i = 0; i < 100; ++i)
+    EXPECT_TRUE(loader.LookupPlugin("not::a::plugin").empty());
+  const std::string output = testing::internal::GetCapturedStderr();
+
+  std::size_t count = 0;
+  for (std::size_t pos = output.find("not::a::plugin");
+       pos != std::string::npos; pos = output.find("not::a::plugin", pos + 1))
+  {
+    ++count;
+  }
+  EXPECT_EQ(100u, count);
+  EXPECT_EQ(std::string::npos, output.find("Dropped"));
+}
+
+/////////////////////////////////////////////////
+TEST(Loader, ChangeNotifications)
+{
+  ignition::plugin::Loader loader;
+  EXPECT_EQ(0u, loader.Generation());
+
+  std::vector<ignition::plugin::Loader::Change> changes;
+  const std::size_t subscription = loader.Subscribe(
+        [&](const ignition::plugin::Loader::Change &_change)
+  {
+    changes.push_back(_change);
+  });
+
+  // Failing to load anything is not a change
+  EXPECT_TRUE(loader.LoadLib("/path/to/libDoesNotExist.so").empty());
+  EXPECT_EQ(0u, loader.Generation());
+  EXPECT_TRUE(changes.empty());
+
+  const std::unordered_set<std::string> loaded =
+      loader.LoadLib(IGNDummyPlugins_LIB);
+  EXPECT_LT(0u, loaded.size());
+  EXPECT_EQ(1u, loader.Generation());
+  ASSERT_EQ(1u, changes.size());
+  EXPECT_EQ(1u, changes[0].generation);
+  EXPECT_EQ(loaded, changes[0].added);
+  EXPECT_TRUE(changes[0].removed.empty());
+
+  // Loading the same library again does not add any plugins
+  EXPECT_EQ(loaded, loader.LoadLib(IGNDummyPlugins_LIB));
+  EXPECT_EQ(1u, loader.Generation());
+  EXPECT_EQ(1u, changes.size());
+
+  EXPECT_TRUE(loader.ForgetLibraryOfPlugin("Foo"));
+  EXPECT_EQ(2u, loader.Generation());
+  ASSERT_EQ(2u, changes.size());
+  EXPECT_EQ(2u, changes[1].generation);
+  EXPECT_TRUE(changes[1].added.empty());
+  EXPECT_EQ(loaded, changes[1].removed);
+
+  // A callback may unsubscribe itself
+  std::size_t selfRemoving = 0;
+  std::size_t selfRemovingCalls = 0;
+  selfRemoving = loader.Subscribe(
+        [&](const ignition::plugin::Loader::Change &)
+  {
+    ++selfRemovingCalls;
+    EXPECT_TRUE(loader.Unsubscribe(selfRemoving));
+  });
+  EXPECT_NE(subscription, selfRemoving);
+
+  EXPECT_TRUE(loader.Unsubscribe(subscription));
+  EXPECT_FALSE(loader.Unsubscribe(subscription));
+
+  loader.LoadLib(IGNDummyPlugins_LIB);
+  EXPECT_EQ(3u, loader.Generation());
+  EXPECT_EQ(2u, changes.size());
+  EXPECT_EQ(1u, selfRemovingCalls);
+
+  EXPECT_TRUE(loader.ForgetLibrary(IGNDummyPlugins_LIB));
+  EXPECT_EQ(4u, loader.Generation());
+  EXPECT_EQ(1u, selfRemovingCalls);
+}
+
 /////////////////////////////////////////////////
 int main(int argc, char **argv)
 {
@@ -0,0 +1,237 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef IGNITION_PLUGIN_SRC_NAMEMAP_HH_
+#define IGNITION_PLUGIN_SRC_NAMEMAP_HH_
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+namespace ignition
+{
+  namespace plugin
+  {
+    /// \brief A hash map which is keyed on names, and which can be searched
+    /// with a std::string_view without allocating a std::string. The entries
+    /// are owned by a std::unordered_map<std::string, Value>, and an index
+    /// maps a std::string_view of each key, which refers to the key owned by
+    /// that map, to its entry. The nodes of a std::unordered_map never move,
+    /// so the index stays valid until the entry is erased.
+    template <typename Value>
+    class NameMap
+    {
+      /// \brief The map which owns the entries
+      public: using Map = std::unordered_map<std::string, Value>;
+
+      /// \brief A key and its value
+      public: using value_type = typename Map::value_type;
+
+      /// \brief Iterator over the entries
+      public: using const_iterator = typename Map::const_iterator;
+
+      /// \brief Default constructor
+      public: NameMap() = default;
+
+      /// \brief The index refers to the entries of this map, so it cannot be
+      /// copied.
+      public: NameMap(const NameMap &) = delete;
+
+      /// \brief The index refers to the entries of this map, so it cannot be
+      /// copied.
+      public: NameMap &operator=(const NameMap &) = delete;
+
+      /// \brief Find the entry of a name.
+      /// \param[in] _name The name to look for
+      /// \return The entry of _name, or nullptr if it has none.
+      public: const value_type *Find(std::string_view _name) const;
+
+      /// \brief Find the entry of a name.
+      /// \param[in] _name The name to look for
+      /// \return The entry of _name, or nullptr if it has none.
+      public: value_type *Find(std::string_view _name);
+
+      /// \brief Get the value of a name which must have an entry.
+      /// \param[in] _name The name to look for
+      /// \return The value of _name
+      /// \throws std::out_of_range if _name has no entry
+      public: const Value &At(std::string_view _name) const;
+
+      /// \brief Get the value of a name which must have an entry.
+      /// \param[in] _name The name to look for
+      /// \return The value of _name
+      /// \throws std::out_of_range if _name has no entry
+      public: Value &At(std::string_view _name);
+
+      /// \brief Add an entry for a name, unless it already has one.
+      /// \param[in] _name The name to add
+      /// \param[in] _value The value to give it if it has no entry yet
+      /// \return The entry of _name, and true if it was added by this call
+      public: std::pair<value_type*, bool> Insert(
+          const std::string &_name, Value _value);
+
+      /// \brief Get the value of a name, and give it a default-constructed
+      /// value first if it has no entry yet.
+      /// \param[in] _name The name to look for
+      /// \return The value of _name
+      public: Value &operator[](const std::string &_name);
+
+      /// \brief Remove the entry of a name, if it has one.
+      /// \param[in] _name The name to remove
+      /// \return The number of entries that were removed
+      public: std::size_t Erase(std::string_view _name);
+
+      /// \brief Get the number of entries.
+      /// \return The number of entries
+      public: std::size_t size() const;
+
+      /// \brief Check whether there are no entries.
+      /// \return True if there are no entries
+      public: bool empty() const;
+
+      /// \brief Iterate over the entries, in no particular order.
+      /// \return An iterator to the first entry
+      public: const_iterator begin() const;
+
+      /// \brief Iterate over the entries, in no particular order.
+      /// \return An iterator past the last entry
+      public: const_iterator end() const;
+
+      /// \brief The entries
+      private: Map entries;
+
+      /// \brief The entry of each key in `entries`
+      private: std::unordered_map<std::string_view, value_type*> index;
+    };
+
+    /////////////////////////////////////////////////
+    template <typename Value>
+    auto NameMap<Value>::Find(const std::string_view _name) const
+        -> const value_type*
+    {
+      const auto it = this->index.find(_name);
+      if (this->index.end() == it)
+        return nullptr;
+
+      return it->second;
+    }
+
+    /////////////////////////////////////////////////
+    template <typename Value>
+    auto NameMap<Value>::Find(const std::string_view _name) -> value_type*
+    {
+      const auto it = this->index.find(_name);
+      if (this->index.end() == it)
+        return nullptr;
+
+      return it->second;
+    }
+
+    /////////////////////////////////////////////////
+    template <typename Value>
+    const Value &NameMap<Value>::At(const std::string_view _name) const
+    {
+      const value_type *entry = this->Find(_name);
+      if (!entry)
+        throw std::out_of_range("NameMap::At");
+
+      return entry->second;
+    }
+
+    /////////////////////////////////////////////////
+    template <typename Value>
+    Value &NameMap<Value>::At(const std::string_view _name)
+    {
+      value_type *entry = this->Find(_name);
+      if (!entry)
+        throw std::out_of_range("NameMap::At");
+
+      return entry->second;
+    }
+
+    /////////////////////////////////////////////////
+    template <typename Value>
+    auto NameMap<Value>::Insert(const std::string &_name, Value _value)
+        -> std::pair<value_type*, bool>
+    {
+      if (value_type *entry = this->Find(_name))
+        return {entry, false};
+
+      value_type &entry =
+          *this->entries.emplace(_name, std::move(_value)).first;
+      this->index.emplace(std::string_view(entry.first), &entry);
+      return {&entry, true};
+    }
+
+    /////////////////////////////////////////////////
+    template <typename Value>
+    Value &NameMap<Value>::operator[](const std::string &_name)
+    {
+      return this->Insert(_name, Value()).first->second;
+    }
+
+    /////////////////////////////////////////////////
+    template <typename Value>
+    std::size_t NameMap<Value>::Erase(const std::string_view _name)
+    {
+      const auto it = this->index.find(_name);
+      if (this->index.end() == it)
+        return 0;
+
+      // The key of the index refers to the key of the entry, so the index is
+      // erased first.
+      const typename Map::const_iterator entry =
+          this->entries.find(it->second->first);
+      this->index.erase(it);
+      this->entries.erase(entry);
+      return 1;
+    }
+
+    /////////////////////////////////////////////////
+    template <typename Value>
+    std::size_t NameMap<Value>::size() const
+    {
+      return this->entries.size();
+    }
+
+    /////////////////////////////////////////////////
+    template <typename Value>
+    bool NameMap<Value>::empty() const
+    {
+      return this->entries.empty();
+    }
+
+    /////////////////////////////////////////////////
+    template <typename Value>
+    auto NameMap<Value>::begin() const -> const_iterator
+    {
+      return this->entries.begin();
+    }
+
+    /////////////////////////////////////////////////
+    template <typename Value>
+    auto NameMap<Value>::end() const -> const_iterator
+    {
+      return this->entries.end();
+    }
+  }
+}
+
+#endif
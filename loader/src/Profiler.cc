@@ -0,0 +1,390 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifdef __linux__
+#include <signal.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+#include <ignition/plugin/Profiler.hh>
+
+#include "AddressAttributor.hh"
+
+namespace
+{
+  /// \brief The program counters that were sampled. The signal handler only
+  /// uses lock-free atomic operations on this, which are safe to use inside
+  /// of a signal handler.
+  struct SampleBuffer
+  {
+    /// \brief Constructor
+    /// \param[in] _capacity The most samples to keep
+    public: explicit SampleBuffer(const std::size_t _capacity)
+      : pcs(new std::atomic<std::uintptr_t>[_capacity]()),
+        capacity(_capacity)
+    {
+      // Do nothing
+    }
+
+    /// \brief The program counter of each sample
+    public: std::unique_ptr<std::atomic<std::uintptr_t>[]> pcs;
+
+    /// \brief The number of elements in pcs
+    public: const std::size_t capacity;
+
+    /// \brief The number of samples that have been taken, including the
+    /// ones that did not fit
+    public: std::atomic<std::size_t> next{0};
+  };
+
+#ifdef __linux__
+  /// \brief The buffer of the profiler which is running, if any
+  std::atomic<SampleBuffer*> activeBuffer{nullptr};
+
+  /// \brief The number of signal handlers which might be using activeBuffer
+  std::atomic<int> handlersRunning{0};
+
+  /// \brief True while a profiler is running
+  std::atomic<bool> profilerClaimed{false};
+
+  /////////////////////////////////////////////////
+  /// \brief Get the program counter of an interrupted thread.
+  /// \param[in] _context The ucontext_t that was passed to the handler
+  /// \return The program counter, or 0 if it is not known on this platform
+  std::uintptr_t ProgramCounter(void *_context)
+  {
+#if defined(__x86_64__)
+    return static_cast<std::uintptr_t>(
+          static_cast<ucontext_t*>(_context)->uc_mcontext.gregs[REG_RIP]);
+#elif defined(__i386__)
+    return static_cast<std::uintptr_t>(
+          static_cast<ucontext_t*>(_context)->uc_mcontext.gregs[REG_EIP]);
+#elif defined(__aarch64__)
+    return static_cast<std::uintptr_t>(
+          static_cast<ucontext_t*>(_context)->uc_mcontext.pc);
+#else
+    (void)_context;
+    return 0;
+#endif
+  }
+
+  /////////////////////////////////////////////////
+  /// \brief The SIGPROF handler. It only records the program counter.
+  void OnSample(int, siginfo_t *, void *_context)
+  {
+    const int savedErrno = errno;
+    ++handlersRunning;
+
+    SampleBuffer *const buffer = activeBuffer.load();
+    if (buffer)
+    {
+      const std::size_t index =
+          buffer->next.fetch_add(1, std::memory_order_relaxed);
+      if (index < buffer->capacity)
+      {
+        buffer->pcs[index].store(
+              ProgramCounter(_context), std::memory_order_relaxed);
+      }
+    }
+
+    --handlersRunning;
+    errno = savedErrno;
+  }
+#endif
+}
+
+namespace ignition
+{
+  namespace plugin
+  {
+    /////////////////////////////////////////////////
+    /// \brief PIMPL Implementation of the Profiler class
+    class Profiler::Implementation
+    {
+      /// \brief Constructor
+      /// \param[in] _loader The Loader whose plugins are profiled
+      /// \param[in] _capacity The most samples to keep
+      public: Implementation(const Loader &_loader, std::size_t _capacity)
+        : attributor(_loader),
+          buffer(_capacity)
+      {
+        // Do nothing
+      }
+
+      /// \sa Profiler::Attribute()
+      public: Attribution Attribute(std::uintptr_t _address) const;
+
+      /// \brief Attributes the samples to the plugins of the Loader
+      public: AddressAttributor attributor;
+
+      /// \brief The samples
+      public: SampleBuffer buffer;
+
+      /// \brief True while this profiler is running
+      public: bool running = false;
+
+#ifdef __linux__
+      /// \brief The SIGPROF action that was replaced by Start()
+      public: struct sigaction previousAction;
+
+      /// \brief The profiling timer that was replaced by Start()
+      public: struct itimerval previousTimer;
+#endif
+    };
+
+    /////////////////////////////////////////////////
+    auto Profiler::Implementation::Attribute(
+        const std::uintptr_t _address) const -> Attribution
+    {
+      AddressAttributor::Attribution found =
+          this->attributor.Attribute(_address);
+
+      Attribution attribution;
+      attribution.library = std::move(found.library);
+      attribution.plugin = std::move(found.plugin);
+      attribution.interface = std::move(found.interface);
+      attribution.symbol = std::move(found.symbol);
+      return attribution;
+    }
+
+    /////////////////////////////////////////////////
+    Profiler::Profiler(const Loader &_loader, const std::size_t _capacity)
+      : dataPtr(new Implementation(_loader, _capacity))
+    {
+      // Do nothing
+    }
+
+    /////////////////////////////////////////////////
+    Profiler::~Profiler()
+    {
+      this->Stop();
+    }
+
+    /////////////////////////////////////////////////
+    bool Profiler::Start(const std::chrono::microseconds _interval)
+    {
+#ifdef __linux__
+      if (this->dataPtr->running)
+        return false;
+
+      bool expected = false;
+      if (!profilerClaimed.compare_exchange_strong(expected, true))
+        return false;
+
+      this->dataPtr->attributor.Refresh();
+      activeBuffer.store(&this->dataPtr->buffer);
+
+      struct sigaction action = {};
+      action.sa_sigaction = &OnSample;
+      sigemptyset(&action.sa_mask);
+      action.sa_flags = SA_SIGINFO | SA_RESTART;
+
+      if (0 != sigaction(SIGPROF, &action, &this->dataPtr->previousAction))
+      {
+        // LCOV_EXCL_START
+        activeBuffer.store(nullptr);
+        profilerClaimed.store(false);
+        return false;
+        // LCOV_EXCL_STOP
+      }
+
+      const std::chrono::microseconds::rep micros =
+          std::max<std::chrono::microseconds::rep>(1, _interval.count());
+
+      struct itimerval timer;
+      timer.it_interval.tv_sec = static_cast<time_t>(micros / 1000000);
+      timer.it_interval.tv_usec = static_cast<suseconds_t>(micros % 1000000);
+      timer.it_value = timer.it_interval;
+
+      if (0 != setitimer(ITIMER_PROF, &timer, &this->dataPtr->previousTimer))
+      {
+        // LCOV_EXCL_START
+        sigaction(SIGPROF, &this->dataPtr->previousAction, nullptr);
+        activeBuffer.store(nullptr);
+        profilerClaimed.store(false);
+        return false;
+        // LCOV_EXCL_STOP
+      }
+
+      this->dataPtr->running = true;
+      return true;
+#else
+      (void)_interval;
+      return false;
+#endif
+    }
+
+    /////////////////////////////////////////////////
+    void Profiler::Stop()
+    {
+#ifdef __linux__
+      if (!this->dataPtr->running)
+        return;
+
+      struct itimerval stopped = {};
+      setitimer(ITIMER_PROF, &stopped, nullptr);
+
+      // Wait for any handler which might still be writing to the buffer
+      activeBuffer.store(nullptr);
+      while (handlersRunning.load() > 0)
+        std::this_thread::yield();
+
+      // A SIGPROF which is still pending would terminate the process under
+      // the default action, so our handler stays installed in that case. It
+      // does nothing while no profiler is running.
+      if (SIG_DFL != this->dataPtr->previousAction.sa_handler)
+      {
+        sigaction(SIGPROF, &this->dataPtr->previousAction, nullptr);
+        setitimer(ITIMER_PROF, &this->dataPtr->previousTimer, nullptr);
+      }
+
+      this->dataPtr->running = false;
+      profilerClaimed.store(false);
+#endif
+    }
+
+    /////////////////////////////////////////////////
+    bool Profiler::IsRunning() const
+    {
+      return this->dataPtr->running;
+    }
+
+    /////////////////////////////////////////////////
+    void Profiler::Reset()
+    {
+      this->dataPtr->buffer.next.store(0);
+    }
+
+    /////////////////////////////////////////////////
+    std::size_t Profiler::SampleCount() const
+    {
+      return std::min(this->dataPtr->buffer.next.load(),
+                      this->dataPtr->buffer.capacity);
+    }
+
+    /////////////////////////////////////////////////
+    std::size_t Profiler::DroppedSampleCount() const
+    {
+      const std::size_t taken = this->dataPtr->buffer.next.load();
+      const std::size_t capacity = this->dataPtr->buffer.capacity;
+      return taken > capacity ? taken - capacity : 0;
+    }
+
+    /////////////////////////////////////////////////
+    auto Profiler::Attribute(const void *_address) const -> Attribution
+    {
+      return this->dataPtr->Attribute(
+            reinterpret_cast<std::uintptr_t>(_address));
+    }
+
+    /////////////////////////////////////////////////
+    auto Profiler::Shares() const -> std::vector<Share>
+    {
+      const std::size_t count = this->SampleCount();
+
+      // Many samples land on the same instructions, so each address is only
+      // attributed once.
+      std::unordered_map<std::uintptr_t, std::size_t> addresses;
+      for (std::size_t i = 0; i < count; ++i)
+      {
+        ++addresses[this->dataPtr->buffer.pcs[i].load(
+              std::memory_order_relaxed)];
+      }
+
+      std::map<std::tuple<std::string, std::string, std::string>,
+               std::size_t> totals;
+      for (const auto &address : addresses)
+      {
+        Attribution attribution = this->dataPtr->Attribute(address.first);
+        totals[std::make_tuple(std::move(attribution.library),
+                               std::move(attribution.plugin),
+                               std::move(attribution.interface))]
+            += address.second;
+      }
+
+      std::vector<Share> shares;
+      for (const auto &total : totals)
+      {
+        Share share;
+        std::tie(share.library, share.plugin, share.interface) = total.first;
+        share.samples = total.second;
+        share.fraction = static_cast<double>(total.second) /
+            static_cast<double>(count);
+        shares.push_back(std::move(share));
+      }
+
+      std::stable_sort(shares.begin(), shares.end(),
+          [](const Share &_a, const Share &_b)
+          {
+            return _a.samples > _b.samples;
+          });
+
+      return shares;
+    }
+
+    /////////////////////////////////////////////////
+    std::string Profiler::FormatShares(const std::vector<Share> &_shares)
+    {
+      const auto pluginOf = [](const Share &_share) -> std::string
+      {
+        if (_share.library.empty())
+          return "(outside of plugin libraries)";
+
+        return _share.plugin.empty() ? "(unknown plugin)" : _share.plugin;
+      };
+
+      std::size_t pluginWidth = std::string("Plugin").size();
+      std::size_t interfaceWidth = std::string("Interface").size();
+      for (const Share &share : _shares)
+      {
+        pluginWidth = std::max(pluginWidth, pluginOf(share).size());
+        interfaceWidth = std::max(interfaceWidth, share.interface.size());
+      }
+
+      std::stringstream table;
+      table << std::right << std::setw(8) << "Share" << std::setw(10)
+            << "Samples" << "  " << std::left << std::setw(pluginWidth)
+            << "Plugin" << "  " << std::setw(interfaceWidth) << "Interface"
+            << "  Library\n";
+
+      for (const Share &share : _shares)
+      {
+        table << std::right << std::fixed << std::setprecision(2)
+              << std::setw(7) << share.fraction * 100.0 << "%"
+              << std::setw(10) << share.samples << "  " << std::left
+              << std::setw(pluginWidth) << pluginOf(share) << "  "
+              << std::setw(interfaceWidth) << share.interface << "  "
+              << share.library << "\n";
+      }
+
+      return table.str();
+    }
+  }
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <ignition/plugin/utility.hh>
+
+#include "ProxyInstances.hh"
+
+namespace ignition
+{
+  namespace plugin
+  {
+    /////////////////////////////////////////////////
+    /// \brief A proxy which was registered with IGNITION_ADD_INTERFACE_PROXY
+    struct ProxyRegistration
+    {
+      /// \brief The names of the methods that the proxy times
+      public: std::vector<std::string> methods;
+
+      /// \brief Creates the proxy around an interface
+      public: detail::ProxyFactory factory;
+    };
+
+    /////////////////////////////////////////////////
+    /// \brief Get the proxies that have been registered, keyed by the
+    /// mangled name of their interface. Proxies are registered while the
+    /// application is being statically initialized, so this is created on
+    /// first use.
+    /// \param[out] _lock Locks the registry for the caller
+    /// \return The registry
+    static std::map<std::string, ProxyRegistration> &ProxyRegistry(
+        std::unique_lock<std::mutex> &_lock)
+    {
+      static std::mutex mutex;
+      static std::map<std::string, ProxyRegistration> registry;
+      _lock = std::unique_lock<std::mutex>(mutex);
+      return registry;
+    }
+
+    namespace detail
+    {
+      /////////////////////////////////////////////////
+      void RegisterInterfaceProxy(
+          const std::string &_interfaceName,
+          std::vector<std::string> _methods,
+          ProxyFactory _factory)
+      {
+        std::unique_lock<std::mutex> lock;
+        ProxyRegistration &registration =
+            ProxyRegistry(lock)[_interfaceName];
+        registration.methods = std::move(_methods);
+        registration.factory = std::move(_factory);
+      }
+    }
+
+    /////////////////////////////////////////////////
+    ConstInfoPtr ProxyInstances::Instrument(
+        const Info &_info,
+        ProxyCountersMap &_counters)
+    {
+      std::shared_ptr<Info> proxied;
+      std::shared_ptr<ProxyInstances> instances;
+
+      for (const auto &interface : _info.interfaces)
+      {
+        ProxyRegistration registration;
+        {
+          std::unique_lock<std::mutex> lock;
+          const std::map<std::string, ProxyRegistration> &registry =
+              ProxyRegistry(lock);
+          const auto it = registry.find(interface.first);
+          if (registry.end() == it)
+            continue;
+          registration = it->second;
+        }
+
+        std::shared_ptr<ProxyCounters> &counters = _counters[std::make_pair(
+              _info.name, DemangleSymbol(interface.first))];
+        if (!counters || counters->methods != registration.methods)
+        {
+          counters = std::make_shared<ProxyCounters>(
+                std::move(registration.methods));
+        }
+
+        if (!instances)
+        {
+          proxied = std::make_shared<Info>(_info);
+          instances = std::make_shared<ProxyInstances>();
+        }
+
+        // Each instance calls the casts once per interface when it is
+        // created, so the proxies are created there, and this is the only
+        // time that the mutex of the instances is locked. Calls of the
+        // interfaces only pay for the timing of the proxy.
+        proxied->interfaces[interface.first] =
+            [cast = interface.second,
+             factory = std::move(registration.factory),
+             counters, instances](void *_instance) -> void*
+        {
+          void *const target = cast(_instance);
+          if (!target)
+            return target;
+
+          std::shared_ptr<void> proxy = factory(
+                target, counters->counters.get(), counters->methods.size());
+          void *const result = proxy.get();
+
+          std::lock_guard<std::mutex> lock(instances->mutex);
+          instances->proxies.emplace(_instance, std::move(proxy));
+          return result;
+        };
+      }
+
+      if (!instances)
+        return nullptr;
+
+      // Proxies are not at a fixed offset from their instance, so the
+      // instances of the copy must stay out of the inline cache of
+      // QueryInterface.
+      proxied->capabilities |= Info::INTERFACE_PROXIES;
+
+      // As with CountingFactory, the deleter only captures a raw pointer.
+      // The casts keep the instances alive, and every instance holds on to
+      // the Info which owns the casts until after the deleter has been
+      // called.
+      instances->deleter = _info.deleter;
+      ProxyInstances *const raw = instances.get();
+      proxied->deleter = [raw](void *_instance)
+      {
+        std::vector<std::shared_ptr<void>> proxies;
+        {
+          std::lock_guard<std::mutex> lock(raw->mutex);
+          const auto range = raw->proxies.equal_range(_instance);
+          for (auto it = range.first; it != range.second; ++it)
+            proxies.push_back(std::move(it->second));
+          raw->proxies.erase(range.first, range.second);
+        }
+
+        // The proxies are destroyed before the instance that they refer to
+        proxies.clear();
+        raw->deleter(_instance);
+      };
+
+      return proxied;
+    }
+  }
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef IGNITION_PLUGIN_SRC_PROXYINSTANCES_HH_
+#define IGNITION_PLUGIN_SRC_PROXYINSTANCES_HH_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <ignition/plugin/Info.hh>
+#include <ignition/plugin/InterfaceProxy.hh>
+
+namespace ignition
+{
+  namespace plugin
+  {
+    /// \brief The method counters of the proxies of one interface of one
+    /// plugin. Every version of the plugin shares the same counters.
+    struct ProxyCounters
+    {
+      /// \brief Constructor
+      /// \param[in] _methods The names of the methods
+      public: explicit ProxyCounters(std::vector<std::string> _methods)
+        : methods(std::move(_methods)),
+          counters(new detail::MethodCounters[this->methods.size()])
+      {
+        // Do nothing
+      }
+
+      /// \brief The names of the methods
+      public: const std::vector<std::string> methods;
+
+      /// \brief The counters of each method, in the same order as methods
+      public: const std::unique_ptr<detail::MethodCounters[]> counters;
+    };
+
+    /// \brief The counters of the proxies of each plugin, keyed by the name
+    /// of the plugin and the demangled name of the interface
+    using ProxyCountersMap = std::map<std::pair<std::string, std::string>,
+                                      std::shared_ptr<ProxyCounters>>;
+
+    /////////////////////////////////////////////////
+    /// \brief The proxies of the instances of one plugin, and the original
+    /// deleter of the plugin, which is called by the version that replaces
+    /// it in the proxied Info after the proxies of the instance are destroyed.
+    struct ProxyInstances
+    {
+      /// \brief Make a copy of _info whose interface casts hand out a proxy
+      /// for each interface which has a registered proxy. The Loader only
+      /// instantiates the copy while proxies are enabled, so only the
+      /// instances which really hand out proxies are kept out of the inline
+      /// cache of QueryInterface, and the casts of the original Info stay
+      /// untouched.
+      /// \param[in] _info The Info to copy. Its name and demangled
+      /// interfaces must already be filled in.
+      /// \param[in, out] _counters The counters of the proxies
+      /// \return The copy, or nullptr if none of the interfaces of the plugin
+      /// has a proxy
+      public: static ConstInfoPtr Instrument(
+          const Info &_info,
+          ProxyCountersMap &_counters);
+
+      /// \brief Protects proxies
+      public: std::mutex mutex;
+
+      /// \brief The proxies of each instance
+      public: std::unordered_multimap<void*, std::shared_ptr<void>> proxies;
+
+      /// \brief The deleter which was provided by the plugin library
+      public: std::function<void(void*)> deleter;
+    };
+  }
+}
+
+#endif
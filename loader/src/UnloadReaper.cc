@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <dlfcn.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#include "UnloadReaper.hh"
+
+namespace ignition
+{
+  namespace plugin
+  {
+    /////////////////////////////////////////////////
+    void CloseLibrary(void *_dlHandle, UnloadPolicy &_policy)
+    {
+      const auto start = std::chrono::steady_clock::now();
+      dlclose(_dlHandle);
+      const std::chrono::nanoseconds::rep elapsed =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+      _policy.totalUnloadTime += elapsed;
+      std::chrono::nanoseconds::rep max = _policy.maxUnloadTime.load();
+      while (elapsed > max &&
+             !_policy.maxUnloadTime.compare_exchange_weak(max, elapsed))
+      {
+        // Keep trying until the max is at least as large as elapsed
+      }
+
+      ++_policy.unloaded;
+    }
+
+    /////////////////////////////////////////////////
+    UnloadReaper &UnloadReaper::Instance()
+    {
+      static UnloadReaper *reaper = []()
+      {
+        UnloadReaper *created = new UnloadReaper;
+
+#ifndef _WIN32
+        // The lock is held across fork(), so that the child gets a copy of
+        // the pending closes which no other thread was changing.
+        pthread_atfork(
+          []() { UnloadReaper::Instance().mutex.lock(); },
+          []() { UnloadReaper::Instance().mutex.unlock(); },
+          []() { UnloadReaper::Instance().AfterForkInChild(); });
+#endif
+
+        std::atexit([]() { UnloadReaper::Instance().Stop(); });
+        return created;
+      }();
+      return *reaper;
+    }
+
+    /////////////////////////////////////////////////
+    void UnloadReaper::Defer(
+        void *_dlHandle,
+        std::shared_ptr<UnloadPolicy> _policy,
+        std::shared_ptr<const void> _closed)
+    {
+      const auto due = std::chrono::steady_clock::now()
+          + std::chrono::milliseconds(_policy->gracePeriod.load());
+
+      ++_policy->pending;
+
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (this->stopping)
+        {
+          // LCOV_EXCL_START
+          --_policy->pending;
+          return;
+          // LCOV_EXCL_STOP
+        }
+
+        this->pending.push_back(
+              {_dlHandle, due, std::move(_policy), std::move(_closed)});
+
+        if (!this->threadStarted)
+        {
+          this->thread = std::thread([this]() { this->Run(); });
+          this->threadStarted = true;
+        }
+      }
+
+      this->wake.notify_one();
+    }
+
+    /////////////////////////////////////////////////
+    bool UnloadReaper::Cancel(
+        void *_dlHandle,
+        std::shared_ptr<const void> &_closed)
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      for (auto it = this->pending.begin(); it != this->pending.end(); ++it)
+      {
+        if (it->dlHandle == _dlHandle)
+        {
+          --it->policy->pending;
+          ++it->policy->cancelled;
+          _closed = std::move(it->closed);
+          this->pending.erase(it);
+          return true;
+        }
+      }
+
+      return false;
+    }
+
+    /////////////////////////////////////////////////
+    void UnloadReaper::Run()
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      while (!this->stopping)
+      {
+        if (this->pending.empty())
+        {
+          this->wake.wait(lock);
+          continue;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        auto next = std::chrono::steady_clock::time_point::max();
+        std::vector<Pending> due;
+        for (auto it = this->pending.begin(); it != this->pending.end();)
+        {
+          if (it->due <= now)
+          {
+            due.push_back(std::move(*it));
+            it = this->pending.erase(it);
+          }
+          else
+          {
+            next = std::min(next, it->due);
+            ++it;
+          }
+        }
+
+        if (due.empty())
+        {
+          this->wake.wait_until(lock, next);
+          continue;
+        }
+
+        // Close the whole batch without holding the lock, so that releasing
+        // or loading libraries does not wait for dlclose.
+        lock.unlock();
+        for (Pending &item : due)
+        {
+          CloseLibrary(item.dlHandle, *item.policy);
+          --item.policy->pending;
+          item.closed.reset();
+        }
+        due.clear();
+        lock.lock();
+      }
+    }
+
+    /////////////////////////////////////////////////
+    void UnloadReaper::Stop()
+    {
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (this->stopping)
+          return;
+        this->stopping = true;
+      }
+
+      this->wake.notify_one();
+      if (this->threadStarted)
+        this->thread.join();
+    }
+
+    /////////////////////////////////////////////////
+    void UnloadReaper::AfterForkInChild()
+    {
+      // The mutex was locked by the thread which called fork(), and the
+      // condition variable may count the waiting thread of the parent, so
+      // both are replaced instead of being used. The handle of the parent's
+      // thread is dropped without being joined or detached, since there is
+      // no such thread in this process. Closes which that thread had already
+      // taken out of the pending list are not repeated, so those libraries
+      // simply stay loaded in the child.
+      new (&this->mutex) std::mutex;
+      new (&this->wake) std::condition_variable;
+      new (&this->thread) std::thread;
+      this->threadStarted = false;
+      this->stopping = false;
+    }
+  }
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef IGNITION_PLUGIN_SRC_UNLOADREAPER_HH_
+#define IGNITION_PLUGIN_SRC_UNLOADREAPER_HH_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ignition
+{
+  namespace plugin
+  {
+    /// \brief The unload settings and statistics of one Loader. The deleters
+    /// of its library handles share ownership of this, because libraries can
+    /// be released after the Loader is gone.
+    struct UnloadPolicy
+    {
+      /// \brief The grace period in milliseconds
+      public: std::atomic<std::chrono::milliseconds::rep> gracePeriod{0};
+
+      /// \sa Loader::UnloadStatistics::unloaded
+      public: std::atomic<std::size_t> unloaded{0};
+
+      /// \sa Loader::UnloadStatistics::cancelled
+      public: std::atomic<std::size_t> cancelled{0};
+
+      /// \sa Loader::UnloadStatistics::pending
+      public: std::atomic<std::size_t> pending{0};
+
+      /// \sa Loader::UnloadStatistics::totalUnloadTime
+      public: std::atomic<std::chrono::nanoseconds::rep> totalUnloadTime{0};
+
+      /// \sa Loader::UnloadStatistics::maxUnloadTime
+      public: std::atomic<std::chrono::nanoseconds::rep> maxUnloadTime{0};
+    };
+
+    /// \brief Close a library handle and record how long it took.
+    /// \param[in] _dlHandle The handle to close
+    /// \param[in] _policy The policy whose statistics should be updated
+    void CloseLibrary(void *_dlHandle, UnloadPolicy &_policy);
+
+    /// \brief Background thread which closes library handles once their
+    /// grace period has passed. There is one reaper per process, so that a
+    /// library which is released by one Loader can be reused by another.
+    class UnloadReaper
+    {
+      /// \brief Get the reaper of this process. It is never destroyed, since
+      /// library handles can be released while the process is exiting.
+      /// \return The reaper
+      public: static UnloadReaper &Instance();
+
+      /// \brief Close a library handle once its grace period has passed.
+      /// \param[in] _dlHandle The handle to close
+      /// \param[in] _policy The policy of the Loader that released it
+      /// \param[in] _closed Released right after the handle has been closed,
+      /// so that weak references to it expire only once the library is gone
+      public: void Defer(
+          void *_dlHandle,
+          std::shared_ptr<UnloadPolicy> _policy,
+          std::shared_ptr<const void> _closed);
+
+      /// \brief Take back one pending close of a library handle.
+      /// \param[in] _dlHandle The handle which is being loaded again
+      /// \param[out] _closed Receives the token that the close would have
+      /// released, if a pending close was cancelled
+      /// \return True if a pending close was cancelled. The caller then owns
+      /// the reference to the library that the close would have released.
+      public: bool Cancel(
+          void *_dlHandle,
+          std::shared_ptr<const void> &_closed);
+
+      /// \brief Close each handle when it is due, until the process exits
+      private: void Run();
+
+      /// \brief Stop the thread without closing the pending handles. This is
+      /// called when the process exits, because the dynamic linker will
+      /// unload everything by itself at that point.
+      private: void Stop();
+
+      /// \brief Forget the thread of the parent in a child process which was
+      /// just forked, since only the thread which called fork() exists in
+      /// the child. The pending closes are kept, and they are taken over by
+      /// the thread which the child starts for its first deferred close.
+      private: void AfterForkInChild();
+
+      /// \brief A handle that is waiting for its grace period to pass
+      private: struct Pending
+      {
+        /// \brief The handle to close
+        public: void *dlHandle;
+
+        /// \brief When to close it
+        public: std::chrono::steady_clock::time_point due;
+
+        /// \brief The policy of the Loader that released it
+        public: std::shared_ptr<UnloadPolicy> policy;
+
+        /// \brief Released once the handle has been closed
+        public: std::shared_ptr<const void> closed;
+      };
+
+      /// \brief Protects every field below
+      private: std::mutex mutex;
+
+      /// \brief Wakes up the thread when a handle is added or the process is
+      /// exiting
+      private: std::condition_variable wake;
+
+      /// \brief The handles that are waiting
+      private: std::vector<Pending> pending;
+
+      /// \brief The reaper thread, which is started by the first deferral
+      private: std::thread thread;
+
+      /// \brief True if this process started the reaper thread. A child
+      /// process must never join the thread that it inherited from its
+      /// parent.
+      private: bool threadStarted = false;
+
+      /// \brief True once the process has started to exit
+      private: bool stopping = false;
+    };
+  }
+}
+
+#endif
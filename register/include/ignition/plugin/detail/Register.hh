@@ -19,6 +19,7 @@
 #ifndef IGNITION_PLUGIN_DETAIL_REGISTER_HH_
 #define IGNITION_PLUGIN_DETAIL_REGISTER_HH_
 
+#include <cstdint>
 #include <set>
 #include <string>
 #include <typeinfo>
@@ -160,6 +161,8 @@ extern "C"
 
         for (const auto &aliasSetEntry : input->aliases)
           entry.aliases.insert(aliasSetEntry);
+
+        entry.capabilities |= input->capabilities;
       }
     }
 
@@ -342,6 +345,19 @@ namespace ignition
                 std::is_base_of<EnablePluginFromThis, PluginClass>::value>
       { }; // NOLINT
 
+      //////////////////////////////////////////////////
+      /// \brief Compute the Info::Capability flags of PluginClass when it is
+      /// registered with the given Interfaces
+      template <typename PluginClass, typename... Interfaces>
+      constexpr std::uint32_t CapabilitiesOf()
+      {
+        return
+            (std::is_base_of<EnablePluginFromThis, PluginClass>::value ?
+               Info::ENABLE_PLUGIN_FROM_THIS : 0u)
+          | ((IsFactory<Interfaces>::value || ...) ?
+               Info::FACTORY : 0u);
+      }
+
       //////////////////////////////////////////////////
       /// \brief This specialization of the Register class will be called when
       /// one or more arguments are provided to the IGNITION_ADD_PLUGIN(~)
@@ -357,6 +373,10 @@ namespace ignition
           // Set the name of the plugin
           info.name = typeid(PluginClass).name();
 
+          // Record the traits of the plugin class so that the Loader does not
+          // need to inspect its interfaces to find them.
+          info.capabilities = CapabilitiesOf<PluginClass, Interfaces...>();
+
           // Create a factory for generating new plugin instances
           info.factory = [=]()
           {
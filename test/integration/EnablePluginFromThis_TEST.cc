@@ -17,10 +17,13 @@
 
 #include <gtest/gtest.h>
 
+#include <string>
+
 #include <ignition/plugin/EnablePluginFromThis.hh>
 #include <ignition/plugin/Loader.hh>
 #include <ignition/plugin/SpecializedPluginPtr.hh>
 #include <ignition/plugin/WeakPluginPtr.hh>
+#include <ignition/plugin/utility.hh>
 
 #include "../plugins/DummyPlugins.hh"
 #include "utils.hh"
@@ -98,6 +101,38 @@ TEST(EnablePluginFromThis, TemplatedInstantiate)
   EXPECT_EQ(nullptr, fromThisInterface);
 }
 
+/////////////////////////////////////////////////
+TEST(EnablePluginFromThis, Capabilities)
+{
+  using ignition::plugin::Info;
+
+  void *dlHandle = dlopen(IGNDummyPlugins_LIB, RTLD_LAZY | RTLD_LOCAL);
+  ASSERT_NE(nullptr, dlHandle);
+
+  const ignition::plugin::InfoMap *allInfo = GetInfoMap(dlHandle);
+  ASSERT_NE(nullptr, allInfo);
+
+  std::size_t multiPlugins = 0;
+  for (const auto &entry : *allInfo)
+  {
+    const Info &info = entry.second;
+
+    // DummyMultiPlugin is the only plugin of this library which inherits
+    // EnablePluginFromThis.
+    const bool isMultiPlugin = ignition::plugin::DemangleSymbol(entry.first)
+        == "test::util::DummyMultiPlugin";
+    multiPlugins += isMultiPlugin;
+
+    EXPECT_EQ(isMultiPlugin,
+              info.HasCapability(Info::ENABLE_PLUGIN_FROM_THIS)) << info.name;
+    EXPECT_FALSE(info.HasCapability(Info::FACTORY)) << info.name;
+  }
+
+  EXPECT_EQ(1u, multiPlugins);
+
+  dlclose(dlHandle);
+}
+
 /////////////////////////////////////////////////
 TEST(EnablePluginFromThis, LibraryManagement)
 {
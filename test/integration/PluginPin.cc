@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include <ignition/plugin/Loader.hh>
+#include <ignition/plugin/PluginPin.hh>
+#include <ignition/plugin/SpecializedPluginPtr.hh>
+#include <ignition/plugin/WeakPluginPtr.hh>
+
+#include "../plugins/DummyPlugins.hh"
+#include "utils.hh"
+
+/////////////////////////////////////////////////
+TEST(PluginPin, Borrow)
+{
+  ignition::plugin::PluginPin empty;
+  EXPECT_TRUE(empty.IsEmpty());
+  EXPECT_FALSE(empty);
+
+  ignition::plugin::Loader pl;
+  pl.LoadLib(IGNDummyPlugins_LIB);
+
+  ignition::plugin::PluginPtr plugin =
+      pl.Instantiate("test::util::DummyMultiPlugin");
+
+  const ignition::plugin::PluginPin pin(plugin);
+  EXPECT_TRUE(pin);
+  EXPECT_EQ(plugin->QueryInterface<test::util::DummyIntBase>(),
+            pin->QueryInterface<test::util::DummyIntBase>());
+  EXPECT_EQ(&(*plugin), &(*pin));
+
+  const ignition::plugin::ConstPluginPtr constPlugin = plugin;
+  const ignition::plugin::ConstPluginPin constPin(constPlugin);
+  EXPECT_TRUE(constPin);
+
+  using IntPlugin =
+      ignition::plugin::SpecializedPlugin<test::util::DummyIntBase>;
+  const ignition::plugin::TemplatePluginPtr<IntPlugin> specialized = plugin;
+  const ignition::plugin::TemplatePluginPin<IntPlugin> specPin(specialized);
+  EXPECT_EQ(5, specPin->QueryInterface<test::util::DummyIntBase>()
+                  ->MyIntegerValueIs());
+
+  std::vector<std::thread> workers;
+  std::vector<int> values(8, 0);
+  for (std::size_t i = 0; i < values.size(); ++i)
+  {
+    workers.push_back(std::thread([pin, &values, i]()
+    {
+      values[i] = pin->QueryInterface<test::util::DummyIntBase>()
+          ->MyIntegerValueIs();
+    }));
+  }
+
+  for (std::thread &worker : workers)
+    worker.join();
+
+  for (const int value : values)
+    EXPECT_EQ(5, value);
+
+  // A pin reflects the state of the PluginPtr that it borrows from
+  plugin = nullptr;
+  EXPECT_TRUE(pin.IsEmpty());
+}
+
+/////////////////////////////////////////////////
+TEST(ShardedPluginPtr, Lifecycle)
+{
+  const std::string &libraryPath = IGNDummyPlugins_LIB;
+
+  ignition::plugin::ShardedPluginPtr empty;
+  EXPECT_TRUE(empty.IsEmpty());
+  EXPECT_FALSE(empty.Acquire());
+  EXPECT_FALSE(ignition::plugin::ShardedPluginPtr(
+                 ignition::plugin::PluginPtr()));
+
+  ignition::plugin::PluginPtr acquired;
+  ignition::plugin::WeakPluginPtr weak;
+
+  CHECK_FOR_LIBRARY(libraryPath, false);
+
+  {
+    ignition::plugin::Loader pl;
+    pl.LoadLib(libraryPath);
+
+    ignition::plugin::PluginPtr plugin =
+        pl.Instantiate("test::util::DummyMultiPlugin");
+    weak = plugin;
+
+    ignition::plugin::ShardedPluginPtr sharded(plugin, 4);
+    EXPECT_TRUE(sharded);
+    EXPECT_EQ(4u, sharded.ShardCount());
+
+    std::vector<ignition::plugin::PluginPtr> fromWorkers(8);
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < fromWorkers.size(); ++i)
+    {
+      workers.push_back(std::thread([&sharded, &fromWorkers, i]()
+      {
+        fromWorkers[i] = sharded.Acquire();
+      }));
+    }
+
+    for (std::thread &worker : workers)
+      worker.join();
+
+    for (const ignition::plugin::PluginPtr &ptr : fromWorkers)
+    {
+      EXPECT_EQ(plugin, ptr);
+      EXPECT_EQ(plugin->QueryInterface<test::util::DummyIntBase>(),
+                ptr->QueryInterface<test::util::DummyIntBase>());
+    }
+
+    acquired = sharded.Acquire();
+    EXPECT_EQ(plugin, acquired);
+    EXPECT_TRUE(acquired->QueryInterfaceSharedPtr<test::util::DummyIntBase>());
+  }
+
+  // The acquired PluginPtr keeps the instance and the library alive after
+  // the Loader, the original PluginPtr, and the ShardedPluginPtr are gone.
+  CHECK_FOR_LIBRARY(libraryPath, true);
+  EXPECT_FALSE(weak.IsExpired());
+  EXPECT_EQ(5, acquired->QueryInterface<test::util::DummyIntBase>()
+                  ->MyIntegerValueIs());
+
+  acquired = nullptr;
+  EXPECT_TRUE(weak.IsExpired());
+  CHECK_FOR_LIBRARY(libraryPath, false);
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -98,6 +98,38 @@ TEST(WeakPluginPtr, CopyMove)
   EXPECT_EQ(plugin, weakAssignFromPlugin.Lock());
 }
 
+/////////////////////////////////////////////////
+TEST(WeakPluginPtr, Compact)
+{
+  // A WeakPluginPtr should not need anything beyond a single weak reference
+  static_assert(sizeof(ignition::plugin::WeakPluginPtr)
+                == sizeof(std::weak_ptr<void>),
+                "WeakPluginPtr should be as small as a std::weak_ptr");
+
+  ignition::plugin::Loader pl;
+  pl.LoadLib(IGNDummyPlugins_LIB);
+
+  ignition::plugin::PluginPtr plugin =
+      pl.Instantiate("test::util::DummyMultiPlugin");
+
+  const ignition::plugin::WeakPluginPtr weak = plugin;
+
+  // Every PluginPtr produced by Lock() shares the interfaces of the original
+  const ignition::plugin::PluginPtr locked = weak.Lock();
+  EXPECT_EQ(plugin->QueryInterface<test::util::DummyIntBase>(),
+            locked->QueryInterface<test::util::DummyIntBase>());
+  EXPECT_EQ(plugin->QueryInterface<test::util::DummyNameBase>(),
+            locked->QueryInterface<test::util::DummyNameBase>());
+  EXPECT_TRUE(locked->HasInterface("test::util::DummyDoubleBase"));
+  EXPECT_TRUE(locked->HasInterface(
+                typeid(test::util::DummyDoubleBase).name(), false));
+  EXPECT_FALSE(locked->HasInterface("not::an::interface"));
+
+  const ignition::plugin::WeakPluginPtr empty;
+  EXPECT_TRUE(empty.IsExpired());
+  EXPECT_FALSE(empty.Lock());
+}
+
 /////////////////////////////////////////////////
 int main(int argc, char **argv)
 {
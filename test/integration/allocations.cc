@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <dlfcn.h>
+
+#include <cstdint>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <ignition/plugin/Loader.hh>
+#include <ignition/plugin/TrackAllocations.hh>
+
+#include "../plugins/DummyPlugins.hh"
+
+using AllocationStatistics = ignition::plugin::Loader::AllocationStatistics;
+
+/////////////////////////////////////////////////
+/// \brief Find the entry of a plugin in allocation statistics
+/// \param[in] _stats The statistics
+/// \param[in] _plugin The name of the plugin
+/// \return The entry, or an empty entry if there is none
+AllocationStatistics Find(
+    const std::vector<AllocationStatistics> &_stats,
+    const std::string &_plugin)
+{
+  for (const AllocationStatistics &entry : _stats)
+  {
+    if (entry.plugin == _plugin)
+      return entry;
+  }
+  return AllocationStatistics();
+}
+
+/////////////////////////////////////////////////
+TEST(Allocations, OperatorsKeepTheirContract)
+{
+  struct alignas(128) Overaligned
+  {
+    char bytes[3];
+  };
+
+  Overaligned *overaligned = new Overaligned;
+  EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(overaligned) % 128u);
+  delete overaligned;
+
+  Overaligned *array = new Overaligned[5];
+  EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(array) % 128u);
+  delete[] array;
+
+  int *nothrow = new (std::nothrow) int[16]();
+  ASSERT_NE(nullptr, nothrow);
+  EXPECT_EQ(0, nothrow[15]);
+  delete[] nothrow;
+
+  void *empty = ::operator new(0);
+  EXPECT_NE(nullptr, empty);
+  ::operator delete(empty);
+
+  EXPECT_THROW(static_cast<void>(::operator new(
+      static_cast<std::size_t>(-1))), std::bad_alloc);
+  EXPECT_EQ(nullptr,
+            ::operator new(static_cast<std::size_t>(-1), std::nothrow));
+
+  EXPECT_TRUE(ignition::plugin::Loader::AllocationTrackingEnabled());
+}
+
+/////////////////////////////////////////////////
+TEST(Allocations, AttributedToPlugins)
+{
+  ignition::plugin::Loader pl;
+  EXPECT_TRUE(pl.AllocationStats().empty());
+
+  pl.LoadLib(IGNDummyPlugins_LIB);
+
+  const std::string name = "test::util::DummyMultiPlugin";
+  const AllocationStatistics before = Find(pl.AllocationStats(), name);
+
+  const std::size_t count = 10;
+  std::vector<ignition::plugin::PluginPtr> plugins;
+  for (std::size_t i = 0; i < count; ++i)
+    plugins.push_back(pl.Instantiate(name));
+
+#ifdef __linux__
+  const AllocationStatistics held = Find(pl.AllocationStats(), name);
+  EXPECT_EQ(IGNDummyPlugins_LIB, held.library);
+  EXPECT_EQ(name, held.plugin);
+  EXPECT_LE(before.allocations + count, held.allocations);
+  EXPECT_LE(before.liveAllocations + count, held.liveAllocations);
+  EXPECT_LE(before.liveBytes + count * sizeof(void*), held.liveBytes);
+  EXPECT_LE(held.liveBytes, held.allocatedBytes);
+  EXPECT_LT(0.0, held.bytesPerSecond);
+
+  const std::string pretty = pl.PrettyStr();
+  EXPECT_NE(std::string::npos, pretty.find("Heap Allocations"));
+  EXPECT_NE(std::string::npos, pretty.find("[" + name + "] in "));
+  std::cout << pretty;
+
+  plugins.clear();
+
+  const AllocationStatistics released = Find(pl.AllocationStats(), name);
+  EXPECT_EQ(held.allocations, released.allocations);
+  EXPECT_EQ(before.liveAllocations, released.liveAllocations);
+  EXPECT_EQ(before.liveBytes, released.liveBytes);
+#endif
+}
+
+/////////////////////////////////////////////////
+TEST(Allocations, DeepBindIsRefused)
+{
+  ignition::plugin::Loader pl;
+
+  ignition::plugin::Loader::LoadOptions options;
+  options.deepBind = true;
+#ifdef RTLD_DEEPBIND
+  EXPECT_TRUE(pl.LoadLib(IGNDummyPlugins_LIB, options).empty());
+  EXPECT_TRUE(pl.AllPlugins().empty());
+#endif
+
+  options.deepBind = false;
+  EXPECT_FALSE(pl.LoadLib(IGNDummyPlugins_LIB, options).empty());
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
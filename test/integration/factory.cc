@@ -134,6 +134,49 @@ TEST(Factory, Alias)
   }
 }
 
+/////////////////////////////////////////////////
+TEST(Factory, Capabilities)
+{
+  using ignition::plugin::Info;
+
+  void *dlHandle = dlopen(IGNFactoryPlugins_LIB, RTLD_LAZY | RTLD_LOCAL);
+  ASSERT_NE(nullptr, dlHandle);
+
+  const ignition::plugin::InfoMap *allInfo = GetInfoMap(dlHandle);
+  ASSERT_NE(nullptr, allInfo);
+  EXPECT_FALSE(allInfo->empty());
+
+  for (const auto &entry : *allInfo)
+  {
+    const Info &info = entry.second;
+    EXPECT_TRUE(info.HasCapability(Info::FACTORY)) << info.name;
+
+    // Every Factory inherits EnablePluginFromThis
+    EXPECT_TRUE(info.HasCapability(Info::ENABLE_PLUGIN_FROM_THIS))
+        << info.name;
+    EXPECT_FALSE(info.HasCapability(Info::INTERFACE_PROXIES)) << info.name;
+  }
+
+  dlclose(dlHandle);
+
+  // A plugin which is not a Factory does not get instantiated when a Factory
+  // is requested from it.
+  ignition::plugin::Loader pl;
+  pl.LoadLib(IGNDummyPlugins_LIB);
+  pl.LoadLib(IGNFactoryPlugins_LIB);
+
+  EXPECT_EQ(nullptr, pl.Factory<NameFactory>("test::util::DummySinglePlugin"));
+  EXPECT_NE(nullptr, pl.Factory<NameFactory>("test::util::DummyNameForward"));
+
+  for (const auto &plugin : pl.Stats().plugins)
+  {
+    if (plugin.name == "test::util::DummySinglePlugin")
+    {
+      EXPECT_EQ(0u, plugin.instantiated);
+    }
+  }
+}
+
 /////////////////////////////////////////////////
 TEST(Factory, LibraryManagement)
 {
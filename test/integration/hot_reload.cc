@@ -0,0 +1,287 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <ignition/plugin/Loader.hh>
+
+#include "../plugins/DummyPlugins.hh"
+
+/////////////////////////////////////////////////
+/// \brief A temporary directory which holds a copy of the dummy plugin
+/// library, so that the tests can modify it.
+class DeployedLibrary
+{
+  public: DeployedLibrary()
+  {
+    char dir[] = "/tmp/ign-plugin-hot-reload-XXXXXX";
+    EXPECT_NE(nullptr, mkdtemp(dir));
+    this->directory = dir;
+    this->path = this->directory + "/libIGNDummyPlugins.so";
+    this->Deploy();
+  }
+
+  public: ~DeployedLibrary()
+  {
+    for (const std::string &file : {this->path, this->path + ".new",
+                                    this->directory + "/other.txt"})
+    {
+      std::remove(file.c_str());
+    }
+
+    rmdir(this->directory.c_str());
+  }
+
+  /// \brief Write a new version of the library in place
+  public: void Deploy()
+  {
+    Copy(IGNDummyPlugins_LIB, this->path);
+  }
+
+  /// \brief Write a new version of the library next to it, and rename it
+  /// over the old one
+  public: void DeployByRename()
+  {
+    Copy(IGNDummyPlugins_LIB, this->path + ".new");
+    EXPECT_EQ(0, std::rename((this->path + ".new").c_str(),
+                             this->path.c_str()));
+  }
+
+  /// \brief Overwrite the library with something that cannot be loaded
+  public: void DeployGarbage()
+  {
+    std::ofstream(this->path, std::ios::trunc) << "not a library";
+  }
+
+  public: static void Copy(const std::string &_from, const std::string &_to)
+  {
+    std::ifstream in(_from, std::ios::binary);
+    std::ofstream out(_to, std::ios::binary | std::ios::trunc);
+    out << in.rdbuf();
+  }
+
+  public: std::string directory;
+
+  public: std::string path;
+};
+
+/////////////////////////////////////////////////
+TEST(HotReload, ReloadLib)
+{
+  DeployedLibrary library;
+
+  ignition::plugin::Loader pl;
+  const std::unordered_set<std::string> names = pl.LoadLib(library.path);
+  ASSERT_LT(0u, names.size());
+
+  std::vector<ignition::plugin::Loader::Change> changes;
+  pl.Subscribe([&](const ignition::plugin::Loader::Change &_change)
+  {
+    changes.push_back(_change);
+  });
+
+  std::vector<std::string> drained;
+  pl.SetDrainCallback([&](const std::string &_path)
+  {
+    drained.push_back(_path);
+  });
+
+  ignition::plugin::PluginPtr oldVersion =
+      pl.Instantiate("test::util::DummyMultiPlugin");
+  ASSERT_TRUE(oldVersion);
+
+  const std::uint64_t generation = pl.Generation();
+  EXPECT_EQ(names, pl.ReloadLib(library.path));
+
+  // The whole swap is a single change
+  EXPECT_EQ(generation + 1, pl.Generation());
+  ASSERT_EQ(1u, changes.size());
+  EXPECT_EQ(names, changes[0].added);
+  EXPECT_EQ(names, changes[0].removed);
+
+  ignition::plugin::PluginPtr newVersion =
+      pl.Instantiate("test::util::DummyMultiPlugin");
+  ASSERT_TRUE(newVersion);
+
+  // The old instance keeps working with the old version of the library
+  EXPECT_EQ(5, oldVersion->QueryInterface<test::util::DummyIntBase>()
+              ->MyIntegerValueIs());
+  EXPECT_EQ(5, newVersion->QueryInterface<test::util::DummyIntBase>()
+              ->MyIntegerValueIs());
+
+  EXPECT_EQ(1u, pl.DrainingLibraryCount());
+  EXPECT_EQ(0u, pl.ProcessLibraryChanges());
+  EXPECT_TRUE(drained.empty());
+
+  oldVersion = ignition::plugin::PluginPtr();
+  EXPECT_EQ(0u, pl.DrainingLibraryCount());
+  EXPECT_EQ(0u, pl.ProcessLibraryChanges());
+  ASSERT_EQ(1u, drained.size());
+  EXPECT_EQ(library.path, drained[0]);
+
+  // A version that cannot be loaded leaves the current version in place
+  library.DeployGarbage();
+  pl.SetDiagnosticSink(nullptr);
+  EXPECT_TRUE(pl.ReloadLib(library.path).empty());
+  EXPECT_EQ(1u, changes.size());
+  EXPECT_TRUE(pl.Instantiate("test::util::DummyMultiPlugin"));
+
+  // The reloaded version can be forgotten through the original path
+  newVersion = ignition::plugin::PluginPtr();
+  EXPECT_TRUE(pl.ForgetLibrary(library.path));
+  EXPECT_TRUE(pl.AllPlugins().empty());
+  EXPECT_FALSE(pl.ForgetLibrary(library.path));
+}
+
+/////////////////////////////////////////////////
+TEST(HotReload, RepeatedReloads)
+{
+  DeployedLibrary library;
+
+  ignition::plugin::Loader pl;
+  ASSERT_LT(0u, pl.LoadLib(library.path).size());
+
+  std::size_t drained = 0;
+  pl.SetDrainCallback([&](const std::string &)
+  {
+    ++drained;
+  });
+
+  // Each reload opens a new copy of the library, and the bookkeeping of the
+  // copies which have been closed is dropped along the way.
+  const std::size_t reloads = 20;
+  for (std::size_t i = 0; i < reloads; ++i)
+  {
+    ignition::plugin::PluginPtr oldVersion =
+        pl.Instantiate("test::util::DummyMultiPlugin");
+    ASSERT_TRUE(oldVersion);
+    ASSERT_LT(0u, pl.ReloadLib(library.path).size());
+    EXPECT_EQ(1u, pl.DrainingLibraryCount());
+
+    oldVersion = ignition::plugin::PluginPtr();
+    EXPECT_EQ(0u, pl.DrainingLibraryCount());
+    EXPECT_EQ(0u, pl.ProcessLibraryChanges());
+  }
+
+  EXPECT_EQ(reloads, drained);
+  EXPECT_TRUE(pl.Instantiate("test::util::DummyMultiPlugin"));
+}
+
+/////////////////////////////////////////////////
+TEST(HotReload, DrainWaitsForDeferredUnload)
+{
+  DeployedLibrary library;
+
+  ignition::plugin::Loader pl;
+  ASSERT_LT(0u, pl.LoadLib(library.path).size());
+  pl.SetUnloadGracePeriod(std::chrono::milliseconds(200));
+
+  std::vector<std::string> drained;
+  pl.SetDrainCallback([&](const std::string &_path)
+  {
+    drained.push_back(_path);
+  });
+
+  ignition::plugin::PluginPtr oldVersion =
+      pl.Instantiate("test::util::DummyMultiPlugin");
+  ASSERT_TRUE(oldVersion);
+  EXPECT_LT(0u, pl.ReloadLib(library.path).size());
+
+  // The old version is released now, but it is only closed once its grace
+  // period has passed, so it is still draining until then.
+  oldVersion = ignition::plugin::PluginPtr();
+  EXPECT_EQ(1u, pl.DrainingLibraryCount());
+  EXPECT_EQ(0u, pl.ProcessLibraryChanges());
+  EXPECT_TRUE(drained.empty());
+
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (pl.DrainingLibraryCount() > 0
+         && std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  EXPECT_EQ(0u, pl.DrainingLibraryCount());
+  EXPECT_LE(1u, pl.UnloadStats().unloaded);
+  EXPECT_EQ(0u, pl.ProcessLibraryChanges());
+  ASSERT_EQ(1u, drained.size());
+  EXPECT_EQ(library.path, drained[0]);
+}
+
+/////////////////////////////////////////////////
+TEST(HotReload, WatchLib)
+{
+  DeployedLibrary library;
+
+  ignition::plugin::Loader pl;
+  ASSERT_LT(0u, pl.LoadLib(library.path).size());
+
+  EXPECT_EQ(-1, pl.LibraryWatchDescriptor());
+  EXPECT_EQ(0u, pl.ProcessLibraryChanges());
+
+  ASSERT_TRUE(pl.WatchLib(library.path));
+  EXPECT_LE(0, pl.LibraryWatchDescriptor());
+  EXPECT_EQ(0u, pl.ProcessLibraryChanges());
+
+  const std::uint64_t generation = pl.Generation();
+
+  library.DeployByRename();
+  EXPECT_EQ(1u, pl.ProcessLibraryChanges());
+  EXPECT_EQ(generation + 1, pl.Generation());
+  EXPECT_TRUE(pl.Instantiate("test::util::DummyMultiPlugin"));
+
+  library.Deploy();
+  EXPECT_EQ(1u, pl.ProcessLibraryChanges());
+  EXPECT_EQ(generation + 2, pl.Generation());
+  EXPECT_TRUE(pl.Instantiate("test::util::DummyMultiPlugin"));
+
+  // Other files in the same directory are ignored
+  std::ofstream(library.directory + "/other.txt") << "unrelated";
+  EXPECT_EQ(0u, pl.ProcessLibraryChanges());
+
+  pl.SetDiagnosticSink(nullptr);
+  library.DeployGarbage();
+  EXPECT_EQ(0u, pl.ProcessLibraryChanges());
+  EXPECT_EQ(generation + 2, pl.Generation());
+  EXPECT_TRUE(pl.Instantiate("test::util::DummyMultiPlugin"));
+
+  EXPECT_TRUE(pl.UnwatchLib(library.path));
+  EXPECT_FALSE(pl.UnwatchLib(library.path));
+
+  library.Deploy();
+  EXPECT_EQ(0u, pl.ProcessLibraryChanges());
+  EXPECT_EQ(generation + 2, pl.Generation());
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
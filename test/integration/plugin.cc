@@ -21,12 +21,20 @@
 #define IGNITION_UNITTEST_SPECIALIZED_PLUGIN_ACCESS
 
 #include <gtest/gtest.h>
+#include <chrono>
+#include <cstdlib>
+#include <set>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
 #include <vector>
 #include <iostream>
 #include "ignition/plugin/Loader.hh"
 #include "ignition/plugin/PluginPtr.hh"
+#include "ignition/plugin/QueryStats.hh"
 #include "ignition/plugin/SpecializedPluginPtr.hh"
+#include "ignition/plugin/Trace.hh"
 
 #include "../plugins/DummyPlugins.hh"
 #include "utils.hh"
@@ -147,6 +155,148 @@ TEST(Loader, LoadExistingLibrary)
 }
 
 
+/////////////////////////////////////////////////
+TEST(Loader, PluginsImplementingAllAny)
+{
+  ignition::plugin::Loader pl;
+  EXPECT_TRUE(pl.PluginsImplementingAny<test::util::DummyNameBase>().empty());
+  EXPECT_TRUE(pl.PluginsImplementingAll<>().empty());
+
+  pl.LoadLib(IGNDummyPlugins_LIB);
+
+  const std::unordered_set<std::string> multiOnly =
+      {"test::util::DummyMultiPlugin"};
+
+  EXPECT_EQ(multiOnly, (pl.PluginsImplementingAll<
+              test::util::DummyNameBase, test::util::DummyIntBase>()));
+  EXPECT_EQ(pl.PluginsImplementing<test::util::DummyNameBase>(),
+            pl.PluginsImplementingAll<test::util::DummyNameBase>());
+  EXPECT_EQ(pl.AllPlugins().size(), pl.PluginsImplementingAll<>().size());
+  EXPECT_TRUE(pl.PluginsImplementingAny<>().empty());
+
+  EXPECT_EQ(3u, (pl.PluginsImplementingAny<
+              test::util::DummyIntBase, test::util::DummyNameBase>().size()));
+  EXPECT_EQ(multiOnly, (pl.PluginsImplementingAny<
+              test::util::DummyIntBase, test::util::DummyDoubleBase>()));
+
+  EXPECT_EQ(multiOnly, pl.PluginsImplementingAll(
+              {"test::util::DummyDoubleBase", "test::util::DummySetterBase"}));
+  EXPECT_EQ(multiOnly, pl.PluginsImplementingAll(
+              {typeid(test::util::DummyDoubleBase).name()}, false));
+
+  // Interfaces that no plugin implements
+  EXPECT_TRUE(pl.PluginsImplementingAll(
+                {"test::util::DummyNameBase", "not::an::Interface"}).empty());
+  EXPECT_EQ(3u, pl.PluginsImplementingAny(
+              {"test::util::DummyNameBase", "not::an::Interface"}).size());
+  EXPECT_TRUE(pl.PluginsImplementing("not::an::Interface").empty());
+
+  // Forgetting the library releases the rows of its plugins, and loading it
+  // again reuses them.
+  EXPECT_TRUE(pl.ForgetLibrary(IGNDummyPlugins_LIB));
+  EXPECT_TRUE(pl.PluginsImplementingAny<test::util::DummyNameBase>().empty());
+  EXPECT_TRUE(pl.PluginsImplementingAll<>().empty());
+
+  pl.LoadLib(IGNDummyPlugins_LIB);
+  EXPECT_EQ(multiOnly, (pl.PluginsImplementingAll<
+              test::util::DummyNameBase, test::util::DummyIntBase>()));
+  EXPECT_EQ(3u, pl.PluginsImplementingAll<test::util::DummyNameBase>().size());
+
+  // The columns of interfaces which no plugin implements anymore are handed
+  // to the next interfaces, without mixing up the plugins of the two.
+  for (std::size_t i = 0; i < 3; ++i)
+  {
+    EXPECT_TRUE(pl.ForgetLibrary(IGNDummyPlugins_LIB));
+    EXPECT_FALSE(pl.LoadLib(IGNFactoryPlugins_LIB).empty());
+    EXPECT_TRUE(pl.PluginsImplementing("test::util::DummyNameBase").empty());
+    EXPECT_TRUE((pl.PluginsImplementingAny<
+                 test::util::DummyIntBase,
+                 test::util::DummyNameBase>().empty()));
+
+    pl.LoadLib(IGNDummyPlugins_LIB);
+    EXPECT_TRUE(pl.ForgetLibrary(IGNFactoryPlugins_LIB));
+    EXPECT_EQ(multiOnly, (pl.PluginsImplementingAll<
+                test::util::DummyNameBase, test::util::DummyIntBase>()));
+    EXPECT_EQ(3u,
+              pl.PluginsImplementing("test::util::DummyNameBase").size());
+    EXPECT_EQ(pl.AllPlugins().size(), pl.PluginsImplementingAll<>().size());
+  }
+}
+
+/////////////////////////////////////////////////
+TEST(Loader, ForEachVisitors)
+{
+  ignition::plugin::Loader pl;
+  pl.LoadLib(IGNDummyPlugins_LIB);
+
+  // Every visitor must see exactly what the set-returning query reports
+  std::set<std::string> visited;
+  const auto collect = [&](std::string_view _name)
+  {
+    EXPECT_TRUE(visited.emplace(_name).second);
+  };
+
+  pl.ForEachPlugin(collect);
+  EXPECT_EQ(pl.AllPlugins(), visited);
+
+  const auto asSet = [](const std::unordered_set<std::string> &_names)
+  {
+    return std::set<std::string>(_names.begin(), _names.end());
+  };
+
+  visited.clear();
+  pl.ForEachPluginImplementing<test::util::DummyNameBase>(collect);
+  EXPECT_EQ(asSet(pl.PluginsImplementing<test::util::DummyNameBase>()),
+            visited);
+  EXPECT_EQ(3u, visited.size());
+
+  visited.clear();
+  pl.ForEachPluginImplementing("test::util::DummyIntBase", collect);
+  EXPECT_EQ(std::set<std::string>{"test::util::DummyMultiPlugin"}, visited);
+
+  visited.clear();
+  pl.ForEachPluginImplementing("not::an::Interface", collect);
+  EXPECT_TRUE(visited.empty());
+
+  visited.clear();
+  pl.ForEachPluginWithAlias("Bar", collect);
+  EXPECT_EQ(pl.PluginsWithAlias("Bar"), visited);
+  EXPECT_EQ(2u, visited.size());
+
+  visited.clear();
+  pl.ForEachPluginWithAlias("test::util::DummySinglePlugin", collect);
+  EXPECT_EQ(pl.PluginsWithAlias("test::util::DummySinglePlugin"), visited);
+
+  visited.clear();
+  pl.ForEachAliasOfPlugin("test::util::DummyMultiPlugin", collect);
+  EXPECT_EQ(pl.AliasesOfPlugin("test::util::DummyMultiPlugin"), visited);
+  EXPECT_FALSE(visited.empty());
+
+  visited.clear();
+  pl.ForEachAliasOfPlugin("not::a::plugin", collect);
+  EXPECT_TRUE(visited.empty());
+
+  // The view refers to storage that is owned by the Loader
+  const std::string key = "Foo";
+  const std::string_view resolved = pl.LookupPluginView(key);
+  EXPECT_EQ("test::util::DummyMultiPlugin", resolved);
+  EXPECT_NE(key.data(), resolved.data());
+  EXPECT_EQ(resolved, pl.LookupPluginView("test::util::DummyMultiPlugin"));
+  EXPECT_TRUE(pl.LookupPluginView("Bar").empty());
+
+  // Substrings can be used as keys without copying them first
+  const std::string_view padded = "[Foo]";
+  EXPECT_TRUE(pl.Instantiate(padded.substr(1, 3)));
+  EXPECT_EQ(resolved, pl.LookupPlugin(padded.substr(1, 3)));
+
+  pl.Freeze();
+  EXPECT_EQ(resolved, pl.LookupPluginView(key));
+
+  visited.clear();
+  pl.ForEachPluginImplementing<test::util::DummyNameBase>(collect);
+  EXPECT_EQ(3u, visited.size());
+}
+
 /////////////////////////////////////////////////
 class SomeInterface { };
 
@@ -211,6 +361,54 @@ TEST(SpecializedPluginPtr, Construction)
   EXPECT_EQ(nullptr, someInterface);
 }
 
+/////////////////////////////////////////////////
+TEST(SpecializedPluginPtr, Conversion)
+{
+  using IntFirstPluginPtr = ignition::plugin::SpecializedPluginPtr<
+        test::util::DummyIntBase, SomeInterface>;
+
+  ignition::plugin::Loader pl;
+  pl.LoadLib(IGNDummyPlugins_LIB);
+
+  ignition::plugin::PluginPtr multi =
+      pl.Instantiate("test::util::DummyMultiPlugin");
+  ASSERT_TRUE(multi);
+
+  test::util::DummyIntBase *expected =
+      multi->QueryInterface<test::util::DummyIntBase>();
+  ASSERT_NE(nullptr, expected);
+
+  // Convert through several specialized types, which anticipate the same
+  // interfaces in different orders, and make sure that each of them finds
+  // the interfaces of the instance.
+  SomeSpecializedPluginPtr some = multi;
+  IntFirstPluginPtr intFirst = some;
+  SomeSpecializedPluginPtr someAgain = intFirst;
+
+  usedSpecializedInterfaceAccess = false;
+  EXPECT_EQ(expected, some->QueryInterface<test::util::DummyIntBase>());
+  EXPECT_EQ(expected, intFirst->QueryInterface<test::util::DummyIntBase>());
+  EXPECT_EQ(expected, someAgain->QueryInterface<test::util::DummyIntBase>());
+  EXPECT_EQ(nullptr, intFirst->QueryInterface<SomeInterface>());
+  EXPECT_NE(nullptr, someAgain->QueryInterface<test::util::DummySetterBase>());
+  EXPECT_TRUE(usedSpecializedInterfaceAccess);
+
+  // Pointing at a different kind of plugin must refresh the interfaces
+  intFirst = pl.Instantiate("test::util::DummySinglePlugin");
+  ASSERT_TRUE(intFirst);
+  EXPECT_EQ(nullptr, intFirst->QueryInterface<test::util::DummyIntBase>());
+  EXPECT_FALSE(intFirst->HasInterface<test::util::DummyIntBase>());
+
+  intFirst = someAgain;
+  EXPECT_EQ(expected, intFirst->QueryInterface<test::util::DummyIntBase>());
+
+  // Clearing a specialized pointer must not affect the others
+  some = nullptr;
+  EXPECT_EQ(nullptr, some->QueryInterface<test::util::DummyIntBase>());
+  EXPECT_EQ(expected, someAgain->QueryInterface<test::util::DummyIntBase>());
+}
+
+/////////////////////////////////////////////////
 TEST(PluginPtr, Empty)
 {
   ignition::plugin::PluginPtr empty;
@@ -578,6 +776,398 @@ TEST(PluginPtr, LibraryManagement)
   CHECK_FOR_LIBRARY(path, false);
 }
 
+/////////////////////////////////////////////////
+TEST(Loader, DeferredUnload)
+{
+  const std::string &path = IGNDummyPlugins_LIB;
+  CHECK_FOR_LIBRARY(path, false);
+
+  // By default, libraries are closed as soon as they are released
+  {
+    ignition::plugin::Loader pl;
+    EXPECT_EQ(std::chrono::milliseconds(0), pl.UnloadGracePeriod());
+
+    pl.LoadLib(path);
+    EXPECT_TRUE(pl.ForgetLibrary(path));
+    CHECK_FOR_LIBRARY(path, false);
+
+    const auto stats = pl.UnloadStats();
+    EXPECT_EQ(1u, stats.unloaded);
+    EXPECT_EQ(0u, stats.pending);
+    EXPECT_LE(stats.maxUnloadTime, stats.totalUnloadTime);
+  }
+
+  ignition::plugin::Loader pl;
+  pl.SetUnloadGracePeriod(std::chrono::milliseconds(100));
+  EXPECT_EQ(std::chrono::milliseconds(100), pl.UnloadGracePeriod());
+
+  pl.LoadLib(path);
+  ignition::plugin::PluginPtr plugin =
+      pl.Instantiate("test::util::DummyMultiPlugin");
+  EXPECT_TRUE(pl.ForgetLibrary(path));
+
+  // Releasing the last reference does not close the library right away
+  plugin = ignition::plugin::PluginPtr();
+  CHECK_FOR_LIBRARY(path, true);
+  EXPECT_EQ(1u, pl.UnloadStats().pending);
+  EXPECT_EQ(0u, pl.UnloadStats().unloaded);
+
+  // Loading it again during the grace period cancels the close
+  EXPECT_LT(0u, pl.LoadLib(path).size());
+  EXPECT_EQ(0u, pl.UnloadStats().pending);
+  EXPECT_EQ(1u, pl.UnloadStats().cancelled);
+  EXPECT_TRUE(pl.Instantiate("test::util::DummyMultiPlugin"));
+
+  EXPECT_TRUE(pl.ForgetLibrary(path));
+  EXPECT_EQ(1u, pl.UnloadStats().pending);
+
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (pl.UnloadStats().unloaded == 0 &&
+         std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  const auto stats = pl.UnloadStats();
+  EXPECT_EQ(1u, stats.unloaded);
+  EXPECT_EQ(0u, stats.pending);
+  EXPECT_EQ(1u, stats.cancelled);
+  EXPECT_LT(0, stats.totalUnloadTime.count());
+  CHECK_FOR_LIBRARY(path, false);
+}
+
+/////////////////////////////////////////////////
+TEST(Loader, LoadOptions)
+{
+  ignition::plugin::Loader pl;
+
+  const ignition::plugin::Loader::LoadOptions defaults =
+      pl.DefaultLoadOptions();
+  EXPECT_FALSE(defaults.bindNow);
+  EXPECT_FALSE(defaults.global);
+  EXPECT_FALSE(defaults.deepBind);
+  EXPECT_FALSE(defaults.noDelete);
+  EXPECT_FALSE(defaults.prefault);
+
+  ignition::plugin::Loader::LoadOptions eager;
+  eager.bindNow = true;
+  eager.prefault = true;
+  pl.SetDefaultLoadOptions(eager);
+  EXPECT_TRUE(pl.DefaultLoadOptions().bindNow);
+  EXPECT_TRUE(pl.DefaultLoadOptions().prefault);
+
+  const std::string &path = IGNDummyPlugins_LIB;
+  EXPECT_LT(0u, pl.LoadLib(path).size());
+
+  ignition::plugin::PluginPtr plugin =
+      pl.Instantiate("test::util::DummyMultiPlugin");
+  ASSERT_TRUE(plugin);
+  EXPECT_EQ(5, plugin->QueryInterface<test::util::DummyIntBase>()
+              ->MyIntegerValueIs());
+
+  plugin = ignition::plugin::PluginPtr();
+  EXPECT_TRUE(pl.ForgetLibrary(path));
+  CHECK_FOR_LIBRARY(path, false);
+
+#ifdef RTLD_NODELETE
+  // A library that is loaded with noDelete stays loaded after it has been
+  // released. That would affect every test which runs after this one, so it
+  // is checked in a child process. The deferred unload test may have left
+  // the reaper thread running, so the child must not simply be forked.
+  ::testing::FLAGS_gtest_death_test_style = "threadsafe";
+  EXPECT_EXIT(
+  {
+    ignition::plugin::Loader::LoadOptions resident;
+    resident.noDelete = true;
+
+    const bool loaded = !pl.LoadLib(path, resident).empty();
+    const bool forgotten = pl.ForgetLibrary(path);
+    void *dlHandle = dlopen(path.c_str(), RTLD_NOLOAD | RTLD_LAZY);
+    std::exit(loaded && forgotten && dlHandle ? 0 : 1);
+  }, ::testing::ExitedWithCode(0), "");
+#endif
+}
+
+/////////////////////////////////////////////////
+TEST(Loader, Stats)
+{
+  const std::string &path = IGNDummyPlugins_LIB;
+  const std::string name = "test::util::DummyMultiPlugin";
+
+  ignition::plugin::Loader pl;
+  EXPECT_TRUE(pl.Stats().libraries.empty());
+  EXPECT_TRUE(pl.Stats().plugins.empty());
+
+  EXPECT_LT(0u, pl.LoadLib(path).size());
+
+  const auto findPlugin =
+      [&](const ignition::plugin::Loader::Statistics &_stats)
+  {
+    for (const auto &plugin : _stats.plugins)
+    {
+      if (plugin.name == name)
+        return plugin;
+    }
+    ADD_FAILURE() << "No statistics for " << name;
+    return ignition::plugin::Loader::PluginStatistics();
+  };
+
+  auto stats = pl.Stats();
+  ASSERT_EQ(1u, stats.libraries.size());
+  EXPECT_EQ(path, stats.libraries[0].path);
+  EXPECT_EQ(1u, stats.libraries[0].loads);
+  EXPECT_LT(0, stats.libraries[0].dlopenTime.count());
+  EXPECT_LT(0, stats.libraries[0].hookTime.count());
+  EXPECT_LT(0, stats.libraries[0].demangleTime.count());
+  EXPECT_EQ(pl.AllPlugins().size(), stats.plugins.size());
+  EXPECT_EQ(0u, findPlugin(stats).instantiated);
+
+  ignition::plugin::PluginPtr first = pl.Instantiate(name);
+  ignition::plugin::PluginPtr second = pl.Instantiate(name);
+  ASSERT_TRUE(first && second);
+  first = ignition::plugin::PluginPtr();
+
+  auto plugin = findPlugin(pl.Stats());
+  EXPECT_EQ(path, plugin.library);
+  EXPECT_EQ(2u, plugin.instantiated);
+  EXPECT_EQ(1u, plugin.live);
+  EXPECT_EQ(1u, plugin.destroyed);
+  if (ignition::plugin::ConstructionTimingEnabled)
+    EXPECT_LT(0, plugin.constructionTime.count());
+  else
+    EXPECT_EQ(0, plugin.constructionTime.count());
+
+  // Instances stay counted after their plugin has been forgotten
+  EXPECT_TRUE(pl.ForgetLibrary(path));
+  second = ignition::plugin::PluginPtr();
+  plugin = findPlugin(pl.Stats());
+  EXPECT_EQ(0u, plugin.live);
+  EXPECT_EQ(2u, plugin.destroyed);
+
+  EXPECT_LT(0u, pl.LoadLib(path).size());
+  EXPECT_EQ(2u, pl.Stats().libraries[0].loads);
+  EXPECT_TRUE(pl.Instantiate(name));
+  EXPECT_EQ(3u, findPlugin(pl.Stats()).instantiated);
+
+  const std::string json =
+      ignition::plugin::Loader::StatsToJson(pl.Stats());
+  EXPECT_EQ('{', json.front());
+  EXPECT_EQ('}', json.back());
+  EXPECT_NE(std::string::npos, json.find("\"path\":\"" + path + "\""));
+  EXPECT_NE(std::string::npos, json.find(
+      "{\"name\":\"" + name + "\",\"library\":\"" + path + "\","
+      "\"instantiated\":3,\"live\":0,\"destroyed\":3,"));
+
+  const std::string text =
+      ignition::plugin::Loader::StatsToPrometheus(pl.Stats());
+  EXPECT_NE(std::string::npos, text.find(
+      "# TYPE ignition_plugin_instances_live gauge\n"));
+  EXPECT_NE(std::string::npos, text.find(
+      "ignition_plugin_library_loads_total{library=\"" + path + "\"} 2\n"));
+  EXPECT_NE(std::string::npos, text.find(
+      "ignition_plugin_instances_created_total{plugin=\"" + name + "\","
+      "library=\"" + path + "\"} 3\n"));
+}
+
+/////////////////////////////////////////////////
+TEST(Loader, Tracing)
+{
+  const std::string &path = IGNDummyPlugins_LIB;
+  ignition::plugin::ClearTrace();
+
+  {
+    ignition::plugin::Loader pl;
+    pl.LoadLib(path);
+    EXPECT_TRUE(pl.Instantiate("test::util::DummyMultiPlugin"));
+    EXPECT_TRUE(pl.ForgetLibrary(path));
+  }
+
+  const std::string trace = ignition::plugin::ChromeTrace();
+  for (const std::string &span :
+       {"LoadLib", "Instantiate", "DestroyPlugin", "ForgetLibrary"})
+  {
+    const std::string begin =
+        "{\"name\":\"" + span + "\",\"cat\":\"ignition-plugin\",\"ph\":\"B\"";
+    EXPECT_EQ(ignition::plugin::TracingEnabled,
+              trace.find(begin) != std::string::npos) << span;
+  }
+
+  if (ignition::plugin::TracingEnabled)
+  {
+    EXPECT_NE(std::string::npos, trace.find(
+        "\"args\":{\"detail\":\"test::util::DummyMultiPlugin"));
+  }
+}
+
+/////////////////////////////////////////////////
+TEST(PluginPtr, QueryInterfaceInlineCache)
+{
+  // Each Loader has its own Info for every plugin type, so the plugins of
+  // three Loaders are more plugin types than the inline cache of
+  // QueryInterface has entries.
+  std::vector<ignition::plugin::Loader> loaders(3);
+  for (ignition::plugin::Loader &pl : loaders)
+    pl.LoadLib(IGNDummyPlugins_LIB);
+
+  // Alternate between plugin types, and between several instances of each
+  // type, so that the entries of the cache get hit and replaced.
+  std::vector<ignition::plugin::PluginPtr> plugins;
+  for (std::size_t i = 0; i < 2; ++i)
+  {
+    for (const ignition::plugin::Loader &pl : loaders)
+    {
+      plugins.push_back(pl.Instantiate("test::util::DummyMultiPlugin"));
+      plugins.push_back(pl.Instantiate("test::util::DummySinglePlugin"));
+    }
+  }
+
+  for (std::size_t repeat = 0; repeat < 3; ++repeat)
+  {
+    for (const ignition::plugin::PluginPtr &plugin : plugins)
+    {
+      test::util::DummyNameBase *name =
+          plugin->QueryInterface<test::util::DummyNameBase>();
+      ASSERT_NE(nullptr, name);
+      EXPECT_EQ(plugin->QueryInterfaceSharedPtr<
+                  test::util::DummyNameBase>().get(), name);
+
+      const bool hasInt =
+          plugin->HasInterface("test::util::DummyIntBase");
+      test::util::DummyIntBase *integer =
+          plugin->QueryInterface<test::util::DummyIntBase>();
+      EXPECT_EQ(hasInt, nullptr != integer);
+      if (integer)
+        EXPECT_EQ(5, integer->MyIntegerValueIs());
+    }
+  }
+
+  // Replacing the instance of a PluginPtr must also refresh its interfaces
+  ignition::plugin::PluginPtr plugin = plugins[0];
+  EXPECT_NE(nullptr, plugin->QueryInterface<test::util::DummyIntBase>());
+  plugin = plugins[1];
+  EXPECT_EQ(nullptr, plugin->QueryInterface<test::util::DummyIntBase>());
+  plugin = nullptr;
+  EXPECT_EQ(nullptr, plugin->QueryInterface<test::util::DummyNameBase>());
+}
+
+/////////////////////////////////////////////////
+TEST(SpecializedPluginPtr, QueryStats)
+{
+  ignition::plugin::Loader pl;
+  pl.LoadLib(IGNDummyPlugins_LIB);
+
+  SomeSpecializedPluginPtr plugin(
+        pl.Instantiate("test::util::DummyMultiPlugin"));
+  ASSERT_FALSE(plugin.IsEmpty());
+
+  ignition::plugin::ResetQueryStats();
+  for (std::size_t i = 0; i < 10; ++i)
+  {
+    EXPECT_NE(nullptr, plugin->QueryInterface<test::util::DummyDoubleBase>());
+    EXPECT_NE(nullptr, plugin->QueryInterface<test::util::DummyIntBase>());
+    EXPECT_EQ(nullptr, plugin->QueryInterface<SomeInterface>());
+  }
+
+  const std::vector<ignition::plugin::QueryStatistics> stats =
+      ignition::plugin::QueryStats();
+  if (!ignition::plugin::QueryStatsEnabled)
+  {
+    EXPECT_TRUE(stats.empty());
+    return;
+  }
+
+  ASSERT_EQ(3u, stats.size());
+  EXPECT_EQ("test::util::DummyDoubleBase", stats[0].interface);
+  EXPECT_EQ(3u, stats[0].pointerInterfaces.size());
+  EXPECT_FALSE(stats[0].specialized);
+  EXPECT_EQ(10u, stats[0].hits);
+  EXPECT_LE(stats[0].lookups, 1u);
+
+  for (std::size_t i = 1; i < stats.size(); ++i)
+  {
+    EXPECT_TRUE(stats[i].specialized);
+    EXPECT_EQ(0u, stats[i].lookups);
+  }
+
+  const std::vector<ignition::plugin::SpecializationAdvice> advice =
+      ignition::plugin::AdviseSpecializations();
+  ASSERT_EQ(1u, advice.size());
+  EXPECT_EQ(10u, advice[0].unspecializedQueries);
+  EXPECT_EQ(std::vector<std::string>{"test::util::DummyDoubleBase"},
+            advice[0].interfaces);
+  EXPECT_EQ("ignition::plugin::SpecializedPluginPtr<SomeInterface, "
+            "test::util::DummyIntBase, test::util::DummySetterBase, "
+            "test::util::DummyDoubleBase>", advice[0].suggestedType);
+}
+
+/////////////////////////////////////////////////
+TEST(PluginPtr, QueryInterfaces)
+{
+  ignition::plugin::Loader pl;
+  pl.LoadLib(IGNDummyPlugins_LIB);
+
+  ignition::plugin::PluginPtr plugin =
+      pl.Instantiate("test::util::DummyMultiPlugin");
+  ASSERT_TRUE(plugin);
+
+  test::util::DummyIntBase *integer = nullptr;
+  test::util::DummyNameBase *name = nullptr;
+  SomeInterface *some = nullptr;
+
+  // Ask in an order that differs from the sorted order of the names
+  std::tie(name, some, integer) = plugin->QueryInterfaces<
+      test::util::DummyNameBase, SomeInterface, test::util::DummyIntBase>();
+  EXPECT_EQ(plugin->QueryInterface<test::util::DummyNameBase>(), name);
+  EXPECT_EQ(plugin->QueryInterface<test::util::DummyIntBase>(), integer);
+  ASSERT_NE(nullptr, integer);
+  EXPECT_EQ(5, integer->MyIntegerValueIs());
+  EXPECT_EQ(nullptr, some);
+
+  EXPECT_TRUE((plugin->HasInterfaces<
+                 test::util::DummyNameBase, test::util::DummyIntBase>()));
+  EXPECT_FALSE((plugin->HasInterfaces<
+                  test::util::DummyNameBase, SomeInterface>()));
+  EXPECT_TRUE(plugin->HasInterfaces<>());
+
+  const ignition::plugin::ConstPluginPtr constPlugin = plugin;
+  const test::util::DummyIntBase *constInteger = nullptr;
+  std::tie(constInteger) =
+      constPlugin->QueryInterfaces<test::util::DummyIntBase>();
+  EXPECT_EQ(integer, constInteger);
+
+  // Specialized pointers answer from their cached interfaces when every
+  // requested interface is specialized, and fall back otherwise.
+  SomeSpecializedPluginPtr spec = plugin;
+  usedSpecializedInterfaceAccess = false;
+  test::util::DummySetterBase *setter = nullptr;
+  std::tie(integer, setter) = spec->QueryInterfaces<
+      test::util::DummyIntBase, test::util::DummySetterBase>();
+  EXPECT_TRUE(usedSpecializedInterfaceAccess);
+  EXPECT_EQ(plugin->QueryInterface<test::util::DummySetterBase>(), setter);
+  EXPECT_NE(nullptr, integer);
+
+  usedSpecializedInterfaceAccess = false;
+  std::tie(integer, name) = spec->QueryInterfaces<
+      test::util::DummyIntBase, test::util::DummyNameBase>();
+  EXPECT_FALSE(usedSpecializedInterfaceAccess);
+  EXPECT_NE(nullptr, integer);
+  EXPECT_NE(nullptr, name);
+
+  EXPECT_FALSE((spec->HasInterfaces<
+                  test::util::DummyIntBase, SomeInterface>()));
+  EXPECT_TRUE((spec->HasInterfaces<
+                 test::util::DummyIntBase, test::util::DummyNameBase>()));
+
+  // An empty plugin has none of the interfaces
+  plugin = nullptr;
+  std::tie(name, some, integer) = plugin->QueryInterfaces<
+      test::util::DummyNameBase, SomeInterface, test::util::DummyIntBase>();
+  EXPECT_EQ(nullptr, name);
+  EXPECT_EQ(nullptr, integer);
+  EXPECT_FALSE(plugin->HasInterfaces<test::util::DummyNameBase>());
+}
+
 /////////////////////////////////////////////////
 int main(int argc, char **argv)
 {
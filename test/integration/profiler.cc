@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <ignition/plugin/Loader.hh>
+#include <ignition/plugin/Profiler.hh>
+
+#include "../plugins/DummyPlugins.hh"
+
+/////////////////////////////////////////////////
+/// \brief A function which does not belong to any plugin
+int NotAPlugin()
+{
+  return 0;
+}
+
+/////////////////////////////////////////////////
+TEST(Profiler, AddressRanges)
+{
+  ignition::plugin::Loader pl;
+  EXPECT_TRUE(pl.AddressRanges().empty());
+
+  pl.LoadLib(IGNDummyPlugins_LIB);
+  const std::vector<ignition::plugin::Loader::AddressRange> ranges =
+      pl.AddressRanges();
+
+#ifdef __linux__
+  ASSERT_FALSE(ranges.empty());
+  for (std::size_t i = 0; i < ranges.size(); ++i)
+  {
+    EXPECT_LT(ranges[i].begin, ranges[i].end);
+    if (i > 0)
+    {
+      EXPECT_LE(ranges[i-1].end, ranges[i].begin);
+    }
+
+    EXPECT_EQ(IGNDummyPlugins_LIB, ranges[i].library);
+    EXPECT_EQ(pl.AllPlugins().size(), ranges[i].plugins.size());
+    EXPECT_EQ(pl.InterfacesImplemented().size(), ranges[i].interfaces.size());
+  }
+#endif
+}
+
+/////////////////////////////////////////////////
+TEST(Profiler, Attribute)
+{
+  ignition::plugin::Loader pl;
+  pl.LoadLib(IGNDummyPlugins_LIB);
+
+  ignition::plugin::PluginPtr plugin =
+      pl.Instantiate("test::util::DummyMultiPlugin");
+  ASSERT_TRUE(plugin);
+
+  test::util::DummyIntBase *integer =
+      plugin->QueryInterface<test::util::DummyIntBase>();
+  ASSERT_NE(nullptr, integer);
+
+  ignition::plugin::Profiler profiler(pl);
+
+  // Code outside of the plugin libraries belongs to no plugin
+  const ignition::plugin::Profiler::Attribution outside =
+      profiler.Attribute(reinterpret_cast<const void*>(&NotAPlugin));
+  EXPECT_TRUE(outside.library.empty());
+  EXPECT_TRUE(outside.plugin.empty());
+
+#ifdef __linux__
+  // The first entry in the virtual table of the interface is the
+  // implementation of MyIntegerValueIs(), or a thunk to it.
+  const void *function = (*reinterpret_cast<void* const* const*>(integer))[0];
+  const ignition::plugin::Profiler::Attribution inside =
+      profiler.Attribute(function);
+  EXPECT_EQ(IGNDummyPlugins_LIB, inside.library);
+
+  // The symbol is only known if the library exports it
+  if (!inside.symbol.empty())
+  {
+    EXPECT_NE(std::string::npos, inside.symbol.find("MyIntegerValueIs"));
+    EXPECT_EQ("test::util::DummyMultiPlugin", inside.plugin);
+  }
+#endif
+}
+
+/////////////////////////////////////////////////
+TEST(Profiler, Sampling)
+{
+  ignition::plugin::Loader pl;
+  pl.LoadLib(IGNDummyPlugins_LIB);
+
+  ignition::plugin::PluginPtr plugin =
+      pl.Instantiate("test::util::DummyMultiPlugin");
+  test::util::DummyIntBase *integer =
+      plugin->QueryInterface<test::util::DummyIntBase>();
+  ASSERT_NE(nullptr, integer);
+
+  ignition::plugin::Profiler profiler(pl);
+  EXPECT_FALSE(profiler.IsRunning());
+
+#ifndef __linux__
+  EXPECT_FALSE(profiler.Start());
+#else
+  ASSERT_TRUE(profiler.Start(std::chrono::microseconds(500)));
+  EXPECT_TRUE(profiler.IsRunning());
+  EXPECT_FALSE(profiler.Start());
+
+  // Only one profiler can run at a time
+  ignition::plugin::Profiler other(pl);
+  EXPECT_FALSE(other.Start());
+
+  // Burn some CPU time, partly inside of the plugin
+  volatile int sum = 0;
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(300);
+  while (std::chrono::steady_clock::now() < deadline)
+  {
+    for (int i = 0; i < 1000; ++i)
+      sum = sum + integer->MyIntegerValueIs();
+  }
+
+  profiler.Stop();
+  EXPECT_FALSE(profiler.IsRunning());
+
+  const std::size_t samples = profiler.SampleCount();
+  EXPECT_LT(0u, samples);
+  EXPECT_EQ(0u, profiler.DroppedSampleCount());
+
+  const std::vector<ignition::plugin::Profiler::Share> shares =
+      profiler.Shares();
+  ASSERT_FALSE(shares.empty());
+
+  std::size_t total = 0;
+  double fraction = 0.0;
+  for (std::size_t i = 0; i < shares.size(); ++i)
+  {
+    total += shares[i].samples;
+    fraction += shares[i].fraction;
+    if (i > 0)
+    {
+      EXPECT_GE(shares[i-1].samples, shares[i].samples);
+    }
+  }
+  EXPECT_EQ(samples, total);
+  EXPECT_NEAR(1.0, fraction, 1e-9);
+
+  const std::string table =
+      ignition::plugin::Profiler::FormatShares(shares);
+  EXPECT_EQ(0u, table.find("   Share   Samples  Plugin"));
+  std::cout << table;
+
+  // Samples are kept until they are reset, and no more are taken once the
+  // profiler has stopped
+  EXPECT_EQ(samples, profiler.SampleCount());
+  profiler.Reset();
+  EXPECT_EQ(0u, profiler.SampleCount());
+
+  // Now the other profiler can run
+  EXPECT_TRUE(other.Start());
+  other.Stop();
+#endif
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
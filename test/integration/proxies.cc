@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <ignition/plugin/InterfaceProxy.hh>
+#include <ignition/plugin/Loader.hh>
+#include <ignition/plugin/SpecializedPluginPtr.hh>
+
+#include "../plugins/DummyPlugins.hh"
+
+namespace test
+{
+  /// \brief The number of TimedSetter proxies that exist
+  int liveSetterProxies = 0;
+
+  /// \brief Times the calls to DummySetterBase
+  class TimedSetter
+    : public ignition::plugin::InterfaceProxy<util::DummySetterBase>
+  {
+    public: TimedSetter(util::DummySetterBase *_target,
+                        ignition::plugin::detail::MethodCounters *_counters,
+                        const std::size_t _methodCount)
+      : InterfaceProxy(_target, _counters, _methodCount)
+    {
+      ++liveSetterProxies;
+    }
+
+    public: ~TimedSetter()
+    {
+      --liveSetterProxies;
+    }
+
+    public: void SetName(const std::string &_name) override
+    {
+      this->Forward(0, &util::DummySetterBase::SetName, _name);
+    }
+
+    public: void SetDoubleValue(const double _val) override
+    {
+      this->Forward(1, &util::DummySetterBase::SetDoubleValue, _val);
+    }
+
+    public: void SetIntegerValue(const int _val) override
+    {
+      this->Forward(2, &util::DummySetterBase::SetIntegerValue, _val);
+    }
+  };
+
+  /// \brief Times the calls to DummyIntBase
+  class TimedInt : public ignition::plugin::InterfaceProxy<util::DummyIntBase>
+  {
+    public: using InterfaceProxy::InterfaceProxy;
+
+    public: int MyIntegerValueIs() const override
+    {
+      return this->Forward(0, &util::DummyIntBase::MyIntegerValueIs);
+    }
+  };
+}
+
+IGNITION_ADD_INTERFACE_PROXY(test::TimedSetter,
+    "SetName", "SetDoubleValue", "SetIntegerValue")
+IGNITION_ADD_INTERFACE_PROXY(test::TimedInt, "MyIntegerValueIs")
+
+using MethodStatistics = ignition::plugin::Loader::MethodStatistics;
+
+/////////////////////////////////////////////////
+/// \brief Find the statistics of a method
+/// \param[in] _stats The statistics of every method
+/// \param[in] _plugin The name of the plugin
+/// \param[in] _method The name of the method
+/// \return The statistics, or empty statistics if there are none
+MethodStatistics Find(const std::vector<MethodStatistics> &_stats,
+                      const std::string &_plugin,
+                      const std::string &_method)
+{
+  for (const MethodStatistics &stats : _stats)
+  {
+    if (stats.plugin == _plugin && stats.method == _method)
+      return stats;
+  }
+  return MethodStatistics();
+}
+
+/////////////////////////////////////////////////
+TEST(InterfaceProxy, DisabledByDefault)
+{
+  ignition::plugin::Loader pl;
+  pl.LoadLib(IGNDummyPlugins_LIB);
+  EXPECT_FALSE(pl.InterfaceProxiesEnabled());
+
+  ignition::plugin::PluginPtr plugin =
+      pl.Instantiate("test::util::DummyMultiPlugin");
+  test::util::DummyIntBase *integer =
+      plugin->QueryInterface<test::util::DummyIntBase>();
+  ASSERT_NE(nullptr, integer);
+  EXPECT_EQ(nullptr, dynamic_cast<test::TimedInt*>(integer));
+  EXPECT_EQ(5, integer->MyIntegerValueIs());
+
+  // The methods are known, but nothing has been timed
+  const std::vector<MethodStatistics> stats = pl.MethodStats();
+  const MethodStatistics value =
+      Find(stats, "test::util::DummyMultiPlugin", "MyIntegerValueIs");
+  EXPECT_EQ("test::util::DummyIntBase", value.interface);
+  EXPECT_EQ(0u, value.calls);
+  EXPECT_EQ(ignition::plugin::detail::LatencyBuckets,
+            value.latencyHistogram.size());
+  EXPECT_EQ(0, test::liveSetterProxies);
+}
+
+/////////////////////////////////////////////////
+TEST(InterfaceProxy, TimesCalls)
+{
+  ignition::plugin::Loader pl;
+  pl.LoadLib(IGNDummyPlugins_LIB);
+
+  ignition::plugin::PluginPtr before =
+      pl.Instantiate("test::util::DummyMultiPlugin");
+
+  pl.SetInterfaceProxies(true);
+  EXPECT_TRUE(pl.InterfaceProxiesEnabled());
+
+  ignition::plugin::PluginPtr plugin =
+      pl.Instantiate("test::util::DummyMultiPlugin");
+  EXPECT_EQ(1, test::liveSetterProxies);
+
+  // Instances which were created before the proxies were turned on keep
+  // handing out the plugin itself
+  EXPECT_EQ(nullptr, dynamic_cast<test::TimedInt*>(
+              before->QueryInterface<test::util::DummyIntBase>()));
+
+  test::util::DummySetterBase *setter =
+      plugin->QueryInterface<test::util::DummySetterBase>();
+  test::util::DummyIntBase *integer =
+      plugin->QueryInterface<test::util::DummyIntBase>();
+  ASSERT_NE(nullptr, setter);
+  ASSERT_NE(nullptr, integer);
+  EXPECT_NE(nullptr, dynamic_cast<test::TimedSetter*>(setter));
+  EXPECT_NE(nullptr, dynamic_cast<test::TimedInt*>(integer));
+
+  // Interfaces without a proxy are handed out as usual
+  test::util::DummyNameBase *name =
+      plugin->QueryInterface<test::util::DummyNameBase>();
+  ASSERT_NE(nullptr, name);
+  EXPECT_EQ("DummyMultiPlugin", name->MyNameIs());
+
+  // Calls are forwarded to the instance
+  setter->SetIntegerValue(42);
+  setter->SetName("proxied");
+  EXPECT_EQ(42, integer->MyIntegerValueIs());
+  EXPECT_EQ(42, integer->MyIntegerValueIs());
+  EXPECT_EQ("proxied", name->MyNameIs());
+
+  // Specialized plugins find the same proxies
+  using SpecializedIntPtr =
+      ignition::plugin::SpecializedPluginPtr<test::util::DummyIntBase>;
+  SpecializedIntPtr specialized = plugin;
+  EXPECT_EQ(integer, specialized->QueryInterface<test::util::DummyIntBase>());
+
+  const std::vector<MethodStatistics> stats = pl.MethodStats();
+  const std::string pluginName = "test::util::DummyMultiPlugin";
+  EXPECT_EQ(2u, Find(stats, pluginName, "MyIntegerValueIs").calls);
+  EXPECT_EQ(1u, Find(stats, pluginName, "SetIntegerValue").calls);
+  EXPECT_EQ(1u, Find(stats, pluginName, "SetName").calls);
+  EXPECT_EQ(0u, Find(stats, pluginName, "SetDoubleValue").calls);
+
+  for (const MethodStatistics &method : stats)
+  {
+    std::uint64_t total = 0;
+    for (const std::uint64_t count : method.latencyHistogram)
+      total += count;
+    EXPECT_EQ(method.calls, total) << method.method;
+  }
+
+  // The proxies are destroyed together with their instance
+  plugin = nullptr;
+  specialized = nullptr;
+  EXPECT_EQ(0, test::liveSetterProxies);
+
+  pl.SetInterfaceProxies(false);
+  plugin = pl.Instantiate("test::util::DummyMultiPlugin");
+  EXPECT_EQ(0, test::liveSetterProxies);
+}
+
+/////////////////////////////////////////////////
+TEST(InterfaceProxy, MixedInstances)
+{
+  ignition::plugin::Loader pl;
+  pl.LoadLib(IGNDummyPlugins_LIB);
+
+  pl.SetInterfaceProxies(true);
+  ignition::plugin::PluginPtr proxied =
+      pl.Instantiate("test::util::DummyMultiPlugin");
+  pl.SetInterfaceProxies(false);
+  ignition::plugin::PluginPtr plain =
+      pl.Instantiate("test::util::DummyMultiPlugin");
+
+  // Instances of the same plugin keep handing out whatever they were created
+  // with, no matter which of them is queried first or how often.
+  for (std::size_t i = 0; i < 3; ++i)
+  {
+    EXPECT_EQ(nullptr, dynamic_cast<test::TimedInt*>(
+                plain->QueryInterface<test::util::DummyIntBase>()));
+    EXPECT_NE(nullptr, dynamic_cast<test::TimedInt*>(
+                proxied->QueryInterface<test::util::DummyIntBase>()));
+  }
+}
+
+/////////////////////////////////////////////////
+TEST(InterfaceProxy, LatencyBuckets)
+{
+  using ignition::plugin::detail::LatencyBucket;
+  EXPECT_EQ(0u, LatencyBucket(0));
+  EXPECT_EQ(1u, LatencyBucket(1));
+  EXPECT_EQ(2u, LatencyBucket(2));
+  EXPECT_EQ(2u, LatencyBucket(3));
+  EXPECT_EQ(11u, LatencyBucket(1024));
+  EXPECT_EQ(ignition::plugin::detail::LatencyBuckets - 1,
+            LatencyBucket(UINT64_MAX));
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -20,6 +20,37 @@
 
 #include <dlfcn.h>
 
+#include <cstddef>
+
+#include <ignition/plugin/Info.hh>
+
+/////////////////////////////////////////////////
+/// \brief Get the Info of the plugins of a library straight from the hook
+/// that the Loader calls, so that the Info can be inspected the way that the
+/// library provides it. The library must stay loaded while the Info is used.
+/// \param[in] _dlHandle Handle of the library
+/// \return The Info of each plugin, keyed by its mangled name, or nullptr if
+/// the library does not provide any plugins.
+inline const ignition::plugin::InfoMap *GetInfoMap(void *_dlHandle)
+{
+  using HookSignature = void(*)(const void *, const void **,
+                                int *, std::size_t *, std::size_t *);
+
+  void *symbol = dlsym(_dlHandle, "IgnitionPluginHook");
+  if (!symbol)
+    return nullptr;
+
+  int version = ignition::plugin::INFO_API_VERSION;
+  std::size_t size = sizeof(ignition::plugin::Info);
+  std::size_t alignment = alignof(ignition::plugin::Info);
+  const ignition::plugin::InfoMap *allInfo = nullptr;
+  reinterpret_cast<HookSignature>(symbol)(
+        nullptr, reinterpret_cast<const void**>(&allInfo),
+        &version, &size, &alignment);
+
+  return allInfo;
+}
+
 /////////////////////////////////////////////////
 // The macro RTLD_NOLOAD is not part of the POSIX standard, and is a custom
 // addition to glibc-2.2, so the unloading test can only work when we are using
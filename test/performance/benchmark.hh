@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGNITION_TEST_PERFORMANCE_BENCHMARK_HH_
+#define IGNITION_TEST_PERFORMANCE_BENCHMARK_HH_
+
+// Helpers for the benchmarks which write their results as JSON. This header
+// replaces the global operator new and operator delete with versions that
+// count allocations, so it must only be included by the source file which
+// defines main().
+//
+// The results are printed to stdout. If the environment variable
+// IGN_PLUGIN_BENCHMARK_DIR is set, they are also written to
+// <IGN_PLUGIN_BENCHMARK_DIR>/<suite>.json.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace test
+{
+namespace benchmark
+{
+
+/// \brief The number of calls to operator new so far
+std::atomic<std::size_t> allocations(0);
+
+/// \brief One result of a benchmark
+struct Result
+{
+  /// \brief What was measured
+  public: std::string name;
+
+  /// \brief The parameters and measurements, in the order they are written
+  public: std::vector<std::pair<std::string, double>> values;
+};
+
+/// \brief The cost of one operation
+struct Measurement
+{
+  /// \brief Nanoseconds per operation, in the fastest trial
+  public: double nanoseconds = 0.0;
+
+  /// \brief Calls to operator new per operation, in the fastest trial
+  public: double allocations = 0.0;
+};
+
+/////////////////////////////////////////////////
+/// \brief Keep the compiler from optimizing away the computation of _value.
+template <typename T>
+void DoNotOptimize(const T &_value)
+{
+#ifdef _MSC_VER
+  // MSVC has no inline assembly on x64. A volatile read of the value makes
+  // the compiler produce it, and the barrier keeps the read in place.
+  static_cast<void>(*reinterpret_cast<const volatile char*>(&_value));
+  _ReadWriteBarrier();
+#else
+  asm volatile("" : : "r,m"(_value) : "memory");
+#endif
+}
+
+/////////////////////////////////////////////////
+/// \brief Measure the cost of an operation. _work is timed in several
+/// trials, each of which is preceded by a call to _prepare that is not
+/// timed.
+/// \param[in] _operations The number of operations that _work performs
+/// \param[in] _prepare Sets up a trial
+/// \param[in] _work Performs the operations
+/// \return The cost of one operation
+Measurement Measure(
+    const std::size_t _operations,
+    const std::function<void()> &_prepare,
+    const std::function<void()> &_work)
+{
+  const std::size_t Trials = 7;
+
+  Measurement best;
+  best.nanoseconds = std::numeric_limits<double>::max();
+  for (std::size_t trial = 0; trial < Trials; ++trial)
+  {
+    _prepare();
+
+    const std::size_t before = allocations.load();
+    const auto start = std::chrono::steady_clock::now();
+    _work();
+    const auto finish = std::chrono::steady_clock::now();
+    const std::size_t after = allocations.load();
+
+    const double nanoseconds = std::chrono::duration<double, std::nano>(
+          finish - start).count() / static_cast<double>(_operations);
+    if (nanoseconds < best.nanoseconds)
+    {
+      best.nanoseconds = nanoseconds;
+      best.allocations = static_cast<double>(after - before)
+          / static_cast<double>(_operations);
+    }
+  }
+
+  return best;
+}
+
+/////////////////////////////////////////////////
+/// \brief Measure the cost of an operation which needs no preparation.
+Measurement Measure(
+    const std::size_t _operations,
+    const std::function<void()> &_work)
+{
+  return Measure(_operations, []() { }, _work);
+}
+
+/////////////////////////////////////////////////
+/// \brief Get the value below which a fraction of the samples fall.
+/// \param[in,out] _samples The samples. They get sorted.
+/// \param[in] _fraction The fraction, from 0 to 1
+/// \return The sample at that fraction, or 0 if there are no samples
+double Percentile(std::vector<double> &_samples, const double _fraction)
+{
+  if (_samples.empty())
+    return 0.0;
+
+  std::sort(_samples.begin(), _samples.end());
+  const std::size_t index = std::min(_samples.size() - 1,
+      static_cast<std::size_t>(_fraction * static_cast<double>(
+          _samples.size())));
+  return _samples[index];
+}
+
+/////////////////////////////////////////////////
+/// \brief Format the results of a suite of benchmarks as JSON.
+std::string ToJson(
+    const std::string &_suite,
+    const std::vector<Result> &_results)
+{
+  std::stringstream json;
+  json << "{\"suite\":\"" << _suite << "\",\"results\":[";
+  for (std::size_t i = 0; i < _results.size(); ++i)
+  {
+    json << (i > 0 ? ",\n" : "\n")
+         << "{\"name\":\"" << _results[i].name << "\"";
+    for (const auto &value : _results[i].values)
+      json << ",\"" << value.first << "\":" << value.second;
+    json << "}";
+  }
+  json << "\n]}\n";
+  return json.str();
+}
+
+/////////////////////////////////////////////////
+/// \brief Write the results of a suite of benchmarks.
+void WriteJson(
+    const std::string &_suite,
+    const std::vector<Result> &_results)
+{
+  const std::string json = ToJson(_suite, _results);
+  std::cout << json << std::flush;
+
+  if (const char *dir = std::getenv("IGN_PLUGIN_BENCHMARK_DIR"))
+    std::ofstream(std::string(dir) + "/" + _suite + ".json") << json;
+}
+
+}
+}
+
+/////////////////////////////////////////////////
+void *operator new(std::size_t _size)
+{
+  ++test::benchmark::allocations;
+  if (void *ptr = std::malloc(std::max<std::size_t>(_size, 1)))
+    return ptr;
+
+  throw std::bad_alloc();
+}
+
+/////////////////////////////////////////////////
+void *operator new[](std::size_t _size)
+{
+  return ::operator new(_size);
+}
+
+/////////////////////////////////////////////////
+void operator delete(void *_ptr) noexcept
+{
+  std::free(_ptr);
+}
+
+/////////////////////////////////////////////////
+void operator delete[](void *_ptr) noexcept
+{
+  std::free(_ptr);
+}
+
+/////////////////////////////////////////////////
+void operator delete(void *_ptr, std::size_t) noexcept
+{
+  std::free(_ptr);
+}
+
+/////////////////////////////////////////////////
+void operator delete[](void *_ptr, std::size_t) noexcept
+{
+  std::free(_ptr);
+}
+
+#endif
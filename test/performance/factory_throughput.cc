@@ -0,0 +1,301 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ignition/plugin/Factory.hh>
+#include <ignition/plugin/Loader.hh>
+
+#include "../plugins/FactoryPlugins.hh"
+#include "benchmark.hh"
+
+using test::util::DummyIntBase;
+using test::util::IntFactory;
+
+const std::size_t MaxThreads = 8;
+const std::size_t NumProducts = 5000;
+
+/// \brief The results of every test, which main() writes once they are done
+std::vector<test::benchmark::Result> results;
+
+/////////////////////////////////////////////////
+/// \brief How the products of a trial are destroyed
+enum class Destruction
+{
+  /// \brief By their ProductPtr, while the factory is still held
+  BeforeFactory,
+
+  /// \brief By their ProductPtr, after the factory has been released, so
+  /// that the products hold the last references to the factory plugin
+  AfterFactory,
+
+  /// \brief By plain delete after being released from their ProductPtr, so
+  /// that each of them hands its factory reference to the lost product
+  /// manager
+  Lost,
+
+  /// \brief Like Lost, while another thread calls CleanupLostProducts() over
+  /// and over
+  LostWithCleanup
+};
+
+/////////////////////////////////////////////////
+/// \brief Get the name of a way of destroying products.
+std::string ToString(const Destruction _destruction)
+{
+  switch (_destruction)
+  {
+    case Destruction::BeforeFactory:
+      return "destroyed before factory";
+    case Destruction::AfterFactory:
+      return "destroyed after factory";
+    case Destruction::Lost:
+      return "lost";
+    case Destruction::LostWithCleanup:
+      return "lost during cleanup";
+  }
+
+  return "";
+}
+
+/////////////////////////////////////////////////
+/// \brief Run _work(i) on _numThreads threads at once, where i is the index
+/// of the thread, and get how long it took all of them to finish.
+double RunThreads(
+    const std::size_t _numThreads,
+    const std::function<void(std::size_t)> &_work)
+{
+  std::atomic<bool> go(false);
+  std::atomic<std::size_t> ready(0);
+
+  std::vector<std::thread> threads;
+  threads.reserve(_numThreads);
+  for (std::size_t i = 0; i < _numThreads; ++i)
+  {
+    threads.push_back(std::thread([&, i]()
+    {
+      ++ready;
+      while (!go)
+        std::this_thread::yield();
+
+      _work(i);
+    }));
+  }
+
+  while (ready < _numThreads)
+    std::this_thread::yield();
+
+  const auto start = std::chrono::steady_clock::now();
+  go = true;
+  for (std::thread &thread : threads)
+    thread.join();
+  const auto finish = std::chrono::steady_clock::now();
+
+  return std::chrono::duration<double, std::micro>(finish - start).count();
+}
+
+/////////////////////////////////////////////////
+/// \brief Construct NumProducts products on each of _numThreads threads and
+/// then destroy them in the way given by _destruction. The latency of each
+/// Construct() and each destruction is recorded.
+void RunTrial(
+    const std::size_t _numThreads,
+    const Destruction _destruction)
+{
+  ignition::plugin::Loader pl;
+  ASSERT_FALSE(pl.LoadLib(IGNFactoryPlugins_LIB).empty());
+
+  std::shared_ptr<IntFactory> factory =
+      pl.Factory<IntFactory>("test::util::DummyIntForward");
+  ASSERT_NE(nullptr, factory);
+
+  const std::size_t total = _numThreads * NumProducts;
+
+  // Everything the threads write to is allocated up front, so that the
+  // allocations of the benchmark itself are not counted.
+  std::vector<IntFactory::ProductPtrType> products(total);
+  std::vector<DummyIntBase*> released(total, nullptr);
+  std::vector<double> constructNs(total);
+  std::vector<double> destroyNs(total);
+  std::vector<double> cleanupNs;
+  cleanupNs.reserve(1000000);
+
+  // Construct
+  std::size_t before = test::benchmark::allocations.load();
+  const double constructUs = RunThreads(_numThreads, [&](std::size_t _thread)
+  {
+    for (std::size_t i = _thread * NumProducts;
+         i < (_thread + 1) * NumProducts; ++i)
+    {
+      const auto start = std::chrono::steady_clock::now();
+      products[i] = factory->Construct(static_cast<int>(i));
+      const auto finish = std::chrono::steady_clock::now();
+      constructNs[i] =
+          std::chrono::duration<double, std::nano>(finish - start).count();
+    }
+  });
+  const std::size_t constructAllocations =
+      test::benchmark::allocations.load() - before;
+
+  for (std::size_t i = 0; i < total; ++i)
+  {
+    ASSERT_NE(nullptr, products[i]);
+    ASSERT_EQ(static_cast<int>(i), products[i]->MyIntegerValueIs());
+  }
+
+  const bool lost = _destruction == Destruction::Lost
+      || _destruction == Destruction::LostWithCleanup;
+  if (lost)
+  {
+    for (std::size_t i = 0; i < total; ++i)
+      released[i] = products[i].release();
+  }
+
+  if (_destruction != Destruction::BeforeFactory)
+    factory.reset();
+
+  ignition::plugin::CleanupLostProducts(std::chrono::nanoseconds(0));
+
+  // Destroy
+  std::atomic<bool> destroying(true);
+  std::thread cleaner;
+  if (_destruction == Destruction::LostWithCleanup)
+  {
+    cleaner = std::thread([&]()
+    {
+      while (destroying)
+      {
+        const auto start = std::chrono::steady_clock::now();
+        ignition::plugin::CleanupLostProducts();
+        const auto finish = std::chrono::steady_clock::now();
+        if (cleanupNs.size() < cleanupNs.capacity())
+        {
+          cleanupNs.push_back(std::chrono::duration<double, std::nano>(
+                finish - start).count());
+        }
+      }
+    });
+  }
+
+  before = test::benchmark::allocations.load();
+  const double destroyUs = RunThreads(_numThreads, [&](std::size_t _thread)
+  {
+    for (std::size_t i = _thread * NumProducts;
+         i < (_thread + 1) * NumProducts; ++i)
+    {
+      const auto start = std::chrono::steady_clock::now();
+      if (lost)
+        delete released[i];
+      else
+        products[i].reset();
+      const auto finish = std::chrono::steady_clock::now();
+      destroyNs[i] =
+          std::chrono::duration<double, std::nano>(finish - start).count();
+    }
+  });
+  const std::size_t destroyAllocations =
+      test::benchmark::allocations.load() - before;
+
+  destroying = false;
+  if (cleaner.joinable())
+    cleaner.join();
+
+  if (_destruction == Destruction::Lost)
+  {
+    EXPECT_EQ(total, ignition::plugin::LostProductCount());
+  }
+
+  const auto cleanupStart = std::chrono::steady_clock::now();
+  ignition::plugin::CleanupLostProducts();
+  const auto cleanupFinish = std::chrono::steady_clock::now();
+  EXPECT_EQ(0u, ignition::plugin::LostProductCount());
+
+  test::benchmark::Result result;
+  result.name = "Factory::Construct, " + ToString(_destruction);
+  result.values = {
+    {"threads", static_cast<double>(_numThreads)},
+    {"products", static_cast<double>(total)},
+    {"construct_p50_ns", test::benchmark::Percentile(constructNs, 0.5)},
+    {"construct_p99_ns", test::benchmark::Percentile(constructNs, 0.99)},
+    {"construct_per_us", static_cast<double>(total) / constructUs},
+    {"construct_allocations_per_product",
+     static_cast<double>(constructAllocations) / static_cast<double>(total)},
+    {"destroy_p50_ns", test::benchmark::Percentile(destroyNs, 0.5)},
+    {"destroy_p99_ns", test::benchmark::Percentile(destroyNs, 0.99)},
+    {"destroy_per_us", static_cast<double>(total) / destroyUs},
+    {"destroy_allocations_per_product",
+     static_cast<double>(destroyAllocations) / static_cast<double>(total)},
+    {"final_cleanup_us", std::chrono::duration<double, std::micro>(
+        cleanupFinish - cleanupStart).count()}};
+
+  if (_destruction == Destruction::LostWithCleanup)
+  {
+    result.values.push_back(
+        {"cleanup_calls", static_cast<double>(cleanupNs.size())});
+    result.values.push_back(
+        {"cleanup_p50_ns", test::benchmark::Percentile(cleanupNs, 0.5)});
+    result.values.push_back(
+        {"cleanup_p99_ns", test::benchmark::Percentile(cleanupNs, 0.99)});
+  }
+
+  results.push_back(result);
+}
+
+/////////////////////////////////////////////////
+TEST(FactoryThroughput, DestroyedBeforeFactory)
+{
+  for (std::size_t n = 1; n <= MaxThreads; n *= 2)
+    RunTrial(n, Destruction::BeforeFactory);
+}
+
+/////////////////////////////////////////////////
+TEST(FactoryThroughput, DestroyedAfterFactory)
+{
+  for (std::size_t n = 1; n <= MaxThreads; n *= 2)
+    RunTrial(n, Destruction::AfterFactory);
+}
+
+/////////////////////////////////////////////////
+TEST(FactoryThroughput, LostProducts)
+{
+  for (std::size_t n = 1; n <= MaxThreads; n *= 2)
+    RunTrial(n, Destruction::Lost);
+}
+
+/////////////////////////////////////////////////
+TEST(FactoryThroughput, CleanupContention)
+{
+  for (std::size_t n = 1; n <= MaxThreads; n *= 2)
+    RunTrial(n, Destruction::LostWithCleanup);
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  const int result = RUN_ALL_TESTS();
+  test::benchmark::WriteJson("factory_throughput", results);
+  return result;
+}
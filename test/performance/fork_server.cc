@@ -0,0 +1,277 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ignition/plugin/Loader.hh>
+
+#include "../plugins/DummyPlugins.hh"
+
+const std::size_t NumWorkers = 4;
+const std::size_t NumIterations = 100000;
+
+/// \brief How many more pages than an idle worker a worker may unshare. This
+/// covers the fixed cost of the first call into each code path, and it is far
+/// below one page per thousand iterations.
+const long FaultAllowance = 64;
+
+/// \brief What a worker sends back to the parent
+struct WorkerReport
+{
+  /// \brief Number of minor page faults caused by the work
+  long faults = -1;
+
+  /// \brief Whether the work produced the expected results
+  bool passed = false;
+};
+
+/////////////////////////////////////////////////
+/// \brief Get the number of minor page faults (which include copy-on-write
+/// faults) that this process has caused so far.
+long MinorFaults()
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_minflt;
+}
+
+/////////////////////////////////////////////////
+/// \brief Fork a worker process which runs _work, and get the number of minor
+/// page faults that _work caused inside of the worker. Test assertions cannot
+/// fail the test from inside of the worker, so _work reports whether it
+/// passed, and that gets sent back to the parent along with the faults.
+WorkerReport RunWorker(const std::function<bool()> &_work)
+{
+  WorkerReport report;
+
+  int fds[2];
+  if (pipe(fds) != 0)
+    return report;
+
+  const pid_t pid = fork();
+  if (0 == pid)
+  {
+    close(fds[0]);
+    const long before = MinorFaults();
+    report.passed = _work();
+    report.faults = MinorFaults() - before;
+    const ssize_t written = write(fds[1], &report, sizeof(report));
+    close(fds[1]);
+    _exit(written == sizeof(report) ? 0 : 1);
+  }
+
+  close(fds[1]);
+  if (read(fds[0], &report, sizeof(report)) != sizeof(report))
+    report = WorkerReport();
+  close(fds[0]);
+
+  int status = 0;
+  waitpid(pid, &status, 0);
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    return WorkerReport();
+
+  return report;
+}
+
+/////////////////////////////////////////////////
+TEST(ForkServer, CopyOnWriteFaultsPerWorker)
+{
+  ignition::plugin::Loader pl;
+  pl.LoadLib(IGNDummyPlugin_LIB);
+  pl.Freeze();
+
+  // Collect every name and unambiguous alias
+  std::vector<std::string> keys;
+  for (const std::string &name : pl.AllPlugins())
+  {
+    keys.push_back(name);
+    for (const std::string &alias : pl.AliasesOfPlugin(name))
+    {
+      if (pl.PluginsWithAlias(alias).size() == 1)
+        keys.push_back(alias);
+    }
+  }
+
+  // This is the heavy, read-only plugin that the parent shares with the
+  // workers.
+  ignition::plugin::PluginPtr shared =
+      pl.Instantiate("test::util::DummyMultiPlugin");
+  ASSERT_TRUE(shared);
+
+  struct Scenario
+  {
+    std::string label;
+    std::function<bool()> work;
+    std::vector<WorkerReport> reports;
+  };
+
+  std::vector<Scenario> scenarios;
+
+  // Measures what every worker unshares no matter what it does, e.g. the
+  // stack and the pages touched by exiting.
+  scenarios.push_back({"Idle worker", [&]()
+  {
+    return true;
+  }, {}});
+
+  scenarios.push_back({"Frozen lookup", [&]()
+  {
+    std::size_t resolved = 0;
+    for (std::size_t i = 0; i < NumIterations; ++i)
+      resolved += pl.LookupPlugin(keys[i % keys.size()]).size();
+    return resolved > 0;
+  }, {}});
+
+  scenarios.push_back({"QueryInterface on shared PluginPtr", [&]()
+  {
+    std::size_t found = 0;
+    for (std::size_t i = 0; i < NumIterations; ++i)
+    {
+      if (shared->QueryInterface<test::util::DummyNameBase>())
+        ++found;
+    }
+    return NumIterations == found;
+  }, {}});
+
+  scenarios.push_back({"Copy of shared PluginPtr", [&]()
+  {
+    std::size_t found = 0;
+    for (std::size_t i = 0; i < NumIterations; ++i)
+    {
+      ignition::plugin::PluginPtr copy = shared;
+      if (copy->QueryInterface<test::util::DummyNameBase>())
+        ++found;
+    }
+    return NumIterations == found;
+  }, {}});
+
+  scenarios.push_back({"Instantiate in worker", [&]()
+  {
+    std::size_t created = 0;
+    for (std::size_t i = 0; i < NumIterations; ++i)
+    {
+      if (pl.Instantiate("test::util::DummyMultiPlugin"))
+        ++created;
+    }
+    return NumIterations == created;
+  }, {}});
+
+  for (Scenario &scenario : scenarios)
+  {
+    for (std::size_t w = 0; w < NumWorkers; ++w)
+      scenario.reports.push_back(RunWorker(scenario.work));
+  }
+
+  long idle = 0;
+  for (const WorkerReport &report : scenarios.front().reports)
+    idle = std::max(idle, report.faults);
+
+  for (const Scenario &scenario : scenarios)
+  {
+    std::cout << " --- " << scenario.label << " ---\n";
+    for (std::size_t w = 0; w < scenario.reports.size(); ++w)
+    {
+      std::cout << "Worker " << w << " page faults: " << std::setw(8)
+                << std::right << scenario.reports[w].faults << "\n";
+    }
+    std::cout << std::endl;
+
+    // No scenario may unshare a number of pages that grows with the amount
+    // of work done by the worker. Instantiating and copying only write to
+    // reference counts that belong to the worker, or to a fixed set of pages
+    // that are unshared the first time that they are written to.
+    for (std::size_t w = 0; w < scenario.reports.size(); ++w)
+    {
+      const WorkerReport &report = scenario.reports[w];
+      EXPECT_TRUE(report.passed)
+        << scenario.label << ": worker " << w << " failed";
+      EXPECT_LE(0, report.faults) << scenario.label << ": worker " << w;
+      EXPECT_LE(report.faults, idle + FaultAllowance)
+        << scenario.label << ": worker " << w;
+    }
+  }
+}
+
+/////////////////////////////////////////////////
+TEST(ForkServer, WorkerUnloadsAndExits)
+{
+  ignition::plugin::Loader pl;
+  pl.SetUnloadGracePeriod(std::chrono::milliseconds(50));
+
+  // Releasing a library starts the unload thread of this process, and the
+  // close of this library is still pending when the worker gets forked.
+  ASSERT_LT(0u, pl.LoadLib(IGNFactoryPlugins_LIB).size());
+  EXPECT_TRUE(pl.ForgetLibrary(IGNFactoryPlugins_LIB));
+  ASSERT_LT(0u, pl.LoadLib(IGNDummyPlugin_LIB).size());
+
+  const pid_t pid = fork();
+  if (0 == pid)
+  {
+    // A worker which hangs is killed instead of hanging the test
+    alarm(10);
+
+    // The worker has to start an unload thread of its own, which also closes
+    // the library that it inherited a pending close of.
+    const std::size_t unloaded = pl.UnloadStats().unloaded;
+    const bool forgotten = pl.ForgetLibrary(IGNDummyPlugin_LIB);
+
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (pl.UnloadStats().pending > 0
+           && std::chrono::steady_clock::now() < deadline)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    const ignition::plugin::Loader::UnloadStatistics stats = pl.UnloadStats();
+    const bool passed = forgotten && 0 == stats.pending
+        && stats.unloaded >= unloaded + 1;
+
+    // Exiting normally runs the exit handler which stops the unload thread.
+    std::exit(passed ? 0 : 1);
+  }
+
+  ASSERT_LT(0, pid);
+  int status = 0;
+  ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  EXPECT_TRUE(WIFEXITED(status)) << "The worker did not exit by itself";
+  if (WIFEXITED(status))
+  {
+    EXPECT_EQ(0, WEXITSTATUS(status));
+  }
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
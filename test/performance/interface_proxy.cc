@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <ignition/plugin/InterfaceProxy.hh>
+#include <ignition/plugin/Loader.hh>
+
+#include "../plugins/DummyPlugins.hh"
+
+namespace test
+{
+  /// \brief Times the calls to DummyIntBase
+  class TimedInt : public ignition::plugin::InterfaceProxy<util::DummyIntBase>
+  {
+    public: using InterfaceProxy::InterfaceProxy;
+
+    public: int MyIntegerValueIs() const override
+    {
+      return this->Forward(0, &util::DummyIntBase::MyIntegerValueIs);
+    }
+  };
+}
+
+IGNITION_ADD_INTERFACE_PROXY(test::TimedInt, "MyIntegerValueIs")
+
+const std::size_t NumTests = 10000;
+const std::size_t NumTrials = 200;
+
+/////////////////////////////////////////////////
+/// \brief Get the average time of one call of _work, in nanoseconds
+double AverageTime(const std::function<void()> &_work)
+{
+  double total = 0.0;
+  for (std::size_t trial = 0; trial < NumTrials; ++trial)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < NumTests; ++i)
+      _work();
+    const auto finish = std::chrono::steady_clock::now();
+
+    total += std::chrono::duration<double, std::nano>(finish - start).count();
+  }
+
+  return total / static_cast<double>(NumTests * NumTrials);
+}
+
+/////////////////////////////////////////////////
+TEST(InterfaceProxy, Overhead)
+{
+  ignition::plugin::Loader pl;
+  pl.LoadLib(IGNDummyPlugin_LIB);
+
+  ignition::plugin::PluginPtr plain =
+      pl.Instantiate("test::util::DummyMultiPlugin");
+  pl.SetInterfaceProxies(true);
+  ignition::plugin::PluginPtr proxied =
+      pl.Instantiate("test::util::DummyMultiPlugin");
+  pl.SetInterfaceProxies(false);
+  ASSERT_TRUE(plain);
+  ASSERT_TRUE(proxied);
+
+  test::util::DummyIntBase *const direct =
+      plain->QueryInterface<test::util::DummyIntBase>();
+  test::util::DummyIntBase *const timed =
+      proxied->QueryInterface<test::util::DummyIntBase>();
+  ASSERT_NE(nullptr, direct);
+  ASSERT_NE(nullptr, dynamic_cast<test::TimedInt*>(timed));
+
+  volatile int sink = 0;
+
+  struct TestData
+  {
+    std::string label;
+    double avg;
+  };
+
+  std::vector<TestData> tests = {
+    {"Read steady_clock", AverageTime([&]()
+      {
+        sink = static_cast<int>(
+              std::chrono::steady_clock::now().time_since_epoch().count());
+      })},
+    {"Direct call", AverageTime([&]()
+      {
+        sink = direct->MyIntegerValueIs();
+      })},
+    {"Call through a proxy", AverageTime([&]()
+      {
+        sink = timed->MyIntegerValueIs();
+      })},
+    {"QueryInterface, instance without proxies", AverageTime([&]()
+      {
+        sink = nullptr != plain->QueryInterface<test::util::DummyIntBase>();
+      })},
+    {"QueryInterface, instance with proxies", AverageTime([&]()
+      {
+        sink = nullptr != proxied->QueryInterface<test::util::DummyIntBase>();
+      })}};
+
+  for (const TestData &test : tests)
+  {
+    std::cout << std::fixed;
+    std::cout << std::setprecision(6);
+    std::cout << std::right;
+
+    std::cout << " --- " << test.label << " result ---\n"
+              << "Avg time: " << std::setw(11) << std::right
+              << test.avg << "ns\n" << std::endl;
+  }
+
+  // Timing a call reads the clock twice and adds to three counters, so the
+  // overhead of a proxy should be the cost of two clock reads plus a small
+  // constant. The constant is generous so that this holds on busy machines.
+  EXPECT_LT(tests[2].avg - tests[1].avg, 2.0*tests[0].avg + 100.0);
+
+  // An instance which was created while proxies were disabled can still use
+  // the inline cache of QueryInterface, even though its plugin has a proxy.
+  EXPECT_LT(tests[3].avg, tests[4].avg);
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ignition/plugin/Loader.hh>
+#include <ignition/plugin/PluginPin.hh>
+#include <ignition/plugin/WeakPluginPtr.hh>
+
+#include "../plugins/DummyPlugins.hh"
+
+const std::size_t MaxThreads = 64;
+const std::size_t NumIterations = 20000;
+
+/////////////////////////////////////////////////
+/// \brief Run _work on _numThreads threads at once, and get the number of
+/// operations per microsecond that were achieved by all of them together.
+/// _work must return how many times its operation succeeded.
+double Throughput(
+    const std::size_t _numThreads,
+    const std::function<std::size_t()> &_work)
+{
+  std::atomic<bool> go(false);
+  std::atomic<std::size_t> ready(0);
+  std::atomic<std::size_t> succeeded(0);
+
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < _numThreads; ++i)
+  {
+    threads.push_back(std::thread([&]()
+    {
+      ++ready;
+      while (!go)
+        std::this_thread::yield();
+
+      succeeded += _work();
+    }));
+  }
+
+  while (ready < _numThreads)
+    std::this_thread::yield();
+
+  const auto start = std::chrono::steady_clock::now();
+  go = true;
+  for (std::thread &thread : threads)
+    thread.join();
+  const auto finish = std::chrono::steady_clock::now();
+
+  EXPECT_EQ(_numThreads * NumIterations, succeeded.load());
+
+  const double us = std::chrono::duration<double, std::micro>(
+        finish - start).count();
+
+  return static_cast<double>(_numThreads * NumIterations) / us;
+}
+
+/////////////////////////////////////////////////
+TEST(PinContention, CopyAndLockThroughput)
+{
+  ignition::plugin::Loader pl;
+  pl.LoadLib(IGNDummyPlugin_LIB);
+
+  const ignition::plugin::PluginPtr plugin =
+      pl.Instantiate("test::util::DummyMultiPlugin");
+  ASSERT_TRUE(plugin);
+
+  const ignition::plugin::WeakPluginPtr weak = plugin;
+  const ignition::plugin::PluginPin pin = plugin;
+  const ignition::plugin::ShardedPluginPtr sharded(plugin);
+
+  using test::util::DummyIntBase;
+
+  struct Scenario
+  {
+    std::string label;
+    std::function<std::size_t()> work;
+  };
+
+  const std::vector<Scenario> scenarios = {
+    {"PluginPtr copy", [&]()
+      {
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < NumIterations; ++i)
+        {
+          ignition::plugin::PluginPtr copy = plugin;
+          count += copy->QueryInterface<DummyIntBase>() ? 1 : 0;
+        }
+        return count;
+      }},
+    {"QueryInterfaceSharedPtr", [&]()
+      {
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < NumIterations; ++i)
+          count += plugin->QueryInterfaceSharedPtr<DummyIntBase>() ? 1 : 0;
+        return count;
+      }},
+    {"WeakPluginPtr::Lock", [&]()
+      {
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < NumIterations; ++i)
+          count += weak.Lock()->QueryInterface<DummyIntBase>() ? 1 : 0;
+        return count;
+      }},
+    {"ShardedPluginPtr::Acquire", [&]()
+      {
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < NumIterations; ++i)
+          count += sharded.Acquire()->QueryInterface<DummyIntBase>() ? 1 : 0;
+        return count;
+      }},
+    {"PluginPin", [&]()
+      {
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < NumIterations; ++i)
+        {
+          const ignition::plugin::PluginPin local = pin;
+          count += local->QueryInterface<DummyIntBase>() ? 1 : 0;
+        }
+        return count;
+      }}
+  };
+
+  std::cout << std::setw(28) << std::left << "ops/us by thread count";
+  for (std::size_t n = 1; n <= MaxThreads; n *= 2)
+    std::cout << std::setw(9) << std::right << n;
+  std::cout << "\n";
+
+  for (const Scenario &scenario : scenarios)
+  {
+    std::cout << std::setw(28) << std::left << scenario.label;
+    for (std::size_t n = 1; n <= MaxThreads; n *= 2)
+    {
+      std::cout << std::setw(9) << std::right << std::fixed
+                << std::setprecision(2) << Throughput(n, scenario.work)
+                << std::flush;
+    }
+    std::cout << std::endl;
+  }
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
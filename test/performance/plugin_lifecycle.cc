@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <ignition/plugin/EnablePluginFromThis.hh>
+#include <ignition/plugin/Loader.hh>
+#include <ignition/plugin/SpecializedPluginPtr.hh>
+#include <ignition/plugin/WeakPluginPtr.hh>
+
+#include "../plugins/SweepPlugins.hh"
+#include "benchmark.hh"
+
+using test::benchmark::DoNotOptimize;
+using test::benchmark::Measure;
+using test::benchmark::Measurement;
+
+using FirstInterface = test::plugins::SweepInterface<0>;
+
+const std::size_t NumIterations = 10000;
+
+/////////////////////////////////////////////////
+TEST(PluginLifecycle, InterfaceSweep)
+{
+  ignition::plugin::Loader pl;
+  ASSERT_EQ(std::size(test::plugins::SweepSizes),
+            pl.LoadLib(IGNSweepPlugins_LIB).size());
+
+  std::vector<test::benchmark::Result> results;
+
+  for (const std::size_t size : test::plugins::SweepSizes)
+  {
+    const std::string alias = "Sweep" + std::to_string(size);
+
+    const ignition::plugin::PluginPtr plugin = pl.Instantiate(alias);
+    const ignition::plugin::PluginPtr other = pl.Instantiate(alias);
+    ASSERT_TRUE(plugin);
+    ASSERT_TRUE(other);
+
+    const ignition::plugin::WeakPluginPtr weak = plugin;
+    ignition::plugin::EnablePluginFromThis *fromThis =
+        plugin->QueryInterface<ignition::plugin::EnablePluginFromThis>();
+    ASSERT_NE(nullptr, fromThis);
+
+    // The instance which gets moved back and forth
+    ignition::plugin::PluginPtr moving;
+
+    // The instances whose destruction is measured
+    std::vector<ignition::plugin::PluginPtr> doomed;
+
+    struct Operation
+    {
+      std::string name;
+      std::function<void()> prepare;
+      std::function<void()> work;
+    };
+
+    const std::vector<Operation> operations = {
+      {"PluginPtr copy", []() { }, [&]()
+        {
+          for (std::size_t i = 0; i < NumIterations; ++i)
+          {
+            const ignition::plugin::PluginPtr copy = plugin;
+            DoNotOptimize(copy);
+          }
+        }},
+      {"PluginPtr move", [&]() { moving = plugin; }, [&]()
+        {
+          ignition::plugin::PluginPtr second;
+          for (std::size_t i = 0; i < NumIterations; i += 2)
+          {
+            second = std::move(moving);
+            moving = std::move(second);
+          }
+          DoNotOptimize(moving);
+        }},
+      {"PluginPtr assign", []() { }, [&]()
+        {
+          ignition::plugin::PluginPtr target;
+          for (std::size_t i = 0; i < NumIterations; ++i)
+          {
+            target = (i % 2) ? plugin : other;
+            DoNotOptimize(target);
+          }
+        }},
+      {"WeakPluginPtr construct", []() { }, [&]()
+        {
+          for (std::size_t i = 0; i < NumIterations; ++i)
+          {
+            const ignition::plugin::WeakPluginPtr local = plugin;
+            DoNotOptimize(local);
+          }
+        }},
+      {"WeakPluginPtr::Lock", []() { }, [&]()
+        {
+          for (std::size_t i = 0; i < NumIterations; ++i)
+          {
+            const ignition::plugin::PluginPtr locked = weak.Lock();
+            DoNotOptimize(locked);
+          }
+        }},
+      {"WeakPluginPtr::IsExpired", []() { }, [&]()
+        {
+          for (std::size_t i = 0; i < NumIterations; ++i)
+            DoNotOptimize(weak.IsExpired());
+        }},
+      {"EnablePluginFromThis::PluginFromThis", []() { }, [&]()
+        {
+          for (std::size_t i = 0; i < NumIterations; ++i)
+          {
+            const ignition::plugin::PluginPtr self =
+                fromThis->PluginFromThis();
+            DoNotOptimize(self);
+          }
+        }},
+      {"SpecializedPluginPtr conversion", []() { }, [&]()
+        {
+          for (std::size_t i = 0; i < NumIterations; ++i)
+          {
+            const ignition::plugin::SpecializedPluginPtr<FirstInterface>
+                specialized = plugin;
+            DoNotOptimize(specialized);
+          }
+        }},
+      {"QueryInterfaceSharedPtr", []() { }, [&]()
+        {
+          for (std::size_t i = 0; i < NumIterations; ++i)
+          {
+            const std::shared_ptr<FirstInterface> shared =
+                plugin->QueryInterfaceSharedPtr<FirstInterface>();
+            DoNotOptimize(shared);
+          }
+        }},
+      {"Instance destruction", [&]()
+        {
+          doomed.clear();
+          for (std::size_t i = 0; i < NumIterations; ++i)
+            doomed.push_back(pl.Instantiate(alias));
+        }, [&]()
+        {
+          for (ignition::plugin::PluginPtr &instance : doomed)
+            instance = nullptr;
+        }}
+    };
+
+    for (const Operation &operation : operations)
+    {
+      const Measurement measurement =
+          Measure(NumIterations, operation.prepare, operation.work);
+
+      results.push_back({operation.name, {
+          {"interfaces", static_cast<double>(size)},
+          {"ns_per_op", measurement.nanoseconds},
+          {"allocations_per_op", measurement.allocations}}});
+
+      // These operations only touch reference counts. The threads of the
+      // Loader may still allocate now and then while they are measured.
+      if (operation.name == "WeakPluginPtr::IsExpired" ||
+          operation.name == "QueryInterfaceSharedPtr" ||
+          operation.name == "PluginPtr move")
+      {
+        EXPECT_LT(measurement.allocations, 0.01)
+            << operation.name << " with " << size << " interfaces";
+      }
+    }
+  }
+
+  test::benchmark::WriteJson("plugin_lifecycle", results);
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -20,8 +20,13 @@
 #include <chrono>
 #include <iomanip>
 #include <cmath>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <ignition/plugin/Loader.hh>
+#include <ignition/plugin/QueryStats.hh>
 #include <ignition/plugin/SpecializedPluginPtr.hh>
 
 #include "../plugins/DummyPlugins.hh"
@@ -124,6 +129,31 @@ double RunPerformanceTest(const PluginType &plugin)
   return avg;
 }
 
+/////////////////////////////////////////////////
+/// \brief Query plugins of different types in turn. Up to
+/// QueryInterfaceCache::Entries types share the inline cache of
+/// QueryInterface, and cycling through more types than that makes it miss on
+/// every call.
+double RunMixedPerformanceTest(
+    const std::vector<ignition::plugin::PluginPtr> &plugins)
+{
+  const std::size_t NumTests = 10000;
+  const auto start = std::chrono::high_resolution_clock::now();
+  for (std::size_t i = 0; i < NumTests; ++i)
+  {
+    plugins[i % plugins.size()]->QueryInterface<
+        test::util::DummySetterBase>();
+  }
+  const auto finish = std::chrono::high_resolution_clock::now();
+
+  const auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        finish - start).count();
+
+  const double avg = static_cast<double>(time)/static_cast<double>(NumTests);
+
+  return avg;
+}
+
 /////////////////////////////////////////////////
 TEST(PluginSpecialization, AccessTime)
 {
@@ -132,7 +162,26 @@ TEST(PluginSpecialization, AccessTime)
 
   // Load up the generic plugin
   ignition::plugin::PluginPtr plugin =
-      pl.Instantiate("::test::util::DummyMultiPlugin");
+      pl.Instantiate("test::util::DummyMultiPlugin");
+  ASSERT_TRUE(plugin);
+
+  // Plugins of two types, which fit into the inline cache of QueryInterface
+  const std::vector<ignition::plugin::PluginPtr> mixed = {
+    plugin, pl.Instantiate("test::util::DummySinglePlugin")};
+  ASSERT_TRUE(mixed.back());
+
+  // Every Loader has its own Info for each plugin type, so the plugins of
+  // several Loaders are more plugin types than the inline cache has entries,
+  // and cycling through them defeats the cache.
+  using Cache = ignition::plugin::detail::QueryInterfaceCache;
+  std::vector<ignition::plugin::Loader> loaders(Cache::Entries + 1);
+  std::vector<ignition::plugin::PluginPtr> crowded;
+  for (ignition::plugin::Loader &loader : loaders)
+  {
+    loader.LoadLib(IGNDummyPlugin_LIB);
+    crowded.push_back(loader.Instantiate("test::util::DummyMultiPlugin"));
+    ASSERT_TRUE(crowded.back());
+  }
 
   // Create specialized versions
   Specialize1Type spec_1 = plugin;
@@ -161,6 +210,8 @@ TEST(PluginSpecialization, AccessTime)
   tests.push_back(TestData("20 specializations (leading)"));
   tests.push_back(TestData("20 specializations (trailing)"));
   tests.push_back(TestData("No specialization"));
+  tests.push_back(TestData("No specialization (2 plugin types)"));
+  tests.push_back(TestData("No specialization (inline cache misses)"));
 
   const std::size_t NumTrials = 1000;
   const std::size_t Warmup = 50;
@@ -176,6 +227,8 @@ TEST(PluginSpecialization, AccessTime)
     tests[t++].avg += RunPerformanceTest(spec_20_leading);
     tests[t++].avg += RunPerformanceTest(spec_20_trailing);
     tests[t++].avg += RunPerformanceTest(plugin);
+    tests[t++].avg += RunMixedPerformanceTest(mixed);
+    tests[t++].avg += RunMixedPerformanceTest(crowded);
 
     // Note that whichever test is listed first in the for-loop will have the
     // worst performance, probably due to weird register behavior. We run
@@ -199,7 +252,14 @@ TEST(PluginSpecialization, AccessTime)
   EXPECT_LT(std::abs(tests[5].avg - baseline), baseline);
   EXPECT_LT(std::abs(tests[6].avg - baseline), baseline);
 
-  // Test that the specialized results are always better than the generic result
+  // Test that the inline cache of QueryInterface makes a generic PluginPtr
+  // much faster than it is when the cache cannot be used, including when the
+  // queries alternate between plugin types
+  EXPECT_LT(tests[7].avg, tests.back().avg/2.0);
+  EXPECT_LT(tests[8].avg, tests.back().avg/2.0);
+
+  // Test that the specialized results are always better than the generic
+  // result when it cannot use its inline cache
   EXPECT_LT(tests[0].avg, tests.back().avg);
   EXPECT_LT(tests[1].avg, tests.back().avg);
   EXPECT_LT(tests[2].avg, tests.back().avg);
@@ -219,6 +279,137 @@ TEST(PluginSpecialization, AccessTime)
               << test.avg/static_cast<double>(NumTrials)
               << "ns\n" << std::endl;
   }
+
+  // The query counters can tell how often the cache missed
+  if (!ignition::plugin::QueryStatsEnabled)
+  {
+    std::cout << "Build with IGN_PLUGIN_ENABLE_QUERY_STATS to count the "
+              << "misses of the inline cache\n" << std::endl;
+    return;
+  }
+
+  const std::vector<std::pair<std::string,
+      const std::vector<ignition::plugin::PluginPtr>*>> missTests = {
+    {tests[8].label, &mixed}, {tests[9].label, &crowded}};
+
+  std::vector<double> missRates;
+  for (const auto &test : missTests)
+  {
+    const std::size_t NumTests = 10000;
+    ignition::plugin::ResetQueryStats();
+    for (std::size_t i = 0; i < NumTests; ++i)
+    {
+      (*test.second)[i % test.second->size()]->QueryInterface<
+          test::util::DummySetterBase>();
+    }
+
+    std::uint64_t lookups = 0;
+    for (const ignition::plugin::QueryStatistics &stats :
+         ignition::plugin::QueryStats())
+    {
+      if (stats.pointerInterfaces.empty()
+          && stats.interface == "test::util::DummySetterBase")
+        lookups += stats.lookups;
+    }
+
+    missRates.push_back(
+          static_cast<double>(lookups) / static_cast<double>(NumTests));
+    std::cout << " --- " << test.first << " ---\n"
+              << "Inline cache miss rate: " << std::setw(11) << std::right
+              << missRates.back() << "\n" << std::endl;
+  }
+
+  // Two plugin types only miss while the cache is being filled in
+  EXPECT_LT(missRates[0], 0.01);
+  EXPECT_DOUBLE_EQ(1.0, missRates[1]);
+}
+
+/////////////////////////////////////////////////
+/// \brief Get the size of the plugin wrapper that is held by PluginPtrType
+template <typename PluginPtrType>
+std::size_t WrapperSize()
+{
+  return sizeof(typename std::remove_reference<
+                decltype(*std::declval<PluginPtrType>())>::type);
+}
+
+/////////////////////////////////////////////////
+/// \brief Measure how long it takes to construct PluginPtrType from a generic
+/// PluginPtr, which includes filling in all of its specialized interfaces.
+template <typename PluginPtrType>
+double RunConstructionTest(const ignition::plugin::PluginPtr &plugin)
+{
+  const std::size_t NumTests = 1000;
+  const auto start = std::chrono::high_resolution_clock::now();
+  for (std::size_t i = 0; i < NumTests; ++i)
+  {
+    PluginPtrType spec = plugin;
+    EXPECT_TRUE(spec);
+  }
+  const auto finish = std::chrono::high_resolution_clock::now();
+
+  const auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        finish - start).count();
+
+  return static_cast<double>(time)/static_cast<double>(NumTests);
+}
+
+/////////////////////////////////////////////////
+TEST(PluginSpecialization, ConstructionTime)
+{
+  ignition::plugin::Loader pl;
+  pl.LoadLib(IGNDummyPlugin_LIB);
+
+  ignition::plugin::PluginPtr plugin =
+      pl.Instantiate("test::util::DummyMultiPlugin");
+  ASSERT_TRUE(plugin);
+
+  struct TestData
+  {
+    std::string label;
+    std::size_t size;
+    double avg;
+  };
+
+  std::vector<TestData> tests = {
+    {"No specialization", WrapperSize<ignition::plugin::PluginPtr>(), 0.0},
+    {"1 specialization", WrapperSize<Specialize1Type>(), 0.0},
+    {"10 specializations", WrapperSize<Specialize10Types_Trailing>(), 0.0},
+    {"20 specializations", WrapperSize<Specialize20Types_Trailing>(), 0.0}};
+
+  const std::size_t NumTrials = 100;
+  for (std::size_t i = 0; i < NumTrials; ++i)
+  {
+    std::size_t t = 0;
+    tests[t++].avg += RunConstructionTest<ignition::plugin::PluginPtr>(plugin);
+    tests[t++].avg += RunConstructionTest<Specialize1Type>(plugin);
+    tests[t++].avg += RunConstructionTest<Specialize10Types_Trailing>(plugin);
+    tests[t++].avg += RunConstructionTest<Specialize20Types_Trailing>(plugin);
+  }
+
+  for (const TestData &test : tests)
+  {
+    std::cout << std::fixed;
+    std::cout << std::setprecision(6);
+    std::cout << std::right;
+
+    std::cout << " --- " << test.label << " result ---\n"
+              << "Object size: " << std::setw(8) << test.size << " bytes\n"
+              << "Avg construction time: " << std::setw(11) << std::right
+              << test.avg/static_cast<double>(NumTrials)
+              << "ns\n" << std::endl;
+  }
+
+  // The specialized interfaces are shared by reference, so every specialized
+  // wrapper is one pointer larger than a generic one, no matter how many
+  // interfaces it anticipates.
+  EXPECT_EQ(tests[0].size + sizeof(void*), tests[1].size);
+  EXPECT_EQ(tests[1].size, tests[2].size);
+  EXPECT_EQ(tests[1].size, tests[3].size);
+
+  // For the same reason, converting into a specialized type should not get
+  // slower as more interfaces are anticipated.
+  EXPECT_LT(tests[3].avg, 2.0*tests[1].avg);
 }
 
 
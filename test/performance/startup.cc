@@ -0,0 +1,243 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <ignition/plugin/Loader.hh>
+
+#include "StartupLibraries.hh"
+#include "benchmark.hh"
+
+const std::size_t Trials = 5;
+
+/////////////////////////////////////////////////
+/// \brief Ask the kernel to drop the pages of a file from the page cache.
+/// This only works for pages which are not mapped by any process, so the
+/// library must be unloaded first. Dropping the whole page cache with
+/// /proc/sys/vm/drop_caches would need root.
+void DropFromPageCache(const std::string &_path)
+{
+  const int fd = open(_path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return;
+
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+}
+
+/////////////////////////////////////////////////
+/// \brief Get the fraction of the pages of a file which are in the page
+/// cache, so that the results show whether a cold run really was cold.
+double ResidentFraction(const std::string &_path)
+{
+  const int fd = open(_path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return 0.0;
+
+  struct stat status;
+  if (fstat(fd, &status) != 0 || status.st_size == 0)
+  {
+    close(fd);
+    return 0.0;
+  }
+
+  const std::size_t size = static_cast<std::size_t>(status.st_size);
+  void *map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (MAP_FAILED == map)
+    return 0.0;
+
+  const std::size_t pageSize =
+      static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  std::vector<unsigned char> pages((size + pageSize - 1) / pageSize);
+
+  std::size_t resident = 0;
+  if (mincore(map, size, pages.data()) == 0)
+  {
+    for (const unsigned char page : pages)
+      resident += (page & 1u);
+  }
+  munmap(map, size);
+
+  return static_cast<double>(resident) / static_cast<double>(pages.size());
+}
+
+/////////////////////////////////////////////////
+/// \brief Check whether a library is currently loaded by this process.
+bool IsLoaded(const std::string &_path)
+{
+  void *handle = dlopen(_path.c_str(), RTLD_LAZY | RTLD_NOLOAD);
+  if (!handle)
+    return false;
+
+  dlclose(handle);
+  return true;
+}
+
+/////////////////////////////////////////////////
+/// \brief Get how long the static registration of the plugins of a loaded
+/// library took. Every generated library records this while it is loaded.
+std::chrono::nanoseconds RegistrationTime(const std::string &_path)
+{
+  void *handle = dlopen(_path.c_str(), RTLD_LAZY | RTLD_NOLOAD);
+  if (!handle)
+    return std::chrono::nanoseconds(0);
+
+  using Signature = std::int64_t(*)();
+  const auto registration = reinterpret_cast<Signature>(
+      dlsym(handle, "StartupRegistrationNanoseconds"));
+
+  const std::chrono::nanoseconds time(registration ? registration() : 0);
+  dlclose(handle);
+  return time;
+}
+
+/////////////////////////////////////////////////
+/// \brief The time that one LoadLib() spent in each of its phases
+struct Phases
+{
+  /// \brief Time of the whole LoadLib() call
+  std::chrono::nanoseconds total{0};
+
+  /// \brief Time in dlopen, excluding the static registration
+  std::chrono::nanoseconds dlopen{0};
+
+  /// \brief Time of the static initializers which register the plugins,
+  /// which run inside dlopen
+  std::chrono::nanoseconds registration{0};
+
+  /// \brief Time in IgnitionPluginHook
+  std::chrono::nanoseconds hook{0};
+
+  /// \brief Time importing the Info into the Loader, excluding demangling
+  std::chrono::nanoseconds import{0};
+
+  /// \brief Time demangling the names of plugins and interfaces
+  std::chrono::nanoseconds demangle{0};
+
+  /// \brief Fraction of the library file which was in the page cache
+  double resident = 0.0;
+};
+
+/////////////////////////////////////////////////
+/// \brief Load a library with a new Loader and unload it again.
+/// \param[in] _path The library
+/// \param[in] _cold Drop the library from the page cache before loading it
+/// \param[in] _bindNow Resolve all of the symbols of the library in dlopen
+/// \return The time of each phase of LoadLib()
+Phases LoadOnce(const std::string &_path, const bool _cold, const bool _bindNow)
+{
+  Phases phases;
+
+  EXPECT_FALSE(IsLoaded(_path)) << _path << " was not unloaded";
+  if (_cold)
+    DropFromPageCache(_path);
+  phases.resident = ResidentFraction(_path);
+
+  ignition::plugin::Loader::LoadOptions options;
+  options.bindNow = _bindNow;
+
+  ignition::plugin::Loader pl;
+
+  const auto start = std::chrono::steady_clock::now();
+  const bool loaded = !pl.LoadLib(_path, options).empty();
+  phases.total = std::chrono::steady_clock::now() - start;
+  EXPECT_TRUE(loaded) << _path;
+
+  phases.registration = RegistrationTime(_path);
+
+  for (const auto &library : pl.Stats().libraries)
+  {
+    if (library.path != _path)
+      continue;
+
+    phases.dlopen = library.dlopenTime - phases.registration;
+    phases.hook = library.hookTime;
+    phases.import = library.importTime;
+    phases.demangle = library.demangleTime;
+  }
+
+  return phases;
+}
+
+/////////////////////////////////////////////////
+TEST(Startup, LoadLib)
+{
+  std::vector<test::benchmark::Result> results;
+
+  const auto ns = [](const std::chrono::nanoseconds _time)
+  {
+    return static_cast<double>(_time.count());
+  };
+
+  for (const test::plugins::StartupLibrary &library :
+       test::plugins::StartupLibraries)
+  {
+    for (const bool cold : {true, false})
+    {
+      for (const bool bindNow : {false, true})
+      {
+        // Load the library once so that a warm run starts out warm
+        if (!cold)
+          LoadOnce(library.path, false, bindNow);
+
+        Phases best;
+        best.total = std::chrono::nanoseconds::max();
+        for (std::size_t trial = 0; trial < Trials; ++trial)
+        {
+          const Phases phases = LoadOnce(library.path, cold, bindNow);
+          if (phases.total < best.total)
+            best = phases;
+        }
+
+        results.push_back({"LoadLib", {
+            {"plugins", static_cast<double>(library.plugins)},
+            {"aliases", static_cast<double>(library.aliases)},
+            {"interfaces", static_cast<double>(library.interfaces)},
+            {"cold", cold ? 1.0 : 0.0},
+            {"bind_now", bindNow ? 1.0 : 0.0},
+            {"resident_fraction", best.resident},
+            {"total_ns", ns(best.total)},
+            {"dlopen_ns", ns(best.dlopen)},
+            {"registration_ns", ns(best.registration)},
+            {"hook_ns", ns(best.hook)},
+            {"import_ns", ns(best.import)},
+            {"demangle_ns", ns(best.demangle)}}});
+      }
+    }
+  }
+
+  test::benchmark::WriteJson("startup", results);
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
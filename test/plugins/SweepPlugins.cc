@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <utility>
+
+#include "SweepPlugins.hh"
+
+#include <ignition/plugin/EnablePluginFromThis.hh>
+#include <ignition/plugin/Register.hh>
+
+namespace test
+{
+namespace plugins
+{
+
+/////////////////////////////////////////////////
+template <typename Indices>
+class SweepPluginBase;
+
+/////////////////////////////////////////////////
+template <std::size_t... Indices>
+class SweepPluginBase<std::index_sequence<Indices...>>
+    : public SweepInterface<Indices>...,
+      public ignition::plugin::EnablePluginFromThis
+{
+};
+
+/////////////////////////////////////////////////
+template <std::size_t Count>
+class SweepPlugin
+    : public SweepPluginBase<std::make_index_sequence<Count>>
+{
+};
+
+}
+}
+
+// These expand to the lists of interfaces of the plugins
+#define SWEEP_INTERFACES_1(I) \
+  test::plugins::SweepInterface<I>
+#define SWEEP_INTERFACES_4(I) \
+  SWEEP_INTERFACES_1(I), SWEEP_INTERFACES_1(I+1), \
+  SWEEP_INTERFACES_1(I+2), SWEEP_INTERFACES_1(I+3)
+#define SWEEP_INTERFACES_16(I) \
+  SWEEP_INTERFACES_4(I), SWEEP_INTERFACES_4(I+4), \
+  SWEEP_INTERFACES_4(I+8), SWEEP_INTERFACES_4(I+12)
+#define SWEEP_INTERFACES_64(I) \
+  SWEEP_INTERFACES_16(I), SWEEP_INTERFACES_16(I+16), \
+  SWEEP_INTERFACES_16(I+32), SWEEP_INTERFACES_16(I+48)
+
+IGNITION_ADD_PLUGIN(test::plugins::SweepPlugin<1>, SWEEP_INTERFACES_1(0))
+IGNITION_ADD_PLUGIN_ALIAS(test::plugins::SweepPlugin<1>, "Sweep1")
+
+IGNITION_ADD_PLUGIN(test::plugins::SweepPlugin<4>, SWEEP_INTERFACES_4(0))
+IGNITION_ADD_PLUGIN_ALIAS(test::plugins::SweepPlugin<4>, "Sweep4")
+
+IGNITION_ADD_PLUGIN(test::plugins::SweepPlugin<16>, SWEEP_INTERFACES_16(0))
+IGNITION_ADD_PLUGIN_ALIAS(test::plugins::SweepPlugin<16>, "Sweep16")
+
+IGNITION_ADD_PLUGIN(test::plugins::SweepPlugin<64>, SWEEP_INTERFACES_64(0))
+IGNITION_ADD_PLUGIN_ALIAS(test::plugins::SweepPlugin<64>, "Sweep64")
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2018 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef IGNITION_PLUGIN_TEST_PLUGINS_SWEEPPLUGINS_HH_
+#define IGNITION_PLUGIN_TEST_PLUGINS_SWEEPPLUGINS_HH_
+
+#include <cstddef>
+
+namespace test
+{
+namespace plugins
+{
+
+/// \brief One of many interfaces which only differ by their index. The
+/// plugins of the SweepPlugins library implement the first N of them, so
+/// that benchmarks can see how the number of interfaces affects each
+/// operation.
+template <std::size_t Index>
+class SweepInterface
+{
+  public: virtual std::size_t SweepIndex() const
+  {
+    return Index;
+  }
+
+  public: virtual ~SweepInterface() = default;
+};
+
+/// \brief The numbers of interfaces of the plugins in the SweepPlugins
+/// library. The plugin which implements N interfaces has the alias "SweepN".
+constexpr std::size_t SweepSizes[] = {1, 4, 16, 64};
+
+}
+}
+
+#endif